@@ -0,0 +1,170 @@
+//
+// Created by raph on 30/01/25.
+//
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <stdexcept>
+
+#include "../src/core/Logger.h"
+#include "../src/core/Statistics.h"
+#include "../src/core/ThreadPool.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double secondsSince(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    std::string escape(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    std::string number(double value) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.6g", value);
+        return text;
+    }
+
+    // Value of "key": in a line written by toJson()
+    std::string field(const std::string& line, const std::string& key) {
+        const std::string pattern = "\"" + key + "\": ";
+        size_t start = line.find(pattern);
+        if (start == std::string::npos) {
+            return {};
+        }
+        start += pattern.size();
+        if (line[start] == '"') {
+            return line.substr(start + 1, line.find('"', start + 1) - start - 1);
+        }
+        return line.substr(start, line.find_first_of(",}", start) - start);
+    }
+}
+
+void BenchmarkSuite::add(Benchmark benchmark) {
+    benchmarks.push_back(std::move(benchmark));
+}
+
+std::vector<BenchmarkResult> BenchmarkSuite::run(const BenchmarkOptions& options,
+                                                  const std::function<void(const BenchmarkResult&)>& onResult) {
+    std::vector<BenchmarkResult> results;
+    for (auto& benchmark : benchmarks) {
+        if (benchmark.name.find(options.filter) != std::string::npos) {
+            results.push_back(measure(benchmark, options));
+            if (onResult) {
+                onResult(results.back());
+            }
+        }
+    }
+    return results;
+}
+
+BenchmarkResult BenchmarkSuite::measure(Benchmark& benchmark, const BenchmarkOptions& options) {
+    if (benchmark.setup) {
+        benchmark.setup();
+    }
+
+    // Warm the caches and the thread pool, and find how long one run takes
+    uint64_t warmupRuns = 0;
+    auto start = Clock::now();
+    do {
+        benchmark.run();
+        warmupRuns++;
+    } while (secondsSince(start) < options.warmupTime);
+    const double secondsPerRun = secondsSince(start) / static_cast<double>(warmupRuns);
+    const auto batch = static_cast<uint64_t>(std::max(1.0, options.minTime / 100.0 / secondsPerRun));
+
+    std::vector<double> samples;
+    double measured = 0.0;
+    while (samples.size() < options.maxSamples && (samples.size() < options.minSamples || measured < options.minTime)) {
+        auto before = Clock::now();
+        for (uint64_t run = 0; run < batch; run++) {
+            benchmark.run();
+        }
+        const double elapsed = secondsSince(before);
+        measured += elapsed;
+        samples.push_back(elapsed * 1e9 / static_cast<double>(batch));
+    }
+
+    if (benchmark.teardown) {
+        benchmark.teardown();
+    }
+
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.itemName = benchmark.itemName;
+    result.itemsPerRun = benchmark.itemsPerRun;
+    result.runs = batch * samples.size();
+    result.samples = samples.size();
+    result.mean = measured * 1e9 / static_cast<double>(result.runs);
+
+    std::sort(samples.begin(), samples.end());
+    result.min = samples.front();
+    result.p50 = percentile(samples, 0.5);
+    result.p90 = percentile(samples, 0.9);
+    result.p99 = percentile(samples, 0.99);
+    result.max = samples.back();
+    result.itemsPerSecond = static_cast<double>(benchmark.itemsPerRun) * 1e9 / result.p50;
+    return result;
+}
+
+std::string BenchmarkSuite::toJson(const std::vector<BenchmarkResult>& results) {
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+#ifdef NDEBUG
+    const char* assertions = "false";
+#else
+    const char* assertions = "true";
+#endif
+
+    std::string json = "{\n";
+    json += "  \"context\": {\"date\": \"" + std::string(date) + "\", \"compiler\": \"" + escape(__VERSION__) +
+            "\", \"threads\": " + std::to_string(ThreadPool::global().getConcurrency()) +
+            ", \"assertions\": " + assertions + ", \"logCompiledLevel\": " + std::to_string(LOG_COMPILED_LEVEL) + "},\n";
+    json += "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& result = results[i];
+        json += "    {\"name\": \"" + escape(result.name) + "\", \"unit\": \"ns\", \"runs\": " + std::to_string(result.runs) +
+                ", \"samples\": " + std::to_string(result.samples) + ", \"mean\": " + number(result.mean) +
+                ", \"min\": " + number(result.min) + ", \"p50\": " + number(result.p50) +
+                ", \"p90\": " + number(result.p90) + ", \"p99\": " + number(result.p99) +
+                ", \"max\": " + number(result.max) + ", \"items\": " + std::to_string(result.itemsPerRun) +
+                ", \"itemName\": \"" + escape(result.itemName) + "\", \"itemsPerSecond\": " + number(result.itemsPerSecond) + "}" +
+                (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    json += "  ]\n}\n";
+    return json;
+}
+
+std::vector<std::pair<std::string, double>> BenchmarkSuite::readBaseline(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open baseline " + path);
+    }
+
+    std::vector<std::pair<std::string, double>> medians;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::string name = field(line, "name");
+        std::string median = field(line, "p50");
+        if (!name.empty() && !median.empty()) {
+            medians.emplace_back(std::move(name), std::stod(median));
+        }
+    }
+    return medians;
+}
@@ -0,0 +1,104 @@
+//
+// Created by raph on 30/01/25.
+//
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * One measured kernel. Only run() is timed: setup() is called once before the warmup and teardown() once after
+ * the last sample, both are optional
+ */
+struct Benchmark {
+    std::string name;                   // group/kernel, e.g. "scene/cull"
+    uint64_t itemsPerRun = 1;           // particles, stars, chunks... processed by one run()
+    std::string itemName = "items";
+    std::function<void()> run;
+    std::function<void()> setup = {};       // optional, before the warmup
+    std::function<void()> teardown = {};    // optional, after the last sample
+};
+
+/**
+ * Timings of one benchmark, in nanoseconds per run()
+ */
+struct BenchmarkResult {
+    std::string name;
+    std::string itemName;
+    uint64_t itemsPerRun = 0;
+    uint64_t runs = 0;                  // timed runs, over every sample
+    size_t samples = 0;
+
+    double mean = 0.0;
+    double min = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+
+    double itemsPerSecond = 0.0;        // at the median
+};
+
+struct BenchmarkOptions {
+    std::string filter;                 // only run the benchmarks whose name contains this
+    double minTime = 0.5;               // seconds measured per benchmark, after the warmup
+    double warmupTime = 0.05;           // seconds
+    size_t minSamples = 10;
+    size_t maxSamples = 1000;
+};
+
+/**
+ * Runs the registered benchmarks. Runs are timed in batches sized so a sample lasts about minTime / 100, which
+ * keeps the clock overhead out of short kernels while long ones still get one run per sample. Percentiles are
+ * over the samples.
+ */
+class BenchmarkSuite {
+public:
+    void add(Benchmark benchmark);
+
+    /**
+     * Measure every benchmark matching the filter, in the order they were added
+     * @param onResult called as soon as each benchmark is measured
+     */
+    std::vector<BenchmarkResult> run(const BenchmarkOptions& options,
+                                     const std::function<void(const BenchmarkResult&)>& onResult = {});
+
+    const std::vector<Benchmark>& getBenchmarks() const { return benchmarks; }
+
+    static BenchmarkResult measure(Benchmark& benchmark, const BenchmarkOptions& options);
+
+    /**
+     * Results and the build and machine they come from. Every benchmark is written on its own line, so
+     * readBaseline() does not need a JSON parser
+     */
+    static std::string toJson(const std::vector<BenchmarkResult>& results);
+
+    /**
+     * Median of every benchmark of a file written by toJson(), by name
+     */
+    static std::vector<std::pair<std::string, double>> readBaseline(const std::string& path);
+
+private:
+    std::vector<Benchmark> benchmarks;
+};
+
+/**
+ * Keep the compiler from removing a computation whose result is otherwise unused
+ */
+template<typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Every kernel group adds its benchmarks here
+void registerCoreBenchmarks(BenchmarkSuite& suite);
+void registerGalaxyBenchmarks(BenchmarkSuite& suite);
+void registerSimulationBenchmarks(BenchmarkSuite& suite);
+void registerSceneBenchmarks(BenchmarkSuite& suite);
+
+#endif //BENCHMARK_H
@@ -0,0 +1,41 @@
+//
+// Created by raph on 30/01/25.
+//
+
+#include "BenchmarkData.h"
+
+#include "../src/galaxy/Blackbody.h"
+#include "../src/galaxy/GalaxyGenerator.h"
+
+BenchmarkGalaxy makeBenchmarkGalaxy(uint32_t starCount, bool withParticles) {
+    GalaxyParameters parameters;
+    parameters.starCount = starCount;
+    GalaxyGenerator generator(parameters);
+    const auto& palette = Blackbody::Palette::get();
+    const float particleMass = generator.getParticleMass();
+
+    BenchmarkGalaxy galaxy;
+    galaxy.positions.resize(3 * size_t(starCount));
+    galaxy.appearance.resize(starCount);
+    if (withParticles) {
+        galaxy.particles.resize(starCount);
+    }
+
+    generator.generate([&](size_t i, const Star& star) {
+        galaxy.positions[3 * i] = star.position[0];
+        galaxy.positions[3 * i + 1] = star.position[1];
+        galaxy.positions[3 * i + 2] = star.position[2];
+        galaxy.appearance[i] = {palette.indexOf(star.temperature), StarPacking::encodeMagnitude(star.luminosity)};
+
+        if (withParticles) {
+            galaxy.particles.x[i] = star.position[0];
+            galaxy.particles.y[i] = star.position[1];
+            galaxy.particles.z[i] = star.position[2];
+            galaxy.particles.vx[i] = star.velocity[0];
+            galaxy.particles.vy[i] = star.velocity[1];
+            galaxy.particles.vz[i] = star.velocity[2];
+            galaxy.particles.mass[i] = particleMass;
+        }
+    });
+    return galaxy;
+}
@@ -0,0 +1,25 @@
+//
+// Created by raph on 30/01/25.
+//
+
+#ifndef BENCHMARKDATA_H
+#define BENCHMARKDATA_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../src/renderer/StarPacking.h"
+#include "../src/simulation/ParticleSet.h"
+
+/**
+ * Generated galaxy in the layouts the kernels take, built the same way as Application::initGalaxy
+ */
+struct BenchmarkGalaxy {
+    std::vector<float> positions;                       // interleaved xyz
+    std::vector<StarPacking::Appearance> appearance;
+    ParticleSet particles;                              // only filled when asked for
+};
+
+BenchmarkGalaxy makeBenchmarkGalaxy(uint32_t starCount, bool withParticles);
+
+#endif //BENCHMARKDATA_H
@@ -0,0 +1,120 @@
+//
+// Created by raph on 30/01/25.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "Benchmark.h"
+#include "../src/core/JobSystem.h"
+#include "../src/core/Logger.h"
+#include "../src/core/RadixSort.h"
+#include "../src/core/ThreadPool.h"
+#include "../src/galaxy/CounterRng.h"
+
+void registerCoreBenchmarks(BenchmarkSuite& suite) {
+    // Scheduling overhead of small ranges, the work itself is a sum
+    constexpr size_t RANGE_COUNT = 4096;
+    suite.add({
+        .name = "core/parallelFor",
+        .itemsPerRun = RANGE_COUNT,
+        .itemName = "ranges",
+        .run = [] {
+            std::atomic<uint64_t> sum{0};
+            ThreadPool::global().parallelFor(0, RANGE_COUNT * 64, 64, [&](size_t first, size_t last) {
+                uint64_t local = 0;
+                for (size_t i = first; i < last; i++) {
+                    local += i;
+                }
+                sum.fetch_add(local, std::memory_order_relaxed);
+            });
+            doNotOptimize(sum.load());
+        },
+    });
+
+    constexpr size_t SPAWN_COUNT = 1024;
+    suite.add({
+        .name = "core/spawn",
+        .itemsPerRun = SPAWN_COUNT,
+        .itemName = "jobs",
+        .run = [] {
+            JobSystem& jobs = JobSystem::global();
+            std::atomic<size_t> ran{0};
+            JobSystem::Job* root = jobs.create([] {});
+            for (size_t i = 0; i < SPAWN_COUNT; i++) {
+                jobs.submit(jobs.create([&ran] { ran.fetch_add(1, std::memory_order_relaxed); }, root));
+            }
+            jobs.submit(root);
+            jobs.wait(root);
+            doNotOptimize(ran.load());
+        },
+    });
+
+    // Random 64 bit keys with 32 bit values, the copy of the unsorted input is part of every run
+    constexpr size_t SORT_COUNT = 1'048'576;
+    struct SortState {
+        RadixSorter sorter;
+        std::vector<uint64_t> input;
+        std::vector<uint64_t> keys;
+        std::vector<uint32_t> values;
+    };
+    auto sort = std::make_shared<SortState>();
+    suite.add({
+        .name = "core/radixSort",
+        .itemsPerRun = SORT_COUNT,
+        .itemName = "keys",
+        .run = [sort] {
+            std::copy(sort->input.begin(), sort->input.end(), sort->keys.begin());
+            for (uint32_t i = 0; i < SORT_COUNT; i++) {
+                sort->values[i] = i;
+            }
+            sort->sorter.sort(sort->keys.data(), sort->values.data(), SORT_COUNT);
+            doNotOptimize(sort->values.data());
+        },
+        .setup = [sort] {
+            sort->input.resize(SORT_COUNT);
+            for (size_t i = 0; i < SORT_COUNT; i++) {
+                CounterRng rng(11, i);
+                sort->input[i] = (uint64_t(rng.nextUInt()) << 32) | rng.nextUInt();
+            }
+            sort->keys.resize(SORT_COUNT);
+            sort->values.resize(SORT_COUNT);
+        },
+        .teardown = [sort] { *sort = {}; },
+    });
+
+    // Cost of a log call on the calling thread. Records go to a binary log so the console stays readable
+    struct LogState {
+        Logger logger{"BenchLog"};
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "VulkanGalaxyBench.vglog";
+        uint64_t frame = 0;
+    };
+    auto log = std::make_shared<LogState>();
+    auto openLog = [log] { Logger::openBinaryLog(log->path.string()); };
+    auto closeLog = [log] {
+        Logger::closeBinaryLog();
+        std::filesystem::remove(log->path);
+    };
+
+    suite.add({
+        .name = "core/logFormat",
+        .itemName = "records",
+        .run = [log] {
+            LOG_INFO(log->logger, "Uploaded chunk positions for frame {}, blend factor {:.2}", log->frame++, 0.5f);
+        },
+        .setup = openLog,
+        .teardown = closeLog,
+    });
+
+    // Below the default DEBUG level of the logger
+    suite.add({
+        .name = "core/logFiltered",
+        .itemName = "records",
+        .run = [log] {
+            LOG_TRACE(log->logger, "Uploaded chunk positions for frame {}, blend factor {:.2}", log->frame++, 0.5f);
+        },
+    });
+}
@@ -0,0 +1,78 @@
+//
+// Created by raph on 30/01/25.
+//
+
+#include <vector>
+
+#include "Benchmark.h"
+#include "../src/galaxy/Blackbody.h"
+#include "../src/galaxy/CounterRng.h"
+#include "../src/galaxy/GalaxyGenerator.h"
+
+void registerGalaxyBenchmarks(BenchmarkSuite& suite) {
+    constexpr uint32_t STAR_COUNT = 262'144;
+
+    suite.add({
+        .name = "galaxy/philox",
+        .itemsPerRun = 4096,
+        .itemName = "blocks",
+        .run = [] {
+            uint32_t hash = 0;
+            for (uint32_t i = 0; i < 4096; i++) {
+                hash ^= CounterRng::philox({i, 0, 0, 0}, {0x1234u, 0x5678u})[0];
+            }
+            doNotOptimize(hash);
+        },
+    });
+
+    // One star at a time on the calling thread, then the whole galaxy over the thread pool
+    suite.add({
+        .name = "galaxy/generateStar",
+        .itemsPerRun = 4096,
+        .itemName = "stars",
+        .run = [generator = GalaxyGenerator(GalaxyParameters())] {
+            float sum = 0.0f;
+            for (uint64_t i = 0; i < 4096; i++) {
+                sum += generator.generateStar(i).luminosity;
+            }
+            doNotOptimize(sum);
+        },
+    });
+
+    suite.add({
+        .name = "galaxy/generate",
+        .itemsPerRun = STAR_COUNT,
+        .itemName = "stars",
+        .run = [generator = GalaxyGenerator(GalaxyParameters{.starCount = STAR_COUNT})] {
+            std::vector<float> luminosity(STAR_COUNT);
+            generator.generate([&](size_t i, const Star& star) {
+                luminosity[i] = star.luminosity;
+            });
+            doNotOptimize(luminosity.data());
+        },
+    });
+
+    suite.add({
+        .name = "galaxy/paletteIndex",
+        .itemsPerRun = 4096,
+        .itemName = "lookups",
+        .run = [] {
+            const auto& palette = Blackbody::Palette::get();
+            uint32_t sum = 0;
+            for (uint32_t i = 0; i < 4096; i++) {
+                sum += palette.indexOf(1000.0f + 9.5f * static_cast<float>(i));
+            }
+            doNotOptimize(sum);
+        },
+    });
+
+    suite.add({
+        .name = "galaxy/blackbodyColor",
+        .itemsPerRun = 1,
+        .itemName = "colors",
+        .run = [temperature = 3000.0] () mutable {
+            temperature = temperature < 30000.0 ? temperature + 7.0 : 3000.0;
+            doNotOptimize(Blackbody::computeColor(temperature));
+        },
+    });
+}
@@ -0,0 +1,151 @@
+//
+// Created by raph on 30/01/25.
+//
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Benchmark.h"
+#include "BenchmarkData.h"
+#include "../src/galaxy/CounterRng.h"
+#include "../src/renderer/StarPacking.h"
+#include "../src/scene/DepthSorter.h"
+#include "../src/scene/FrustumCuller.h"
+#include "../src/scene/StarScene.h"
+
+namespace {
+    constexpr size_t CHUNK_COUNT = 1'000'000;
+    constexpr uint32_t STAR_COUNT = 1'048'576;
+
+    // Looking at the whole disk from above and to the side, like the default camera
+    const glm::vec3 OVERVIEW_EYE(0.0f, -25.0f, 25.0f);
+
+    glm::mat4 overviewViewProjection() {
+        glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.01f, 100.0f);
+        return projection * glm::lookAtRH(OVERVIEW_EYE, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+}
+
+void registerSceneBenchmarks(BenchmarkSuite& suite) {
+    // Same synthetic chunks as CullBenchmark
+    struct CullState {
+        ChunkBounds bounds;
+        FrustumCuller culler;
+        std::vector<uint32_t> visible;
+    };
+    auto cull = std::make_shared<CullState>();
+    suite.add({
+        .name = "scene/cull",
+        .itemsPerRun = CHUNK_COUNT,
+        .itemName = "chunks",
+        .run = [cull] {
+            cull->culler.cull(Frustum::fromViewProjection(overviewViewProjection()), cull->bounds, cull->visible);
+        },
+        .setup = [cull] {
+            cull->bounds.resize(CHUNK_COUNT);
+            for (size_t i = 0; i < CHUNK_COUNT; i++) {
+                CounterRng rng(7, i);
+                float x = 30.0f * rng.nextFloat() - 15.0f;
+                float y = 30.0f * rng.nextFloat() - 15.0f;
+                float z = 0.6f * rng.nextFloat() - 0.3f;
+                float halfSize = 0.05f + 0.2f * rng.nextFloat();
+                cull->bounds.set(i, {x - halfSize, y - halfSize, z - 0.5f * halfSize},
+                                 {x + halfSize, y + halfSize, z + 0.5f * halfSize});
+            }
+        },
+        .teardown = [cull] { *cull = {}; },
+    });
+
+    // A million star galaxy, packed and organized the way the renderer does it
+    struct StarState {
+        BenchmarkGalaxy galaxy;
+        std::unique_ptr<StarScene> scene;
+        std::vector<StarPacking::PackedStar> packed;
+    };
+    auto stars = std::make_shared<StarState>();
+    auto setupStars = [stars] {
+        stars->galaxy = makeBenchmarkGalaxy(STAR_COUNT, false);
+        stars->scene = std::make_unique<StarScene>(STAR_COUNT);
+        stars->scene->build(stars->galaxy.positions.data(), stars->galaxy.appearance.data());
+    };
+    auto teardownStars = [stars] { *stars = {}; };
+
+    suite.add({
+        .name = "scene/pack",
+        .itemsPerRun = STAR_COUNT,
+        .itemName = "stars",
+        .run = [stars] {
+            const auto& galaxy = stars->galaxy;
+            for (size_t first = 0; first < STAR_COUNT; first += StarPacking::CHUNK_SIZE) {
+                const size_t count = std::min<size_t>(StarPacking::CHUNK_SIZE, STAR_COUNT - first);
+                const float* positions = galaxy.positions.data() + 3 * first;
+                StarPacking::packChunk(StarPacking::computeFrame(positions, count), positions,
+                                       galaxy.appearance.data() + first, count, stars->packed.data() + first);
+            }
+            doNotOptimize(stars->packed.data());
+        },
+        .setup = [stars, setupStars] {
+            setupStars();
+            stars->packed.resize(STAR_COUNT);
+        },
+        .teardown = teardownStars,
+    });
+
+    suite.add({
+        .name = "scene/build",
+        .itemsPerRun = STAR_COUNT,
+        .itemName = "stars",
+        .run = [stars] { stars->scene->build(stars->galaxy.positions.data(), stars->galaxy.appearance.data()); },
+        .setup = setupStars,
+        .teardown = teardownStars,
+    });
+
+    suite.add({
+        .name = "scene/update",
+        .itemsPerRun = STAR_COUNT,
+        .itemName = "stars",
+        .run = [stars] { stars->scene->update(stars->galaxy.positions.data()); },
+        .setup = setupStars,
+        .teardown = teardownStars,
+    });
+
+    suite.add({
+        .name = "scene/select",
+        .itemsPerRun = StarPacking::chunkCount(STAR_COUNT),
+        .itemName = "chunks",
+        .run = [stars] { doNotOptimize(stars->scene->select(overviewViewProjection(), OVERVIEW_EYE, 1080.0f).size()); },
+        .setup = setupStars,
+        .teardown = teardownStars,
+    });
+
+    // Back to front order of every star, the worst case of a selection
+    struct SortState {
+        std::unique_ptr<DepthSorter> sorter;
+        std::vector<StarDrawRange> ranges;
+    };
+    auto sort = std::make_shared<SortState>();
+    suite.add({
+        .name = "scene/depthSort",
+        .itemsPerRun = STAR_COUNT,
+        .itemName = "stars",
+        .run = [sort] {
+            sort->sorter->sort(sort->ranges, glm::vec3(0.0f, -25.0f, 25.0f));
+            doNotOptimize(sort->sorter->getIndices().data());
+        },
+        .setup = [stars, sort, setupStars] {
+            setupStars();
+            sort->sorter = std::make_unique<DepthSorter>(*stars->scene);
+            for (uint32_t chunk = 0; chunk < stars->scene->getChunkCount(); chunk++) {
+                const uint32_t firstPoint = stars->scene->getChunkFirstPoint(chunk);
+                const uint32_t starCount = stars->scene->getChunkStarCount(chunk);
+                sort->ranges.push_back({chunk, firstPoint, starCount, {firstPoint + starCount - 1, 1, 1}});
+            }
+        },
+        .teardown = [sort, teardownStars] {
+            *sort = {};
+            teardownStars();
+        },
+    });
+}
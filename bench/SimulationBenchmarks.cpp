@@ -0,0 +1,91 @@
+//
+// Created by raph on 30/01/25.
+//
+
+#include <memory>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkData.h"
+#include "../src/simulation/BlockTimestepIntegrator.h"
+#include "../src/simulation/DirectSummationSolver.h"
+#include "../src/simulation/FFT.h"
+#include "../src/simulation/GravityValidation.h"
+#include "../src/simulation/PMSolver.h"
+
+void registerSimulationBenchmarks(BenchmarkSuite& suite) {
+    // Heavy state is only built for the benchmarks that run, and released right after them
+    struct FFTState {
+        FFT3D fft{64};
+        std::vector<FFT3D::Complex> grid;
+    };
+    auto fft = std::make_shared<FFTState>();
+    suite.add({
+        .name = "simulation/fft64",
+        .itemsPerRun = 64 * 64 * 64,
+        .itemName = "cells",
+        .run = [fft] {
+            fft->fft.forward(fft->grid.data());
+            fft->fft.inverse(fft->grid.data());
+        },
+        .setup = [fft] {
+            fft->grid.assign(fft->fft.getCellCount(), {});
+            fft->grid[0] = 1.0f;
+        },
+        .teardown = [fft] { fft->grid = {}; },
+    });
+
+    constexpr size_t DIRECT_COUNT = 2048;
+    auto direct = std::make_shared<ParticleSet>();
+    suite.add({
+        .name = "simulation/directSummation",
+        .itemsPerRun = DIRECT_COUNT * DIRECT_COUNT,
+        .itemName = "interactions",
+        .run = [direct] {
+            DirectSummationSolver solver(0.05f);
+            solver.computeAccelerations(*direct);
+        },
+        .setup = [direct] { *direct = GravityValidation::makePlummerSphere(DIRECT_COUNT, 1.0f, 1e10f, 3); },
+        .teardown = [direct] { *direct = {}; },
+    });
+
+    // Disk galaxy under the default isolated 64^3 mesh, as run by the application
+    constexpr uint32_t PM_COUNT = 262'144;
+    struct PMState {
+        ParticleSet particles;
+        std::unique_ptr<PMSolver> solver;
+        std::unique_ptr<BlockTimestepIntegrator> integrator;
+    };
+    auto pm = std::make_shared<PMState>();
+    auto setupPM = [pm] {
+        pm->particles = makeBenchmarkGalaxy(PM_COUNT, true).particles;
+        pm->solver = std::make_unique<PMSolver>(PMSolverConfig{.softening = 0.05f});
+    };
+    auto teardownPM = [pm] {
+        pm->integrator.reset();
+        pm->solver.reset();
+        pm->particles = {};
+    };
+
+    suite.add({
+        .name = "simulation/pmSolve",
+        .itemsPerRun = PM_COUNT,
+        .itemName = "particles",
+        .run = [pm] { pm->solver->computeAccelerations(pm->particles); },
+        .setup = setupPM,
+        .teardown = teardownPM,
+    });
+
+    suite.add({
+        .name = "simulation/substep",
+        .itemsPerRun = PM_COUNT,
+        .itemName = "particles",
+        .run = [pm] { pm->integrator->substep(pm->particles); },
+        .setup = [pm, setupPM] {
+            setupPM();
+            pm->integrator = std::make_unique<BlockTimestepIntegrator>(*pm->solver, BlockTimestepConfig());
+            pm->integrator->initialize(pm->particles);
+        },
+        .teardown = teardownPM,
+    });
+}
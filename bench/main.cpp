@@ -0,0 +1,137 @@
+//
+// Created by raph on 30/01/25.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "../src/core/Logger.h"
+
+namespace {
+    void printUsage() {
+        std::cerr << "Usage: VulkanGalaxyBench [--filter text] [--min-time seconds] [--json path|-] "
+                     "[--baseline path] [--tolerance fraction] [--list]" << std::endl;
+    }
+
+    std::string formatCount(double value) {
+        const char* suffixes[] = {"", " k", " M", " G"};
+        size_t suffix = 0;
+        while (value >= 1000.0 && suffix < 3) {
+            value /= 1000.0;
+            suffix++;
+        }
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.2f%s", value, suffixes[suffix]);
+        return text;
+    }
+
+    std::string formatTime(double nanoseconds) {
+        char text[32];
+        if (nanoseconds < 1e3) {
+            std::snprintf(text, sizeof(text), "%.1f ns", nanoseconds);
+        } else if (nanoseconds < 1e6) {
+            std::snprintf(text, sizeof(text), "%.2f us", nanoseconds / 1e3);
+        } else {
+            std::snprintf(text, sizeof(text), "%.2f ms", nanoseconds / 1e6);
+        }
+        return text;
+    }
+}
+
+/**
+ * Benchmarks of the CPU kernels: job system, logging, galaxy generation, gravity, packing and culling. Needs
+ * neither a GPU nor a window, so it runs on CI machines.
+ * Usage: VulkanGalaxyBench [--filter text] [--min-time seconds] [--json path|-] [--baseline path] [--tolerance fraction] [--list]
+ * With --baseline, returns a non zero exit code when a median got slower than the baseline one by more than the
+ * tolerance (0.15 by default).
+ */
+int main(int argc, char** argv) {
+    Logger logger("Bench");
+
+    try {
+        BenchmarkOptions options;
+        std::string jsonPath;
+        std::string baselinePath;
+        double tolerance = 0.15;
+        bool list = false;
+
+        for (int i = 1; i < argc; i++) {
+            const std::string argument = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (argument == "--filter" && hasValue) {
+                options.filter = argv[++i];
+            } else if (argument == "--min-time" && hasValue) {
+                options.minTime = std::stod(argv[++i]);
+            } else if (argument == "--json" && hasValue) {
+                jsonPath = argv[++i];
+            } else if (argument == "--baseline" && hasValue) {
+                baselinePath = argv[++i];
+            } else if (argument == "--tolerance" && hasValue) {
+                tolerance = std::stod(argv[++i]);
+            } else if (argument == "--list") {
+                list = true;
+            } else {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        }
+
+        BenchmarkSuite suite;
+        registerCoreBenchmarks(suite);
+        registerGalaxyBenchmarks(suite);
+        registerSimulationBenchmarks(suite);
+        registerSceneBenchmarks(suite);
+
+        if (list) {
+            for (const auto& benchmark : suite.getBenchmarks()) {
+                std::cout << benchmark.name << std::endl;
+            }
+            return EXIT_SUCCESS;
+        }
+
+        std::vector<BenchmarkResult> results = suite.run(options, [&](const BenchmarkResult& result) {
+            logger.info(result.name + ": median " + formatTime(result.p50) + ", p90 " + formatTime(result.p90) +
+                        ", p99 " + formatTime(result.p99) + " (" + formatCount(result.itemsPerSecond) + " " +
+                        result.itemName + "/s, " + std::to_string(result.runs) + " runs)");
+        });
+
+        if (!jsonPath.empty()) {
+            const std::string json = BenchmarkSuite::toJson(results);
+            if (jsonPath == "-") {
+                Logger::flush();
+                std::cout << json;
+            } else {
+                std::ofstream file(jsonPath);
+                if (!(file << json)) {
+                    throw std::runtime_error("Failed to write " + jsonPath);
+                }
+            }
+        }
+
+        bool success = true;
+        if (!baselinePath.empty()) {
+            for (const auto& [name, baseline] : BenchmarkSuite::readBaseline(baselinePath)) {
+                for (const auto& result : results) {
+                    if (result.name == name && result.p50 > baseline * (1.0 + tolerance)) {
+                        success = false;
+                        logger.error(name + " regressed: median " + formatTime(result.p50) + " against " +
+                                     formatTime(baseline) + " in the baseline");
+                    }
+                }
+            }
+        }
+        Logger::flush();
+
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
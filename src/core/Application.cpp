@@ -4,10 +4,50 @@
 
 #include "Application.h"
 #include "../renderer/VulkanContext.h"
+#include <algorithm>
 #include <chrono>
-
+#include <cmath>
+#include <filesystem>
+#include <limits>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Camera.h"
+#include "CameraScript.h"
+#include "ThreadPool.h"
+#include "../galaxy/Snapshot.h"
+#include "../renderer/FrameUniforms.h"
+#include "../renderer/GpuTimer.h"
 #include "../renderer/PipelineManager.h"
+#include "../renderer/StarDepthSort.h"
+#include "../renderer/StarField.h"
+#include "../renderer/StarPalette.h"
+#include "../renderer/StarSplat.h"
+#include "../renderer/GalaxyVolume.h"
+#include "../renderer/FarFieldCache.h"
 #include "../renderer/Synchronization.h"
+#include "../renderer/Tonemap.h"
+#include "../renderer/VertexStreams.h"
+#include "../scene/StarScene.h"
+#include "../simulation/SimulationThread.h"
+
+namespace {
+    void setViewport(VkCommandBuffer commandBuffer, VkExtent2D extent) {
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+        VkRect2D scissor{};
+        scissor.offset = {0, 0};
+        scissor.extent = extent;
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    }
+}
 
 Application::Application(const ApplicationConfig& config)
     : config(config)
@@ -22,45 +62,32 @@ Application::~Application() {
 }
 
 void Application::init() {
+    if (!config.binaryLogPath.empty()) {
+        Logger::openBinaryLog(config.binaryLogPath);
+    }
     logger.info("Initializing application");
 
     initWindow();
     initVulkan();
-    initCamera();
 
     synchronization = std::make_unique<Synchronization>(*vulkanContext, config.maxFramesInFlight);
     currentFrame = 0;
 
-    const std::vector<Vertex> vertices = {
-        {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
-        {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
-        {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}},
-        {{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}}
-    };
-    const std::vector<uint16_t> indices = {
-        0, 1, 2, 2, 3, 0
-    };
-
-    VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-
-    // init vertex buffer
-    vertexBuffer = std::make_unique<Buffer>(
-        *vulkanContext,
-        bufferSize,
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-    );
-    vertexBuffer->copyFrom(vertices.data(), bufferSize);
-
-    VkDeviceSize indexBufferSize = sizeof(indices[0]) * indices.size();
-    indexBuffer = std::make_unique<Buffer>(
-        *vulkanContext,
-        indexBufferSize,
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-    );
+    if (config.simulation.enabled && config.playback.directory.empty()) {
+        simulation = std::make_unique<Simulation>(config.simulation);
+    }
 
-    indexBuffer->copyFrom(indices.data(), indexBufferSize);
+    initGalaxy();
+    initCamera();
+
+    // Everything the galaxy needs is allocated by now
+    vulkanContext->getMemoryTracker().update(frameNumber);
+    logger.info(vulkanContext->getMemoryTracker().describe());
+
+    // From here on the simulation belongs to its thread
+    if (simulation && simulation->hasParticles()) {
+        simulationThread = std::make_unique<SimulationThread>(*simulation);
+    }
 
     // Set up window callbacks
     window->setResizeCallback([](GLFWwindow* window, int width, int height) {
@@ -103,48 +130,627 @@ void Application::initVulkan() {
 
     pipelineManager = std::make_unique<PipelineManager>(*vulkanContext);
 
-    auto basicConfig = PipelineManager::getDefaultConfig();
-    basicConfig.bindingDescriptions = {Vertex::getBindingDescription()};
-    auto attributes = Vertex::getAttributeDescriptions();
-    basicConfig.attributeDescriptions = std::vector<VkVertexInputAttributeDescription>(attributes.begin(), attributes.end());
+    starPalette = std::make_unique<StarPalette>(*vulkanContext);
+    frameUniforms = std::make_unique<FrameUniforms>(*vulkanContext, config.maxFramesInFlight);
+    gpuTimer = std::make_unique<GpuTimer>(*vulkanContext, config.maxFramesInFlight);
+
+    if (config.bloom.enabled) {
+        bloom = std::make_unique<Bloom>(*vulkanContext, config.bloom);
+    }
+    tonemap = std::make_unique<Tonemap>(*vulkanContext);
+    buildRenderGraph();
+
+    auto tonemapConfig = PipelineManager::getFullscreenConfig();
+    renderGraph->configurePipeline("tonemap", tonemapConfig);
+    tonemapConfig.descriptorSetLayouts = {tonemap->getDescriptorSetLayout()};
+    tonemapConfig.pushConstantRanges = {{VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(TonemapPushConstants)}};
 
     pipelineManager->createPipeline(
-        "basic",
-        "shaders/shader.vert.spv",
-        "shaders/shader.frag.spv",
-        basicConfig
+        "tonemap",
+        "shaders/fullscreen.vert.spv",
+        "shaders/tonemap.frag.spv",
+        tonemapConfig
     );
+
+    // Stars are added into the HDR target
+    auto starConfig = PipelineManager::getParticleConfig();
+    renderGraph->configurePipeline("stars", starConfig);
+    starConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+    starConfig.descriptorSetLayouts = {starPalette->getDescriptorSetLayout(), frameUniforms->getDescriptorSetLayout()};
+    starConfig.pushConstantRanges = {{VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(StarPushConstants)}};
+
+    // Pulled vertices are read straight from the star and keyframe buffers, bound as a third set. Sprites are
+    // always pulled, that is how one record serves every corner
+    const bool playbackEnabled = !config.playback.directory.empty();
+    starSprites = chooseStarSprites();
+    const bool pullVertices = config.vertexPulling || starSprites != StarSprites::Pixels;
+    if (pullVertices) {
+        starStreams = std::make_unique<VertexStreams>(*vulkanContext, playbackEnabled ? StarVertex::PULLED_PLAYBACK_STREAMS : 1);
+        starConfig.vertexInput = VertexInput::Pulling;
+        starConfig.descriptorSetLayouts.push_back(starStreams->getDescriptorSetLayout());
+    }
+
+    auto playbackConfig = starConfig;
+    if (!pullVertices) {
+        auto bindings = StarVertex::getBindingDescriptions();
+        starConfig.bindingDescriptions = std::vector<VkVertexInputBindingDescription>(bindings.begin(), bindings.end());
+        auto attributes = StarVertex::getAttributeDescriptions();
+        starConfig.attributeDescriptions = std::vector<VkVertexInputAttributeDescription>(attributes.begin(), attributes.end());
+
+        auto playbackBindings = StarVertex::getPlaybackBindingDescriptions();
+        playbackConfig.bindingDescriptions = std::vector<VkVertexInputBindingDescription>(playbackBindings.begin(), playbackBindings.end());
+        auto playbackAttributes = StarVertex::getPlaybackAttributeDescriptions();
+        playbackConfig.attributeDescriptions = std::vector<VkVertexInputAttributeDescription>(playbackAttributes.begin(), playbackAttributes.end());
+    }
+
+    const char* starVertexShader = pullVertices ? "shaders/stars_pulled.vert.spv" : "shaders/stars.vert.spv";
+    const char* starFragmentShader = "shaders/stars.frag.spv";
+    if (starSprites != StarSprites::Pixels) {
+        starConfig.pushConstantRanges = {{VK_SHADER_STAGE_VERTEX_BIT, 0,
+                                          sizeof(StarPushConstants) + sizeof(StarSpritePushConstants)}};
+    }
+    if (starSprites == StarSprites::Quads) {
+        starConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        starVertexShader = "shaders/stars_sprite.vert.spv";
+        starFragmentShader = "shaders/stars_sprite.frag.spv";
+    } else if (starSprites == StarSprites::Points) {
+        starVertexShader = "shaders/stars_point_sprite.vert.spv";
+        starFragmentShader = "shaders/stars_point_sprite.frag.spv";
+    }
+
+    pipelineManager->createPipeline(
+        "stars",
+        starVertexShader,
+        starFragmentShader,
+        starConfig
+    );
+
+    if (playbackEnabled) {
+        playbackConfig.pushConstantRanges = {{VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(StarPlaybackPushConstants)}};
+
+        pipelineManager->createPipeline(
+            "stars_playback",
+            pullVertices ? "shaders/stars_playback_pulled.vert.spv" : "shaders/stars_playback.vert.spv",
+            "shaders/stars.frag.spv",
+            playbackConfig
+        );
+    }
+}
+
+StarSprites Application::chooseStarSprites() {
+    StarSprites sprites = config.sprites.mode;
+    if (!config.playback.directory.empty() && sprites != StarSprites::Pixels) {
+        logger.info("Snapshot playback draws its stars as pixels");
+    }
+
+    // Sorted ranges index whole stars, there is no room for the corners of a quad
+    if (sprites == StarSprites::Quads && config.depthSort.enabled) {
+        logger.warning("Sorted stars cannot be expanded into quads, drawing them as sized points");
+        sprites = StarSprites::Points;
+    }
+    if (sprites == StarSprites::Points && vulkanContext->getMaxPointSize() <= 1.0f) {
+        if (config.depthSort.enabled) {
+            logger.warning("The device has no large points, sorted stars are drawn as pixels");
+            return StarSprites::Pixels;
+        }
+        logger.warning("The device has no large points, expanding the star sprites into quads");
+        sprites = StarSprites::Quads;
+    }
+    return sprites;
+}
+
+void Application::buildRenderGraph() {
+    auto& swapChain = vulkanContext->getSwapChain();
+    renderGraph = std::make_unique<RenderGraph>(*vulkanContext, config.dynamicRendering);
+
+    swapChainImage = renderGraph->importImage("swapchain", {swapChain.getImageFormat(), VK_IMAGE_LAYOUT_UNDEFINED,
+                                                            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                                            VK_IMAGE_LAYOUT_PRESENT_SRC_KHR});
+    const VkFormat hdrFormat = Tonemap::chooseFormat(*vulkanContext, config.hdr);
+    hdrColor = renderGraph->createImage("hdr", {hdrFormat});
+
+    // The galaxy seen from outside is raymarched at a fraction of the resolution, then upsampled by the stars pass
+    const bool marchVolume = config.volume.enabled && config.playback.directory.empty();
+    if (marchVolume) {
+        volumeTarget = renderGraph->createImage("volume", {GalaxyVolume::TARGET_FORMAT, config.volume.scale});
+        renderGraph->addComputePass("volume", [this](VkCommandBuffer commandBuffer) {
+            if (volume && volumeActive) {
+                volume->march(commandBuffer);
+            }
+        }).storage(volumeTarget, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    }
+
+    // Distant stars are drawn into an image kept across frames, and only when it is stale: the other frames skip the
+    // pass, so they neither load nor store the image
+    const bool cacheFarField = config.farField.enabled && config.playback.directory.empty() && !config.depthSort.enabled;
+    if (cacheFarField) {
+        farFieldImage = renderGraph->importImage("far field", FarFieldCache::getImportInfo(hdrFormat));
+        renderGraph->addGraphicsPass("far field", [this](VkCommandBuffer commandBuffer) {
+            drawFarField(commandBuffer);
+        }).colorAttachment(farFieldImage).enableIf([this] {
+            return farField && !volumeActive && farField->isRefreshing() && pipelineManager->hasPipeline("stars");
+        });
+    }
+
+    // Stars are added into the HDR target
+    auto& starsPass = renderGraph->addGraphicsPass("stars", [this](VkCommandBuffer commandBuffer) {
+        setViewport(commandBuffer, renderGraph->getExtent());
+        drawStars(commandBuffer);
+    });
+    if (marchVolume) {
+        starsPass.sampled(volumeTarget, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    }
+    if (cacheFarField) {
+        starsPass.sampled(farFieldImage, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    }
+    starsPass.colorAttachment(hdrColor);
+
+    if (bloom) {
+        bloomChain = renderGraph->createImage("bloom", {Bloom::FORMAT, 0.5f, Bloom::LEVELS});
+        renderGraph->addComputePass("bloom", [this](VkCommandBuffer commandBuffer) {
+            bloom->record(commandBuffer);
+        }).sampled(hdrColor, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT)
+          .storage(bloomChain, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    }
+
+    // Tonemap into the swap chain image
+    auto& tonemapPass = renderGraph->addGraphicsPass("tonemap", [this](VkCommandBuffer commandBuffer) {
+        setViewport(commandBuffer, renderGraph->getExtent());
+        tonemap->draw(commandBuffer, *pipelineManager->getPipeline("tonemap"), config.hdr.exposure, config.bloom.intensity);
+    });
+    tonemapPass.sampled(hdrColor, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    if (bloom) {
+        tonemapPass.sampled(bloomChain, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    }
+    tonemapPass.colorAttachment(swapChainImage);
+
+    renderGraph->compile(swapChain.getExtent());
+    updateRenderGraphImages();
+}
+
+void Application::updateRenderGraphImages() {
+    if (volume) {
+        volume->setTarget(renderGraph->getImage(volumeTarget));
+    }
+    if (bloom) {
+        bloom->update(renderGraph->getImage(hdrColor), renderGraph->getImage(bloomChain));
+    }
+    tonemap->update(renderGraph->getImage(hdrColor), bloom ? &renderGraph->getImage(bloomChain) : nullptr);
+}
+
+void Application::drawStars(VkCommandBuffer commandBuffer) {
+    const char* starPipeline = playback ? "stars_playback" : "stars";
+    if (!(starField || playback) || !pipelineManager->hasPipeline(starPipeline)) {
+        return;
+    }
+    auto* pipeline = pipelineManager->getPipeline(starPipeline);
+    pipeline->bind(commandBuffer);
+    starPalette->bind(commandBuffer, pipeline->getLayout());
+    frameUniforms->bind(commandBuffer, pipeline->getLayout(), currentFrame);
+
+    if (playback) {
+        playback->draw(commandBuffer, *pipeline);
+        return;
+    }
+
+    if (volumeActive) {
+        volume->composite(commandBuffer, *pipelineManager->getPipeline("galaxy_volume"));
+        return;
+    }
+
+    pushStarSprites(commandBuffer, *pipeline);
+
+    if (depthSort) {
+        depthSort->bindIndices(commandBuffer, currentFrame);
+        starField->draw(commandBuffer, *pipeline, depthSort->getRanges());
+    } else if (visibleRanges) {
+        const uint32_t verticesPerStar = starSprites == StarSprites::Quads ? StarVertex::SPRITE_VERTICES : 1;
+        starField->draw(commandBuffer, *pipeline, *visibleRanges, verticesPerStar);
+    }
+
+    if (starSplat) {
+        starSplat->composite(commandBuffer, *pipelineManager->getPipeline("star_splat"));
+    }
+    if (farField) {
+        farField->composite(commandBuffer, *pipelineManager->getPipeline("far_field"));
+    }
+}
+
+void Application::drawFarField(VkCommandBuffer commandBuffer) {
+    setViewport(commandBuffer, farField->getImage().getExtent());
+
+    // The stars pipeline with the camera of the cache
+    auto* pipeline = pipelineManager->getPipeline("stars");
+    pipeline->bind(commandBuffer);
+    starPalette->bind(commandBuffer, pipeline->getLayout());
+    farField->begin(commandBuffer, *pipeline, currentFrame);
+    pushStarSprites(commandBuffer, *pipeline);
+
+    const uint32_t verticesPerStar = starSprites == StarSprites::Quads ? StarVertex::SPRITE_VERTICES : 1;
+    starField->draw(commandBuffer, *pipeline, farField->getFarRanges(), verticesPerStar);
+}
+
+StarSpritePushConstants Application::getStarSprites() const {
+    if (starSprites == StarSprites::Pixels) {
+        return {0.0f, 0.0f, 0.0f, 0.0f};
+    }
+    StarSpritePushConstants sprite{config.sprites.radius, config.sprites.minPixels, config.sprites.maxPixels, 0.0f};
+    if (starSprites == StarSprites::Points) {
+        // Points are clamped to the device range, a smaller max keeps the sprites round
+        sprite.maxPixels = std::min(sprite.maxPixels, 0.5f * vulkanContext->getMaxPointSize());
+    }
+    return sprite;
+}
+
+void Application::pushStarSprites(VkCommandBuffer commandBuffer, const Pipeline& pipeline) const {
+    if (starSprites == StarSprites::Pixels) {
+        return;
+    }
+    const StarSpritePushConstants sprite = getStarSprites();
+    vkCmdPushConstants(commandBuffer, pipeline.getLayout(), VK_SHADER_STAGE_VERTEX_BIT, sizeof(StarPushConstants),
+                       sizeof(sprite), &sprite);
+}
+
+void Application::initGalaxy() {
+    if (!config.playback.directory.empty()) {
+        // Framing comes from the first snapshot, positions are streamed
+        playback = std::make_unique<SnapshotPlayback>(*vulkanContext, config.playback, config.maxFramesInFlight,
+                                                      starStreams.get());
+        const Snapshot::Metadata metadata = SnapshotFile(playback->getSeries().getPath(0)).getMetadata();
+        galaxyRadius = metadata.radius > 0.0f ? metadata.radius : GalaxyGenerator(config.galaxy).getRadius();
+        galaxySeed = metadata.seed;
+    } else if (!config.snapshotPath.empty()) {
+        loadSnapshot(config.snapshotPath);
+    } else {
+        generateGalaxy();
+    }
+
+    if (scene && config.depthSort.enabled) {
+        depthSort = std::make_unique<StarDepthSort>(*vulkanContext, *scene, config.maxFramesInFlight, config.depthSort);
+    }
+    if (starField && config.splat.enabled) {
+        initStarSplat();
+    }
+    if (starField && config.volume.enabled) {
+        initGalaxyVolume();
+    }
+    if (starField && config.farField.enabled) {
+        initFarField();
+    }
+}
+
+void Application::initStarSplat() {
+    // Splatted stars land in any order, the sorted draws exist for blending that depends on it
+    if (depthSort) {
+        logger.warning("Sorted stars are not splatted");
+        return;
+    }
+    starSplat = std::make_unique<StarSplat>(*vulkanContext, *starField, *scene, *starPalette, *frameUniforms, config.splat);
+    starSplat->resize(renderGraph->getExtent());
+
+    // Added over the rasterized stars in their pass
+    auto compositeConfig = PipelineManager::getFullscreenConfig();
+    renderGraph->configurePipeline("stars", compositeConfig);
+    compositeConfig.colorBlendAttachment = PipelineManager::getParticleConfig().colorBlendAttachment;
+    compositeConfig.descriptorSetLayouts = {starPalette->getDescriptorSetLayout(), frameUniforms->getDescriptorSetLayout(),
+                                            starSplat->getDescriptorSetLayout()};
+    compositeConfig.pushConstantRanges = {{VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(StarSplatResolveConstants)}};
+
+    pipelineManager->createPipeline(
+        "star_splat",
+        "shaders/fullscreen.vert.spv",
+        "shaders/star_splat_resolve.frag.spv",
+        compositeConfig
+    );
+}
+
+void Application::initGalaxyVolume() {
+    volume = std::make_unique<GalaxyVolume>(*vulkanContext, *starField, *scene, *starPalette, *frameUniforms, config.volume);
+    volume->setTarget(renderGraph->getImage(volumeTarget));
+
+    // Upsampled over the clear color in the stars pass
+    auto compositeConfig = PipelineManager::getFullscreenConfig();
+    renderGraph->configurePipeline("stars", compositeConfig);
+    compositeConfig.colorBlendAttachment = PipelineManager::getParticleConfig().colorBlendAttachment;
+    compositeConfig.descriptorSetLayouts = {starPalette->getDescriptorSetLayout(), frameUniforms->getDescriptorSetLayout(),
+                                            volume->getDescriptorSetLayout()};
+    compositeConfig.pushConstantRanges = {{VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(VolumeCompositeConstants)}};
+
+    pipelineManager->createPipeline(
+        "galaxy_volume",
+        "shaders/fullscreen.vert.spv",
+        "shaders/galaxy_volume_composite.frag.spv",
+        compositeConfig
+    );
+}
+
+void Application::initFarField() {
+    // Cached stars are drawn before the near ones, the sorted draws exist for blending that depends on the order
+    if (depthSort) {
+        logger.warning("The far field is not cached with sorted stars");
+        return;
+    }
+    farField = std::make_unique<FarFieldCache>(*vulkanContext, *scene, config.maxFramesInFlight,
+                                               renderGraph->getImage(hdrColor).getFormat(), galaxyRadius, config.farField);
+    farField->resize(renderGraph->getExtent());
+
+    // Reprojected over the clear color in the stars pass
+    auto compositeConfig = PipelineManager::getFullscreenConfig();
+    renderGraph->configurePipeline("stars", compositeConfig);
+    compositeConfig.colorBlendAttachment = PipelineManager::getParticleConfig().colorBlendAttachment;
+    compositeConfig.descriptorSetLayouts = {starPalette->getDescriptorSetLayout(), frameUniforms->getDescriptorSetLayout(),
+                                            farField->getDescriptorSetLayout()};
+    compositeConfig.pushConstantRanges = {{VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(FarFieldPushConstants)}};
+
+    pipelineManager->createPipeline(
+        "far_field",
+        "shaders/fullscreen.vert.spv",
+        "shaders/far_field.frag.spv",
+        compositeConfig
+    );
+}
+
+void Application::generateGalaxy() {
+    logger.info("Generating a galaxy of " + std::to_string(config.galaxy.starCount) + " stars");
+
+    GalaxyGenerator generator(config.galaxy);
+    galaxyRadius = generator.getRadius();
+    galaxySeed = config.galaxy.seed;
+    scene = std::make_unique<StarScene>(config.galaxy.starCount, config.lod);
+    starField = std::make_unique<StarField>(*vulkanContext, *scene, config.maxFramesInFlight, simulation != nullptr,
+                                            starStreams.get());
+
+    const bool simulate = simulation != nullptr;
+    const float particleMass = generator.getParticleMass();
+    const auto& palette = Blackbody::Palette::get();
+    ParticleSet particles;
+    if (simulate) {
+        particles.resize(config.galaxy.starCount);
+    }
+
+    // Stars go straight into the upload streams, and into the simulation state if there is one
+    auto start = std::chrono::steady_clock::now();
+    StarUploadStreams streams = starField->beginUpload();
+    generator.generate([&](size_t i, const Star& star) {
+        streams.positions[i] = StarVertex::Position(star.position[0], star.position[1], star.position[2]);
+        streams.appearance[i] = {palette.indexOf(star.temperature), StarPacking::encodeMagnitude(star.luminosity)};
+
+        if (simulate) {
+            particles.x[i] = star.position[0];
+            particles.y[i] = star.position[1];
+            particles.z[i] = star.position[2];
+            particles.vx[i] = star.velocity[0];
+            particles.vy[i] = star.velocity[1];
+            particles.vz[i] = star.velocity[2];
+            particles.mass[i] = particleMass;
+        }
+    });
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    starField->endUpload();
+
+    logger.info("Galaxy generated in " + std::to_string(elapsed) + " ms");
+
+    if (simulate) {
+        simulation->setParticles(std::move(particles));
+        uploadedStateVersion = simulation->getStateVersion();
+    }
+}
+
+void Application::loadSnapshot(const std::string& path) {
+    logger.info("Loading snapshot " + path);
+
+    auto start = std::chrono::steady_clock::now();
+    SnapshotFile snapshot(path);
+    const Snapshot::Metadata& metadata = snapshot.getMetadata();
+
+    if (metadata.particleCount == 0 || metadata.particleCount > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Snapshot " + path + " has an unsupported star count");
+    }
+    if (config.verifySnapshotChecksums && !snapshot.verifyChecksums()) {
+        throw std::runtime_error("Snapshot " + path + " is corrupted");
+    }
+
+    const auto starCount = static_cast<uint32_t>(metadata.particleCount);
+    galaxyRadius = metadata.radius > 0.0f ? metadata.radius : GalaxyGenerator(config.galaxy).getRadius();
+    galaxySeed = metadata.seed;
+    scene = std::make_unique<StarScene>(starCount, config.lod);
+    starField = std::make_unique<StarField>(*vulkanContext, *scene, config.maxFramesInFlight, simulation != nullptr,
+                                            starStreams.get());
+
+    // The sections have the layout of the upload streams, straight from the page cache
+    StarUploadStreams streams = starField->beginUpload();
+    snapshot.copySection(Snapshot::Section::Positions, sizeof(StarVertex::Position), streams.positions);
+    if (snapshot.hasSection(Snapshot::Section::Appearance)) {
+        snapshot.copySection(Snapshot::Section::Appearance, sizeof(StarPacking::Appearance), streams.appearance);
+    } else {
+        convertSnapshotColors(snapshot, streams.appearance);
+    }
+    starField->endUpload();
+
+    if (simulation) {
+        auto positions = reinterpret_cast<const StarVertex::Position*>(
+            snapshot.getSection(Snapshot::Section::Positions, sizeof(StarVertex::Position)).data());
+        auto velocities = reinterpret_cast<const glm::vec3*>(
+            snapshot.getSection(Snapshot::Section::Velocities, sizeof(glm::vec3)).data());
+        auto masses = reinterpret_cast<const float*>(
+            snapshot.getSection(Snapshot::Section::Masses, sizeof(float)).data());
+
+        ParticleSet particles;
+        particles.resize(starCount);
+        ThreadPool::global().parallelFor(0, starCount, 65536, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                particles.x[i] = positions[i].x;
+                particles.y[i] = positions[i].y;
+                particles.z[i] = positions[i].z;
+                particles.vx[i] = velocities[i].x;
+                particles.vy[i] = velocities[i].y;
+                particles.vz[i] = velocities[i].z;
+                particles.mass[i] = masses[i];
+            }
+        });
+
+        simulation->setParticles(std::move(particles), metadata.time);
+        uploadedStateVersion = simulation->getStateVersion();
+        nextRecordTime = metadata.time;
+    }
+
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    logger.info("Loaded " + std::to_string(starCount) + " stars at t = " + std::to_string(metadata.time) +
+                " Myr in " + std::to_string(elapsed) + " ms");
+}
+
+void Application::convertSnapshotColors(const SnapshotFile& snapshot, StarPacking::Appearance* appearance) {
+    // Snapshots written before the packed format only have float colors: match them against the palette
+    logger.warning("Snapshot " + snapshot.getPath() + " has no appearance section, converting its colors");
+
+    auto colors = reinterpret_cast<const std::array<float, 3>*>(
+        snapshot.getSection(Snapshot::Section::Colors, sizeof(std::array<float, 3>)).data());
+    const auto& palette = Blackbody::Palette::get().getColors();
+    const uint8_t sunMagnitude = StarPacking::encodeMagnitude(1.0f);
+
+    ThreadPool::global().parallelFor(0, snapshot.getMetadata().particleCount, 16384, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            size_t best = 0;
+            float bestDistance = std::numeric_limits<float>::max();
+            for (size_t entry = 0; entry < palette.size(); entry++) {
+                float dr = palette[entry][0] - colors[i][0];
+                float dg = palette[entry][1] - colors[i][1];
+                float db = palette[entry][2] - colors[i][2];
+                float distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = entry;
+                }
+            }
+            appearance[i] = {static_cast<uint8_t>(best), sunMagnitude};
+        }
+    });
+}
+
+void Application::saveSnapshot(const std::string& path) {
+    if (!simulation || !simulation->hasParticles() || !starField) {
+        logger.warning("No simulation state to save");
+        return;
+    }
+
+    // The particles are only consistent between two steps of the simulation thread
+    if (simulationThread) {
+        simulationThread->post([this, path](const Simulation& source) { writeSnapshot(path, source); });
+    } else {
+        writeSnapshot(path, *simulation);
+    }
+}
+
+void Application::writeSnapshot(const std::string& path, const Simulation& source) {
+    auto start = std::chrono::steady_clock::now();
+    const ParticleSet& particles = source.getParticles();
+    const BlockTimestepIntegrator& integrator = source.getIntegrator();
+    const size_t count = particles.size();
+
+    // Sections are stored in star order, which the simulation reorders freely. Velocities are synchronized to
+    // the positions, loading the snapshot kicks them again
+    std::vector<StarVertex::Position> positions(count);
+    std::vector<glm::vec3> velocities(count);
+    std::vector<float> masses(count);
+    ThreadPool::global().parallelFor(0, count, 65536, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            uint32_t slot = particles.id[i];
+            positions[slot] = StarVertex::Position(particles.x[i], particles.y[i], particles.z[i]);
+            integrator.getSynchronizedVelocity(particles, i, velocities[slot].x, velocities[slot].y, velocities[slot].z);
+            masses[slot] = particles.mass[i];
+        }
+    });
+
+    Snapshot::Metadata metadata;
+    metadata.particleCount = count;
+    metadata.seed = galaxySeed;
+    metadata.time = source.getTime();
+    metadata.radius = galaxyRadius;
+
+    Snapshot::write(path, metadata, {
+        {Snapshot::Section::Positions, sizeof(StarVertex::Position), positions.data()},
+        {Snapshot::Section::Velocities, sizeof(glm::vec3), velocities.data()},
+        {Snapshot::Section::Appearance, sizeof(StarPacking::Appearance), starField->getAppearance().data()},
+        {Snapshot::Section::Masses, sizeof(float), masses.data()},
+    });
+
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    logger.info("Saved snapshot " + path + " in " + std::to_string(elapsed) + " ms");
 }
 
 void Application::initCamera() {
-    // camera = std::make_unique<Camera>(
-    //     glm::vec3(0.0f, 0.0f, -10.0f),  // position
-    //     glm::vec3(0.0f, 0.0f, 0.0f),    // target
-    //     glm::vec3(0.0f, 1.0f, 0.0f)     // up
-    // );
+    // Orbit the galaxy center, far enough to see the whole disk
+    camera = std::make_unique<Camera>(glm::vec3(0.0f), galaxyRadius);
+    camera->frame(glm::vec3(0.0f), galaxyRadius);
 }
 
-void Application::run() {
+void Application::run(uint64_t frameLimit, const CameraScript* script, uint64_t warmupFrames) {
     logger.info("Starting application main loop");
     isRunning = true;
     lastFrameTime = static_cast<float>(glfwGetTime());
 
-    while (isRunning && !window->shouldClose()) {
+    measureFrames = frameLimit > 0;
+    if (measureFrames) {
+        frameStatistics = FrameStatistics(warmupFrames, frameLimit);
+    }
+    constexpr float SCRIPT_STEP = 1.0f / 60.0f;
+
+    while (isRunning && !window->shouldClose() && (frameLimit == 0 || frameNumber < frameLimit)) {
         float currentTime = static_cast<float>(glfwGetTime());
         float deltaTime = currentTime - lastFrameTime;
         lastFrameTime = currentTime;
 
+        const uint64_t frame = frameNumber;
+        auto start = std::chrono::steady_clock::now();
+        frameWaitTime = 0.0;
+
+        if (script) {
+            deltaTime = SCRIPT_STEP;
+            const CameraScript::Pose pose = script->sample(static_cast<float>(frameNumber) * SCRIPT_STEP);
+            camera->setOrbit(pose.target, pose.distance, pose.yaw, pose.pitch);
+        }
         update(deltaTime);
         render();
+
+        // Frames skipped by render(), minimized or out of date, are not counted
+        if (measureFrames && frameNumber != frame) {
+            const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            frameStatistics.addCpuTime(frame, elapsed - frameWaitTime);
+        }
     }
 
     // Wait for the GPU to finish all operations
     vulkanContext->waitIdle();
+
+    if (measureFrames) {
+        for (uint32_t slot = 0; slot < config.maxFramesInFlight; slot++) {
+            if (auto timing = gpuTimer->collect(slot)) {
+                frameStatistics.addGpuTime(timing->frame, timing->milliseconds);
+            }
+        }
+        logger.info("Frame times over " + std::to_string(frameNumber) + " frames (ms): " + frameStatistics.toJson());
+    }
 }
 
 void Application::update(float deltaTime) {
     window->update();
-    // camera->update(deltaTime);
+    camera->update(deltaTime);
+
+    // The simulation advances on its own thread, frames only pick up what it published
+    if (simulationThread) {
+        simulationThread->acquireState();
+
+        if (!config.recordDirectory.empty() && simulationThread->getState().time >= nextRecordTime) {
+            std::filesystem::create_directories(config.recordDirectory);
+            saveSnapshot((std::filesystem::path(config.recordDirectory) /
+                          SnapshotSeries::frameFileName(recordedSnapshots++)).string());
+            nextRecordTime += config.recordInterval;
+        }
+    }
+
+    if (playback) {
+        playback->advance(deltaTime);
+    }
 }
 
 void Application::render() {
@@ -153,7 +759,11 @@ void Application::render() {
     }
 
     // Wait for the previous frame to complete
+    auto waitStart = std::chrono::steady_clock::now();
     synchronization->waitForFence(currentFrame);
+    if (auto timing = gpuTimer->collect(currentFrame); timing && measureFrames) {
+        frameStatistics.addGpuTime(timing->frame, timing->milliseconds);
+    }
 
     // Get command buffer for current frame
     auto& commandManager = vulkanContext->getCommandManager();
@@ -170,15 +780,32 @@ void Application::render() {
     );
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        vulkanContext->getSwapChain().recreate();
+        recreateSwapChain();
         return;
     }
     if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         throw std::runtime_error("Failed to acquire swap chain image");
     }
+    frameWaitTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
 
     // Reset the command buffer only after we're sure the previous frame is done
     synchronization->resetFence(currentFrame);
+    vulkanContext->getMemoryTracker().update(frameNumber);
+
+    // The fence also released this frame's uniform slot
+    auto& swapChain = vulkanContext->getSwapChain();
+    const VkExtent2D extent = swapChain.getExtent();
+    if (extent.height > 0) {
+        camera->setAspect(static_cast<float>(extent.width) / static_cast<float>(extent.height));
+    }
+    CameraUniforms cameraUniforms{};
+    cameraUniforms.view = camera->getView();
+    cameraUniforms.projection = camera->getProjection();
+    cameraUniforms.viewProjection = cameraUniforms.projection * cameraUniforms.view;
+    cameraUniforms.position = glm::vec4(camera->getPosition(), 1.0f);
+    cameraUniforms.viewport = glm::vec4(static_cast<float>(extent.width), static_cast<float>(extent.height),
+                                        0.5f * static_cast<float>(extent.height) / std::tan(0.5f * camera->getFieldOfView()), 0.0f);
+    frameUniforms->write(currentFrame, cameraUniforms);
 
     VkCommandBuffer commandBuffer = commandManager.getCurrentBuffer();
     vkResetCommandBuffer(commandBuffer, 0);
@@ -192,37 +819,65 @@ void Application::render() {
     if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
         throw std::runtime_error("Failed to begin recording command buffer!");
     }
+    gpuTimer->begin(commandBuffer, currentFrame, frameNumber);
+
+    // Upload the last two simulation states when a new one arrives, transfers must happen outside of the render pass.
+    // Between states the shaders blend them
+    if (simulationThread && starField) {
+        const SimulationState& state = simulationThread->getState();
+        if (state.version != uploadedStateVersion) {
+            starField->updatePositions(commandBuffer, currentFrame, state.previousPositions.data(),
+                                       state.positions.data());
+            uploadedStateVersion = state.version;
+        }
+        starField->setBlend(config.simulation.interpolate ? state.blendAt(SimulationThread::clock()) : 1.0f);
+    }
+    if (playback) {
+        playback->recordUploads(commandBuffer, frameNumber);
+    }
 
-    // Begin render pass
-    auto& swapChain = vulkanContext->getSwapChain();
-    swapChain.beginRenderPass(commandBuffer, swapChain.getFramebuffers()[imageIndex]);
-
-    if (pipelineManager && pipelineManager->hasPipeline("basic")) {
-        auto* pipeline = pipelineManager->getPipeline("basic");
-        pipeline->bind(commandBuffer);
-        vertexBuffer->bindAsVertex(commandBuffer);
-        indexBuffer->bindAsIndex(commandBuffer, 1);
-
-        VkViewport viewport{};
-        viewport.x = 0.0f;
-        viewport.y = 0.0f;
-        viewport.width = static_cast<float>(swapChain.getExtent().width);
-        viewport.height = static_cast<float>(swapChain.getExtent().height);
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-
-        VkRect2D scissor{};
-        scissor.offset = {0, 0};
-        scissor.extent = swapChain.getExtent();
-        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
-        // Draw call would go here
-        vkCmdDraw(commandBuffer, 3, 1, 0, 0); // Draw a triangle for testing
+    // Select the stars before the graph, sorting them may record compute work
+    visibleRanges = nullptr;
+    volumeActive = false;
+    if (starField && !playback) {
+        visibleRanges = &scene->select(cameraUniforms.viewProjection, camera->getPosition(), static_cast<float>(extent.height));
+
+        // From outside of the galaxy with all of it in view, the raymarch replaces the stars
+        if (volume) {
+            volume->update(commandBuffer, scene->getPositionsVersion());
+            volumeActive = volume->covers(camera->getPosition()) && scene->getVisibleChunkCount() == scene->getChunkCount();
+        }
+        if (volumeActive) {
+            volume->setView(cameraUniforms.viewProjection, camera->getPosition(),
+                            glm::vec3(cameraUniforms.viewport.x, cameraUniforms.viewport.y, cameraUniforms.viewport.z));
+            visibleRanges = nullptr;
+        } else {
+            // Only the stars the cache does not hold are drawn, it selects its own when it is drawn again
+            if (farField) {
+                farField->update(currentFrame, cameraUniforms, scene->getPositionsVersion());
+                visibleRanges = &farField->splitNear(*visibleRanges);
+            }
+            if (depthSort) {
+                depthSort->update(commandBuffer, currentFrame, *visibleRanges, camera->getPosition());
+            }
+
+            // Chunks where a sun like star stays under a pixel are splatted, the rasterizer draws the rest
+            if (starSplat) {
+                starSplat->record(commandBuffer, currentFrame, *visibleRanges, camera->getPosition(),
+                                  config.sprites.radius * cameraUniforms.viewport.z, getStarSprites());
+                visibleRanges = &starSplat->getNearRanges();
+            }
+        }
     }
 
-    // End render pass
-    swapChain.endRenderPass(commandBuffer);
+    // Stars, bloom and tonemap, with the barriers between them
+    renderGraph->setImage(swapChainImage, swapChain.getImages()[imageIndex], swapChain.getImageViews()[imageIndex], extent);
+    if (farField) {
+        const Image& cache = farField->getImage();
+        renderGraph->setImage(farFieldImage, cache.getImage(), cache.getView(), cache.getExtent());
+    }
+    renderGraph->execute(commandBuffer);
+    gpuTimer->end(commandBuffer, currentFrame);
 
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         throw std::runtime_error("Failed to record command buffer!");
@@ -244,7 +899,13 @@ void Application::render() {
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
-    if (vkQueueSubmit(vulkanContext->getGraphicsQueue(), 1, &submitInfo, synchronization->getFence(currentFrame)) != VK_SUCCESS) {
+    result = vkQueueSubmit(vulkanContext->getGraphicsQueue(), 1, &submitInfo, synchronization->getFence(currentFrame));
+    if (result == VK_ERROR_DEVICE_LOST) {
+        // Usually memory exhaustion on large galaxies, keep what we were using
+        throw std::runtime_error("Device lost while submitting frame " + std::to_string(frameNumber) + "\n" +
+                                 vulkanContext->getMemoryTracker().describe());
+    }
+    if (result != VK_SUCCESS) {
         throw std::runtime_error("Failed to submit draw command buffer!");
     }
 
@@ -262,14 +923,40 @@ void Application::render() {
 
     result = vkQueuePresentKHR(vulkanContext->getPresentQueue(), &presentInfo);
 
+    const double presentTime = glfwGetTime();
+    if (measureFrames && lastPresentTime >= 0.0) {
+        frameStatistics.addPresentInterval(frameNumber, 1000.0 * (presentTime - lastPresentTime));
+    }
+    lastPresentTime = presentTime;
+
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
-        swapChain.recreate();
+        recreateSwapChain();
     } else if (result != VK_SUCCESS) {
         throw std::runtime_error("Failed to present swap chain image!");
     }
 
     // Update current frame
     currentFrame = (currentFrame + 1) % config.maxFramesInFlight;
+    frameNumber++;
+}
+
+void Application::recreateSwapChain() {
+    auto& swapChain = vulkanContext->getSwapChain();
+    swapChain.recreate();
+
+    // A minimized window has no size, the targets keep theirs until it is restored
+    const VkExtent2D extent = swapChain.getExtent();
+    if (extent.width == 0 || extent.height == 0) {
+        return;
+    }
+    renderGraph->compile(extent);
+    updateRenderGraphImages();
+    if (starSplat) {
+        starSplat->resize(extent);
+    }
+    if (farField) {
+        farField->resize(extent);
+    }
 }
 
 void Application::stop() {
@@ -279,10 +966,25 @@ void Application::stop() {
 void Application::cleanup() {
     logger.info("Cleaning up application");
 
+    simulationThread.reset();
+    simulation.reset();
+    playback.reset();
+    camera.reset();
     synchronization.reset();
     pipelineManager.reset();
-    vertexBuffer.reset();
-    indexBuffer.reset();
+    starPalette.reset();
+    frameUniforms.reset();
+    gpuTimer.reset();
+    renderGraph.reset();
+    tonemap.reset();
+    bloom.reset();
+    depthSort.reset();
+    starSplat.reset();
+    volume.reset();
+    farField.reset();
+    starField.reset();
+    starStreams.reset();
+    scene.reset();
     vulkanContext.reset();
     window.reset();
 }
@@ -291,8 +993,8 @@ void Application::cleanup() {
 void Application::onWindowResize(int width, int height) {
     if (width == 0 || height == 0) return;
 
-    // Handle resize
-    // This might involve recreating the swap chain
+    // The swap chain is recreated when presenting reports it out of date, only the camera needs to know now
+    camera->setAspect(static_cast<float>(width) / static_cast<float>(height));
 }
 
 void Application::onKeyEvent(int key, int scancode, int action, int mods) {
@@ -301,18 +1003,25 @@ void Application::onKeyEvent(int key, int scancode, int action, int mods) {
         stop();
     }
 
-    // Pass input to camera
-    // camera->handleKeyInput(key, action);
+    if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+        try {
+            saveSnapshot(config.snapshotSavePath);
+        } catch (const std::exception& e) {
+            logger.error(e.what());
+        }
+    }
+
+    camera->handleKeyInput(key, action);
 }
 
 void Application::onMouseMove(double xpos, double ypos) {
-    // camera->handleMouseMove(static_cast<float>(xpos), static_cast<float>(ypos));
+    camera->handleMouseMove(static_cast<float>(xpos), static_cast<float>(ypos));
 }
 
 void Application::onMouseButton(int button, int action, int mods) {
-    // camera->handleMouseButton(button, action);
+    camera->handleMouseButton(button, action);
 }
 
 void Application::onMouseScroll(double xoffset, double yoffset) {
-    // camera->handleMouseScroll(static_cast<float>(yoffset));
+    camera->handleMouseScroll(static_cast<float>(yoffset));
 }
\ No newline at end of file
@@ -8,10 +8,24 @@
 
 #include <array>
 #include <memory>
+#include <string>
 #include "Window.h"
 #include <glm/glm.hpp>
+#include "FrameStatistics.h"
 #include "Logger.h"
-#include "../renderer/Buffer.h"
+#include "../galaxy/GalaxyGenerator.h"
+#include "../renderer/Bloom.h"
+#include "../renderer/RenderGraph.h"
+#include "../renderer/SnapshotPlayback.h"
+#include "../renderer/StarSplat.h"
+#include "../renderer/GalaxyVolume.h"
+#include "../renderer/FarFieldCache.h"
+#include "../renderer/StarPacking.h"
+#include "../renderer/StarVertex.h"
+#include "../renderer/Tonemap.h"
+#include "../scene/DepthSorter.h"
+#include "../scene/StarScene.h"
+#include "../simulation/Simulation.h"
 
 class Synchronization;
 class PipelineManager;
@@ -19,40 +33,43 @@ class VulkanContext;
 class SwapChain;
 class CommandManager;
 class Pipeline;
+class StarField;
+class StarPalette;
+class FrameUniforms;
+class Camera;
+class SimulationThread;
+class SnapshotFile;
+class CameraScript;
+class GpuTimer;
+class StarDepthSort;
+class VertexStreams;
 
 struct ApplicationConfig {
     WindowProperties windowProps;
     bool enableValidationLayers = true;
     uint32_t maxFramesInFlight = 2;
-};
-
-struct Vertex {
-    glm::vec2 pos;
-    glm::vec3 color;
-
-    static VkVertexInputBindingDescription getBindingDescription() {
-        VkVertexInputBindingDescription bindingDescription{};
-        bindingDescription.binding = 0;
-        bindingDescription.stride = sizeof(Vertex);
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-        return bindingDescription;
-    }
-
-    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
-        std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
-        attributeDescriptions[0].binding = 0;
-        attributeDescriptions[0].location = 0;
-        attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-        attributeDescriptions[0].offset = offsetof(Vertex, pos);
-
-        attributeDescriptions[1].binding = 0;
-        attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[1].offset = offsetof(Vertex, color);
-
-        return attributeDescriptions;
-    }
+    GalaxyParameters galaxy;
+    SimulationConfig simulation;
+    StarLodConfig lod;
+    DepthSortConfig depthSort;                      // back to front star order, only needed by order dependent blending
+    HdrConfig hdr;                                  // stars are added into a floating point target, then tonemapped
+    BloomConfig bloom;
+    bool dynamicRendering = true;                   // when the device has it, render passes and framebuffers otherwise
+    bool vertexPulling = false;                     // star shaders read their storage buffers instead of vertex attributes
+    StarSpriteConfig sprites;                       // stars sized by magnitude and distance, pulled whatever vertexPulling says
+    StarSplatConfig splat;                          // far chunks rasterized by a compute shader, not with depth sort
+    VolumeConfig volume;                            // raymarched galaxy instead of the stars when the eye is outside of it
+    FarFieldConfig farField;                        // distant stars kept in an image across frames, not with depth sort
+
+    std::string snapshotPath;                       // load the galaxy from this snapshot instead of generating it
+    std::string snapshotSavePath = "galaxy.vgs";    // written when F5 is pressed
+    bool verifySnapshotChecksums = false;
+
+    std::string recordDirectory;                    // when set, a snapshot is written every recordInterval
+    float recordInterval = 20.0f;                   // simulated Myr between recorded snapshots
+    PlaybackConfig playback;                        // replaces the simulation when a directory is given
+
+    std::string binaryLogPath;                      // when set, every record goes there for LogDecode, the console only gets warnings
 };
 
 class Application {
@@ -65,12 +82,22 @@ public:
     Application& operator=(const Application&) = delete;
 
     // Core functions
-    void run();
+
+    /**
+     * Render until the window is closed, or for frameLimit frames when it is not 0.
+     * With a script the camera follows it instead of the inputs, and the frames advance by a fixed 1/60 s so
+     * every run renders the same images whatever the frame rate.
+     * Frame times are measured when there is a frame limit, the first warmupFrames frames are left out of them.
+     */
+    void run(uint64_t frameLimit = 0, const CameraScript* script = nullptr, uint64_t warmupFrames = 0);
     void stop();
 
     // Getters
     Window& getWindow() { return *window; }
     VulkanContext& getVulkanContext() { return *vulkanContext; }
+    const FrameStatistics& getFrameStatistics() const { return frameStatistics; }
+    uint64_t getFrameNumber() const { return frameNumber; }
+    float getGalaxyRadius() const { return galaxyRadius; }
 
 private:
     // Initialization
@@ -78,6 +105,17 @@ private:
     void initWindow();
     void initVulkan();
     void initCamera();
+    void initGalaxy();
+    void generateGalaxy();
+    void loadSnapshot(const std::string& path);
+
+    void convertSnapshotColors(const SnapshotFile& snapshot, StarPacking::Appearance* appearance);
+
+    /**
+     * Save the current simulation state, between two steps of the simulation thread
+     */
+    void saveSnapshot(const std::string& path);
+    void writeSnapshot(const std::string& path, const Simulation& source);
 
     // Frame handling
     void mainLoop();
@@ -85,6 +123,61 @@ private:
     void render();
     void cleanup();
 
+    /**
+     * Declare the passes of a frame, from the stars to the swap chain image
+     */
+    void buildRenderGraph();
+
+    /**
+     * Point the passes at the images of the compiled render graph
+     */
+    void updateRenderGraphImages();
+
+    /**
+     * Compute rasterization of the far field and the pipeline adding it to the stars pass
+     */
+    void initStarSplat();
+
+    /**
+     * Emission texture of the galaxy and the pipeline adding its raymarch to the stars pass
+     */
+    void initGalaxyVolume();
+
+    /**
+     * Cache of the distant stars and the pipeline reprojecting it into the stars pass
+     */
+    void initFarField();
+
+    /**
+     * Sprite mode of the stars pipeline: quads are not sorted, and points need the largePoints feature
+     */
+    StarSprites chooseStarSprites();
+
+    /**
+     * Draw the stars selected for this frame, inside the stars pass
+     */
+    void drawStars(VkCommandBuffer commandBuffer);
+
+    /**
+     * Draw the distant stars into the cache, in the far field pass that only runs when the cache is refreshed
+     */
+    void drawFarField(VkCommandBuffer commandBuffer);
+
+    /**
+     * Sizes of the star sprites, all 0 when stars are single pixels
+     */
+    StarSpritePushConstants getStarSprites() const;
+
+    /**
+     * Sizes of the star sprites, for a bound stars pipeline
+     */
+    void pushStarSprites(VkCommandBuffer commandBuffer, const Pipeline& pipeline) const;
+
+    /**
+     * Recreate the swap chain and the targets of its size
+     */
+    void recreateSwapChain();
+
     // Event callbacks
     void onWindowResize(int width, int height);
     void onKeyEvent(int key, int scancode, int action, int mods);
@@ -104,13 +197,46 @@ private:
     std::unique_ptr<VulkanContext> vulkanContext;
     std::unique_ptr<PipelineManager> pipelineManager;
     std::unique_ptr<Synchronization> synchronization;
-
-    std::unique_ptr<Buffer> vertexBuffer;
-    uint32_t vertexCount = 0;
-    std::unique_ptr<Buffer> indexBuffer;
-    uint32_t indexCount = 0;
+    std::unique_ptr<Simulation> simulation;
+    std::unique_ptr<SimulationThread> simulationThread;
+    std::unique_ptr<Camera> camera;
+    std::unique_ptr<FrameUniforms> frameUniforms;
+    std::unique_ptr<GpuTimer> gpuTimer;
+    std::unique_ptr<RenderGraph> renderGraph;
+    std::unique_ptr<Bloom> bloom;
+    std::unique_ptr<Tonemap> tonemap;
+    RenderGraph::Resource swapChainImage = 0;
+    RenderGraph::Resource hdrColor = 0;
+    RenderGraph::Resource bloomChain = 0;
+    RenderGraph::Resource volumeTarget = 0;
+    RenderGraph::Resource farFieldImage = 0;
+
+    std::unique_ptr<StarScene> scene;
+    std::unique_ptr<StarField> starField;
+    std::unique_ptr<StarDepthSort> depthSort;
+    std::unique_ptr<StarSplat> starSplat;
+    std::unique_ptr<GalaxyVolume> volume;
+    bool volumeActive = false;                      // the raymarch replaces the stars this frame
+    std::unique_ptr<FarFieldCache> farField;
+    std::unique_ptr<StarPalette> starPalette;
+    std::unique_ptr<VertexStreams> starStreams;     // only when the vertices are pulled
+    StarSprites starSprites = StarSprites::Pixels;  // config.sprites.mode, or what the device and depth sort allow
+    std::unique_ptr<SnapshotPlayback> playback;
+    float galaxyRadius = 1.0f;
+    uint64_t galaxySeed = 0;
+    uint64_t uploadedStateVersion = 0;
+    size_t recordedSnapshots = 0;
+    double nextRecordTime = 0.0;
 
     // Frame synchronization
     uint32_t currentFrame = 0;
+    const std::vector<StarDrawRange>* visibleRanges = nullptr;     // selected by render() for drawStars()
+    uint64_t frameNumber = 0;
+
+    // Frame times, only filled when running for a fixed number of frames
+    bool measureFrames = false;
+    FrameStatistics frameStatistics;
+    double frameWaitTime = 0.0;             // ms spent in the fence and image acquire waits of the last render()
+    double lastPresentTime = -1.0;          // s, glfwGetTime() after the last present
 };
 #endif //APPLICATION_H
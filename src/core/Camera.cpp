@@ -0,0 +1,185 @@
+//
+// Created by raph on 24/01/25.
+//
+
+#include "Camera.h"
+
+#include <algorithm>
+#include <cmath>
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+    const glm::vec3 UP(0.0f, 0.0f, 1.0f);
+
+    constexpr float ROTATE_SPEED = 0.005f;      // radians per pixel
+    constexpr float PAN_SPEED = 0.0015f;        // distance per pixel
+    constexpr float ZOOM_STEP = 0.9f;           // distance factor per wheel notch
+    constexpr float SPEED_STEP = 1.2f;          // fly speed factor per wheel notch
+    constexpr float FAST_FACTOR = 5.0f;
+    constexpr float MAX_PITCH = 1.55f;
+    constexpr float MIN_DISTANCE = 1e-3f;
+    constexpr float MAX_DISTANCE = 1e3f;
+    constexpr float FLY_NEAR = 1e-4f;
+    constexpr float DEPTH_RANGE = 1e6f;         // far over near
+}
+
+Camera::Camera(const glm::vec3& target, float distance)
+    : target(target)
+    , distance(distance) {
+    position = getPosition();
+}
+
+void Camera::frame(const glm::vec3& center, float radius) {
+    target = center;
+    distance = std::clamp(1.1f * radius / std::tan(0.5f * fieldOfView), MIN_DISTANCE, MAX_DISTANCE);
+    yaw = 0.0f;
+    pitch = -0.8f;
+    flySpeed = 0.2f * radius;
+
+    Mode previous = mode;
+    mode = Mode::Orbit;
+    position = getPosition();
+    mode = previous;
+}
+
+void Camera::setOrbit(const glm::vec3& target, float distance, float yaw, float pitch) {
+    mode = Mode::Orbit;
+    this->target = target;
+    this->distance = std::clamp(distance, MIN_DISTANCE, MAX_DISTANCE);
+    this->yaw = yaw;
+    this->pitch = std::clamp(pitch, -MAX_PITCH, MAX_PITCH);
+    position = getPosition();
+}
+
+void Camera::update(float deltaTime) {
+    glm::vec3 direction(0.0f);
+    if (mode == Mode::FreeFly) {
+        const glm::vec3 forward = getForward();
+        const glm::vec3 right = getRight();
+        direction += forward * static_cast<float>(forwardHeld - backHeld);
+        direction += right * static_cast<float>(rightHeld - leftHeld);
+        direction += UP * static_cast<float>(upHeld - downHeld);
+    } else {
+        // Pans stay in the disk plane whatever the pitch
+        const glm::vec3 right = getRight();
+        const glm::vec3 ahead = glm::normalize(glm::cross(UP, right));
+        direction += ahead * static_cast<float>(forwardHeld - backHeld);
+        direction += right * static_cast<float>(rightHeld - leftHeld);
+        direction += UP * static_cast<float>(upHeld - downHeld);
+    }
+
+    if (direction.x == 0.0f && direction.y == 0.0f && direction.z == 0.0f) {
+        return;
+    }
+
+    float speed = mode == Mode::FreeFly ? flySpeed : 0.8f * distance;
+    if (fastHeld) {
+        speed *= FAST_FACTOR;
+    }
+    const glm::vec3 step = glm::normalize(direction) * (speed * deltaTime);
+    if (mode == Mode::FreeFly) {
+        position += step;
+    } else {
+        target += step;
+    }
+}
+
+void Camera::handleKeyInput(int key, int action) {
+    if (action == GLFW_REPEAT) {
+        return;
+    }
+    const bool pressed = action == GLFW_PRESS;
+
+    switch (key) {
+        case GLFW_KEY_W: forwardHeld = pressed; break;
+        case GLFW_KEY_S: backHeld = pressed; break;
+        case GLFW_KEY_A: leftHeld = pressed; break;
+        case GLFW_KEY_D: rightHeld = pressed; break;
+        case GLFW_KEY_E: upHeld = pressed; break;
+        case GLFW_KEY_Q: downHeld = pressed; break;
+        case GLFW_KEY_LEFT_SHIFT: fastHeld = pressed; break;
+        case GLFW_KEY_C:
+            if (pressed) {
+                setMode(mode == Mode::Orbit ? Mode::FreeFly : Mode::Orbit);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void Camera::handleMouseMove(float x, float y) {
+    const float dx = hasCursor ? x - cursorX : 0.0f;
+    const float dy = hasCursor ? y - cursorY : 0.0f;
+    cursorX = x;
+    cursorY = y;
+    hasCursor = true;
+
+    if (rotating) {
+        // Orbiting drags the galaxy along with the cursor, flying turns the head towards it
+        const float sign = mode == Mode::Orbit ? -1.0f : 1.0f;
+        yaw += sign * dx * ROTATE_SPEED;
+        pitch = std::clamp(pitch - sign * dy * ROTATE_SPEED, -MAX_PITCH, MAX_PITCH);
+    }
+    if (panning && mode == Mode::Orbit) {
+        const glm::vec3 right = getRight();
+        const glm::vec3 up = glm::cross(right, getForward());
+        target += (up * dy - right * dx) * (PAN_SPEED * distance);
+    }
+}
+
+void Camera::handleMouseButton(int button, int action) {
+    if (button == GLFW_MOUSE_BUTTON_LEFT) {
+        rotating = action == GLFW_PRESS;
+    } else if (button == GLFW_MOUSE_BUTTON_RIGHT) {
+        panning = action == GLFW_PRESS;
+    }
+}
+
+void Camera::handleMouseScroll(float offset) {
+    if (mode == Mode::Orbit) {
+        distance = std::clamp(distance * std::pow(ZOOM_STEP, offset), MIN_DISTANCE, MAX_DISTANCE);
+    } else {
+        flySpeed *= std::pow(SPEED_STEP, offset);
+    }
+}
+
+void Camera::setMode(Mode newMode) {
+    if (newMode == mode) {
+        return;
+    }
+
+    // Keep the eye where it is, the orbit center goes in front of it at the current distance
+    if (newMode == Mode::FreeFly) {
+        position = getPosition();
+    } else {
+        target = position + getForward() * distance;
+    }
+    mode = newMode;
+}
+
+glm::vec3 Camera::getPosition() const {
+    return mode == Mode::FreeFly ? position : target - getForward() * distance;
+}
+
+glm::vec3 Camera::getForward() const {
+    return {std::sin(yaw) * std::cos(pitch), std::cos(yaw) * std::cos(pitch), std::sin(pitch)};
+}
+
+glm::vec3 Camera::getRight() const {
+    return glm::normalize(glm::cross(glm::vec3(std::sin(yaw), std::cos(yaw), 0.0f), UP));
+}
+
+glm::mat4 Camera::getView() const {
+    const glm::vec3 eye = getPosition();
+    return glm::lookAtRH(eye, eye + getForward(), UP);
+}
+
+glm::mat4 Camera::getProjection() const {
+    // Near scales with the orbit distance so zooming in on a cluster does not clip it
+    const float near = mode == Mode::Orbit ? std::max(FLY_NEAR, 1e-3f * distance) : FLY_NEAR;
+    glm::mat4 projection = glm::perspectiveRH_ZO(fieldOfView, aspect, near, near * DEPTH_RANGE);
+    projection[1][1] *= -1.0f; // Vulkan clip space has y pointing down
+    return projection;
+}
@@ -0,0 +1,85 @@
+//
+// Created by raph on 24/01/25.
+//
+
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <glm/glm.hpp>
+
+/**
+ * Perspective camera with two modes, toggled with C:
+ *  - orbit: left drag rotates around the target, right drag pans it, the wheel zooms. WASD pans too
+ *  - free fly: left drag looks around, WASD moves, Q/E go down/up, the wheel changes the speed, shift speeds up
+ *
+ * Distances are in kpc, z is up (the galaxy disk is the xy plane).
+ */
+class Camera {
+public:
+    enum class Mode {
+        Orbit,
+        FreeFly,
+    };
+
+    Camera(const glm::vec3& target, float distance);
+
+    /**
+     * Look at the whole of a region of the given radius from above, at an angle
+     */
+    void frame(const glm::vec3& center, float radius);
+
+    /**
+     * Place the camera on its orbit, in orbit mode. Used by scripted runs instead of the inputs
+     */
+    void setOrbit(const glm::vec3& target, float distance, float yaw, float pitch);
+
+    /**
+     * Apply the held keys
+     */
+    void update(float deltaTime);
+
+    void handleKeyInput(int key, int action);
+    void handleMouseMove(float x, float y);
+    void handleMouseButton(int button, int action);
+    void handleMouseScroll(float offset);
+
+    void setMode(Mode mode);
+    void setAspect(float aspect) { this->aspect = aspect; }
+
+    Mode getMode() const { return mode; }
+    glm::vec3 getPosition() const;
+    glm::vec3 getForward() const;
+    glm::mat4 getView() const;
+
+    /**
+     * Vulkan clip space: depth in [0, 1] and y pointing down
+     */
+    glm::mat4 getProjection() const;
+    glm::mat4 getViewProjection() const { return getProjection() * getView(); }
+
+    float getFieldOfView() const { return fieldOfView; }
+
+private:
+    glm::vec3 getRight() const;
+
+    Mode mode = Mode::Orbit;
+    glm::vec3 target;           // orbit center
+    glm::vec3 position{0.0f};   // free fly eye, the orbit eye derives from target and distance
+    float distance;
+    float yaw = 0.0f;           // radians around z, 0 looks along +y
+    float pitch = -0.8f;        // radians, negative looks down
+    float aspect = 16.0f / 9.0f;
+    float fieldOfView = 0.9f;   // vertical, radians
+    float flySpeed = 1.0f;      // kpc per second
+
+    // Held inputs
+    bool rotating = false;
+    bool panning = false;
+    bool hasCursor = false;
+    float cursorX = 0.0f;
+    float cursorY = 0.0f;
+    bool forwardHeld = false, backHeld = false, leftHeld = false, rightHeld = false, upHeld = false, downHeld = false;
+    bool fastHeld = false;
+};
+
+#endif //CAMERA_H
@@ -0,0 +1,85 @@
+//
+// Created by raph on 31/01/25.
+//
+
+#include "CameraScript.h"
+
+#include <algorithm>
+#include <fstream>
+#include <numbers>
+#include <sstream>
+#include <stdexcept>
+
+CameraScript::CameraScript(std::vector<Pose> keyframes)
+    : keyframes(std::move(keyframes)) {
+    if (this->keyframes.empty()) {
+        throw std::runtime_error("Camera script has no keyframe");
+    }
+    for (size_t i = 1; i < this->keyframes.size(); i++) {
+        if (this->keyframes[i].time <= this->keyframes[i - 1].time) {
+            throw std::runtime_error("Camera script keyframe " + std::to_string(i) + " does not come after the previous one");
+        }
+    }
+}
+
+CameraScript CameraScript::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open camera script " + path);
+    }
+
+    constexpr float DEGREES = std::numbers::pi_v<float> / 180.0f;
+    std::vector<Pose> keyframes;
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(file, line); lineNumber++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        Pose pose;
+        if (!(fields >> pose.time)) {
+            continue;   // blank or comment
+        }
+        if (!(fields >> pose.yaw >> pose.pitch >> pose.distance)) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": expected time yaw pitch distance");
+        }
+        fields >> pose.target.x >> pose.target.y >> pose.target.z;
+        pose.yaw *= DEGREES;
+        pose.pitch *= DEGREES;
+        keyframes.push_back(pose);
+    }
+    return CameraScript(std::move(keyframes));
+}
+
+CameraScript CameraScript::orbit(float radius, float duration) {
+    constexpr float TWO_PI = 2.0f * std::numbers::pi_v<float>;
+    const float far = 2.5f * radius;
+    return CameraScript({
+        {0.0f, 0.0f, -1.2f, far},
+        {0.25f * duration, 0.25f * TWO_PI, -0.8f, 0.6f * far},
+        {0.5f * duration, 0.5f * TWO_PI, -0.4f, 0.25f * far},
+        {0.75f * duration, 0.75f * TWO_PI, -0.1f, 0.6f * far},
+        {duration, TWO_PI, -1.2f, far},
+    });
+}
+
+CameraScript::Pose CameraScript::sample(float time) const {
+    if (time <= keyframes.front().time) {
+        return keyframes.front();
+    }
+    if (time >= keyframes.back().time) {
+        return keyframes.back();
+    }
+
+    auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+                                 [](float t, const Pose& pose) { return t < pose.time; });
+    const Pose& a = *(next - 1);
+    const Pose& b = *next;
+    const float t = (time - a.time) / (b.time - a.time);
+
+    Pose pose;
+    pose.time = time;
+    pose.yaw = a.yaw + t * (b.yaw - a.yaw);
+    pose.pitch = a.pitch + t * (b.pitch - a.pitch);
+    pose.distance = a.distance + t * (b.distance - a.distance);
+    pose.target = a.target + (b.target - a.target) * t;
+    return pose;
+}
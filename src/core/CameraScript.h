@@ -0,0 +1,49 @@
+//
+// Created by raph on 31/01/25.
+//
+
+#ifndef CAMERASCRIPT_H
+#define CAMERASCRIPT_H
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * Orbit camera path replayed instead of user input, so a run needs nobody at the keyboard. Keyframes are linearly
+ * interpolated and the last one is held once the path is over.
+ *
+ * Text format, one keyframe per line, # starts a comment:
+ *     time yaw pitch distance [targetX targetY targetZ]
+ * in seconds, degrees, degrees, kpc and kpc. Times must increase.
+ */
+class CameraScript {
+public:
+    struct Pose {
+        float time = 0.0f;          // s
+        float yaw = 0.0f;           // radians
+        float pitch = 0.0f;         // radians
+        float distance = 1.0f;      // kpc
+        glm::vec3 target{0.0f};
+    };
+
+    explicit CameraScript(std::vector<Pose> keyframes);
+
+    static CameraScript load(const std::string& path);
+
+    /**
+     * One turn around the galaxy center in duration seconds, dipping from above the disk down to its edge and
+     * zooming in halfway, so the path covers the far and the near views
+     * @param radius of the galaxy, in kpc
+     */
+    static CameraScript orbit(float radius, float duration);
+
+    Pose sample(float time) const;
+
+    float getDuration() const { return keyframes.back().time; }
+
+private:
+    std::vector<Pose> keyframes;
+};
+
+#endif //CAMERASCRIPT_H
@@ -0,0 +1,21 @@
+//
+// Created by raph on 08/02/25.
+//
+
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+/**
+ * Size for the logs and error messages, like "12.5 MiB"
+ */
+inline std::string mebibytes(uint64_t bytes) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1f MiB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+    return text;
+}
+
+#endif //FORMAT_H
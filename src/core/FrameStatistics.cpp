@@ -0,0 +1,67 @@
+//
+// Created by raph on 31/01/25.
+//
+
+#include "FrameStatistics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+#include "Statistics.h"
+
+namespace {
+    std::string summaryJson(const FrameTimeSummary& summary) {
+        char text[192];
+        std::snprintf(text, sizeof(text),
+                      "{\"count\": %zu, \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}",
+                      summary.count, summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+        return text;
+    }
+}
+
+FrameStatistics::FrameStatistics(uint64_t warmupFrames, size_t expectedFrames)
+    : warmupFrames(warmupFrames) {
+    cpu.reserve(expectedFrames);
+    gpu.reserve(expectedFrames);
+    present.reserve(expectedFrames);
+}
+
+void FrameStatistics::addCpuTime(uint64_t frame, double milliseconds) {
+    if (frame >= warmupFrames) {
+        cpu.push_back(milliseconds);
+    }
+}
+
+void FrameStatistics::addGpuTime(uint64_t frame, double milliseconds) {
+    if (frame >= warmupFrames) {
+        gpu.push_back(milliseconds);
+    }
+}
+
+void FrameStatistics::addPresentInterval(uint64_t frame, double milliseconds) {
+    if (frame >= warmupFrames) {
+        present.push_back(milliseconds);
+    }
+}
+
+FrameTimeSummary FrameStatistics::summarize(std::vector<double> samples) {
+    FrameTimeSummary summary;
+    if (samples.empty()) {
+        return summary;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    summary.count = samples.size();
+    summary.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+    summary.p50 = percentile(samples, 0.5);
+    summary.p95 = percentile(samples, 0.95);
+    summary.p99 = percentile(samples, 0.99);
+    summary.max = samples.back();
+    return summary;
+}
+
+std::string FrameStatistics::toJson() const {
+    return "{\"cpu\": " + summaryJson(getCpu()) + ", \"gpu\": " + summaryJson(getGpu()) +
+           ", \"present\": " + summaryJson(getPresent()) + "}";
+}
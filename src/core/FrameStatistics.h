@@ -0,0 +1,58 @@
+//
+// Created by raph on 31/01/25.
+//
+
+#ifndef FRAMESTATISTICS_H
+#define FRAMESTATISTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Distribution of one frame time, in milliseconds
+ */
+struct FrameTimeSummary {
+    size_t count = 0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+/**
+ * Frame times of a run, in milliseconds:
+ *  - cpu: update and command recording, without the waits on the fence and for the swap chain image
+ *  - gpu: first to last command of the frame, from timestamp queries, a few frames late
+ *  - present: between two successive presents, what the user sees
+ * Frames below warmupFrames are ignored, so pipeline creation, first uploads and driver warmup stay out.
+ */
+class FrameStatistics {
+public:
+    explicit FrameStatistics(uint64_t warmupFrames = 0, size_t expectedFrames = 0);
+
+    void addCpuTime(uint64_t frame, double milliseconds);
+    void addGpuTime(uint64_t frame, double milliseconds);
+    void addPresentInterval(uint64_t frame, double milliseconds);
+
+    FrameTimeSummary getCpu() const { return summarize(cpu); }
+    FrameTimeSummary getGpu() const { return summarize(gpu); }
+    FrameTimeSummary getPresent() const { return summarize(present); }
+
+    static FrameTimeSummary summarize(std::vector<double> samples);
+
+    /**
+     * {"cpu": {...}, "gpu": {...}, "present": {...}}, each with count, mean, p50, p95, p99 and max
+     */
+    std::string toJson() const;
+
+private:
+    uint64_t warmupFrames;
+    std::vector<double> cpu;
+    std::vector<double> gpu;
+    std::vector<double> present;
+};
+
+#endif //FRAMESTATISTICS_H
@@ -0,0 +1,361 @@
+//
+// Created by raph on 26/01/25.
+//
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    constexpr int IDLE_SPINS = 64;      // failed searches before a worker goes to sleep
+
+    thread_local JobSystem* currentSystem = nullptr;
+    thread_local void* currentState = nullptr;
+
+    // Slots this thread registered in, in any scheduler, handed back when it exits
+    struct SlotOwner {
+        std::vector<std::shared_ptr<std::atomic<bool>>> retired;
+        ~SlotOwner() {
+            for (auto& flag : retired) {
+                flag->store(true, std::memory_order_release);
+            }
+        }
+    };
+    thread_local SlotOwner slotOwner;
+
+    struct RangeContext {
+        JobSystem* system;
+        const JobSystem::RangeFunction* fn;
+        size_t grain;
+        JobSystem::Job* root;
+    };
+
+    // Hand the upper half to other threads until a single range is left, then run it
+    void splitRange(RangeContext& context, size_t begin, size_t end) {
+        while (end - begin > context.grain) {
+            size_t ranges = (end - begin + context.grain - 1) / context.grain;
+            size_t middle = begin + ranges / 2 * context.grain;
+            auto* upper = context.system->create([&context, middle, end] { splitRange(context, middle, end); }, context.root);
+            context.system->submit(upper);
+            end = middle;
+        }
+        (*context.fn)(begin, end);
+    }
+
+    uint64_t nextRandom(uint64_t& state) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+}
+
+bool JobSystem::Deque::push(Job* job) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= static_cast<int64_t>(DEQUE_SIZE)) {
+        return false;
+    }
+    buffer[b & (DEQUE_SIZE - 1)].store(job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+JobSystem::Job* JobSystem::Deque::pop() {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = buffer[b & (DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+    if (t == b) {
+        // Last job: race the thieves for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+JobSystem::Job* JobSystem::Deque::steal() {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) {
+        return nullptr;
+    }
+
+    Job* job = buffer[t & (DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return job;
+}
+
+JobSystem::JobSystem(size_t workerCount) {
+    workerCount = std::min(workerCount, MAX_THREADS - 1);
+    for (auto& thread : threads) {
+        thread = std::make_unique<ThreadState>();
+    }
+
+    // Workers take the first slots, the other threads register on their first call
+    threadCount.store(workerCount, std::memory_order_release);
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard lock(sleepMutex);
+        stopping.store(true);
+    }
+    wakeCondition.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+JobSystem& JobSystem::global() {
+    static JobSystem system;
+    return system;
+}
+
+size_t JobSystem::defaultWorkerCount() {
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+void JobSystem::addDependency(Job* job, Job* prerequisite) {
+    while (prerequisite->continuationLock.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    // Nothing to wait for once the prerequisite has finished
+    if (!prerequisite->continuationsSent) {
+        if (prerequisite->continuationCount == MAX_CONTINUATIONS) {
+            prerequisite->continuationLock.clear(std::memory_order_release);
+            throw std::runtime_error("Too many jobs depend on the same job");
+        }
+        job->blockers.fetch_add(1, std::memory_order_acq_rel);
+        prerequisite->continuations[prerequisite->continuationCount++] = job;
+    }
+    prerequisite->continuationLock.clear(std::memory_order_release);
+}
+
+void JobSystem::submit(Job* job) {
+    release(job);
+}
+
+void JobSystem::wait(const Job* job) {
+    ThreadState& state = getThreadState();
+    while (!isFinished(job)) {
+        if (Job* other = findJob(state)) {
+            execute(other);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grain, const RangeFunction& fn) {
+    if (end <= begin) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    if (end - begin <= grain) {
+        fn(begin, end);
+        return;
+    }
+
+    RangeContext context{this, &fn, grain, nullptr};
+    Job* root = create([&context, begin, end] { splitRange(context, begin, end); });
+    context.root = root;
+    submit(root);
+
+    // The root is on top of our own deque, waiting starts by running it
+    wait(root);
+}
+
+JobSystem::ThreadState& JobSystem::getThreadState() {
+    if (currentSystem == this) {
+        return *static_cast<ThreadState*>(currentState);
+    }
+
+    std::lock_guard lock(registerMutex);
+    const std::thread::id self = std::this_thread::get_id();
+    const size_t count = threadCount.load(std::memory_order_relaxed);
+
+    // The slot this thread took before it used another scheduler, else one left by a thread that has exited. A slot
+    // is taken over as is: jobs still queued in its deque or running from its pool stay valid
+    size_t index = count;
+    for (size_t i = workers.size(); i < count && index == count; i++) {
+        if (threads[i]->owner == self) {
+            index = i;
+        }
+    }
+    for (size_t i = workers.size(); i < count && index == count; i++) {
+        if (threads[i]->retired->load(std::memory_order_acquire)) {
+            index = i;
+        }
+    }
+    if (index == MAX_THREADS) {
+        throw std::runtime_error("More than " + std::to_string(MAX_THREADS) + " threads use the job system at once");
+    }
+
+    ThreadState& state = *threads[index];
+    if (!state.pool) {
+        state.pool = std::make_unique<Job[]>(POOL_SIZE);
+    }
+    state.random = 0x9E3779B97F4A7C15ull * (index + 1);
+    state.owner = self;
+    state.retired->store(false, std::memory_order_relaxed);
+    if (std::find(slotOwner.retired.begin(), slotOwner.retired.end(), state.retired) == slotOwner.retired.end()) {
+        slotOwner.retired.push_back(state.retired);
+    }
+    if (index == count) {
+        threadCount.store(count + 1, std::memory_order_release);
+    }
+
+    currentSystem = this;
+    currentState = &state;
+    return state;
+}
+
+JobSystem::Job* JobSystem::allocate() {
+    ThreadState& state = getThreadState();
+
+    // A busy slot is usually a job still queued on this thread: run queued jobs until it frees up. Long lived
+    // jobs (parents waiting on their children) are skipped once there is nothing left to run
+    size_t skipped = 0;
+    while (true) {
+        Job* job = &state.pool[state.nextJob & (POOL_SIZE - 1)];
+        if (isFinished(job)) {
+            state.nextJob++;
+            return job;
+        }
+
+        if (Job* other = findJob(state)) {
+            execute(other);
+        } else {
+            state.nextJob++;
+            if (++skipped == POOL_SIZE) {
+                // Every slot is in flight on other threads
+                std::this_thread::yield();
+                skipped = 0;
+            }
+        }
+    }
+}
+
+void JobSystem::schedule(Job* job) {
+    ThreadState& state = getThreadState();
+    if (!state.deque.push(job)) {
+        execute(job);
+        return;
+    }
+
+    queuedJobs.fetch_add(1);
+    if (sleepingWorkers.load() > 0) {
+        std::lock_guard lock(sleepMutex);
+        wakeCondition.notify_one();
+    }
+}
+
+void JobSystem::execute(Job* job) {
+    job->invoke(*job);
+    job->destroy(*job);
+    finish(job);
+}
+
+void JobSystem::finish(Job* job) {
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    // Read everything needed before done is set, the slot may be reused right after
+    Job* parent = job->parent;
+    while (job->continuationLock.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+    job->continuationsSent = true;
+    const uint32_t continuationCount = job->continuationCount;
+    std::array<Job*, MAX_CONTINUATIONS> continuations = job->continuations;
+    job->continuationLock.clear(std::memory_order_release);
+    job->done.store(true, std::memory_order_release);
+
+    for (uint32_t i = 0; i < continuationCount; i++) {
+        release(continuations[i]);
+    }
+    if (parent) {
+        finish(parent);
+    }
+}
+
+void JobSystem::release(Job* job) {
+    if (job->blockers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        schedule(job);
+    }
+}
+
+JobSystem::Job* JobSystem::findJob(ThreadState& state) {
+    if (Job* job = state.deque.pop()) {
+        queuedJobs.fetch_sub(1);
+        return job;
+    }
+
+    // Steal from a random victim first, so thieves spread over the deques
+    const size_t count = std::min(threadCount.load(std::memory_order_acquire), MAX_THREADS);
+    const size_t start = static_cast<size_t>(nextRandom(state.random) % count);
+    for (size_t i = 0; i < count; i++) {
+        ThreadState& victim = *threads[(start + i) % count];
+        if (&victim == &state) {
+            continue;
+        }
+        if (Job* job = victim.deque.steal()) {
+            queuedJobs.fetch_sub(1);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::workerLoop(size_t index) {
+    ThreadState& state = *threads[index];
+    state.pool = std::make_unique<Job[]>(POOL_SIZE);
+    state.random = 0x9E3779B97F4A7C15ull * (index + 1);
+    currentSystem = this;
+    currentState = &state;
+
+    int idle = 0;
+    while (!stopping.load(std::memory_order_relaxed)) {
+        if (Job* job = findJob(state)) {
+            execute(job);
+            idle = 0;
+            continue;
+        }
+
+        if (++idle < IDLE_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Sleep until a job is queued anywhere. Checked under the lock so a push cannot slip in unnoticed
+        std::unique_lock lock(sleepMutex);
+        sleepingWorkers.fetch_add(1);
+        wakeCondition.wait(lock, [this] { return stopping.load() || queuedJobs.load() > 0; });
+        sleepingWorkers.fetch_sub(1);
+        idle = 0;
+    }
+}
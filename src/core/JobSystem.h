@@ -0,0 +1,186 @@
+//
+// Created by raph on 26/01/25.
+//
+
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Work stealing scheduler. Every thread that uses it (workers, the main thread, the simulation thread...) owns a
+ * Chase-Lev deque: it pushes and pops jobs at the bottom of its own deque, idle threads steal from the top of the
+ * others. A thread waiting on a job runs other jobs meanwhile instead of sleeping, so waits can nest freely.
+ * Threads other than the workers register on their first call and give their slot back when they exit: at most
+ * MAX_THREADS threads use the scheduler at once, but any number can over time.
+ *
+ * Jobs come from a ring of slots owned by the thread that creates them, with their function stored inline:
+ * creating and running a job does not allocate. A job handle stays valid until its thread created POOL_SIZE
+ * more jobs, which is far more than anything waits on at once.
+ */
+class JobSystem {
+public:
+    using RangeFunction = std::function<void(size_t begin, size_t end)>;
+
+    static constexpr size_t MAX_THREADS = 64;
+    static constexpr size_t DEQUE_SIZE = 4096;
+    static constexpr size_t POOL_SIZE = 4096;
+    static constexpr size_t STORAGE_SIZE = 48;
+    static constexpr size_t MAX_CONTINUATIONS = 8;
+
+    struct Job {
+        void (*invoke)(Job& job) = nullptr;
+        void (*destroy)(Job& job) = nullptr;
+        alignas(std::max_align_t) unsigned char storage[STORAGE_SIZE];
+
+        Job* parent = nullptr;
+        std::atomic<int32_t> unfinished{0};         // the job itself and its unfinished children
+        std::atomic<int32_t> blockers{0};           // submit() and the unfinished dependencies
+        std::atomic<bool> done{true};
+
+        std::atomic_flag continuationLock = ATOMIC_FLAG_INIT;
+        bool continuationsSent = false;
+        uint32_t continuationCount = 0;
+        std::array<Job*, MAX_CONTINUATIONS> continuations{};
+    };
+
+    explicit JobSystem(size_t workerCount = defaultWorkerCount());
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /**
+     * Prepare a job, it does not run before submit()
+     * @param function callable without arguments, its captures must fit in STORAGE_SIZE bytes
+     * @param parent job that only finishes once this one has; it must not have finished yet
+     */
+    template<typename Function>
+    Job* create(Function&& function, Job* parent = nullptr);
+
+    /**
+     * Run job only once prerequisite and all its children have finished. Call before submit(job)
+     */
+    void addDependency(Job* job, Job* prerequisite);
+
+    /**
+     * Hand the job to the scheduler, it runs as soon as its dependencies are met
+     */
+    void submit(Job* job);
+
+    /**
+     * Run other jobs until job and its children have finished
+     */
+    void wait(const Job* job);
+
+    bool isFinished(const Job* job) const { return job->done.load(std::memory_order_acquire); }
+
+    /**
+     * Run fn over [begin, end) split into ranges of at most grain elements, and wait for all of them.
+     * Ranges start at begin + k * grain. The range is split in halves recursively, so idle threads steal large
+     * pieces first; the caller works on it too and may be called from inside a job
+     */
+    void parallelFor(size_t begin, size_t end, size_t grain, const RangeFunction& fn);
+
+    /**
+     * Threads that can run jobs at the same time, including the caller
+     */
+    size_t getConcurrency() const { return workers.size() + 1; }
+
+    /**
+     * Scheduler shared by the whole application, created on first use
+     */
+    static JobSystem& global();
+
+    static size_t defaultWorkerCount();
+
+private:
+    /**
+     * Chase-Lev deque of fixed capacity. Only the owner pushes and pops, any thread steals
+     */
+    class Deque {
+    public:
+        bool push(Job* job);
+        Job* pop();
+        Job* steal();
+
+    private:
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+        alignas(64) std::array<std::atomic<Job*>, DEQUE_SIZE> buffer{};
+    };
+
+    struct ThreadState {
+        Deque deque;
+        std::unique_ptr<Job[]> pool;
+        size_t nextJob = 0;
+        uint64_t random = 0;
+
+        // Registered threads only. The flag outlives the scheduler, the exiting thread sets it from a thread_local
+        std::thread::id owner;
+        std::shared_ptr<std::atomic<bool>> retired = std::make_shared<std::atomic<bool>>(false);
+    };
+
+    ThreadState& getThreadState();
+    Job* allocate();
+    void schedule(Job* job);
+    void execute(Job* job);
+    void finish(Job* job);
+    void release(Job* job);
+    Job* findJob(ThreadState& state);
+    void workerLoop(size_t index);
+
+    template<typename Function>
+    static void invokeStored(Job& job) { (*std::launder(reinterpret_cast<Function*>(job.storage)))(); }
+
+    template<typename Function>
+    static void destroyStored(Job& job) { std::launder(reinterpret_cast<Function*>(job.storage))->~Function(); }
+
+    std::array<std::unique_ptr<ThreadState>, MAX_THREADS> threads;
+    std::atomic<size_t> threadCount{0};
+    std::mutex registerMutex;
+    std::vector<std::thread> workers;
+
+    std::atomic<int64_t> queuedJobs{0};
+    std::atomic<int32_t> sleepingWorkers{0};
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<bool> stopping{false};
+};
+
+template<typename Function>
+JobSystem::Job* JobSystem::create(Function&& function, Job* parent) {
+    using Stored = std::decay_t<Function>;
+    static_assert(sizeof(Stored) <= STORAGE_SIZE, "Job captures are too large, capture a struct by reference instead");
+    static_assert(alignof(Stored) <= alignof(std::max_align_t), "Job captures are over aligned");
+
+    Job* job = allocate();
+    new (job->storage) Stored(std::forward<Function>(function));
+    job->invoke = &invokeStored<Stored>;
+    job->destroy = &destroyStored<Stored>;
+    job->parent = parent;
+    job->unfinished.store(1, std::memory_order_relaxed);
+    job->blockers.store(1, std::memory_order_relaxed);
+    job->continuationsSent = false;
+    job->continuationCount = 0;
+    job->done.store(false, std::memory_order_release);
+
+    if (parent) {
+        parent->unfinished.fetch_add(1, std::memory_order_acq_rel);
+    }
+    return job;
+}
+
+#endif //JOBSYSTEM_H
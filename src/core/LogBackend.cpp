@@ -0,0 +1,394 @@
+//
+// Created by raph on 27/01/25.
+//
+
+#include "LogBackend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "Logger.h"
+
+namespace {
+    constexpr auto IDLE_TIMEOUT = std::chrono::milliseconds(50);   // safety net, pushes wake the writer
+
+    thread_local void* threadRing = nullptr;
+
+    struct RingOwner {
+        std::atomic<bool>* retired = nullptr;
+        ~RingOwner() {
+            if (retired) {
+                retired->store(true, std::memory_order_release);
+            }
+        }
+    };
+    thread_local RingOwner ringOwner;
+
+    bool isError(uint8_t level) {
+        return level >= static_cast<uint8_t>(Logger::Level::ERROR);
+    }
+
+    int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    template<typename T>
+    void appendRaw(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+}
+
+std::atomic<size_t> LogBackend::componentWidth{15};
+
+LogBackend::LogBackend() {
+    running.store(true, std::memory_order_release);
+    writer = std::thread(&LogBackend::writerLoop, this);
+}
+
+LogBackend& LogBackend::instance() {
+    // Leaked on purpose: threads may still log, or exit and retire their ring, while statics are destroyed
+    static LogBackend* backend = [] {
+        auto* created = new LogBackend();
+        std::atexit([] { instance().shutdown(); });
+        return created;
+    }();
+    return *backend;
+}
+
+const std::string* LogBackend::intern(std::string_view component) {
+    std::lock_guard lock(componentMutex);
+    auto it = components.find(component);
+    if (it == components.end()) {
+        it = components.emplace(component).first;
+    }
+    return &*it;
+}
+
+void LogBackend::reserveComponentWidth(size_t width) {
+    size_t current = componentWidth.load(std::memory_order_relaxed);
+    while (current < width && !componentWidth.compare_exchange_weak(current, width, std::memory_order_relaxed)) {
+    }
+}
+
+LogBackend::Ring& LogBackend::getThreadRing() {
+    if (threadRing) {
+        return *static_cast<Ring*>(threadRing);
+    }
+
+    std::lock_guard lock(ringMutex);
+    Ring* ring = nullptr;
+    for (auto& candidate : rings) {
+        // A ring left by an exited thread can be taken over once the writer has emptied it
+        if (candidate->retired.load(std::memory_order_acquire) &&
+            candidate->tail.load(std::memory_order_acquire) == candidate->head.load(std::memory_order_relaxed)) {
+            ring = candidate.get();
+            ring->retired.store(false, std::memory_order_relaxed);
+            break;
+        }
+    }
+    if (!ring) {
+        rings.push_back(std::make_unique<Ring>());
+        ring = rings.back().get();
+    }
+
+    threadRing = ring;
+    ringOwner.retired = &ring->retired;
+    return *ring;
+}
+
+void LogBackend::push(uint8_t level, uint8_t flags, const std::string* component, const char* format, std::string_view payload) {
+    Record record{};
+    record.timestamp = now();
+    record.component = component;
+    record.format = format;
+    record.level = level;
+    record.flags = flags;
+
+    if (!running.load(std::memory_order_acquire)) {
+        std::lock_guard lock(syncMutex);
+        write(record, payload);
+        flushOutput();
+        return;
+    }
+
+    // Plain text can be cut, encoded arguments cannot
+    if (payload.size() > MAX_PAYLOAD) {
+        if (format) {
+            payload = "(arguments too large to log)";
+            record.format = nullptr;
+        } else {
+            payload = payload.substr(0, MAX_PAYLOAD);
+        }
+    }
+    const uint64_t size = (sizeof(Record) + payload.size() + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+    record.size = static_cast<uint32_t>(size);
+    record.length = static_cast<uint32_t>(payload.size());
+    Ring& ring = getThreadRing();
+
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    uint64_t offset = head % RING_SIZE;
+    const uint64_t padding = RING_SIZE - offset < size ? RING_SIZE - offset : 0;
+
+    // Full: let the writer catch up
+    while (RING_SIZE - (head - ring.tail.load(std::memory_order_acquire)) < size + padding) {
+        wake();
+        std::this_thread::yield();
+    }
+
+    // Records never wrap, the end of the ring is skipped instead. An end too short for a header is skipped implicitly
+    if (padding) {
+        if (padding >= sizeof(Record)) {
+            Record skip{};
+            skip.size = static_cast<uint32_t>(padding);
+            skip.flags = SKIP;
+            std::memcpy(ring.buffer.get() + offset, &skip, sizeof(Record));
+        }
+        head += padding;
+        offset = 0;
+    }
+
+    std::memcpy(ring.buffer.get() + offset, &record, sizeof(Record));
+    std::memcpy(ring.buffer.get() + offset + sizeof(Record), payload.data(), payload.size());
+    ring.head.store(head + size, std::memory_order_release);
+
+    // Pairs with the writer announcing it sleeps then checking the rings
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed)) {
+        wake();
+    }
+}
+
+void LogBackend::wake() {
+    if (sleeping.exchange(false)) {
+        std::lock_guard lock(wakeMutex);
+        wakeCondition.notify_one();
+    }
+}
+
+void LogBackend::flush() {
+    std::unique_lock lock(wakeMutex);
+    if (!running.load(std::memory_order_acquire)) {
+        return;
+    }
+    const uint64_t ticket = ++flushRequests;
+    wakeCondition.notify_one();
+    flushedCondition.wait(lock, [&] { return flushesDone >= ticket; });
+}
+
+void LogBackend::openBinarySink(const std::string& path) {
+    closeBinarySink();
+
+    std::lock_guard lock(syncMutex);
+    binaryFile = std::fopen(path.c_str(), "wb");
+    if (!binaryFile) {
+        throw std::runtime_error("Failed to open binary log " + path);
+    }
+    binaryOutput.assign(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    binaryComponents.clear();
+    binaryFormats.clear();
+}
+
+void LogBackend::closeBinarySink() {
+    flush();
+
+    std::lock_guard lock(syncMutex);
+    if (binaryFile) {
+        flushOutput();
+        std::fclose(binaryFile);
+        binaryFile = nullptr;
+    }
+}
+
+void LogBackend::shutdown() {
+    {
+        std::lock_guard lock(wakeMutex);
+        if (!running.load(std::memory_order_acquire)) {
+            return;
+        }
+        stopping = true;
+    }
+    wakeCondition.notify_one();
+    writer.join();
+
+    // Records pushed while the writer was stopping
+    std::lock_guard lock(syncMutex);
+    running.store(false, std::memory_order_release);
+    while (drain()) {
+    }
+    if (binaryFile) {
+        std::fclose(binaryFile);
+        binaryFile = nullptr;
+    }
+}
+
+void LogBackend::writerLoop() {
+    std::unique_lock lock(wakeMutex);
+    while (true) {
+        const uint64_t requested = flushRequests;
+        const bool stop = stopping;
+        lock.unlock();
+        {
+            std::lock_guard syncLock(syncMutex);
+            while (drain()) {
+            }
+        }
+        lock.lock();
+
+        if (requested > flushesDone) {
+            flushesDone = requested;
+            flushedCondition.notify_all();
+        }
+        if (stop) {
+            // Nothing is left to write, release the flushes that came in meanwhile
+            flushesDone = flushRequests;
+            flushedCondition.notify_all();
+            break;
+        }
+        if (stopping || flushRequests > flushesDone) {
+            continue;
+        }
+
+        // Announce the sleep before the last look at the rings, so a push either sees it or gets drained
+        sleeping.store(true);
+        bool pending = false;
+        {
+            std::lock_guard ringLock(ringMutex);
+            for (auto& ring : rings) {
+                pending = pending || ring->tail.load(std::memory_order_relaxed) != ring->head.load(std::memory_order_acquire);
+            }
+        }
+        if (!pending) {
+            wakeCondition.wait_for(lock, IDLE_TIMEOUT);
+        }
+        sleeping.store(false);
+    }
+}
+
+bool LogBackend::drain() {
+    struct Cursor {
+        Ring* ring;
+        uint64_t tail;
+        uint64_t head;
+    };
+
+    std::vector<Cursor> cursors;
+    {
+        std::lock_guard lock(ringMutex);
+        cursors.reserve(rings.size());
+        for (auto& ring : rings) {
+            cursors.push_back({ring.get(), ring->tail.load(std::memory_order_relaxed), ring->head.load(std::memory_order_acquire)});
+        }
+    }
+
+    auto peek = [](Cursor& cursor) -> const Record* {
+        while (cursor.tail < cursor.head) {
+            const uint64_t offset = cursor.tail % RING_SIZE;
+            if (RING_SIZE - offset < sizeof(Record)) {
+                cursor.tail += RING_SIZE - offset;
+                continue;
+            }
+            auto* record = reinterpret_cast<const Record*>(cursor.ring->buffer.get() + offset);
+            if (!(record->flags & SKIP)) {
+                return record;
+            }
+            cursor.tail += record->size;
+        }
+        return nullptr;
+    };
+
+    // Each ring is in order already, merge them by timestamp
+    bool wrote = false;
+    while (true) {
+        Cursor* next = nullptr;
+        const Record* nextRecord = nullptr;
+        for (auto& cursor : cursors) {
+            const Record* record = peek(cursor);
+            if (record && (!nextRecord || record->timestamp < nextRecord->timestamp)) {
+                next = &cursor;
+                nextRecord = record;
+            }
+        }
+        if (!nextRecord) {
+            break;
+        }
+
+        const auto* payload = reinterpret_cast<const char*>(nextRecord) + sizeof(Record);
+        write(*nextRecord, std::string_view(payload, nextRecord->length));
+        next->tail += nextRecord->size;
+        wrote = true;
+    }
+    flushOutput();
+
+    for (auto& cursor : cursors) {
+        cursor.ring->tail.store(cursor.tail, std::memory_order_release);
+    }
+    return wrote;
+}
+
+void LogBackend::write(const Record& record, std::string_view payload) {
+    if (binaryFile) {
+        writeBinary(record, payload);
+        if (record.level < static_cast<uint8_t>(Logger::Level::WARNING)) {
+            return;
+        }
+    }
+
+    // Keep the order of the records across the two streams
+    if (isError(record.level) != errorStream) {
+        flushOutput();
+        errorStream = isError(record.level);
+    }
+
+    std::string_view text = payload;
+    if (record.format) {
+        message.clear();
+        LogArguments::format(message, record.format, reinterpret_cast<const unsigned char*>(payload.data()), payload.size());
+        text = message;
+    }
+    formatter.appendLine(output, record.timestamp, record.level, record.flags & COLORS, record.flags & TIMESTAMP,
+                         *record.component, getComponentWidth(), text);
+}
+
+void LogBackend::writeBinary(const Record& record, std::string_view payload) {
+    const uint32_t component = defineBinary(BinaryEntry::COMPONENT, binaryComponents, record.component, *record.component);
+    const uint32_t format = record.format ? defineBinary(BinaryEntry::FORMAT, binaryFormats, record.format, record.format) : 0;
+
+    appendRaw(binaryOutput, BinaryEntry::RECORD);
+    appendRaw(binaryOutput, record.timestamp);
+    appendRaw(binaryOutput, record.level);
+    appendRaw(binaryOutput, component);
+    appendRaw(binaryOutput, format);
+    appendRaw(binaryOutput, static_cast<uint32_t>(payload.size()));
+    binaryOutput += payload;
+}
+
+uint32_t LogBackend::defineBinary(BinaryEntry type, std::unordered_map<const void*, uint32_t>& ids, const void* key,
+                                  std::string_view text) {
+    auto [it, inserted] = ids.try_emplace(key, static_cast<uint32_t>(ids.size() + 1));
+    if (inserted) {
+        appendRaw(binaryOutput, type);
+        appendRaw(binaryOutput, it->second);
+        appendRaw(binaryOutput, static_cast<uint32_t>(text.size()));
+        binaryOutput += text;
+    }
+    return it->second;
+}
+
+void LogBackend::flushOutput() {
+    if (!output.empty()) {
+        std::ostream& stream = errorStream ? std::cerr : std::cout;
+        stream.write(output.data(), static_cast<std::streamsize>(output.size()));
+        stream.flush();
+        output.clear();
+    }
+    if (binaryFile && !binaryOutput.empty()) {
+        std::fwrite(binaryOutput.data(), 1, binaryOutput.size(), binaryFile);
+        std::fflush(binaryFile);
+        binaryOutput.clear();
+    }
+}
@@ -0,0 +1,158 @@
+//
+// Created by raph on 27/01/25.
+//
+
+#ifndef LOGBACKEND_H
+#define LOGBACKEND_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "LogFormat.h"
+
+/**
+ * Writes the Logger records on a background thread. Every thread that logs gets its own single producer ring:
+ * logging copies the message, or the format pointer and encoded arguments, into it and returns. The writer
+ * thread merges the rings by timestamp, formats the records and writes them in batches.
+ *
+ * The backend is never destroyed: its thread is stopped and drained at exit, after which records are written
+ * synchronously. Rings outlive their threads and are reused by the next thread that logs.
+ *
+ * A binary sink can be opened next to the console. It stores records unformatted and LogDecode turns it back
+ * into text. The file starts with BINARY_MAGIC, then a sequence of entries in native byte order:
+ *  - COMPONENT: u8 type, u32 id, u32 length, name
+ *  - FORMAT:    u8 type, u32 id, u32 length, format string
+ *  - RECORD:    u8 type, i64 timestamp (ns since epoch), u8 level, u32 component id, u32 format id, u32 length,
+ *               encoded arguments, or plain text when the format id is 0
+ * Components and formats are defined once, before the first record that uses them.
+ */
+class LogBackend {
+public:
+    enum Flags : uint8_t {
+        COLORS = 1 << 0,
+        TIMESTAMP = 1 << 1,
+        SKIP = 1 << 2,      // padding up to the end of the ring
+    };
+
+    enum class BinaryEntry : uint8_t {
+        COMPONENT = 1,
+        FORMAT = 2,
+        RECORD = 3,
+    };
+
+    /**
+     * Record as stored in a ring, followed by the message or the encoded arguments
+     */
+    struct Record {
+        int64_t timestamp;              // system clock, nanoseconds since epoch
+        const std::string* component;   // interned, never freed
+        const char* format;             // string literal, nullptr when the payload is plain text
+        uint32_t size;                  // bytes taken in the ring, header included
+        uint32_t length;                // payload bytes
+        uint8_t level;
+        uint8_t flags;
+    };
+
+    static constexpr char BINARY_MAGIC[8] = {'V', 'G', 'L', 'O', 'G', '0', '0', '1'};
+    static constexpr size_t RING_SIZE = 256 * 1024;
+    static constexpr size_t RECORD_ALIGNMENT = 8;
+    static constexpr size_t MAX_PAYLOAD = RING_SIZE / 4;
+
+    static LogBackend& instance();
+
+    /**
+     * Stable copy of a component name, shared by all the loggers of that component
+     */
+    const std::string* intern(std::string_view component);
+
+    /**
+     * Queue a record from the calling thread. Only waits when the ring of this thread is full
+     * @param format string literal the payload holds the arguments of, nullptr for a plain text payload
+     */
+    void push(uint8_t level, uint8_t flags, const std::string* component, const char* format, std::string_view payload);
+
+    /**
+     * Wait until every record queued before the call is written
+     */
+    void flush();
+
+    /**
+     * Also write every record to a binary file. While it is open, the console only gets warnings and errors
+     */
+    void openBinarySink(const std::string& path);
+    void closeBinarySink();
+
+    /**
+     * Drain the rings and stop the writer thread, later records are written synchronously
+     */
+    void shutdown();
+
+    /**
+     * Widen the component column so that name fits
+     */
+    static void reserveComponentWidth(size_t width);
+    static size_t getComponentWidth() { return componentWidth.load(std::memory_order_relaxed); }
+
+private:
+    struct Ring {
+        std::unique_ptr<unsigned char[]> buffer = std::make_unique<unsigned char[]>(RING_SIZE);
+        alignas(64) std::atomic<uint64_t> head{0};     // bytes written, advanced by the owner thread
+        alignas(64) std::atomic<uint64_t> tail{0};     // bytes consumed, advanced by the writer thread
+        std::atomic<bool> retired{false};              // the owner thread has exited
+    };
+
+    LogBackend();
+
+    Ring& getThreadRing();
+    void wake();
+    void writerLoop();
+    bool drain();
+    void write(const Record& record, std::string_view payload);
+    void writeBinary(const Record& record, std::string_view payload);
+    uint32_t defineBinary(BinaryEntry type, std::unordered_map<const void*, uint32_t>& ids, const void* key, std::string_view text);
+    void flushOutput();
+
+    static std::atomic<size_t> componentWidth;
+
+    std::mutex componentMutex;
+    std::set<std::string, std::less<>> components;
+
+    std::mutex ringMutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+
+    // Writer thread
+    std::thread writer;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable flushedCondition;
+    std::atomic<bool> sleeping{false};
+    std::atomic<bool> running{false};
+    bool stopping = false;
+    uint64_t flushRequests = 0;
+    uint64_t flushesDone = 0;
+
+    // Only touched by the writer, or under syncMutex once it has stopped
+    std::mutex syncMutex;
+    LogFormatter formatter;
+    std::string message;
+    std::string output;
+    bool errorStream = false;
+
+    FILE* binaryFile = nullptr;
+    std::string binaryOutput;
+    std::unordered_map<const void*, uint32_t> binaryComponents;
+    std::unordered_map<const void*, uint32_t> binaryFormats;
+};
+
+#endif //LOGBACKEND_H
@@ -0,0 +1,181 @@
+//
+// Created by raph on 28/01/25.
+//
+
+#include "LogFormat.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+
+#include "Logger.h"
+
+namespace {
+    template<typename T>
+    T read(const unsigned char*& in) {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return value;
+    }
+
+    template<typename T>
+    void appendNumber(std::string& out, T value) {
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+    void appendPadded(std::string& out, std::string_view text, size_t width) {
+        out += text;
+        if (text.size() < width) {
+            out.append(width - text.size(), ' ');
+        }
+    }
+}
+
+void LogArguments::format(std::string& out, std::string_view format, const unsigned char* arguments, size_t size) {
+    const unsigned char* in = arguments;
+    const unsigned char* end = arguments + size;
+
+    size_t position = 0;
+    while (position < format.size()) {
+        const size_t open = format.find('{', position);
+        const size_t close = open == std::string_view::npos ? open : format.find('}', open);
+        if (close == std::string_view::npos) {
+            out += format.substr(position);
+            break;
+        }
+        out += format.substr(position, open - position);
+        position = close + 1;
+
+        if (in >= end) {
+            out += "{?}";
+            continue;
+        }
+
+        // Only floats take a precision, like std::to_string they default to 6 decimals
+        int precision = 6;
+        const std::string_view spec = format.substr(open + 1, close - open - 1);
+        if (spec.size() > 2 && spec[0] == ':' && spec[1] == '.') {
+            std::from_chars(spec.data() + 2, spec.data() + spec.size(), precision);
+        }
+
+        switch (static_cast<Type>(*in++)) {
+            case Type::SIGNED:
+                appendNumber(out, read<int64_t>(in));
+                break;
+            case Type::UNSIGNED:
+                appendNumber(out, read<uint64_t>(in));
+                break;
+            case Type::FLOAT: {
+                char buffer[64];
+                int length = std::snprintf(buffer, sizeof(buffer), "%.*f", precision, read<double>(in));
+                out.append(buffer, std::min<size_t>(length, sizeof(buffer) - 1));
+                break;
+            }
+            case Type::BOOL:
+                out += read<uint8_t>(in) ? "true" : "false";
+                break;
+            case Type::CHAR:
+                out += read<char>(in);
+                break;
+            case Type::STRING: {
+                const auto length = read<uint32_t>(in);
+                out.append(reinterpret_cast<const char*>(in), length);
+                in += length;
+                break;
+            }
+            case Type::POINTER: {
+                char buffer[24];
+                int length = std::snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(read<uint64_t>(in)));
+                out.append(buffer, length);
+                break;
+            }
+            default:
+                // Corrupted record, nothing after this can be trusted
+                out += "{corrupted}";
+                in = end;
+                break;
+        }
+    }
+}
+
+void LogFormatter::appendLine(std::string& out, int64_t timestamp, uint8_t level, bool colors, bool showTimestamp,
+                              std::string_view component, size_t componentWidth, std::string_view message) {
+    if (showTimestamp) {
+        const int64_t second = timestamp / 1'000'000'000;
+        if (second != cachedSecond) {
+            std::time_t time = static_cast<std::time_t>(second);
+            std::tm local{};
+            localtime_r(&time, &local);
+            std::strftime(cachedTime, sizeof(cachedTime), "%Y-%m-%d %H:%M:%S", &local);
+            cachedSecond = second;
+        }
+        const int milliseconds = static_cast<int>(timestamp / 1'000'000 % 1000);
+        const char millisecondText[4] = {
+            char('0' + milliseconds / 100), char('0' + milliseconds / 10 % 10), char('0' + milliseconds % 10), '\0'
+        };
+        out += '[';
+        out += cachedTime;
+        out += '.';
+        out += millisecondText;
+        out += "] ";
+    }
+
+    if (colors) {
+        out += levelColor(level);
+    }
+    appendPadded(out, levelName(level), LEVEL_WIDTH);
+    if (colors) {
+        out += Logger::Colors::RESET;
+    }
+
+    out += ' ';
+    if (colors) {
+        out += Logger::Colors::CYAN;
+    }
+    appendPadded(out, component, componentWidth);
+    if (colors) {
+        out += Logger::Colors::RESET;
+    }
+    out += ' ';
+
+    // One indented line per message line
+    size_t start = 0;
+    while (start < message.size()) {
+        size_t end = message.find('\n', start);
+        if (end == std::string_view::npos) {
+            end = message.size();
+        }
+        out += "    ";
+        out += message.substr(start, end - start);
+        out += '\n';
+        start = end + 1;
+    }
+}
+
+const char* LogFormatter::levelName(uint8_t level) {
+    switch (static_cast<Logger::Level>(level)) {
+        case Logger::Level::TRACE:   return "TRACE";
+        case Logger::Level::DEBUG:   return "DEBUG";
+        case Logger::Level::INFO:    return "INFO";
+        case Logger::Level::WARNING: return "WARN";
+        case Logger::Level::ERROR:   return "ERROR";
+        case Logger::Level::FATAL:   return "FATAL";
+        default:                     return "UNKNOWN";
+    }
+}
+
+const char* LogFormatter::levelColor(uint8_t level) {
+    switch (static_cast<Logger::Level>(level)) {
+        case Logger::Level::TRACE:   return Logger::Colors::BLUE;
+        case Logger::Level::DEBUG:   return Logger::Colors::CYAN;
+        case Logger::Level::INFO:    return Logger::Colors::GREEN;
+        case Logger::Level::WARNING: return Logger::Colors::YELLOW;
+        case Logger::Level::ERROR:   return Logger::Colors::RED;
+        case Logger::Level::FATAL:   return Logger::Colors::MAGENTA;
+        default:                     return Logger::Colors::RESET;
+    }
+}
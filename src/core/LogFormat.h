@@ -0,0 +1,146 @@
+//
+// Created by raph on 28/01/25.
+//
+
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * Format string of a log call: "{}" stands for the next argument, "{:.N}" prints a floating point one with N
+ * decimals. The string must be a literal (checked at compile time, as is the placeholder count): records keep
+ * the pointer and are formatted later, on the writer thread or by LogDecode.
+ */
+template<typename... Args>
+struct LogFormat {
+    consteval LogFormat(const char* text) : text(text) {
+        if (countPlaceholders(text) != sizeof...(Args)) {
+            throw "The log format does not have one placeholder per argument";
+        }
+    }
+
+    static consteval size_t countPlaceholders(const char* text) {
+        size_t count = 0;
+        for (const char* c = text; *c; c++) {
+            if (*c == '{') {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    const char* text;
+};
+
+/**
+ * Binary encoding of log arguments: a type byte followed by the raw value. Strings are copied, everything else
+ * takes 9 bytes at most, so capturing the arguments costs a few stores instead of formatting them.
+ */
+class LogArguments {
+public:
+    enum class Type : uint8_t {
+        SIGNED,
+        UNSIGNED,
+        FLOAT,
+        BOOL,
+        CHAR,
+        STRING,
+        POINTER,
+    };
+
+    template<typename T>
+    static size_t encodedSize(const T& value);
+
+    template<typename T>
+    static unsigned char* encode(unsigned char* out, const T& value);
+
+    /**
+     * Expand format with encoded arguments, the bytes written by encode() one argument after the other
+     */
+    static void format(std::string& out, std::string_view format, const unsigned char* arguments, size_t size);
+
+private:
+    template<typename T>
+    static unsigned char* encodeRaw(unsigned char* out, Type type, const T& value) {
+        *out++ = static_cast<unsigned char>(type);
+        std::memcpy(out, &value, sizeof(T));
+        return out + sizeof(T);
+    }
+
+    static unsigned char* encodeString(unsigned char* out, std::string_view text) {
+        const auto length = static_cast<uint32_t>(text.size());
+        out = encodeRaw(out, Type::STRING, length);
+        std::memcpy(out, text.data(), length);
+        return out + length;
+    }
+
+    template<typename T>
+    static constexpr bool isString = std::is_convertible_v<const T&, std::string_view>;
+};
+
+/**
+ * Turns records into the console line format, shared by the writer thread and LogDecode
+ */
+class LogFormatter {
+public:
+    static constexpr size_t LEVEL_WIDTH = 5;
+
+    /**
+     * Append "[time] LEVEL component     message", with every message line on its own indented line
+     * @param timestamp system clock, nanoseconds since epoch
+     */
+    void appendLine(std::string& out, int64_t timestamp, uint8_t level, bool colors, bool showTimestamp,
+                    std::string_view component, size_t componentWidth, std::string_view message);
+
+    static const char* levelName(uint8_t level);
+    static const char* levelColor(uint8_t level);
+
+private:
+    // localtime only runs once per second
+    int64_t cachedSecond = -1;
+    char cachedTime[32]{};
+};
+
+template<typename T>
+size_t LogArguments::encodedSize(const T& value) {
+    if constexpr (isString<T>) {
+        return 1 + sizeof(uint32_t) + std::string_view(value).size();
+    } else if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, char>) {
+        return 2;
+    } else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>) {
+        return 1 + 8;
+    } else {
+        static_assert(std::is_arithmetic_v<T>, "Unsupported log argument type, convert it to a string or a number");
+        return 0;
+    }
+}
+
+template<typename T>
+unsigned char* LogArguments::encode(unsigned char* out, const T& value) {
+    if constexpr (isString<T>) {
+        return encodeString(out, std::string_view(value));
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return encodeRaw(out, Type::BOOL, static_cast<uint8_t>(value));
+    } else if constexpr (std::is_same_v<T, char>) {
+        return encodeRaw(out, Type::CHAR, value);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return encodeRaw(out, Type::FLOAT, static_cast<double>(value));
+    } else if constexpr (std::is_enum_v<T>) {
+        return encode(out, static_cast<std::underlying_type_t<T>>(value));
+    } else if constexpr (std::is_pointer_v<T>) {
+        return encodeRaw(out, Type::POINTER, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+    } else if constexpr (std::is_signed_v<T>) {
+        return encodeRaw(out, Type::SIGNED, static_cast<int64_t>(value));
+    } else {
+        return encodeRaw(out, Type::UNSIGNED, static_cast<uint64_t>(value));
+    }
+}
+
+#endif //LOGFORMAT_H
@@ -4,56 +4,35 @@
 
 #include "Logger.h"
 
-#include <iostream>
-#include <chrono>
-#include <iomanip>
-#include <ctime>
-
-
-std::map<std::string, size_t> Logger::maxLengths = {
-    {"LEVEL", 5},
-    {"COMPONENT", 15} // updated dynamically
-};
+#include "LogBackend.h"
 
 
 Logger::Logger(std::string component)
-    : componentName(std::move(component))
+    : componentName(LogBackend::instance().intern(component))
     , minimumLevel(Level::DEBUG)
     , useColors(true)
     , showTimestamp(true) {
-    maxLengths["COMPONENT"] = std::max(maxLengths["COMPONENT"], componentName.size());
+    LogBackend::reserveComponentWidth(componentName->size());
 }
 
 void Logger::log(Level level, const std::string& message) {
     if (level < minimumLevel) return;
+    push(level, nullptr, message);
+}
 
-    std::stringstream ss;
-
-    if (showTimestamp) {
-        ss << "[" << getCurrentTime() << "] ";
-    }
-
-
-
-    std::string levelStr = levelToString(level);
+void Logger::push(Level level, const char* format, std::string_view payload) {
+    uint8_t flags = 0;
     if (useColors) {
-        ss << levelToColor(level);
+        flags |= LogBackend::COLORS;
     }
-    ss << std::left << std::setw(maxLengths["LEVEL"]) << levelStr;
-    if (useColors) {
-        ss << Colors::RESET;
+    if (showTimestamp) {
+        flags |= LogBackend::TIMESTAMP;
     }
 
-    ss << " " << Colors::CYAN
-       << std::left << std::setw(maxLengths["COMPONENT"]) << componentName
-       << Colors::RESET;
-
-    ss << " " << formatMessage(message);
-
+    LogBackend& backend = LogBackend::instance();
+    backend.push(static_cast<uint8_t>(level), flags, componentName, format, payload);
     if (level >= Level::ERROR) {
-        std::cerr << ss.str();
-    } else {
-        std::cout << ss.str();
+        backend.flush();
     }
 }
 
@@ -64,51 +43,14 @@ void Logger::warning(const std::string& message) { log(Level::WARNING, message);
 void Logger::error(const std::string& message) { log(Level::ERROR, message); }
 void Logger::fatal(const std::string& message) { log(Level::FATAL, message); }
 
-std::string Logger::levelToString(Level level) {
-    switch (level) {
-        case Level::TRACE:   return "TRACE";
-        case Level::DEBUG:   return "DEBUG";
-        case Level::INFO:    return "INFO";
-        case Level::WARNING: return "WARN";
-        case Level::ERROR:   return "ERROR";
-        case Level::FATAL:   return "FATAL";
-        default:            return "UNKNOWN";
-    }
+void Logger::flush() {
+    LogBackend::instance().flush();
 }
 
-const char* Logger::levelToColor(Level level) {
-    switch (level) {
-        case Level::TRACE:   return Colors::BLUE;
-        case Level::DEBUG:   return Colors::CYAN;
-        case Level::INFO:    return Colors::GREEN;
-        case Level::WARNING: return Colors::YELLOW;
-        case Level::ERROR:   return Colors::RED;
-        case Level::FATAL:   return Colors::MAGENTA;
-        default:            return Colors::RESET;
-    }
+void Logger::openBinaryLog(const std::string& path) {
+    LogBackend::instance().openBinarySink(path);
 }
 
-std::string Logger::getCurrentTime() {
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S");
-    ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
-    return ss.str();
+void Logger::closeBinaryLog() {
+    LogBackend::instance().closeBinarySink();
 }
-
-std::string Logger::formatMessage(const std::string& message) {
-    std::stringstream formatted;
-    std::istringstream stream(message);
-    std::string line;
-
-    while (std::getline(stream, line)) {
-        formatted << "    " << line << "\n";
-    }
-
-    return formatted.str();
-}
-
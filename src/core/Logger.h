@@ -6,12 +6,43 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
-#include <map>
+#include <array>
 #include <string>
-#include <sstream>
-#include <mutex>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
+#include "LogFormat.h"
 
+// Lowest Logger::Level the LOG_* macros compile, set with -DLOG_COMPILED_LEVEL (0 keeps everything down to TRACE)
+#ifndef LOG_COMPILED_LEVEL
+#define LOG_COMPILED_LEVEL 0
+#endif
+
+/**
+ * Log with a format string, e.g. LOG_DEBUG(logger, "Mapped {} particles in {:.2} ms", count, elapsed).
+ * Below LOG_COMPILED_LEVEL the call compiles to nothing and its arguments are never evaluated; above it, the
+ * arguments are copied raw and only formatted on the writer thread
+ */
+#define LOG_AT(logger, level, ...)                                                  \
+    do {                                                                            \
+        if constexpr (static_cast<int>(level) >= LOG_COMPILED_LEVEL) {              \
+            (logger).logFormat(level, __VA_ARGS__);                                 \
+        }                                                                           \
+    } while (false)
+
+#define LOG_TRACE(logger, ...) LOG_AT(logger, Logger::Level::TRACE, __VA_ARGS__)
+#define LOG_DEBUG(logger, ...) LOG_AT(logger, Logger::Level::DEBUG, __VA_ARGS__)
+#define LOG_INFO(logger, ...) LOG_AT(logger, Logger::Level::INFO, __VA_ARGS__)
+#define LOG_WARNING(logger, ...) LOG_AT(logger, Logger::Level::WARNING, __VA_ARGS__)
+#define LOG_ERROR(logger, ...) LOG_AT(logger, Logger::Level::ERROR, __VA_ARGS__)
+#define LOG_FATAL(logger, ...) LOG_AT(logger, Logger::Level::FATAL, __VA_ARGS__)
+
+/**
+ * Component logger. Records are queued to the LogBackend writer thread, so logging from the render or simulation
+ * thread costs a copy of the message. Errors wait until they are written, in case the program dies right after.
+ * Prefer the LOG_* macros where the message is built from values: nothing is formatted on the calling thread.
+ */
 class Logger {
 public:
     enum class Level {
@@ -48,25 +79,60 @@ public:
     void error(const std::string& message);
     void fatal(const std::string& message);
 
+    /**
+     * Queue the arguments unformatted, use through the LOG_* macros
+     */
+    template<typename... Args>
+    void logFormat(Level level, LogFormat<std::type_identity_t<Args>...> format, const Args&... args);
+
     void setLogLevel(Level level) { minimumLevel = level; }
     void setUseColors(bool use) { useColors = use; }
     void setShowTimestamp(bool show) { showTimestamp = show; }
 
-    const std::string& getComponent() const { return componentName; }
+    const std::string& getComponent() const { return *componentName; }
+
+    /**
+     * Wait until everything logged so far, from any thread, is written
+     */
+    static void flush();
+
+    /**
+     * Also write every record, unformatted, to a file LogDecode reads. The console then only gets warnings and errors
+     */
+    static void openBinaryLog(const std::string& path);
+    static void closeBinaryLog();
 
 private:
     void log(Level level, const std::string& message);
+    void push(Level level, const char* format, std::string_view payload);
 
-    static std::map<std::string, size_t> maxLengths;
-    static std::string levelToString(Level level);
-    static const char* levelToColor(Level level);
-    static std::string getCurrentTime();
-    static std::string formatMessage(const std::string& message);
-    const std::string componentName;
+    static constexpr size_t INLINE_ARGUMENTS = 256;
+
+    const std::string* componentName;   // interned by the backend
 
     Level minimumLevel;
     bool useColors;
     bool showTimestamp;
 };
 
+template<typename... Args>
+void Logger::logFormat(Level level, LogFormat<std::type_identity_t<Args>...> format, const Args&... args) {
+    if (level < minimumLevel) return;
+
+    const size_t size = (size_t(0) + ... + LogArguments::encodedSize(args));
+    auto encode = [&](unsigned char* out) {
+        ((out = LogArguments::encode(out, args)), ...);
+    };
+
+    if (size <= INLINE_ARGUMENTS) {
+        std::array<unsigned char, INLINE_ARGUMENTS> buffer;
+        encode(buffer.data());
+        push(level, format.text, std::string_view(reinterpret_cast<const char*>(buffer.data()), size));
+    } else {
+        std::vector<unsigned char> buffer(size);
+        encode(buffer.data());
+        push(level, format.text, std::string_view(reinterpret_cast<const char*>(buffer.data()), size));
+    }
+}
+
 #endif //LOGGER_H
@@ -0,0 +1,98 @@
+//
+// Created by raph on 01/02/25.
+//
+
+#include "RadixSort.h"
+
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+namespace {
+    // Below this many pairs per block the passes are not worth splitting
+    constexpr size_t MIN_BLOCK_SIZE = 16384;
+}
+
+void RadixSorter::sort(uint32_t* keys, uint32_t* values, size_t count, uint32_t keyBits) {
+    sortPairs(keys, values, count, std::min<uint32_t>(keyBits, 32), keyScratch32);
+}
+
+void RadixSorter::sort(uint64_t* keys, uint32_t* values, size_t count, uint32_t keyBits) {
+    sortPairs(keys, values, count, std::min<uint32_t>(keyBits, 64), keyScratch64);
+}
+
+template<typename Key>
+void RadixSorter::sortPairs(Key* keys, uint32_t* values, size_t count, uint32_t keyBits, std::vector<Key>& keyScratch) {
+    if (count < 2) {
+        return;
+    }
+
+    ThreadPool& pool = ThreadPool::global();
+    const size_t blockCount = std::clamp<size_t>(count / MIN_BLOCK_SIZE, 1, pool.getConcurrency());
+    const size_t blockSize = (count + blockCount - 1) / blockCount;
+
+    if (keyScratch.size() < count) {
+        keyScratch.resize(count);
+        valueScratch.resize(count);
+    }
+    histograms.resize(blockCount * BUCKETS);
+
+    Key* sourceKeys = keys;
+    uint32_t* sourceValues = values;
+    Key* destinationKeys = keyScratch.data();
+    uint32_t* destinationValues = valueScratch.data();
+
+    for (uint32_t shift = 0; shift < keyBits; shift += DIGIT_BITS) {
+        // Digit counts of every block
+        pool.parallelFor(0, blockCount, 1, [&](size_t firstBlock, size_t lastBlock) {
+            for (size_t block = firstBlock; block < lastBlock; block++) {
+                uint32_t* counts = histograms.data() + block * BUCKETS;
+                std::fill(counts, counts + BUCKETS, 0u);
+                const size_t last = std::min(count, (block + 1) * blockSize);
+                for (size_t i = block * blockSize; i < last; i++) {
+                    counts[(sourceKeys[i] >> shift) & (BUCKETS - 1)]++;
+                }
+            }
+        });
+
+        // Turn the counts into output offsets, digit major so each block writes after the previous ones
+        size_t offset = 0;
+        bool constantDigit = false;
+        for (uint32_t digit = 0; digit < BUCKETS && !constantDigit; digit++) {
+            const size_t start = offset;
+            for (size_t block = 0; block < blockCount; block++) {
+                uint32_t& slot = histograms[block * BUCKETS + digit];
+                const uint32_t digitCount = slot;
+                slot = static_cast<uint32_t>(offset);
+                offset += digitCount;
+            }
+            constantDigit = offset - start == count;
+        }
+        if (constantDigit) {
+            continue;
+        }
+
+        pool.parallelFor(0, blockCount, 1, [&](size_t firstBlock, size_t lastBlock) {
+            for (size_t block = firstBlock; block < lastBlock; block++) {
+                uint32_t* offsets = histograms.data() + block * BUCKETS;
+                const size_t last = std::min(count, (block + 1) * blockSize);
+                for (size_t i = block * blockSize; i < last; i++) {
+                    const uint32_t destination = offsets[(sourceKeys[i] >> shift) & (BUCKETS - 1)]++;
+                    destinationKeys[destination] = sourceKeys[i];
+                    destinationValues[destination] = sourceValues[i];
+                }
+            }
+        });
+
+        std::swap(sourceKeys, destinationKeys);
+        std::swap(sourceValues, destinationValues);
+    }
+
+    // An odd number of passes ends in the scratch buffers
+    if (sourceKeys != keys) {
+        pool.parallelFor(0, count, 65536, [&](size_t first, size_t last) {
+            std::copy(sourceKeys + first, sourceKeys + last, keys + first);
+            std::copy(sourceValues + first, sourceValues + last, values + first);
+        });
+    }
+}
@@ -0,0 +1,51 @@
+//
+// Created by raph on 01/02/25.
+//
+
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Stable LSD radix sort of key/value pairs with 11 bit digits, so 32 bit keys take 3 passes.
+ *
+ * Each pass splits the input in one block per thread: blocks count their digits in parallel, a prefix over
+ * (digit, block) gives every block its output offsets, then blocks scatter in parallel, which keeps equal keys in
+ * input order. Passes whose digit is the same for every key are skipped, so small ranks in the high bits of a
+ * 64 bit key cost nothing. Scratch memory is kept between calls, a sorter reused every frame does not allocate.
+ */
+class RadixSorter {
+public:
+    static constexpr uint32_t DIGIT_BITS = 11;
+    static constexpr uint32_t BUCKETS = 1u << DIGIT_BITS;
+
+    /**
+     * Sort the pairs by increasing key, only the low keyBits of the keys are looked at
+     */
+    void sort(uint32_t* keys, uint32_t* values, size_t count, uint32_t keyBits = 32);
+    void sort(uint64_t* keys, uint32_t* values, size_t count, uint32_t keyBits = 64);
+
+    /**
+     * Unsigned key in the same order as the float: the sign bit is flipped for positive values, every bit for
+     * negative ones. NaNs go to the ends
+     */
+    static uint32_t sortableKey(float value) {
+        const auto bits = std::bit_cast<uint32_t>(value);
+        return bits ^ ((bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u);
+    }
+
+private:
+    template<typename Key>
+    void sortPairs(Key* keys, uint32_t* values, size_t count, uint32_t keyBits, std::vector<Key>& keyScratch);
+
+    std::vector<uint32_t> keyScratch32;
+    std::vector<uint64_t> keyScratch64;
+    std::vector<uint32_t> valueScratch;
+    std::vector<uint32_t> histograms;       // [block][digit]
+};
+
+#endif //RADIXSORT_H
@@ -0,0 +1,20 @@
+//
+// Created by raph on 08/02/25.
+//
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Nearest rank percentile of samples sorted in increasing order, which must not be empty
+ * @param fraction between 0 and 1, 0.5 for the median
+ */
+inline double percentile(const std::vector<double>& sorted, double fraction) {
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+}
+
+#endif //STATISTICS_H
@@ -0,0 +1,10 @@
+//
+// Created by raph on 04/01/25.
+//
+
+#include "ThreadPool.h"
+
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool(JobSystem::global());
+    return pool;
+}
@@ -0,0 +1,53 @@
+//
+// Created by raph on 04/01/25.
+//
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <cstddef>
+
+#include "JobSystem.h"
+
+/**
+ * Parallel loops for CPU heavy code (gravity, generation, culling...), run by the global JobSystem.
+ * The calling thread always takes part in the work, so a system of N workers runs N + 1 threads.
+ */
+class ThreadPool {
+public:
+    using RangeFunction = JobSystem::RangeFunction;
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Run fn over [begin, end) split into ranges of at most grain elements, and wait for all of them.
+     * Calls can nest and can come from any thread: waiting threads run pending ranges meanwhile.
+     * @param begin first index
+     * @param end one past the last index
+     * @param grain maximum number of indices given to fn at once
+     * @param fn function called with a [begin, end) sub range
+     */
+    void parallelFor(size_t begin, size_t end, size_t grain, const RangeFunction& fn) {
+        jobs.parallelFor(begin, end, grain, fn);
+    }
+
+    /**
+     * Number of threads that can run a parallelFor at the same time, including the caller
+     */
+    size_t getConcurrency() const { return jobs.getConcurrency(); }
+
+    JobSystem& getJobSystem() { return jobs; }
+
+    /**
+     * Pool shared by the whole application, over JobSystem::global()
+     */
+    static ThreadPool& global();
+
+private:
+    explicit ThreadPool(JobSystem& jobs) : jobs(jobs) {}
+
+    JobSystem& jobs;
+};
+
+#endif //THREADPOOL_H
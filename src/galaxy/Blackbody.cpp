@@ -0,0 +1,74 @@
+//
+// Created by raph on 11/01/25.
+//
+
+#include "Blackbody.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Piecewise gaussian used by the analytic CIE fits of Wyman, Sloan and Shirley (2013)
+    double lobe(double wavelength, double mean, double sigmaLow, double sigmaHigh) {
+        double t = (wavelength - mean) / (wavelength < mean ? sigmaLow : sigmaHigh);
+        return std::exp(-0.5 * t * t);
+    }
+
+    double planck(double wavelengthNm, double temperature) {
+        constexpr double H = 6.62607015e-34;
+        constexpr double C = 2.99792458e8;
+        constexpr double K = 1.380649e-23;
+        double lambda = wavelengthNm * 1e-9;
+        return 2.0 * H * C * C / (std::pow(lambda, 5.0) * (std::exp(H * C / (lambda * K * temperature)) - 1.0));
+    }
+}
+
+namespace Blackbody {
+    std::array<float, 3> computeColor(double temperature) {
+        double x = 0.0, y = 0.0, z = 0.0;
+        for (double wavelength = 380.0; wavelength <= 780.0; wavelength += 5.0) {
+            double radiance = planck(wavelength, temperature);
+            x += radiance * (1.056 * lobe(wavelength, 599.8, 37.9, 31.0) +
+                             0.362 * lobe(wavelength, 442.0, 16.0, 26.7) -
+                             0.065 * lobe(wavelength, 501.1, 20.4, 26.2));
+            y += radiance * (0.821 * lobe(wavelength, 568.8, 46.9, 40.5) +
+                             0.286 * lobe(wavelength, 530.9, 16.3, 31.1));
+            z += radiance * (1.217 * lobe(wavelength, 437.0, 11.8, 36.0) +
+                             0.681 * lobe(wavelength, 459.0, 26.0, 13.8));
+        }
+
+        // XYZ to linear sRGB (D65)
+        double r = 3.2406 * x - 1.5372 * y - 0.4986 * z;
+        double g = -0.9689 * x + 1.8758 * y + 0.0415 * z;
+        double b = 0.0557 * x - 0.2040 * y + 1.0570 * z;
+
+        r = std::max(r, 0.0);
+        g = std::max(g, 0.0);
+        b = std::max(b, 0.0);
+        double peak = std::max({r, g, b, 1e-30});
+
+        return {static_cast<float>(r / peak), static_cast<float>(g / peak), static_cast<float>(b / peak)};
+    }
+
+    Palette::Palette() {
+        for (uint32_t i = 0; i < SIZE; i++) {
+            colors[i] = computeColor(temperatureAt(static_cast<uint8_t>(i)));
+        }
+    }
+
+    uint8_t Palette::indexOf(float temperature) const {
+        float t = std::log(std::clamp(temperature, MIN_TEMPERATURE, MAX_TEMPERATURE) / MIN_TEMPERATURE) /
+                  std::log(MAX_TEMPERATURE / MIN_TEMPERATURE);
+        return static_cast<uint8_t>(std::lround(t * static_cast<float>(SIZE - 1)));
+    }
+
+    float Palette::temperatureAt(uint8_t index) {
+        float t = static_cast<float>(index) / static_cast<float>(SIZE - 1);
+        return MIN_TEMPERATURE * std::pow(MAX_TEMPERATURE / MIN_TEMPERATURE, t);
+    }
+
+    const Palette& Palette::get() {
+        static const Palette palette;
+        return palette;
+    }
+}
@@ -0,0 +1,47 @@
+//
+// Created by raph on 11/01/25.
+//
+
+#ifndef BLACKBODY_H
+#define BLACKBODY_H
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Colors of black bodies, from the Planck spectrum integrated against the CIE 1931 color matching functions
+ */
+namespace Blackbody {
+    /**
+     * Linear sRGB chromaticity of a black body, scaled so the largest component is 1
+     * @param temperature in Kelvin
+     */
+    std::array<float, 3> computeColor(double temperature);
+
+    /**
+     * Table of black body colors for temperatures spaced logarithmically between MIN_TEMPERATURE and
+     * MAX_TEMPERATURE. Built once, then a lookup is a log and a multiply
+     */
+    class Palette {
+    public:
+        static constexpr uint32_t SIZE = 256;
+        static constexpr float MIN_TEMPERATURE = 1000.0f;
+        static constexpr float MAX_TEMPERATURE = 40000.0f;
+
+        Palette();
+
+        uint8_t indexOf(float temperature) const;
+        const std::array<float, 3>& colorAt(uint8_t index) const { return colors[index]; }
+        const std::array<float, 3>& colorOf(float temperature) const { return colors[indexOf(temperature)]; }
+        static float temperatureAt(uint8_t index);
+
+        const std::array<std::array<float, 3>, SIZE>& getColors() const { return colors; }
+
+        static const Palette& get();
+
+    private:
+        std::array<std::array<float, 3>, SIZE> colors{};
+    };
+}
+
+#endif //BLACKBODY_H
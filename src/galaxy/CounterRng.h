@@ -0,0 +1,66 @@
+//
+// Created by raph on 11/01/25.
+//
+
+#ifndef COUNTERRNG_H
+#define COUNTERRNG_H
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+ * The output is a pure function of (seed, stream, block), so every star owns its own stream and can be
+ * generated on any thread, in any order, with the same result.
+ */
+class CounterRng {
+public:
+    CounterRng(uint64_t seed, uint64_t stream)
+        : key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}
+        , stream(stream) {}
+
+    uint32_t nextUInt() {
+        if (available == 0) {
+            block = philox({static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32), blockIndex++, 0}, key);
+            available = 4;
+        }
+        return block[4 - available--];
+    }
+
+    /**
+     * Uniform float in the open interval (0, 1), safe to pass to log()
+     */
+    float nextFloat() {
+        return (static_cast<float>(nextUInt() >> 8) + 0.5f) * (1.0f / 16777216.0f);
+    }
+
+    static std::array<uint32_t, 4> philox(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key) {
+        constexpr uint32_t MULTIPLIER_0 = 0xD2511F53u;
+        constexpr uint32_t MULTIPLIER_1 = 0xCD9E8D57u;
+        constexpr uint32_t WEYL_0 = 0x9E3779B9u;
+        constexpr uint32_t WEYL_1 = 0xBB67AE85u;
+
+        for (int round = 0; round < 10; round++) {
+            uint64_t product0 = static_cast<uint64_t>(MULTIPLIER_0) * counter[0];
+            uint64_t product1 = static_cast<uint64_t>(MULTIPLIER_1) * counter[2];
+            counter = {
+                static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                static_cast<uint32_t>(product1),
+                static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                static_cast<uint32_t>(product0),
+            };
+            key[0] += WEYL_0;
+            key[1] += WEYL_1;
+        }
+        return counter;
+    }
+
+private:
+    std::array<uint32_t, 2> key;
+    uint64_t stream;
+    uint32_t blockIndex = 0;
+    std::array<uint32_t, 4> block{};
+    uint32_t available = 0;
+};
+
+#endif //COUNTERRNG_H
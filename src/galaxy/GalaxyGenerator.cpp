@@ -0,0 +1,154 @@
+//
+// Created by raph on 11/01/25.
+//
+
+#include "GalaxyGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include "CounterRng.h"
+#include "../simulation/Units.h"
+
+namespace {
+    constexpr float TWO_PI = 2.0f * std::numbers::pi_v<float>;
+    constexpr float IMF_BREAK_MASS = 0.5f;
+    constexpr float IMF_LOW_SLOPE = 1.3f;
+    constexpr float IMF_HIGH_SLOPE = 2.3f;
+
+    // Coolest main sequence stars (late M dwarfs) and hottest O stars
+    constexpr float MIN_STAR_TEMPERATURE = 2300.0f;
+    constexpr float MAX_STAR_TEMPERATURE = 40000.0f;
+
+    // Integral of m^-slope over [a, b]
+    float powerLawIntegral(float a, float b, float slope) {
+        float exponent = 1.0f - slope;
+        return (std::pow(b, exponent) - std::pow(a, exponent)) / exponent;
+    }
+
+    // Inverse of the cumulative of m^-slope over [a, b], t in [0, 1]
+    float powerLawInverse(float a, float b, float slope, float t) {
+        float exponent = 1.0f - slope;
+        float low = std::pow(a, exponent);
+        float high = std::pow(b, exponent);
+        return std::pow(low + t * (high - low), 1.0f / exponent);
+    }
+
+    float gaussian(CounterRng& rng) {
+        float u1 = rng.nextFloat();
+        float u2 = rng.nextFloat();
+        return std::sqrt(-2.0f * std::log(u1)) * std::cos(TWO_PI * u2);
+    }
+}
+
+GalaxyGenerator::GalaxyGenerator(const GalaxyParameters& parameters)
+    : parameters(parameters)
+    , palette(Blackbody::Palette::get())
+    , tanPitch(std::tan(parameters.pitchAngle * std::numbers::pi_v<float> / 180.0f)) {
+
+    // Both segments join continuously at the break mass
+    float lowMass = std::min(parameters.minStarMass, IMF_BREAK_MASS);
+    float highMass = std::max(parameters.maxStarMass, IMF_BREAK_MASS);
+    float lowWeight = powerLawIntegral(lowMass, IMF_BREAK_MASS, IMF_LOW_SLOPE);
+    float highWeight = std::pow(IMF_BREAK_MASS, IMF_HIGH_SLOPE - IMF_LOW_SLOPE) *
+                       powerLawIntegral(IMF_BREAK_MASS, highMass, IMF_HIGH_SLOPE);
+    lowMassFraction = lowWeight / (lowWeight + highWeight);
+}
+
+Star GalaxyGenerator::generateStar(uint64_t index) const {
+    CounterRng rng(parameters.seed, index);
+    Star star{};
+
+    const float radius = rng.nextFloat();   // drawn first so each component keeps a fixed stream layout
+    const bool inBulge = rng.nextFloat() < parameters.bulgeFraction;
+
+    if (inBulge) {
+        // Hernquist cumulative mass M(<r) / M = r^2 / (r + a)^2, truncated at the disk radius
+        float s = std::sqrt(std::min(radius, 0.98f));
+        float r = parameters.bulgeScaleRadius * s / (1.0f - s);
+
+        float cosTheta = 2.0f * rng.nextFloat() - 1.0f;
+        float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+        float phi = TWO_PI * rng.nextFloat();
+        star.position = {r * sinTheta * std::cos(phi), r * sinTheta * std::sin(phi), r * cosTheta};
+
+        // Isotropic velocities with a dispersion from the virial estimate, plus a little rotation
+        float sigma = std::sqrt(static_cast<float>(Units::G) * enclosedMass(r) / (3.0f * std::max(r, 0.1f * parameters.bulgeScaleRadius)));
+        float rotation = 0.2f * std::sqrt(3.0f) * sigma;
+        float cylindrical = std::max(r * sinTheta, 1e-4f);
+        star.velocity = {
+            sigma * gaussian(rng) - rotation * star.position[1] / cylindrical * sinTheta,
+            sigma * gaussian(rng) + rotation * star.position[0] / cylindrical * sinTheta,
+            sigma * gaussian(rng),
+        };
+    } else {
+        // Exponential surface density: R follows a Gamma(2, h) law, i.e. -h ln(u1 u2). Redrawn past the truncation
+        const float h = parameters.diskScaleLength;
+        float r = -h * std::log(radius * rng.nextFloat());
+        while (r > getRadius()) {
+            r = -h * std::log(rng.nextFloat() * rng.nextFloat());
+        }
+
+        float theta = TWO_PI * rng.nextFloat();
+        if (parameters.armCount > 0 && rng.nextFloat() < parameters.armFraction) {
+            auto arm = static_cast<float>(std::min(static_cast<uint32_t>(rng.nextFloat() * parameters.armCount), parameters.armCount - 1));
+            float spiral = std::log(std::max(r, 0.05f * h) / h) / tanPitch;
+            theta = spiral + arm * TWO_PI / static_cast<float>(parameters.armCount) + parameters.armSpread * gaussian(rng);
+        }
+
+        // sech^2 vertical profile: z = z0 atanh(2u - 1)
+        float z = parameters.diskScaleHeight * std::atanh(2.0f * rng.nextFloat() - 1.0f);
+        float cosTheta = std::cos(theta);
+        float sinTheta = std::sin(theta);
+        star.position = {r * cosTheta, r * sinTheta, z};
+
+        // Circular velocity of the enclosed mass, counter clockwise seen from +z
+        float circular = std::sqrt(static_cast<float>(Units::G) * enclosedMass(r) / std::max(r, 1e-3f));
+        float sigma = parameters.velocityDispersion;
+        float tangential = circular + sigma * gaussian(rng);
+        float radial = sigma * gaussian(rng);
+        star.velocity = {
+            radial * cosTheta - tangential * sinTheta,
+            radial * sinTheta + tangential * cosTheta,
+            0.5f * sigma * gaussian(rng),
+        };
+    }
+
+    star.mass = sampleStarMass(rng.nextFloat());
+    star.temperature = mainSequenceTemperature(star.mass);
+    star.luminosity = mainSequenceLuminosity(star.mass);
+    star.color = palette.colorOf(star.temperature);
+
+    return star;
+}
+
+float GalaxyGenerator::enclosedMass(float radius) const {
+    // Spherical approximation of the disk mass, plus the exact Hernquist bulge mass
+    float diskMass = parameters.totalMass * (1.0f - parameters.bulgeFraction);
+    float bulgeMass = parameters.totalMass * parameters.bulgeFraction;
+    float x = radius / parameters.diskScaleLength;
+    float a = parameters.bulgeScaleRadius;
+
+    return diskMass * (1.0f - (1.0f + x) * std::exp(-x)) +
+           bulgeMass * radius * radius / ((radius + a) * (radius + a));
+}
+
+float GalaxyGenerator::sampleStarMass(float u) const {
+    float lowMass = std::min(parameters.minStarMass, IMF_BREAK_MASS);
+    float highMass = std::max(parameters.maxStarMass, IMF_BREAK_MASS);
+
+    if (u < lowMassFraction) {
+        return powerLawInverse(lowMass, IMF_BREAK_MASS, IMF_LOW_SLOPE, u / lowMassFraction);
+    }
+    return powerLawInverse(IMF_BREAK_MASS, highMass, IMF_HIGH_SLOPE, (u - lowMassFraction) / (1.0f - lowMassFraction));
+}
+
+float GalaxyGenerator::mainSequenceTemperature(float mass) {
+    // From L ~ M^3.5 and R ~ M^0.8 on the main sequence, T ~ (L / R^2)^(1/4) ~ M^0.475
+    return std::clamp(5772.0f * std::pow(mass, 0.475f), MIN_STAR_TEMPERATURE, MAX_STAR_TEMPERATURE);
+}
+
+float GalaxyGenerator::mainSequenceLuminosity(float mass) {
+    return std::pow(mass, 3.5f);
+}
@@ -0,0 +1,99 @@
+//
+// Created by raph on 11/01/25.
+//
+
+#ifndef GALAXYGENERATOR_H
+#define GALAXYGENERATOR_H
+
+#include <array>
+#include <cstdint>
+
+#include "Blackbody.h"
+#include "../core/ThreadPool.h"
+
+struct GalaxyParameters {
+    uint64_t seed = 1;
+    uint32_t starCount = 1'000'000;
+    float totalMass = 6e10f;            // Msun, shared equally between the particles
+
+    // Exponential disk with a sech^2 vertical profile
+    float diskScaleLength = 3.0f;       // kpc
+    float diskScaleHeight = 0.3f;       // kpc
+    float diskTruncation = 5.0f;        // in scale lengths
+
+    // Hernquist bulge
+    float bulgeFraction = 0.15f;        // fraction of the stars, and of the mass
+    float bulgeScaleRadius = 0.5f;      // kpc
+
+    // Logarithmic spiral arms
+    uint32_t armCount = 2;
+    float pitchAngle = 14.0f;           // degrees
+    float armFraction = 0.6f;           // fraction of the disk stars that follow an arm
+    float armSpread = 0.35f;            // radians, angular scatter around the arm
+
+    float velocityDispersion = 0.02f;   // kpc/Myr (about 20 km/s)
+
+    // Kroupa IMF bounds
+    float minStarMass = 0.08f;          // Msun
+    float maxStarMass = 100.0f;         // Msun
+};
+
+struct Star {
+    std::array<float, 3> position;      // kpc
+    std::array<float, 3> velocity;      // kpc/Myr
+    float mass;                         // Msun, mass of the star drawn from the IMF
+    float temperature;                  // K
+    float luminosity;                   // Lsun
+    std::array<float, 3> color;         // linear RGB chromaticity
+};
+
+/**
+ * Procedural disk galaxy. Every star is a pure function of (seed, index) thanks to a counter-based RNG, so the
+ * galaxy is reproducible and can be generated in parallel straight into its final destination.
+ */
+class GalaxyGenerator {
+public:
+    explicit GalaxyGenerator(const GalaxyParameters& parameters);
+
+    Star generateStar(uint64_t index) const;
+
+    /**
+     * Generate every star in parallel and hand it to writer(index, star). The writer is called concurrently
+     * from several threads, each index exactly once
+     */
+    template<typename Writer>
+    void generate(Writer&& writer) const {
+        ThreadPool::global().parallelFor(0, parameters.starCount, 16384, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                writer(i, generateStar(i));
+            }
+        });
+    }
+
+    /**
+     * Mass of a simulation particle. Particles stand for many stars, their mass is not the IMF star mass
+     */
+    float getParticleMass() const { return parameters.totalMass / static_cast<float>(parameters.starCount); }
+
+    /**
+     * Radius enclosing the whole disk, in kpc
+     */
+    float getRadius() const { return parameters.diskScaleLength * parameters.diskTruncation; }
+
+    const GalaxyParameters& getParameters() const { return parameters; }
+
+private:
+    float enclosedMass(float radius) const;
+    float sampleStarMass(float u) const;
+    static float mainSequenceTemperature(float mass);
+    static float mainSequenceLuminosity(float mass);
+
+    GalaxyParameters parameters;
+    const Blackbody::Palette& palette;
+
+    // Kroupa IMF, dN/dm ~ m^-1.3 below 0.5 Msun and m^-2.3 above
+    float lowMassFraction;
+    float tanPitch;
+};
+
+#endif //GALAXYGENERATOR_H
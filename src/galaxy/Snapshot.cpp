@@ -0,0 +1,369 @@
+//
+// Created by raph on 18/01/25.
+//
+
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../core/ThreadPool.h"
+
+namespace {
+    constexpr std::array<char, 8> MAGIC = {'V', 'G', 'S', 'N', 'A', 'P', '\r', '\n'};
+    constexpr uint32_t FLAG_CHECKSUMS = 1u << 0;
+    constexpr uint32_t MAX_SECTIONS = 64;
+
+    struct FileHeader {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t headerSize;        // everything before the first section, page aligned
+        uint64_t particleCount;
+        uint64_t seed;
+        double time;
+        uint32_t chunkParticles;
+        uint32_t sectionCount;
+        uint32_t flags;
+        float radius;
+    };
+    static_assert(sizeof(FileHeader) == 56);
+
+    struct SectionEntry {
+        uint32_t type;
+        uint32_t elementSize;
+        uint64_t offset;
+        uint64_t size;
+        uint64_t firstChecksum;     // index of the section's first chunk in the checksum table
+    };
+    static_assert(sizeof(SectionEntry) == 32);
+
+    uint64_t alignUp(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    uint64_t chunkCount(uint64_t particleCount, uint32_t chunkParticles) {
+        return (particleCount + chunkParticles - 1) / chunkParticles;
+    }
+
+    // CRC32C (Castagnoli), slicing by 8
+    struct Crc32cTables {
+        uint32_t table[8][256];
+
+        Crc32cTables() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; bit++) {
+                    crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
+                }
+                table[0][i] = crc;
+            }
+            for (uint32_t i = 0; i < 256; i++) {
+                for (int slice = 1; slice < 8; slice++) {
+                    table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF];
+                }
+            }
+        }
+    };
+
+    uint32_t crc32c(const std::byte* data, size_t size) {
+        static const Crc32cTables tables;
+        const auto& t = tables.table;
+
+        uint32_t crc = 0xFFFFFFFFu;
+        while (size >= 8) {
+            uint64_t word;
+            std::memcpy(&word, data, 8);
+            word ^= crc;
+            crc = t[7][word & 0xFF] ^ t[6][(word >> 8) & 0xFF] ^ t[5][(word >> 16) & 0xFF] ^
+                  t[4][(word >> 24) & 0xFF] ^ t[3][(word >> 32) & 0xFF] ^ t[2][(word >> 40) & 0xFF] ^
+                  t[1][(word >> 48) & 0xFF] ^ t[0][word >> 56];
+            data += 8;
+            size -= 8;
+        }
+        while (size-- > 0) {
+            crc = (crc >> 8) ^ t[0][(crc ^ static_cast<uint32_t>(*data++)) & 0xFF];
+        }
+        return ~crc;
+    }
+
+    void writeAll(int fd, const void* data, size_t size, const std::string& path) {
+        auto bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t written = ::write(fd, bytes, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Failed to write snapshot " + path + ": " + std::strerror(errno));
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+}
+
+namespace Snapshot {
+    const char* sectionName(Section section) {
+        switch (section) {
+            case Section::Positions: return "positions";
+            case Section::Velocities: return "velocities";
+            case Section::Colors: return "colors";
+            case Section::Masses: return "masses";
+            case Section::Appearance: return "appearance";
+        }
+        return "unknown";
+    }
+
+    void write(const std::string& path, const Metadata& metadata, const std::vector<SectionSource>& sources,
+               const WriteOptions& options) {
+        if (sources.empty() || sources.size() > MAX_SECTIONS) {
+            throw std::runtime_error("Snapshot must have between 1 and " + std::to_string(MAX_SECTIONS) + " sections");
+        }
+        if (options.chunkParticles == 0) {
+            throw std::runtime_error("Snapshot chunk size must not be zero");
+        }
+
+        uint64_t chunksPerSection = chunkCount(metadata.particleCount, options.chunkParticles);
+        uint64_t checksumCount = options.checksums ? chunksPerSection * sources.size() : 0;
+
+        FileHeader header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.headerSize = static_cast<uint32_t>(alignUp(sizeof(FileHeader) + sources.size() * sizeof(SectionEntry)
+                                                          + checksumCount * sizeof(uint32_t), PAGE_SIZE));
+        header.particleCount = metadata.particleCount;
+        header.seed = metadata.seed;
+        header.time = metadata.time;
+        header.chunkParticles = options.chunkParticles;
+        header.sectionCount = static_cast<uint32_t>(sources.size());
+        header.flags = options.checksums ? FLAG_CHECKSUMS : 0;
+        header.radius = metadata.radius;
+
+        std::vector<SectionEntry> entries(sources.size());
+        uint64_t offset = header.headerSize;
+        for (size_t i = 0; i < sources.size(); i++) {
+            entries[i].type = static_cast<uint32_t>(sources[i].type);
+            entries[i].elementSize = sources[i].elementSize;
+            entries[i].offset = offset;
+            entries[i].size = metadata.particleCount * sources[i].elementSize;
+            entries[i].firstChecksum = options.checksums ? i * chunksPerSection : 0;
+            offset = alignUp(offset + entries[i].size, PAGE_SIZE);
+        }
+
+        std::vector<uint32_t> checksums(checksumCount);
+        if (options.checksums) {
+            ThreadPool::global().parallelFor(0, checksumCount, 1, [&](size_t begin, size_t end) {
+                for (size_t index = begin; index < end; index++) {
+                    size_t section = index / chunksPerSection;
+                    uint64_t chunk = index % chunksPerSection;
+                    uint64_t chunkBytes = uint64_t(options.chunkParticles) * sources[section].elementSize;
+                    uint64_t first = chunk * chunkBytes;
+                    uint64_t size = std::min(chunkBytes, entries[section].size - first);
+                    checksums[index] = crc32c(static_cast<const std::byte*>(sources[section].data) + first, size);
+                }
+            });
+        }
+
+        // Written next to the destination then renamed, so a snapshot that is currently mapped can be replaced
+        const std::string temporaryPath = path + ".tmp";
+        int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to create snapshot " + temporaryPath + ": " + std::strerror(errno));
+        }
+
+        try {
+            std::vector<char> headerBytes(header.headerSize, 0);
+            std::memcpy(headerBytes.data(), &header, sizeof(header));
+            std::memcpy(headerBytes.data() + sizeof(header), entries.data(), entries.size() * sizeof(SectionEntry));
+            std::memcpy(headerBytes.data() + sizeof(header) + entries.size() * sizeof(SectionEntry),
+                        checksums.data(), checksums.size() * sizeof(uint32_t));
+            writeAll(fd, headerBytes.data(), headerBytes.size(), path);
+
+            static const std::vector<char> padding(PAGE_SIZE, 0);
+            uint64_t position = header.headerSize;
+            for (size_t i = 0; i < sources.size(); i++) {
+                writeAll(fd, sources[i].data, entries[i].size, path);
+                position += entries[i].size;
+
+                uint64_t aligned = alignUp(position, PAGE_SIZE);
+                if (i + 1 < sources.size() && aligned != position) {
+                    writeAll(fd, padding.data(), aligned - position, path);
+                    position = aligned;
+                }
+            }
+        } catch (...) {
+            ::close(fd);
+            ::unlink(temporaryPath.c_str());
+            throw;
+        }
+
+        if (::close(fd) != 0 || ::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            ::unlink(temporaryPath.c_str());
+            throw std::runtime_error("Failed to finish snapshot " + path + ": " + std::strerror(errno));
+        }
+    }
+}
+
+SnapshotFile::SnapshotFile(const std::string& path) : path(path), logger("Snapshot") {
+    fileDescriptor = ::open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        throw std::runtime_error("Failed to open snapshot " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat status{};
+    if (::fstat(fileDescriptor, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        ::close(fileDescriptor);
+        throw std::runtime_error("Snapshot " + path + " is too small");
+    }
+    mappingSize = static_cast<size_t>(status.st_size);
+
+    void* address = ::mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    if (address == MAP_FAILED) {
+        ::close(fileDescriptor);
+        throw std::runtime_error("Failed to map snapshot " + path + ": " + std::strerror(errno));
+    }
+    mapping = static_cast<const std::byte*>(address);
+
+    try {
+        FileHeader header;
+        std::memcpy(&header, mapping, sizeof(header));
+        if (header.magic != MAGIC) {
+            throw std::runtime_error("Snapshot " + path + " has an invalid magic number");
+        }
+        if (header.version != Snapshot::VERSION) {
+            throw std::runtime_error("Snapshot " + path + " has unsupported version " + std::to_string(header.version));
+        }
+        if (header.sectionCount == 0 || header.sectionCount > MAX_SECTIONS || header.chunkParticles == 0) {
+            throw std::runtime_error("Snapshot " + path + " has a corrupted header");
+        }
+
+        metadata.particleCount = header.particleCount;
+        metadata.seed = header.seed;
+        metadata.time = header.time;
+        metadata.radius = header.radius;
+        chunkParticles = header.chunkParticles;
+        checksums = (header.flags & FLAG_CHECKSUMS) != 0;
+
+        uint64_t chunksPerSection = chunkCount(metadata.particleCount, chunkParticles);
+        uint64_t checksumCount = checksums ? chunksPerSection * header.sectionCount : 0;
+        uint64_t tableEnd = sizeof(FileHeader) + header.sectionCount * sizeof(SectionEntry)
+                            + checksumCount * sizeof(uint32_t);
+        if (tableEnd > header.headerSize || header.headerSize > mappingSize) {
+            throw std::runtime_error("Snapshot " + path + " has a truncated header");
+        }
+
+        const std::byte* cursor = mapping + sizeof(FileHeader);
+        for (uint32_t i = 0; i < header.sectionCount; i++) {
+            SectionEntry entry;
+            std::memcpy(&entry, cursor, sizeof(entry));
+            cursor += sizeof(entry);
+
+            if (entry.elementSize == 0 || entry.size != metadata.particleCount * entry.elementSize ||
+                entry.offset < header.headerSize || entry.offset % Snapshot::PAGE_SIZE != 0 ||
+                entry.offset > mappingSize || entry.size > mappingSize - entry.offset ||
+                (checksums && entry.firstChecksum + chunksPerSection > checksumCount)) {
+                throw std::runtime_error("Snapshot " + path + " has a corrupted section table");
+            }
+
+            sections.push_back({static_cast<Snapshot::Section>(entry.type), entry.elementSize,
+                                entry.offset, entry.size, entry.firstChecksum});
+        }
+
+        chunkChecksums.resize(checksumCount);
+        std::memcpy(chunkChecksums.data(), cursor, checksumCount * sizeof(uint32_t));
+    } catch (...) {
+        ::munmap(const_cast<std::byte*>(mapping), mappingSize);
+        ::close(fileDescriptor);
+        throw;
+    }
+
+    LOG_DEBUG(logger, "Mapped {}: {} particles, {} sections", path, metadata.particleCount, sections.size());
+}
+
+SnapshotFile::~SnapshotFile() {
+    if (mapping) {
+        ::munmap(const_cast<std::byte*>(mapping), mappingSize);
+    }
+    if (fileDescriptor >= 0) {
+        ::close(fileDescriptor);
+    }
+}
+
+const SnapshotFile::SectionInfo* SnapshotFile::findSection(Snapshot::Section section) const {
+    for (const auto& info : sections) {
+        if (info.type == section) {
+            return &info;
+        }
+    }
+    return nullptr;
+}
+
+bool SnapshotFile::hasSection(Snapshot::Section section) const {
+    return findSection(section) != nullptr;
+}
+
+std::span<const std::byte> SnapshotFile::getSection(Snapshot::Section section, uint32_t expectedElementSize) const {
+    const SectionInfo* info = findSection(section);
+    if (!info) {
+        throw std::runtime_error("Snapshot " + path + " has no " + Snapshot::sectionName(section) + " section");
+    }
+    if (info->elementSize != expectedElementSize) {
+        throw std::runtime_error("Snapshot " + path + " stores " + Snapshot::sectionName(section) + " with "
+                                 + std::to_string(info->elementSize) + " byte elements, expected "
+                                 + std::to_string(expectedElementSize));
+    }
+    return {mapping + info->offset, static_cast<size_t>(info->size)};
+}
+
+void SnapshotFile::copySection(Snapshot::Section section, uint32_t expectedElementSize, void* destination) const {
+    auto bytes = getSection(section, expectedElementSize);
+    auto output = static_cast<std::byte*>(destination);
+
+    // Large page aligned blocks, one page fault stream per thread
+    constexpr size_t BLOCK_SIZE = 4 << 20;
+    ThreadPool::global().parallelFor(0, bytes.size(), BLOCK_SIZE, [&](size_t begin, size_t end) {
+        std::memcpy(output + begin, bytes.data() + begin, end - begin);
+    });
+}
+
+void SnapshotFile::prefetchSection(Snapshot::Section section) const {
+    const SectionInfo* info = findSection(section);
+    if (info && info->size > 0) {
+        ::madvise(const_cast<std::byte*>(mapping) + info->offset, info->size, MADV_WILLNEED);
+    }
+}
+
+bool SnapshotFile::verifyChecksums() const {
+    if (!checksums) {
+        return true;
+    }
+
+    uint64_t chunksPerSection = chunkCount(metadata.particleCount, chunkParticles);
+    std::atomic<uint64_t> mismatches{0};
+
+    for (const auto& info : sections) {
+        uint64_t chunkBytes = uint64_t(chunkParticles) * info.elementSize;
+        ThreadPool::global().parallelFor(0, chunksPerSection, 1, [&](size_t begin, size_t end) {
+            for (size_t chunk = begin; chunk < end; chunk++) {
+                uint64_t first = chunk * chunkBytes;
+                uint64_t size = std::min(chunkBytes, info.size - first);
+                if (crc32c(mapping + info.offset + first, size) != chunkChecksums[info.firstChecksum + chunk]) {
+                    logger.error("Checksum mismatch in " + std::string(Snapshot::sectionName(info.type))
+                                 + " chunk " + std::to_string(chunk) + " of " + path);
+                    mismatches.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    return mismatches.load() == 0;
+}
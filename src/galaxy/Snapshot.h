@@ -0,0 +1,130 @@
+//
+// Created by raph on 18/01/25.
+//
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../core/Logger.h"
+
+/**
+ * Versioned binary galaxy snapshots.
+ *
+ * Layout (little endian):
+ *   FileHeader | SectionEntry[sectionCount] | uint32 chunkChecksums[] | padding to a page
+ *   section 0 | padding to a page | section 1 | ...
+ *
+ * Each section is one structure-of-arrays field for every particle, in particle id order, stored exactly as the
+ * renderer's upload streams expect it (positions are float3 like StarVertex::Position). Loading is therefore a mmap
+ * followed by a memcpy into the upload streams. Sections are split in chunks of chunkParticles particles, each with an optional
+ * CRC32C, so corruption can be located without hashing multi-GB files on every open.
+ */
+namespace Snapshot {
+    constexpr uint32_t VERSION = 1;
+    constexpr uint64_t PAGE_SIZE = 4096;
+
+    enum class Section : uint32_t {
+        Positions = 1,      // float3, kpc
+        Velocities = 2,     // float3, kpc/Myr
+        Colors = 3,         // float3, linear RGB
+        Masses = 4,         // float, Msun
+        Appearance = 5,     // uint8 palette index and uint8 magnitude, the packed render format
+    };
+
+    struct Metadata {
+        uint64_t particleCount = 0;
+        uint64_t seed = 0;              // seed of the generated galaxy, 0 if unknown
+        double time = 0.0;              // simulation time in Myr
+        float radius = 0.0f;            // kpc, extent of the galaxy used to frame it, 0 if unknown
+    };
+
+    struct SectionSource {
+        Section type;
+        uint32_t elementSize;
+        const void* data;               // particleCount elements
+    };
+
+    struct WriteOptions {
+        bool checksums = true;
+        uint32_t chunkParticles = 1u << 20;
+    };
+
+    /**
+     * Write a snapshot, replacing any existing file. Throws on I/O errors
+     */
+    void write(const std::string& path, const Metadata& metadata, const std::vector<SectionSource>& sections,
+               const WriteOptions& options = WriteOptions());
+
+    const char* sectionName(Section section);
+}
+
+/**
+ * Read only view of a snapshot file through mmap. Opening only reads and validates the header,
+ * section data is paged in when it is first touched.
+ */
+class SnapshotFile {
+public:
+    explicit SnapshotFile(const std::string& path);
+    ~SnapshotFile();
+
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    const Snapshot::Metadata& getMetadata() const { return metadata; }
+    const std::string& getPath() const { return path; }
+    bool hasChecksums() const { return checksums; }
+
+    bool hasSection(Snapshot::Section section) const;
+
+    /**
+     * Raw bytes of a section. Throws if the section is missing or its element size is not the expected one
+     */
+    std::span<const std::byte> getSection(Snapshot::Section section, uint32_t expectedElementSize) const;
+
+    /**
+     * Copy a section to destination, splitting the copy over the thread pool so page faults overlap
+     */
+    void copySection(Snapshot::Section section, uint32_t expectedElementSize, void* destination) const;
+
+    /**
+     * Tell the kernel a section will be read soon, so it can start reading it ahead
+     */
+    void prefetchSection(Snapshot::Section section) const;
+
+    /**
+     * Recompute every chunk checksum
+     * @return true if they all match, or if the file was written without checksums
+     */
+    bool verifyChecksums() const;
+
+private:
+    struct SectionInfo {
+        Snapshot::Section type;
+        uint32_t elementSize;
+        uint64_t offset;
+        uint64_t size;
+        uint64_t firstChecksum;
+    };
+
+    const SectionInfo* findSection(Snapshot::Section section) const;
+
+    std::string path;
+    int fileDescriptor = -1;
+    const std::byte* mapping = nullptr;
+    size_t mappingSize = 0;
+
+    Snapshot::Metadata metadata;
+    uint32_t chunkParticles = 0;
+    bool checksums = false;
+    std::vector<SectionInfo> sections;
+    std::vector<uint32_t> chunkChecksums;
+    mutable Logger logger;
+};
+
+#endif //SNAPSHOT_H
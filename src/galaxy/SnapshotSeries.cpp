@@ -0,0 +1,59 @@
+//
+// Created by raph on 19/01/25.
+//
+
+#include "SnapshotSeries.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+#include "Snapshot.h"
+
+SnapshotSeries::SnapshotSeries(const std::string& directory) : logger("SnapshotSeries") {
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".vgs") {
+            continue;
+        }
+
+        SnapshotFile snapshot(entry.path().string());
+        if (!snapshot.hasSection(Snapshot::Section::Positions)) {
+            logger.warning("Skipping " + entry.path().string() + ", it has no positions");
+            continue;
+        }
+        if (frames.empty()) {
+            starCount = snapshot.getMetadata().particleCount;
+        } else if (snapshot.getMetadata().particleCount != starCount) {
+            throw std::runtime_error("Snapshot " + entry.path().string() + " has " +
+                                     std::to_string(snapshot.getMetadata().particleCount) + " stars, expected " +
+                                     std::to_string(starCount));
+        }
+        frames.push_back({entry.path().string(), snapshot.getMetadata().time});
+    }
+    if (error) {
+        throw std::runtime_error("Failed to list snapshots in " + directory + ": " + error.message());
+    }
+    if (frames.size() < 2) {
+        throw std::runtime_error("Playback needs at least two snapshots in " + directory);
+    }
+
+    std::sort(frames.begin(), frames.end(), [](const Frame& a, const Frame& b) { return a.time < b.time; });
+
+    logger.info("Found " + std::to_string(frames.size()) + " snapshots of " + std::to_string(starCount) +
+                " stars from t = " + std::to_string(getStartTime()) + " to " + std::to_string(getEndTime()) + " Myr");
+}
+
+size_t SnapshotSeries::findInterval(double time) const {
+    auto next = std::upper_bound(frames.begin(), frames.end(), time,
+                                 [](double t, const Frame& frame) { return t < frame.time; });
+    size_t index = next == frames.begin() ? 0 : static_cast<size_t>(next - frames.begin()) - 1;
+    return std::min(index, frames.size() - 2);
+}
+
+std::string SnapshotSeries::frameFileName(size_t frame) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "snapshot_%06zu.vgs", frame);
+    return name;
+}
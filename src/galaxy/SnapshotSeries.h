@@ -0,0 +1,51 @@
+//
+// Created by raph on 19/01/25.
+//
+
+#ifndef SNAPSHOTSERIES_H
+#define SNAPSHOTSERIES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../core/Logger.h"
+
+/**
+ * Time ordered list of the snapshots found in a directory, the keyframes of a playback.
+ * Only the headers are read, every snapshot must hold the same stars.
+ */
+class SnapshotSeries {
+public:
+    explicit SnapshotSeries(const std::string& directory);
+
+    size_t getFrameCount() const { return frames.size(); }
+    const std::string& getPath(size_t frame) const { return frames[frame].path; }
+    double getTime(size_t frame) const { return frames[frame].time; }
+    double getStartTime() const { return frames.front().time; }
+    double getEndTime() const { return frames.back().time; }
+    uint64_t getStarCount() const { return starCount; }
+
+    /**
+     * Index of the keyframe that starts the interval containing time, clamped to [0, frameCount - 2]
+     */
+    size_t findInterval(double time) const;
+
+    /**
+     * File name used for the frame-th snapshot when recording a series
+     */
+    static std::string frameFileName(size_t frame);
+
+private:
+    struct Frame {
+        std::string path;
+        double time;
+    };
+
+    std::vector<Frame> frames;
+    uint64_t starCount = 0;
+    Logger logger;
+};
+
+#endif //SNAPSHOTSERIES_H
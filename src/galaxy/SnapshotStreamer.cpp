@@ -0,0 +1,85 @@
+//
+// Created by raph on 19/01/25.
+//
+
+#include "SnapshotStreamer.h"
+
+#include <cstring>
+#include <stdexcept>
+
+SnapshotStreamer::SnapshotStreamer() : logger("SnapshotStreamer") {
+    worker = std::thread(&SnapshotStreamer::workerLoop, this);
+}
+
+SnapshotStreamer::~SnapshotStreamer() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    worker.join();
+}
+
+uint64_t SnapshotStreamer::request(const std::string& path, Snapshot::Section section, uint32_t elementSize,
+                                   void* destination, size_t capacity) {
+    uint64_t ticket;
+    {
+        std::lock_guard lock(mutex);
+        ticket = nextTicket++;
+        pending.push_back({ticket, path, section, elementSize, destination, capacity});
+    }
+    wakeCondition.notify_one();
+    return ticket;
+}
+
+bool SnapshotStreamer::isComplete(uint64_t ticket) {
+    std::lock_guard lock(mutex);
+    auto it = finished.find(ticket);
+    if (it == finished.end()) {
+        return false;
+    }
+
+    std::string error = std::move(it->second);
+    finished.erase(it);
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+    return true;
+}
+
+void SnapshotStreamer::workerLoop() {
+    while (true) {
+        Request current;
+        {
+            std::unique_lock lock(mutex);
+            wakeCondition.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (stopping) {
+                return;
+            }
+            current = std::move(pending.front());
+            pending.pop_front();
+        }
+
+        std::string error;
+        try {
+            read(current);
+        } catch (const std::exception& e) {
+            error = e.what();
+            logger.error(error);
+        }
+
+        std::lock_guard lock(mutex);
+        finished[current.ticket] = std::move(error);
+    }
+}
+
+void SnapshotStreamer::read(const Request& request) {
+    // A single sequential copy: the point is to stay off the thread pool the frame is using
+    SnapshotFile snapshot(request.path);
+    auto bytes = snapshot.getSection(request.section, request.elementSize);
+    if (bytes.size() > request.capacity) {
+        throw std::runtime_error("Snapshot " + request.path + " does not fit in the playback buffers");
+    }
+    snapshot.prefetchSection(request.section);
+    std::memcpy(request.destination, bytes.data(), bytes.size());
+}
@@ -0,0 +1,67 @@
+//
+// Created by raph on 19/01/25.
+//
+
+#ifndef SNAPSHOTSTREAMER_H
+#define SNAPSHOTSTREAMER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "Snapshot.h"
+#include "../core/Logger.h"
+
+/**
+ * Background thread reading snapshot sections into caller owned memory (usually a mapped staging buffer),
+ * so the next keyframes of a playback load while the current ones are displayed.
+ */
+class SnapshotStreamer {
+public:
+    SnapshotStreamer();
+    ~SnapshotStreamer();
+
+    SnapshotStreamer(const SnapshotStreamer&) = delete;
+    SnapshotStreamer& operator=(const SnapshotStreamer&) = delete;
+
+    /**
+     * Queue a read and return immediately. destination must stay valid until the read completes
+     * @return ticket to poll with isComplete()
+     */
+    uint64_t request(const std::string& path, Snapshot::Section section, uint32_t elementSize,
+                     void* destination, size_t capacity);
+
+    /**
+     * Whether the read is done. Throws the error of a failed read, after which the ticket is forgotten
+     */
+    bool isComplete(uint64_t ticket);
+
+private:
+    struct Request {
+        uint64_t ticket;
+        std::string path;
+        Snapshot::Section section;
+        uint32_t elementSize;
+        void* destination;
+        size_t capacity;
+    };
+
+    void workerLoop();
+    static void read(const Request& request);
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::deque<Request> pending;
+    std::unordered_map<uint64_t, std::string> finished;    // ticket -> error message, empty on success
+    uint64_t nextTicket = 1;
+    bool stopping = false;
+    Logger logger;
+};
+
+#endif //SNAPSHOTSTREAMER_H
@@ -1,9 +1,11 @@
 
 //#include "App.h"
 #include "core/Application.h"
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
 
-int main() {
+int main(int argc, char** argv) {
     try {
         ApplicationConfig config;
         config.windowProps.title = "Galaxy Renderer";
@@ -11,6 +13,20 @@ int main() {
         config.windowProps.height = 1080;
         config.windowProps.isResizable = true;
 
+        // Optional snapshot to start from instead of a generated galaxy, or a directory of snapshots to play
+        if (argc > 1) {
+            if (std::filesystem::is_directory(argv[1])) {
+                config.playback.directory = argv[1];
+            } else {
+                config.snapshotPath = argv[1];
+            }
+        }
+
+        // Keep every record in a compact file instead of the console, decode it with LogDecode
+        if (const char* logPath = std::getenv("GALAXY_BINARY_LOG")) {
+            config.binaryLogPath = logPath;
+        }
+
         Application app(config);
         app.run();
 
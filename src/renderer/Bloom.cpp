@@ -0,0 +1,234 @@
+//
+// Created by raph on 02/02/25.
+//
+
+#include "Bloom.h"
+
+#include <array>
+#include <stdexcept>
+#include <string>
+
+#include "VulkanContext.h"
+
+namespace {
+    // Must match bloom.glsl
+    constexpr uint32_t GROUP_SIZE = 8;
+
+    void computeBarrier(VkCommandBuffer commandBuffer) {
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+}
+
+Bloom::Bloom(VulkanContext& context, const BloomConfig& config)
+    : context(context)
+    , config(config)
+    , logger("Bloom") {
+    createSampler();
+    createDescriptors();
+    createPipelines();
+}
+
+Bloom::~Bloom() {
+    VkDevice device = context.getDevice();
+    for (VkPipeline pipeline : {downsamplePipeline, upsamplePipeline}) {
+        if (pipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(device, pipeline, nullptr);
+        }
+    }
+    if (pipelineLayout != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    }
+    if (descriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    }
+    if (descriptorSetLayout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+    }
+    if (sampler != VK_NULL_HANDLE) {
+        vkDestroySampler(device, sampler, nullptr);
+    }
+}
+
+void Bloom::createSampler() {
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 0.0f;
+
+    if (vkCreateSampler(context.getDevice(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create bloom sampler");
+    }
+}
+
+void Bloom::createDescriptors() {
+    // Source, destination
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(context.getDevice(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create bloom descriptor set layout");
+    }
+
+    const uint32_t setCount = 2 * LEVELS - 1;
+    std::array<VkDescriptorPoolSize, 2> poolSizes{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = setCount;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[1].descriptorCount = setCount;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = setCount;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    if (vkCreateDescriptorPool(context.getDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create bloom descriptor pool");
+    }
+
+    std::vector<VkDescriptorSetLayout> layouts(setCount, descriptorSetLayout);
+    std::vector<VkDescriptorSet> sets(setCount);
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = setCount;
+    allocInfo.pSetLayouts = layouts.data();
+
+    if (vkAllocateDescriptorSets(context.getDevice(), &allocInfo, sets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate bloom descriptor sets");
+    }
+
+    downsampleSets.assign(sets.begin(), sets.begin() + LEVELS);
+    upsampleSets.assign(sets.begin() + LEVELS, sets.end());
+}
+
+void Bloom::update(const Image& source, const Image& chainImage) {
+    if (chainImage.getMipLevels() != LEVELS) {
+        throw std::runtime_error("The bloom chain needs " + std::to_string(LEVELS) + " mip levels");
+    }
+    chain = &chainImage;
+
+    auto write = [&](VkDescriptorSet set, VkImageView sourceView, VkImageLayout sourceLayout, VkImageView destination) {
+        VkDescriptorImageInfo sourceInfo{sampler, sourceView, sourceLayout};
+        VkDescriptorImageInfo destinationInfo{VK_NULL_HANDLE, destination, VK_IMAGE_LAYOUT_GENERAL};
+
+        std::array<VkWriteDescriptorSet, 2> writes{};
+        writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[0].dstSet = set;
+        writes[0].dstBinding = 0;
+        writes[0].descriptorCount = 1;
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[0].pImageInfo = &sourceInfo;
+        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[1].dstSet = set;
+        writes[1].dstBinding = 1;
+        writes[1].descriptorCount = 1;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1].pImageInfo = &destinationInfo;
+        vkUpdateDescriptorSets(context.getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    };
+
+    write(downsampleSets[0], source.getView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, chain->getMipView(0));
+    for (uint32_t level = 1; level < LEVELS; level++) {
+        write(downsampleSets[level], chain->getMipView(level - 1), VK_IMAGE_LAYOUT_GENERAL, chain->getMipView(level));
+    }
+    for (uint32_t level = 0; level + 1 < LEVELS; level++) {
+        write(upsampleSets[level], chain->getMipView(level + 1), VK_IMAGE_LAYOUT_GENERAL, chain->getMipView(level));
+    }
+
+    LOG_DEBUG(logger, "Bloom chain of {} levels from {}x{}", LEVELS, chain->getExtent().width, chain->getExtent().height);
+}
+
+void Bloom::createPipelines() {
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(PassConstants);
+
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &descriptorSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(context.getDevice(), &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create bloom pipeline layout");
+    }
+
+    downsampleShader = std::make_unique<Shader>(context, "shaders/bloom_downsample.comp.spv", Shader::Type::Compute);
+    upsampleShader = std::make_unique<Shader>(context, "shaders/bloom_upsample.comp.spv", Shader::Type::Compute);
+
+    auto createPipeline = [&](const Shader& shader) {
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shader.getShaderModule();
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+
+        VkPipeline pipeline;
+        if (vkCreateComputePipelines(context.getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create bloom pipeline");
+        }
+        return pipeline;
+    };
+    downsamplePipeline = createPipeline(*downsampleShader);
+    upsamplePipeline = createPipeline(*upsampleShader);
+}
+
+void Bloom::dispatch(VkCommandBuffer commandBuffer, VkPipeline pipeline, VkDescriptorSet set, uint32_t level,
+                     bool prefilter) const {
+    PassConstants constants{};
+    constants.threshold = config.threshold;
+    constants.knee = config.knee;
+    constants.prefilter = prefilter ? 1 : 0;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+
+    const VkExtent2D extent = chain->getMipExtent(level);
+    vkCmdDispatch(commandBuffer, (extent.width + GROUP_SIZE - 1) / GROUP_SIZE, (extent.height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+}
+
+void Bloom::record(VkCommandBuffer commandBuffer) const {
+    if (!chain) {
+        throw std::runtime_error("The bloom has no images");
+    }
+
+    // Each level reads the one written just before it
+    for (uint32_t level = 0; level < LEVELS; level++) {
+        dispatch(commandBuffer, downsamplePipeline, downsampleSets[level], level, level == 0);
+        computeBarrier(commandBuffer);
+    }
+    for (uint32_t level = LEVELS - 1; level-- > 0;) {
+        dispatch(commandBuffer, upsamplePipeline, upsampleSets[level], level, false);
+        if (level > 0) {
+            computeBarrier(commandBuffer);
+        }
+    }
+}
@@ -0,0 +1,88 @@
+//
+// Created by raph on 02/02/25.
+//
+
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "Image.h"
+#include "Shader.h"
+#include "../core/Logger.h"
+
+class VulkanContext;
+
+struct BloomConfig {
+    bool enabled = true;
+    float threshold = 1.0f;         // HDR brightness where stars start to glow
+    float knee = 0.5f;              // width of the soft transition below the threshold
+    float intensity = 0.05f;        // weight of the bloom added to the image by the tonemap
+};
+
+/**
+ * Glow around bright stars and dense regions, computed on a mip chain from 1/2 to 1/64 of the HDR target.
+ *
+ * Every level is downsampled from the previous one with a 13 tap filter (the first one also applies the
+ * threshold), then from the smallest level up every level adds a 3x3 tent upsample of the one below. Level 0 ends
+ * up with the sum of all the blur radii, and is what the tonemap samples.
+ * The chain is a render graph image of FORMAT with LEVELS mips at half the target size, used as storage by the
+ * bloom pass; the barriers between its levels are recorded here.
+ */
+class Bloom {
+public:
+    static constexpr uint32_t LEVELS = 6;
+    static constexpr VkFormat FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+    Bloom(VulkanContext& context, const BloomConfig& config = BloomConfig());
+    ~Bloom();
+
+    Bloom(const Bloom&) = delete;
+    Bloom& operator=(const Bloom&) = delete;
+
+    /**
+     * Point the passes at the images of the compiled render graph, the device must be idle
+     * @param source sampled, in the shader read only layout
+     * @param chain in the general layout
+     */
+    void update(const Image& source, const Image& chain);
+
+    /**
+     * Record the passes, outside of any render pass
+     */
+    void record(VkCommandBuffer commandBuffer) const;
+
+private:
+    struct PassConstants {
+        float threshold;
+        float knee;
+        uint32_t prefilter;
+        uint32_t padding;
+    };
+
+    void createSampler();
+    void createDescriptors();
+    void createPipelines();
+    void dispatch(VkCommandBuffer commandBuffer, VkPipeline pipeline, VkDescriptorSet set, uint32_t level,
+                  bool prefilter) const;
+
+    VulkanContext& context;
+    BloomConfig config;
+    const Image* chain = nullptr;
+    VkSampler sampler = VK_NULL_HANDLE;
+
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> downsampleSets;    // level i - 1 (the target for 0) to level i
+    std::vector<VkDescriptorSet> upsampleSets;      // level i + 1 added to level i
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    std::unique_ptr<Shader> downsampleShader;
+    std::unique_ptr<Shader> upsampleShader;
+    VkPipeline downsamplePipeline = VK_NULL_HANDLE;
+    VkPipeline upsamplePipeline = VK_NULL_HANDLE;
+    Logger logger;
+};
+
+#endif //BLOOM_H
@@ -3,17 +3,20 @@
 
 #include <cstring>
 #include <stdexcept>
+#include <string>
 
 #include "VulkanContext.h"
 
 Buffer::Buffer(VulkanContext& context,
                VkDeviceSize size,
                VkBufferUsageFlags usage,
-               VkMemoryPropertyFlags properties)
+               VkMemoryPropertyFlags properties,
+               MemoryTag tag)
     : context(context)
     , buffer(VK_NULL_HANDLE)
     , memory(VK_NULL_HANDLE)
-    , bufferSize(size) {
+    , bufferSize(size)
+    , tag(tag) {
 
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -33,42 +36,82 @@ Buffer::Buffer(VulkanContext& context,
     allocInfo.allocationSize = memRequirements.size;
     allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
-    if (vkAllocateMemory(context.getDevice(), &allocInfo, nullptr, &memory) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to allocate buffer memory");
+    MemoryTracker& tracker = context.getMemoryTracker();
+    VkResult result = vkAllocateMemory(context.getDevice(), &allocInfo, nullptr, &memory);
+    if (result != VK_SUCCESS) {
+        vkDestroyBuffer(context.getDevice(), buffer, nullptr);
+        tracker.update(tracker.getSnapshot().frame);
+        throw std::runtime_error("Failed to allocate " + std::to_string(memRequirements.size >> 20) + " MiB of buffer memory for " +
+                                 memoryTagName(tag) + (result == VK_ERROR_OUT_OF_DEVICE_MEMORY ? " (out of device memory)\n" : "\n") +
+                                 tracker.describe());
     }
+    memoryType = allocInfo.memoryTypeIndex;
+    allocationSize = memRequirements.size;
+    tracker.recordAllocation(memoryType, allocationSize, tag);
 
     vkBindBufferMemory(context.getDevice(), buffer, memory, 0);
 }
 
 Buffer::~Buffer() {
+    if (mapped) {
+        unmap();
+    }
     if (buffer != VK_NULL_HANDLE) {
         vkDestroyBuffer(context.getDevice(), buffer, nullptr);
     }
     if (memory != VK_NULL_HANDLE) {
         vkFreeMemory(context.getDevice(), memory, nullptr);
+        context.getMemoryTracker().recordFree(memoryType, allocationSize, tag);
     }
 }
 
 void Buffer::copyFrom(const void* data, VkDeviceSize size) {
-    void* mapped;
-    vkMapMemory(context.getDevice(), memory, 0, size, 0, &mapped);
-    memcpy(mapped, data, size);
-    vkUnmapMemory(context.getDevice(), memory);
+    bool wasMapped = mapped != nullptr;
+    memcpy(map(), data, size);
+    if (!wasMapped) {
+        unmap();
+    }
+}
+
+void* Buffer::map() {
+    if (!mapped && vkMapMemory(context.getDevice(), memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to map buffer memory");
+    }
+    return mapped;
+}
+
+void Buffer::unmap() {
+    if (mapped) {
+        vkUnmapMemory(context.getDevice(), memory);
+        mapped = nullptr;
+    }
+}
+
+void Buffer::copyTo(Buffer& destination, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset) const {
+    auto& commandManager = context.getCommandManager();
+    VkCommandBuffer commandBuffer = commandManager.beginSingleTimeCommands();
+
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = srcOffset;
+    copyRegion.dstOffset = dstOffset;
+    copyRegion.size = size;
+    vkCmdCopyBuffer(commandBuffer, buffer, destination.getBuffer(), 1, &copyRegion);
+
+    commandManager.endSingleTimeCommands(commandBuffer);
 }
 
-void Buffer::bindAsVertex(VkCommandBuffer commandBuffer, VkDeviceSize offset) const {
+void Buffer::bindAsVertex(VkCommandBuffer commandBuffer, uint32_t binding, VkDeviceSize offset) const {
     VkBuffer buffers[] = {buffer};
     VkDeviceSize offsets[] = {offset};
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+    vkCmdBindVertexBuffers(commandBuffer, binding, 1, buffers, offsets);
 }
 
-void Buffer::bindAsIndex(VkCommandBuffer commandBuffer, VkDeviceSize offset = 0) const {
-    vkCmdBindIndexBuffer(commandBuffer, buffer, offset, VK_INDEX_TYPE_UINT16);
+void Buffer::bindAsIndex(VkCommandBuffer commandBuffer, VkDeviceSize offset, VkIndexType indexType) const {
+    vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
 }
 
 uint32_t Buffer::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(context.getPhysicalDevice(), &memProperties);
+    const VkPhysicalDeviceMemoryProperties& memProperties = context.getMemoryTracker().getMemoryProperties();
 
     for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
         if ((typeFilter & (1 << i)) &&
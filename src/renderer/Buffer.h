@@ -6,6 +6,8 @@
 #define BUFFER_H
 #include <vulkan/vulkan.h>
 
+#include "MemoryTracker.h"
+
 class VulkanContext;
 
 class Buffer {
@@ -13,24 +15,43 @@ public:
     Buffer(VulkanContext &context,
            VkDeviceSize size,
            VkBufferUsageFlags usage,
-           VkMemoryPropertyFlags properties);
+           VkMemoryPropertyFlags properties,
+           MemoryTag tag = MemoryTag::Other);
 
     ~Buffer();
 
     void copyFrom(const void* data, VkDeviceSize size);
-    void bindAsVertex(VkCommandBuffer commandBuffer, VkDeviceSize offset = 0) const;
 
-    void bindAsIndex(VkCommandBuffer commandBuffer, VkDeviceSize offset) const;
+    /**
+     * Map the whole buffer, it must be host visible. The pointer stays valid until unmap()
+     */
+    void* map();
+    void unmap();
+    void* getMapped() const { return mapped; }
+
+    /**
+     * Copy this buffer into another one with a one time command buffer, and wait for it to complete
+     */
+    void copyTo(Buffer& destination, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0) const;
+
+    void bindAsVertex(VkCommandBuffer commandBuffer, uint32_t binding = 0, VkDeviceSize offset = 0) const;
+
+    void bindAsIndex(VkCommandBuffer commandBuffer, VkDeviceSize offset = 0, VkIndexType indexType = VK_INDEX_TYPE_UINT16) const;
 
     VkBuffer getBuffer() const { return buffer; }
     VkDeviceMemory getMemory() const { return memory; }
     VkDeviceSize getSize() const { return bufferSize; }
+    MemoryTag getTag() const { return tag; }
 
 private:
     VulkanContext& context;
     VkBuffer buffer;
     VkDeviceMemory memory;
     VkDeviceSize bufferSize;
+    void* mapped = nullptr;
+    MemoryTag tag;
+    uint32_t memoryType = 0;
+    VkDeviceSize allocationSize = 0;
 
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 };
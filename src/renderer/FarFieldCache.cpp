@@ -0,0 +1,226 @@
+//
+// Created by raph on 07/02/25.
+//
+
+#include "FarFieldCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "Pipeline.h"
+#include "VulkanContext.h"
+
+FarFieldCache::FarFieldCache(VulkanContext& context, StarScene& scene, uint32_t framesInFlight, VkFormat format,
+                             float galaxyRadius, const FarFieldConfig& config)
+    : context(context)
+    , scene(scene)
+    , format(format)
+    , nearDistance(std::max(config.nearDistance * galaxyRadius, 1e-6f))
+    , config(config)
+    , logger("FarFieldCache") {
+    uniforms = std::make_unique<FrameUniforms>(context, framesInFlight);
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 0.0f;
+
+    if (vkCreateSampler(context.getDevice(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create far field sampler");
+    }
+
+    createDescriptors();
+}
+
+FarFieldCache::~FarFieldCache() {
+    if (descriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(context.getDevice(), descriptorPool, nullptr);
+    }
+    if (descriptorSetLayout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(context.getDevice(), descriptorSetLayout, nullptr);
+    }
+    if (sampler != VK_NULL_HANDLE) {
+        vkDestroySampler(context.getDevice(), sampler, nullptr);
+    }
+}
+
+RenderGraph::ImportInfo FarFieldCache::getImportInfo(VkFormat format) {
+    // Sampled by the stars pass of every frame, and left that way for the next one
+    return {format, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+}
+
+void FarFieldCache::createDescriptors() {
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+
+    if (vkCreateDescriptorSetLayout(context.getDevice(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create far field descriptor set layout");
+    }
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(context.getDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create far field descriptor pool");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(context.getDevice(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate far field descriptor set");
+    }
+}
+
+void FarFieldCache::resize(VkExtent2D extent) {
+    // Same pixels per unit as the HDR target over a wider field of view
+    const float widening = 1.0f + config.margin;
+    const VkExtent2D cacheExtent = {
+        static_cast<uint32_t>(std::ceil(static_cast<float>(extent.width) * widening)),
+        static_cast<uint32_t>(std::ceil(static_cast<float>(extent.height) * widening))
+    };
+    image.reset();
+    image = std::make_unique<Image>(context, cacheExtent, format,
+                                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    transitionImage();
+
+    VkDescriptorImageInfo imageInfo{sampler, image->getView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(context.getDevice(), 1, &write, 0, nullptr);
+
+    valid = false;
+}
+
+void FarFieldCache::transitionImage() {
+    // The render graph expects the layout of the end of a frame, the first frame draws the cache anyway
+    auto& commandManager = context.getCommandManager();
+    VkCommandBuffer commandBuffer = commandManager.beginSingleTimeCommands();
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image->getImage();
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    commandManager.endSingleTimeCommands(commandBuffer);
+}
+
+bool FarFieldCache::isFar(uint32_t chunk, const glm::vec3& eye) const {
+    // Nearest point of the bounds, the eye may be inside
+    return scene.getChunkBounds().distance(chunk, eye) >= nearDistance;
+}
+
+bool FarFieldCache::contains(const glm::mat4& reprojection) const {
+    // Corners of the view in the clip space of the cache
+    for (float x : {-1.0f, 1.0f}) {
+        for (float y : {-1.0f, 1.0f}) {
+            const glm::vec4 corner = reprojection * glm::vec4(x, y, 1.0f, 1.0f);
+            if (corner.w <= 0.0f || std::abs(corner.x) > corner.w || std::abs(corner.y) > corner.w) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool FarFieldCache::update(uint32_t frameIndex, const CameraUniforms& camera, uint64_t positionsVersion) {
+    const glm::vec3 eye(camera.position.x, camera.position.y, camera.position.z);
+    const float pixelsPerUnit = camera.viewport.z;
+    const glm::mat4 inverseViewProjection = glm::inverse(camera.viewProjection);
+
+    // Cached chunks are at least nearDistance from where the cache was drawn, their parallax is bounded by it
+    const float parallax = glm::length(eye - cachedEye) * pixelsPerUnit / nearDistance;
+    refreshing = !valid || positionsVersion != cachedVersion || pixelsPerUnit != cachedPixelsPerUnit ||
+                 parallax > config.maxErrorPixels || !contains(cachedViewProjection * inverseViewProjection);
+
+    if (refreshing) {
+        const VkExtent2D extent = image->getExtent();
+        const float widening = 1.0f + config.margin;
+        CameraUniforms cacheCamera = camera;
+        cacheCamera.projection[0][0] /= widening;
+        cacheCamera.projection[1][1] /= widening;
+        cacheCamera.viewProjection = cacheCamera.projection * cacheCamera.view;
+        cacheCamera.viewport = glm::vec4(static_cast<float>(extent.width), static_cast<float>(extent.height),
+                                         pixelsPerUnit, 0.0f);
+        uniforms->write(frameIndex, cacheCamera);
+
+        // Chunks in view of the cache past the near distance, the frame draws the others. Selected apart from the
+        // frame, whose selection stays valid
+        scene.select(cacheCamera.viewProjection, eye, static_cast<float>(extent.height), farRanges);
+        std::erase_if(farRanges, [&](const StarDrawRange& range) { return !isFar(range.chunk, eye); });
+        cachedChunks.assign(scene.getChunkCount(), false);
+        for (const auto& range : farRanges) {
+            cachedChunks[range.chunk] = true;
+        }
+
+        cachedVersion = positionsVersion;
+        cachedEye = eye;
+        cachedPixelsPerUnit = pixelsPerUnit;
+        cachedViewProjection = cacheCamera.viewProjection;
+        valid = true;
+    }
+
+    pushConstants.reprojection = cachedViewProjection * inverseViewProjection;
+    return refreshing;
+}
+
+const std::vector<StarDrawRange>& FarFieldCache::splitNear(const std::vector<StarDrawRange>& ranges) {
+    nearRanges.clear();
+    for (const auto& range : ranges) {
+        if (range.chunk >= cachedChunks.size() || !cachedChunks[range.chunk]) {
+            nearRanges.push_back(range);
+        }
+    }
+    return nearRanges;
+}
+
+void FarFieldCache::begin(VkCommandBuffer commandBuffer, const Pipeline& pipeline, uint32_t frameIndex) const {
+    uniforms->bind(commandBuffer, pipeline.getLayout(), frameIndex);
+}
+
+void FarFieldCache::composite(VkCommandBuffer commandBuffer, Pipeline& pipeline) const {
+    pipeline.bind(commandBuffer);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getLayout(), SET, 1, &descriptorSet,
+                            0, nullptr);
+    vkCmdPushConstants(commandBuffer, pipeline.getLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pushConstants),
+                       &pushConstants);
+    vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+}
@@ -0,0 +1,140 @@
+//
+// Created by raph on 07/02/25.
+//
+
+#ifndef FARFIELDCACHE_H
+#define FARFIELDCACHE_H
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include "FrameUniforms.h"
+#include "Image.h"
+#include "RenderGraph.h"
+#include "../core/Logger.h"
+#include "../scene/StarScene.h"
+
+class VulkanContext;
+class Pipeline;
+
+struct FarFieldConfig {
+    bool enabled = false;
+    float nearDistance = 0.1f;      // of the galaxy radius: chunks closer than this to the eye are drawn every frame
+    float maxErrorPixels = 0.5f;    // parallax of the cached stars before they are drawn again
+    float margin = 0.1f;            // wider field of view of the cache, so small rotations stay inside of it
+};
+
+/**
+ * Push constants of the pipeline reprojecting the cache (see far_field.frag)
+ */
+struct FarFieldPushConstants {
+    glm::mat4 reprojection;         // clip space of the frame to the one of the cache
+};
+
+/**
+ * The stars far from the eye, drawn into an image that is kept across frames and reprojected into the following
+ * ones, so a static or slowly turning camera only draws the near field.
+ *
+ * The cache is drawn again when the positions changed, the zoom changed, the eye moved far enough for the
+ * parallax of the nearest cached chunk to exceed maxErrorPixels, or the view turned out of the margin of the
+ * cache. Chunks are split when the cache is drawn: the ones it holds are left out of the selection of the
+ * following frames, the others are drawn as usual wherever the eye goes.
+ *
+ * The image is imported into the render graph in the shader read only layout, and drawn by a graphics pass that
+ * clears it and only runs when the cache is refreshed: the frames that keep the cache do not touch it. The cache
+ * has its own camera uniforms, with the wider projection, bound in place of the frame ones.
+ */
+class FarFieldCache {
+public:
+    static constexpr uint32_t SET = 2;
+
+    /**
+     * @param format of the HDR target, the star pipelines draw into the cache
+     */
+    FarFieldCache(VulkanContext& context, StarScene& scene, uint32_t framesInFlight, VkFormat format,
+                  float galaxyRadius, const FarFieldConfig& config = FarFieldConfig());
+    ~FarFieldCache();
+
+    FarFieldCache(const FarFieldCache&) = delete;
+    FarFieldCache& operator=(const FarFieldCache&) = delete;
+
+    /**
+     * How the render graph finds the cache before the frame and leaves it after
+     */
+    static RenderGraph::ImportInfo getImportInfo(VkFormat format);
+
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+    const Image& getImage() const { return *image; }
+
+    /**
+     * Size the cache to the HDR target, with the margin, and draw it again. The device must be idle
+     */
+    void resize(VkExtent2D extent);
+
+    /**
+     * Keep the cache or draw it again this frame. Drawing it selects its chunks with the scene, into its own ranges:
+     * the selection of the frame stays valid
+     * @return the cache is drawn again
+     */
+    bool update(uint32_t frameIndex, const CameraUniforms& camera, uint64_t positionsVersion);
+
+    bool isRefreshing() const { return refreshing; }
+
+    /**
+     * Chunks of the cache, to draw after begin() when it is drawn again
+     */
+    const std::vector<StarDrawRange>& getFarRanges() const { return farRanges; }
+
+    /**
+     * What the cache does not hold in a selection of the frame
+     */
+    const std::vector<StarDrawRange>& splitNear(const std::vector<StarDrawRange>& ranges);
+
+    /**
+     * Bind the camera of the cache to a star pipeline, inside the pass rendering into the cache
+     */
+    void begin(VkCommandBuffer commandBuffer, const Pipeline& pipeline, uint32_t frameIndex) const;
+
+    /**
+     * Add the reprojected cache to the bound color attachment, with the pipeline from
+     * PipelineManager::getFullscreenConfig() blended like the stars
+     */
+    void composite(VkCommandBuffer commandBuffer, Pipeline& pipeline) const;
+
+private:
+    void createDescriptors();
+    void transitionImage();
+    bool isFar(uint32_t chunk, const glm::vec3& eye) const;
+    bool contains(const glm::mat4& reprojection) const;
+
+    VulkanContext& context;
+    StarScene& scene;
+    VkFormat format;
+    float nearDistance;
+    FarFieldConfig config;
+    std::unique_ptr<FrameUniforms> uniforms;
+    std::unique_ptr<Image> image;
+
+    // Camera of the cache
+    bool valid = false;
+    bool refreshing = false;
+    uint64_t cachedVersion = 0;
+    glm::vec3 cachedEye{0.0f};
+    float cachedPixelsPerUnit = 0.0f;
+    glm::mat4 cachedViewProjection{1.0f};
+    FarFieldPushConstants pushConstants{};
+
+    std::vector<StarDrawRange> farRanges;
+    std::vector<StarDrawRange> nearRanges;
+    std::vector<bool> cachedChunks;
+
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    Logger logger;
+};
+
+#endif //FARFIELDCACHE_H
@@ -0,0 +1,108 @@
+//
+// Created by raph on 24/01/25.
+//
+
+#include "FrameUniforms.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "VulkanContext.h"
+
+FrameUniforms::FrameUniforms(VulkanContext& context, uint32_t framesInFlight)
+    : context(context)
+    , framesInFlight(framesInFlight)
+    , logger("FrameUniforms") {
+
+    // Dynamic offsets must be multiples of the device alignment
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(context.getPhysicalDevice(), &properties);
+    const VkDeviceSize alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+    slotSize = (sizeof(CameraUniforms) + alignment - 1) / alignment * alignment;
+
+    uniformBuffer = std::make_unique<Buffer>(
+        context,
+        slotSize * framesInFlight,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        MemoryTag::Uniforms
+    );
+    uniformBuffer->map();
+
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+
+    if (vkCreateDescriptorSetLayout(context.getDevice(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create frame uniform descriptor set layout");
+    }
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    poolSize.descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(context.getDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create frame uniform descriptor pool");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(context.getDevice(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate frame uniform descriptor set");
+    }
+
+    // One descriptor covers a single slot, the dynamic offset picks which
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = uniformBuffer->getBuffer();
+    bufferInfo.offset = 0;
+    bufferInfo.range = sizeof(CameraUniforms);
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(context.getDevice(), 1, &write, 0, nullptr);
+}
+
+FrameUniforms::~FrameUniforms() {
+    if (descriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(context.getDevice(), descriptorPool, nullptr);
+    }
+    if (descriptorSetLayout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(context.getDevice(), descriptorSetLayout, nullptr);
+    }
+}
+
+void FrameUniforms::write(uint32_t frameIndex, const CameraUniforms& uniforms) {
+    if (frameIndex >= framesInFlight) {
+        throw std::runtime_error("Frame index out of the uniform ring");
+    }
+    std::memcpy(static_cast<char*>(uniformBuffer->getMapped()) + slotSize * frameIndex, &uniforms, sizeof(uniforms));
+}
+
+void FrameUniforms::bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t frameIndex,
+                         VkPipelineBindPoint bindPoint) const {
+    const auto offset = static_cast<uint32_t>(slotSize * frameIndex);
+    vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, SET, 1, &descriptorSet, 1, &offset);
+}
@@ -0,0 +1,65 @@
+//
+// Created by raph on 24/01/25.
+//
+
+#ifndef FRAMEUNIFORMS_H
+#define FRAMEUNIFORMS_H
+
+#include <memory>
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include "Buffer.h"
+#include "../core/Logger.h"
+
+class VulkanContext;
+
+/**
+ * Per frame view data, std140 layout (see camera.glsl)
+ */
+struct CameraUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 position;         // xyz, kpc
+    glm::vec4 viewport;         // width, height in pixels, pixels per unit at distance 1, unused
+};
+
+/**
+ * Ring of camera uniforms with one slot per frame in flight, in a single persistently mapped buffer.
+ * A frame writes its own slot after waiting for its fence, so no write ever touches data the GPU may still read,
+ * and the descriptor set is bound with the slot as dynamic offset. Nothing is allocated after construction.
+ * Bound as set 1 of the star pipelines and of the star splat.
+ */
+class FrameUniforms {
+public:
+    static constexpr uint32_t SET = 1;
+
+    FrameUniforms(VulkanContext& context, uint32_t framesInFlight);
+    ~FrameUniforms();
+
+    FrameUniforms(const FrameUniforms&) = delete;
+    FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+
+    /**
+     * Write the slot of the frame, the fence of that frame must have been waited on
+     */
+    void write(uint32_t frameIndex, const CameraUniforms& uniforms);
+
+    void bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t frameIndex,
+              VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS) const;
+
+private:
+    VulkanContext& context;
+    uint32_t framesInFlight;
+    VkDeviceSize slotSize;
+    std::unique_ptr<Buffer> uniformBuffer;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    Logger logger;
+};
+
+#endif //FRAMEUNIFORMS_H
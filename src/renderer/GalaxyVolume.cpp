@@ -0,0 +1,473 @@
+//
+// Created by raph on 06/02/25.
+//
+
+#include "GalaxyVolume.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "FrameUniforms.h"
+#include "Image.h"
+#include "Pipeline.h"
+#include "StarField.h"
+#include "StarPalette.h"
+#include "VulkanContext.h"
+#include "../scene/StarScene.h"
+
+namespace {
+    // Must match the galaxy_volume shaders
+    constexpr uint32_t SPLAT_GROUP_SIZE = 64;
+    constexpr uint32_t RESOLVE_GROUP_SIZE = 4;
+    constexpr uint32_t MARCH_GROUP_SIZE = 8;
+    constexpr VkFormat VOLUME_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+    enum Binding : uint32_t {
+        STARS,
+        ACCUMULATION,
+        VOLUME_STORAGE,
+        VOLUME_SAMPLED,
+        TARGET_STORAGE,
+        TARGET_SAMPLED,
+        BINDING_COUNT
+    };
+
+    uint32_t groups(uint32_t count, uint32_t groupSize) {
+        return (count + groupSize - 1) / groupSize;
+    }
+}
+
+GalaxyVolume::GalaxyVolume(VulkanContext& context, const StarField& starField, const StarScene& scene,
+                           const StarPalette& palette, const FrameUniforms& frameUniforms, const VolumeConfig& config)
+    : context(context)
+    , starField(starField)
+    , scene(scene)
+    , palette(palette)
+    , frameUniforms(frameUniforms)
+    , config(config)
+    , logger("GalaxyVolume") {
+
+    // Cubic voxels for the bounds the galaxy starts with, a flat disk needs few of them vertically
+    glm::vec3 low, high;
+    computeBounds(low, high);
+    const glm::vec3 size = high - low;
+    const float longest = std::max({size.x, size.y, size.z});
+    for (int axis = 0; axis < 3; axis++) {
+        const float voxels = static_cast<float>(config.resolution) * size[axis] / longest;
+        resolution[axis] = std::max(8u, static_cast<uint32_t>(std::ceil(voxels)));
+    }
+
+    createVolume();
+    createDescriptors();
+    createPipelines();
+
+    LOG_DEBUG(logger, "Galaxy volume of {}x{}x{} voxels ({} MiB with its sums)", resolution.x, resolution.y,
+              resolution.z, (volumeSize + accumulation->getSize()) >> 20);
+}
+
+GalaxyVolume::~GalaxyVolume() {
+    VkDevice device = context.getDevice();
+    for (VkPipeline pipeline : {splatPipeline, resolvePipeline, marchPipeline}) {
+        if (pipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(device, pipeline, nullptr);
+        }
+    }
+    if (pipelineLayout != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    }
+    if (descriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    }
+    if (descriptorSetLayout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+    }
+    if (sampler != VK_NULL_HANDLE) {
+        vkDestroySampler(device, sampler, nullptr);
+    }
+    if (volumeView != VK_NULL_HANDLE) {
+        vkDestroyImageView(device, volumeView, nullptr);
+    }
+    if (volume != VK_NULL_HANDLE) {
+        vkDestroyImage(device, volume, nullptr);
+    }
+    if (volumeMemory != VK_NULL_HANDLE) {
+        vkFreeMemory(device, volumeMemory, nullptr);
+        context.getMemoryTracker().recordFree(volumeMemoryType, volumeSize, MemoryTag::Targets);
+    }
+}
+
+void GalaxyVolume::computeBounds(glm::vec3& low, glm::vec3& high) const {
+    const ChunkBounds& bounds = scene.getChunkBounds();
+    low = glm::vec3(std::numeric_limits<float>::max());
+    high = glm::vec3(std::numeric_limits<float>::lowest());
+    for (size_t chunk = 0; chunk < bounds.size(); chunk++) {
+        low = glm::vec3(std::min(low.x, bounds.minX[chunk]), std::min(low.y, bounds.minY[chunk]),
+                        std::min(low.z, bounds.minZ[chunk]));
+        high = glm::vec3(std::max(high.x, bounds.maxX[chunk]), std::max(high.y, bounds.maxY[chunk]),
+                         std::max(high.z, bounds.maxZ[chunk]));
+    }
+
+    // Stars on the faces would fall out of the last voxel
+    const glm::vec3 padding = 0.01f * (high - low) + glm::vec3(1e-3f);
+    low -= padding;
+    high += padding;
+}
+
+void GalaxyVolume::createVolume() {
+    VkDevice device = context.getDevice();
+    const uint32_t voxelCount = resolution.x * resolution.y * resolution.z;
+
+    accumulation = std::make_unique<Buffer>(
+        context,
+        3 * sizeof(uint32_t) * voxelCount,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        MemoryTag::Targets
+    );
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_3D;
+    imageInfo.format = VOLUME_FORMAT;
+    imageInfo.extent = {resolution.x, resolution.y, resolution.z};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(device, &imageInfo, nullptr, &volume) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create galaxy volume");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, volume, &memRequirements);
+
+    MemoryTracker& tracker = context.getMemoryTracker();
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = tracker.findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &volumeMemory) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate " + std::to_string(memRequirements.size >> 20) +
+                                 " MiB for the galaxy volume\n" + tracker.describe());
+    }
+    volumeMemoryType = allocInfo.memoryTypeIndex;
+    volumeSize = memRequirements.size;
+    tracker.recordAllocation(volumeMemoryType, volumeSize, MemoryTag::Targets);
+    vkBindImageMemory(device, volume, volumeMemory, 0);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = volume;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_3D;
+    viewInfo.format = VOLUME_FORMAT;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(device, &viewInfo, nullptr, &volumeView) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create galaxy volume view");
+    }
+
+    // Rays start and end outside of the volume, where it is empty
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+    samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+    samplerInfo.maxLod = 0.0f;
+
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create galaxy volume sampler");
+    }
+}
+
+void GalaxyVolume::createDescriptors() {
+    std::array<VkDescriptorSetLayoutBinding, BINDING_COUNT> bindings{};
+    const std::array<VkDescriptorType, BINDING_COUNT> types = {
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+    };
+    for (uint32_t i = 0; i < BINDING_COUNT; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = types[i];
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = i == TARGET_SAMPLED ? VK_SHADER_STAGE_FRAGMENT_BIT : VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(context.getDevice(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create galaxy volume descriptor set layout");
+    }
+
+    std::array<VkDescriptorPoolSize, 3> poolSizes{};
+    poolSizes[0] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2};
+    poolSizes[1] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2};
+    poolSizes[2] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2};
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    if (vkCreateDescriptorPool(context.getDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create galaxy volume descriptor pool");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(context.getDevice(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate galaxy volume descriptor set");
+    }
+
+    // The volume stays in the general layout, written by the resolve and sampled by the march
+    std::array<VkDescriptorBufferInfo, 2> bufferInfos{};
+    bufferInfos[STARS] = {starField.getStarBuffer().getBuffer(), 0, VK_WHOLE_SIZE};
+    bufferInfos[ACCUMULATION] = {accumulation->getBuffer(), 0, VK_WHOLE_SIZE};
+    std::array<VkDescriptorImageInfo, 2> imageInfos{};
+    imageInfos[0] = {VK_NULL_HANDLE, volumeView, VK_IMAGE_LAYOUT_GENERAL};
+    imageInfos[1] = {sampler, volumeView, VK_IMAGE_LAYOUT_GENERAL};
+
+    std::array<VkWriteDescriptorSet, 4> writes{};
+    for (uint32_t i = 0; i < writes.size(); i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = descriptorSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = types[i];
+    }
+    writes[STARS].pBufferInfo = &bufferInfos[STARS];
+    writes[ACCUMULATION].pBufferInfo = &bufferInfos[ACCUMULATION];
+    writes[VOLUME_STORAGE].pImageInfo = &imageInfos[0];
+    writes[VOLUME_SAMPLED].pImageInfo = &imageInfos[1];
+    vkUpdateDescriptorSets(context.getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void GalaxyVolume::createPipelines() {
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = static_cast<uint32_t>(std::max(sizeof(SplatConstants), sizeof(MarchConstants)));
+
+    // The splat reads the palette like the star pipelines
+    std::array<VkDescriptorSetLayout, 3> setLayouts = {palette.getDescriptorSetLayout(),
+                                                       frameUniforms.getDescriptorSetLayout(), descriptorSetLayout};
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    layoutInfo.pSetLayouts = setLayouts.data();
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(context.getDevice(), &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create galaxy volume pipeline layout");
+    }
+
+    splatShader = std::make_unique<Shader>(context, "shaders/galaxy_volume_splat.comp.spv", Shader::Type::Compute);
+    resolveShader = std::make_unique<Shader>(context, "shaders/galaxy_volume_resolve.comp.spv", Shader::Type::Compute);
+    marchShader = std::make_unique<Shader>(context, "shaders/galaxy_volume_march.comp.spv", Shader::Type::Compute);
+
+    auto createPipeline = [&](const Shader& shader) {
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shader.getShaderModule();
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+
+        VkPipeline pipeline;
+        if (vkCreateComputePipelines(context.getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create galaxy volume pipeline");
+        }
+        return pipeline;
+    };
+    splatPipeline = createPipeline(*splatShader);
+    resolvePipeline = createPipeline(*resolveShader);
+    marchPipeline = createPipeline(*marchShader);
+}
+
+void GalaxyVolume::setTarget(const Image& newTarget) {
+    target = &newTarget;
+
+    std::array<VkDescriptorImageInfo, 2> imageInfos{};
+    imageInfos[0] = {VK_NULL_HANDLE, target->getView(), VK_IMAGE_LAYOUT_GENERAL};
+    imageInfos[1] = {sampler, target->getView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+
+    std::array<VkWriteDescriptorSet, 2> writes{};
+    for (uint32_t i = 0; i < writes.size(); i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = descriptorSet;
+        writes[i].descriptorCount = 1;
+        writes[i].pImageInfo = &imageInfos[i];
+    }
+    writes[0].dstBinding = TARGET_STORAGE;
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[1].dstBinding = TARGET_SAMPLED;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    vkUpdateDescriptorSets(context.getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void GalaxyVolume::update(VkCommandBuffer commandBuffer, uint64_t positionsVersion) {
+    if (!building) {
+        if (ready && positionsVersion == builtVersion) {
+            return;
+        }
+        computeBounds(buildingMin, buildingMax);
+        buildingVersion = positionsVersion;
+        nextChunk = 0;
+        building = true;
+
+        // The resolve of the last build may still read the sums
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = accumulation->getBuffer();
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 0, nullptr, 1, &barrier, 0, nullptr);
+        vkCmdFillBuffer(commandBuffer, accumulation->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    // This frame's share of the chunks, stars only: the aggregates would count them again
+    const size_t chunkCount = scene.getChunkCount();
+    const size_t chunksPerFrame = (chunkCount + std::max(config.buildFrames, 1u) - 1) / std::max(config.buildFrames, 1u);
+    const size_t lastChunk = std::min(chunkCount, nextChunk + chunksPerFrame);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, splatPipeline);
+    palette.bind(commandBuffer, pipelineLayout, VK_PIPELINE_BIND_POINT_COMPUTE);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, SET, 1, &descriptorSet, 0, nullptr);
+    for (size_t chunk = nextChunk; chunk < lastChunk; chunk++) {
+        const auto& frame = starField.getChunkFrame(static_cast<uint32_t>(chunk));
+        SplatConstants constants{};
+        constants.chunkCenter = glm::vec4(frame.center[0], frame.center[1], frame.center[2], 0.0f);
+        constants.chunkHalfExtent = glm::vec4(frame.halfExtent[0], frame.halfExtent[1], frame.halfExtent[2], 0.0f);
+        constants.boundsMin = glm::vec4(buildingMin, 0.0f);
+        constants.boundsMax = glm::vec4(buildingMax, 0.0f);
+        constants.resolution = glm::uvec4(resolution, scene.getChunkFirstPoint(chunk));
+        constants.pointCount = scene.getChunkStarCount(chunk);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(commandBuffer, groups(constants.pointCount, SPLAT_GROUP_SIZE), 1, 1);
+    }
+    nextChunk = lastChunk;
+
+    if (nextChunk == chunkCount) {
+        resolve(commandBuffer);
+    }
+}
+
+void GalaxyVolume::resolve(VkCommandBuffer commandBuffer) {
+    VkMemoryBarrier sumsBarrier{};
+    sumsBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    sumsBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    sumsBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    // Marches of earlier frames may still sample the volume
+    VkImageMemoryBarrier volumeBarrier{};
+    volumeBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    volumeBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    volumeBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    volumeBarrier.oldLayout = volumeInitialized ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_UNDEFINED;
+    volumeBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    volumeBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    volumeBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    volumeBarrier.image = volume;
+    volumeBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 1, &sumsBarrier, 0, nullptr, 1, &volumeBarrier);
+    volumeInitialized = true;
+
+    SplatConstants constants{};
+    constants.resolution = glm::uvec4(resolution, 0);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, resolvePipeline);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    vkCmdDispatch(commandBuffer, groups(resolution.x, RESOLVE_GROUP_SIZE), groups(resolution.y, RESOLVE_GROUP_SIZE),
+                  groups(resolution.z, RESOLVE_GROUP_SIZE));
+
+    volumeBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    volumeBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    volumeBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &volumeBarrier);
+
+    builtMin = buildingMin;
+    builtMax = buildingMax;
+    builtVersion = buildingVersion;
+    building = false;
+    ready = true;
+}
+
+bool GalaxyVolume::covers(const glm::vec3& eye) const {
+    if (!ready) {
+        return false;
+    }
+    const bool inside = eye.x > builtMin.x && eye.y > builtMin.y && eye.z > builtMin.z &&
+                        eye.x < builtMax.x && eye.y < builtMax.y && eye.z < builtMax.z;
+    return !inside;
+}
+
+void GalaxyVolume::setView(const glm::mat4& viewProjection, const glm::vec3& eye, const glm::vec3& viewport) {
+    const glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+    const glm::vec3 voxel = (builtMax - builtMin) / glm::vec3(resolution);
+
+    marchConstants.inverseViewProjection = inverseViewProjection;
+    marchConstants.boundsMin = glm::vec4(builtMin, voxel.x * voxel.y * voxel.z);
+    marchConstants.boundsMax = glm::vec4(builtMax, viewport.z);
+    marchConstants.eye = glm::vec4(eye, 0.0f);
+    marchConstants.steps = std::max(config.steps, 1u);
+
+    compositeConstants.inverseViewProjection = inverseViewProjection;
+    compositeConstants.eye = glm::vec4(eye, 0.5f * (builtMin.z + builtMax.z));
+    compositeConstants.viewport = glm::vec4(viewport.x, viewport.y, 0.0f, 0.0f);
+}
+
+void GalaxyVolume::march(VkCommandBuffer commandBuffer) const {
+    if (!target) {
+        return;
+    }
+    const VkExtent2D extent = target->getExtent();
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, marchPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, SET, 1, &descriptorSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(marchConstants), &marchConstants);
+    vkCmdDispatch(commandBuffer, groups(extent.width, MARCH_GROUP_SIZE), groups(extent.height, MARCH_GROUP_SIZE), 1);
+}
+
+void GalaxyVolume::composite(VkCommandBuffer commandBuffer, Pipeline& pipeline) const {
+    pipeline.bind(commandBuffer);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getLayout(), SET, 1, &descriptorSet,
+                            0, nullptr);
+    vkCmdPushConstants(commandBuffer, pipeline.getLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(compositeConstants),
+                       &compositeConstants);
+    vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+}
@@ -0,0 +1,175 @@
+//
+// Created by raph on 06/02/25.
+//
+
+#ifndef GALAXYVOLUME_H
+#define GALAXYVOLUME_H
+
+#include <memory>
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include "Buffer.h"
+#include "Shader.h"
+#include "../core/Logger.h"
+
+class VulkanContext;
+class FrameUniforms;
+class Image;
+class Pipeline;
+class StarField;
+class StarPalette;
+class StarScene;
+
+struct VolumeConfig {
+    bool enabled = false;
+    uint32_t resolution = 256;      // voxels along the longest side of the galaxy, the others keep its proportions
+    float scale = 0.25f;            // of the HDR target, for the raymarch
+    uint32_t steps = 96;            // samples along each ray
+    uint32_t buildFrames = 8;       // a rebuild splats its share of the chunks each frame for this many frames
+};
+
+/**
+ * Push constants of the pipeline compositing the raymarched volume (see galaxy_volume_composite.frag)
+ */
+struct VolumeCompositeConstants {
+    glm::mat4 inverseViewProjection;
+    glm::vec4 eye;                  // xyz, w is the height of the disk plane
+    glm::vec4 viewport;             // width, height of the full resolution target
+};
+
+/**
+ * Far field of the whole galaxy as a 3D emission texture, raymarched at reduced resolution instead of drawing every
+ * star, so the cost follows the screen size and not the star count.
+ *
+ * The texture is built on the GPU from the packed stars: every star adds its color to its voxel with integer atomics
+ * (galaxy_volume_splat.comp), then the sums are resolved into the texture. A rebuild is spread over buildFrames
+ * frames and starts only when the positions changed, and the previous texture is marched until the new one is
+ * complete. Each voxel holds the light of its stars, so a ray adds it in proportion to the pixel footprint and
+ * the volume is as bright as the stars it replaces.
+ *
+ * The march writes the light along each ray and its mean depth, and the stars pass upsamples it with weights that
+ * follow the depth of the disk plane at full resolution, so the bulge and the disk behind it do not bleed into each
+ * other. Builds are recorded outside of the render graph with their own barriers; the march is a compute pass of
+ * the graph, with the low resolution target as a storage image.
+ */
+class GalaxyVolume {
+public:
+    static constexpr uint32_t SET = 2;
+    static constexpr VkFormat TARGET_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+    /**
+     * Voxel counts come from the bounds of the scene, its positions must be uploaded
+     */
+    GalaxyVolume(VulkanContext& context, const StarField& starField, const StarScene& scene, const StarPalette& palette,
+                 const FrameUniforms& frameUniforms, const VolumeConfig& config = VolumeConfig());
+    ~GalaxyVolume();
+
+    GalaxyVolume(const GalaxyVolume&) = delete;
+    GalaxyVolume& operator=(const GalaxyVolume&) = delete;
+
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+
+    /**
+     * Point the march and the composite at the low resolution target of the compiled render graph, the device must
+     * be idle
+     */
+    void setTarget(const Image& target);
+
+    /**
+     * Continue the rebuild, or start one when the positions changed since the last. Must be recorded outside of a
+     * render pass
+     */
+    void update(VkCommandBuffer commandBuffer, uint64_t positionsVersion);
+
+    /**
+     * A texture was built, and the eye is outside of it: rays cross the whole galaxy
+     */
+    bool covers(const glm::vec3& eye) const;
+
+    /**
+     * View of the frame, for march() and composite()
+     * @param viewport width, height and pixels per unit at distance 1 of the full resolution target
+     */
+    void setView(const glm::mat4& viewProjection, const glm::vec3& eye, const glm::vec3& viewport);
+
+    /**
+     * Raymarch into the target, in the storage layout
+     */
+    void march(VkCommandBuffer commandBuffer) const;
+
+    /**
+     * Add the upsampled march to the bound color attachment, with the pipeline from
+     * PipelineManager::getFullscreenConfig() blended like the stars. The target is in the shader read only layout
+     */
+    void composite(VkCommandBuffer commandBuffer, Pipeline& pipeline) const;
+
+private:
+    struct SplatConstants {
+        glm::vec4 chunkCenter;
+        glm::vec4 chunkHalfExtent;
+        glm::vec4 boundsMin;
+        glm::vec4 boundsMax;
+        glm::uvec4 resolution;      // xyz, w is the first point
+        uint32_t pointCount;
+    };
+
+    struct MarchConstants {
+        glm::mat4 inverseViewProjection;
+        glm::vec4 boundsMin;        // w is the volume of a voxel
+        glm::vec4 boundsMax;        // w is the pixels per unit at distance 1
+        glm::vec4 eye;
+        uint32_t steps;
+    };
+
+    void createVolume();
+    void createDescriptors();
+    void createPipelines();
+    void computeBounds(glm::vec3& low, glm::vec3& high) const;
+    void resolve(VkCommandBuffer commandBuffer);
+
+    VulkanContext& context;
+    const StarField& starField;
+    const StarScene& scene;
+    const StarPalette& palette;
+    const FrameUniforms& frameUniforms;
+    VolumeConfig config;
+    glm::uvec3 resolution{1};
+    const Image* target = nullptr;
+
+    // Build state
+    bool building = false;
+    bool ready = false;
+    bool volumeInitialized = false;     // layout of the texture, undefined until the first resolve
+    uint64_t buildingVersion = 0;
+    uint64_t builtVersion = 0;
+    size_t nextChunk = 0;
+    glm::vec3 buildingMin{0.0f}, buildingMax{0.0f};
+    glm::vec3 builtMin{0.0f}, builtMax{0.0f};
+
+    // View of the frame
+    MarchConstants marchConstants{};
+    VolumeCompositeConstants compositeConstants{};
+
+    std::unique_ptr<Buffer> accumulation;       // r, g, b per voxel
+    VkImage volume = VK_NULL_HANDLE;
+    VkDeviceMemory volumeMemory = VK_NULL_HANDLE;
+    VkImageView volumeView = VK_NULL_HANDLE;
+    uint32_t volumeMemoryType = 0;
+    VkDeviceSize volumeSize = 0;
+    VkSampler sampler = VK_NULL_HANDLE;
+
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    std::unique_ptr<Shader> splatShader;
+    std::unique_ptr<Shader> resolveShader;
+    std::unique_ptr<Shader> marchShader;
+    VkPipeline splatPipeline = VK_NULL_HANDLE;
+    VkPipeline resolvePipeline = VK_NULL_HANDLE;
+    VkPipeline marchPipeline = VK_NULL_HANDLE;
+    Logger logger;
+};
+
+#endif //GALAXYVOLUME_H
@@ -0,0 +1,271 @@
+//
+// Created by raph on 01/02/25.
+//
+
+#include "GpuRadixSort.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "VulkanContext.h"
+
+namespace {
+    // Must match radix_sort.glsl
+    constexpr uint32_t RADIX_BITS = 11;
+    constexpr uint32_t RADIX_BUCKETS = 1u << RADIX_BITS;
+    constexpr uint32_t RADIX_BLOCK = 256 * 16;
+
+    constexpr uint32_t BINDING_COUNT = 5;
+
+    void computeBarrier(VkCommandBuffer commandBuffer) {
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+}
+
+GpuRadixSort::GpuRadixSort(VulkanContext& context, uint32_t capacity, uint32_t framesInFlight)
+    : context(context)
+    , capacity(capacity)
+    , framesInFlight(framesInFlight)
+    , maxBlocks((capacity + RADIX_BLOCK - 1) / RADIX_BLOCK)
+    , logger("GpuRadixSort") {
+
+    if (capacity == 0) {
+        throw std::runtime_error("Cannot create an empty GPU radix sort");
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(context.getPhysicalDevice(), &properties);
+    const VkDeviceSize alignment = std::max<VkDeviceSize>(properties.limits.minStorageBufferOffsetAlignment, 1);
+    keysSize = (sizeof(uint64_t) * capacity + alignment - 1) / alignment * alignment;
+    valuesSize = (sizeof(uint32_t) * capacity + alignment - 1) / alignment * alignment;
+    sliceSize = keysSize + valuesSize;
+
+    input = std::make_unique<Buffer>(
+        context,
+        sliceSize * framesInFlight,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        MemoryTag::Sorting
+    );
+    input->map();
+
+    for (size_t i = 0; i < 2; i++) {
+        keys[i] = std::make_unique<Buffer>(context, sizeof(uint64_t) * capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryTag::Sorting);
+        values[i] = std::make_unique<Buffer>(context, sizeof(uint32_t) * capacity,
+                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryTag::Sorting);
+    }
+    histograms = std::make_unique<Buffer>(context, sizeof(uint32_t) * RADIX_BUCKETS * maxBlocks,
+                                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                          MemoryTag::Sorting);
+
+    createDescriptors();
+    createPipelines();
+
+    LOG_DEBUG(logger, "Created GPU radix sort of {} pairs in {} blocks", capacity, maxBlocks);
+}
+
+GpuRadixSort::~GpuRadixSort() {
+    VkDevice device = context.getDevice();
+    for (VkPipeline pipeline : {histogramPipeline, scanPipeline, scatterPipeline}) {
+        if (pipeline != VK_NULL_HANDLE) {
+            vkDestroyPipeline(device, pipeline, nullptr);
+        }
+    }
+    if (pipelineLayout != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    }
+    if (descriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    }
+    if (descriptorSetLayout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+    }
+}
+
+uint64_t* GpuRadixSort::getKeys(uint32_t frameIndex) const {
+    return reinterpret_cast<uint64_t*>(static_cast<char*>(input->getMapped()) + sliceSize * frameIndex);
+}
+
+uint32_t* GpuRadixSort::getValues(uint32_t frameIndex) const {
+    return reinterpret_cast<uint32_t*>(static_cast<char*>(input->getMapped()) + sliceSize * frameIndex + keysSize);
+}
+
+void GpuRadixSort::createDescriptors() {
+    // Source keys, source values, destination keys, destination values, histograms
+    std::array<VkDescriptorSetLayoutBinding, BINDING_COUNT> bindings{};
+    for (uint32_t i = 0; i < BINDING_COUNT; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = BINDING_COUNT;
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(context.getDevice(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create radix sort descriptor set layout");
+    }
+
+    const uint32_t setCount = framesInFlight + 2;
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = setCount * BINDING_COUNT;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = setCount;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(context.getDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create radix sort descriptor pool");
+    }
+
+    std::vector<VkDescriptorSetLayout> layouts(setCount, descriptorSetLayout);
+    std::vector<VkDescriptorSet> sets(setCount);
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = setCount;
+    allocInfo.pSetLayouts = layouts.data();
+
+    if (vkAllocateDescriptorSets(context.getDevice(), &allocInfo, sets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate radix sort descriptor sets");
+    }
+
+    inputSets.assign(sets.begin(), sets.begin() + framesInFlight);
+    pingPongSets = {sets[framesInFlight], sets[framesInFlight + 1]};
+
+    for (uint32_t frame = 0; frame < framesInFlight; frame++) {
+        writeSet(inputSets[frame], input->getBuffer(), sliceSize * frame, input->getBuffer(), sliceSize * frame + keysSize, 0);
+    }
+    writeSet(pingPongSets[0], keys[0]->getBuffer(), 0, values[0]->getBuffer(), 0, 1);
+    writeSet(pingPongSets[1], keys[1]->getBuffer(), 0, values[1]->getBuffer(), 0, 0);
+}
+
+void GpuRadixSort::writeSet(VkDescriptorSet set, VkBuffer sourceKeys, VkDeviceSize sourceKeysOffset, VkBuffer sourceValues,
+                            VkDeviceSize sourceValuesOffset, size_t destination) {
+    std::array<VkDescriptorBufferInfo, BINDING_COUNT> bufferInfos{};
+    bufferInfos[0] = {sourceKeys, sourceKeysOffset, sizeof(uint64_t) * capacity};
+    bufferInfos[1] = {sourceValues, sourceValuesOffset, sizeof(uint32_t) * capacity};
+    bufferInfos[2] = {keys[destination]->getBuffer(), 0, VK_WHOLE_SIZE};
+    bufferInfos[3] = {values[destination]->getBuffer(), 0, VK_WHOLE_SIZE};
+    bufferInfos[4] = {histograms->getBuffer(), 0, VK_WHOLE_SIZE};
+
+    std::array<VkWriteDescriptorSet, BINDING_COUNT> writes{};
+    for (uint32_t i = 0; i < BINDING_COUNT; i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    vkUpdateDescriptorSets(context.getDevice(), BINDING_COUNT, writes.data(), 0, nullptr);
+}
+
+void GpuRadixSort::createPipelines() {
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(PassConstants);
+
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &descriptorSetLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(context.getDevice(), &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create radix sort pipeline layout");
+    }
+
+    histogramShader = std::make_unique<Shader>(context, "shaders/radix_histogram.comp.spv", Shader::Type::Compute);
+    scanShader = std::make_unique<Shader>(context, "shaders/radix_scan.comp.spv", Shader::Type::Compute);
+    scatterShader = std::make_unique<Shader>(context, "shaders/radix_scatter.comp.spv", Shader::Type::Compute);
+
+    auto createPipeline = [&](const Shader& shader) {
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shader.getShaderModule();
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+
+        VkPipeline pipeline;
+        if (vkCreateComputePipelines(context.getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create radix sort pipeline");
+        }
+        return pipeline;
+    };
+    histogramPipeline = createPipeline(*histogramShader);
+    scanPipeline = createPipeline(*scanShader);
+    scatterPipeline = createPipeline(*scatterShader);
+}
+
+void GpuRadixSort::record(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t count, uint32_t keyBits) {
+    if (count > capacity) {
+        throw std::runtime_error("Radix sort of " + std::to_string(count) + " pairs over its capacity of " +
+                                 std::to_string(capacity));
+    }
+    if (count == 0) {
+        return;
+    }
+
+    // Draws of earlier frames may still read the sorted values
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_INDEX_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    PassConstants constants{};
+    constants.count = count;
+    constants.blockCount = (count + RADIX_BLOCK - 1) / RADIX_BLOCK;
+
+    // Digits never straddle the two words of the keys
+    uint32_t pass = 0;
+    for (uint32_t word = 0; word < 2; word++) {
+        const uint32_t wordBits = std::min(32u, keyBits - std::min(keyBits, 32 * word));
+        for (uint32_t shift = 0; shift < wordBits; shift += RADIX_BITS, pass++) {
+            constants.word = word;
+            constants.shift = shift;
+            VkDescriptorSet set = pass == 0 ? inputSets[frameIndex] : pingPongSets[(pass - 1) % 2];
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, histogramPipeline);
+            vkCmdDispatch(commandBuffer, constants.blockCount, 1, 1);
+            computeBarrier(commandBuffer);
+
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, scanPipeline);
+            vkCmdDispatch(commandBuffer, 1, 1, 1);
+            computeBarrier(commandBuffer);
+
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, scatterPipeline);
+            vkCmdDispatch(commandBuffer, constants.blockCount, 1, 1);
+            computeBarrier(commandBuffer);
+        }
+    }
+
+    // Pass p writes buffers p % 2
+    sortedBuffer = (pass - 1) % 2;
+
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
@@ -0,0 +1,95 @@
+//
+// Created by raph on 01/02/25.
+//
+
+#ifndef GPURADIXSORT_H
+#define GPURADIXSORT_H
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "Buffer.h"
+#include "Shader.h"
+#include "../core/Logger.h"
+
+class VulkanContext;
+
+/**
+ * Compute shader version of RadixSorter, for selections too large to sort on the CPU every frame.
+ *
+ * Pairs of 64 bit keys and 32 bit values are written by the CPU into a host visible slice per frame in flight,
+ * then every 11 bit digit takes three dispatches (see radix_*.comp): per block digit counts, one prefix over all
+ * the counts, and a stable scatter. Passes ping-pong between two device local buffers, the values of the last one
+ * are directly usable as a 32 bit index buffer.
+ */
+class GpuRadixSort {
+public:
+    GpuRadixSort(VulkanContext& context, uint32_t capacity, uint32_t framesInFlight);
+    ~GpuRadixSort();
+
+    GpuRadixSort(const GpuRadixSort&) = delete;
+    GpuRadixSort& operator=(const GpuRadixSort&) = delete;
+
+    uint32_t getCapacity() const { return capacity; }
+
+    /**
+     * Input of the frame, the fence of the frame must have been waited on before writing
+     */
+    uint64_t* getKeys(uint32_t frameIndex) const;
+    uint32_t* getValues(uint32_t frameIndex) const;
+
+    /**
+     * Record the sort of the first count pairs of the input of the frame, outside of a render pass
+     * @param keyBits low bits of the keys that are not always 0
+     */
+    void record(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t count, uint32_t keyBits);
+
+    /**
+     * Values sorted by the last recorded sort, for the commands recorded after it
+     */
+    VkBuffer getSortedValues() const { return values[sortedBuffer]->getBuffer(); }
+
+private:
+    struct PassConstants {
+        uint32_t count;
+        uint32_t word;
+        uint32_t shift;
+        uint32_t blockCount;
+    };
+
+    void createDescriptors();
+    void createPipelines();
+    void writeSet(VkDescriptorSet set, VkBuffer sourceKeys, VkDeviceSize sourceKeysOffset, VkBuffer sourceValues,
+                  VkDeviceSize sourceValuesOffset, size_t destination);
+
+    VulkanContext& context;
+    uint32_t capacity;
+    uint32_t framesInFlight;
+    uint32_t maxBlocks;
+    VkDeviceSize keysSize;                  // of a slice, aligned for storage buffer offsets
+    VkDeviceSize valuesSize;
+    VkDeviceSize sliceSize;
+
+    std::unique_ptr<Buffer> input;          // host visible, per frame: keys then values
+    std::array<std::unique_ptr<Buffer>, 2> keys;
+    std::array<std::unique_ptr<Buffer>, 2> values;
+    std::unique_ptr<Buffer> histograms;
+    uint32_t sortedBuffer = 0;
+
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> inputSets; // input of each frame to buffers 0
+    std::array<VkDescriptorSet, 2> pingPongSets{};     // buffers 0 to 1, buffers 1 to 0
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    std::unique_ptr<Shader> histogramShader;
+    std::unique_ptr<Shader> scanShader;
+    std::unique_ptr<Shader> scatterShader;
+    VkPipeline histogramPipeline = VK_NULL_HANDLE;
+    VkPipeline scanPipeline = VK_NULL_HANDLE;
+    VkPipeline scatterPipeline = VK_NULL_HANDLE;
+    Logger logger;
+};
+
+#endif //GPURADIXSORT_H
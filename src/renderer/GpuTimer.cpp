@@ -0,0 +1,83 @@
+//
+// Created by raph on 31/01/25.
+//
+
+#include "GpuTimer.h"
+
+#include <stdexcept>
+
+#include "VulkanContext.h"
+
+GpuTimer::GpuTimer(VulkanContext& context, uint32_t framesInFlight)
+    : context(context)
+    , frames(framesInFlight, 0)
+    , pending(framesInFlight, false)
+    , logger("GpuTimer") {
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(context.getPhysicalDevice(), &properties);
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(context.getPhysicalDevice(), &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(context.getPhysicalDevice(), &familyCount, families.data());
+
+    const QueueFamilyIndices indices = context.findQueueFamilies(context.getPhysicalDevice());
+    const uint32_t validBits = indices.graphicsFamily ? families[*indices.graphicsFamily].timestampValidBits : 0;
+    if (validBits == 0 || properties.limits.timestampPeriod <= 0.0f) {
+        logger.warning("The graphics queue has no timestamps, GPU frame times are not measured");
+        return;
+    }
+    nanosecondsPerTick = properties.limits.timestampPeriod;
+    validMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = 2 * framesInFlight;
+
+    if (vkCreateQueryPool(context.getDevice(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create timestamp query pool");
+    }
+}
+
+GpuTimer::~GpuTimer() {
+    if (queryPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(context.getDevice(), queryPool, nullptr);
+    }
+}
+
+void GpuTimer::begin(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frame) {
+    if (!isSupported()) {
+        return;
+    }
+    vkCmdResetQueryPool(commandBuffer, queryPool, 2 * frameIndex, 2);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, 2 * frameIndex);
+    frames[frameIndex] = frame;
+}
+
+void GpuTimer::end(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+    if (!isSupported()) {
+        return;
+    }
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 2 * frameIndex + 1);
+    pending[frameIndex] = true;
+}
+
+std::optional<GpuTimer::Timing> GpuTimer::collect(uint32_t frameIndex) {
+    if (!isSupported() || !pending[frameIndex]) {
+        return std::nullopt;
+    }
+    pending[frameIndex] = false;
+
+    uint64_t timestamps[2];
+    VkResult result = vkGetQueryPoolResults(context.getDevice(), queryPool, 2 * frameIndex, 2, sizeof(timestamps),
+                                            timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) {
+        return std::nullopt;
+    }
+
+    // The counter wraps at validBits
+    const uint64_t ticks = (timestamps[1] - timestamps[0]) & validMask;
+    return Timing{frames[frameIndex], static_cast<double>(ticks) * nanosecondsPerTick * 1e-6};
+}
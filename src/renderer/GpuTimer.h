@@ -0,0 +1,62 @@
+//
+// Created by raph on 31/01/25.
+//
+
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "../core/Logger.h"
+
+class VulkanContext;
+
+/**
+ * GPU duration of whole frames, from two timestamps per frame in flight: one before the first command and one
+ * after the last. A frame slot is read back once its fence has been waited on, so reading never stalls.
+ * Does nothing on queues without timestamp support.
+ */
+class GpuTimer {
+public:
+    struct Timing {
+        uint64_t frame;
+        double milliseconds;
+    };
+
+    GpuTimer(VulkanContext& context, uint32_t framesInFlight);
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    bool isSupported() const { return queryPool != VK_NULL_HANDLE; }
+
+    /**
+     * Right after vkBeginCommandBuffer, outside of any render pass
+     */
+    void begin(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frame);
+
+    /**
+     * Right before vkEndCommandBuffer
+     */
+    void end(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+    /**
+     * Duration of the last frame recorded in this slot, the fence of the slot must have been waited on.
+     * Empty when nothing was recorded since the last call or the results are not there
+     */
+    std::optional<Timing> collect(uint32_t frameIndex);
+
+private:
+    VulkanContext& context;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    double nanosecondsPerTick = 1.0;
+    uint64_t validMask = ~0ull;
+    std::vector<uint64_t> frames;           // frame recorded in each slot
+    std::vector<bool> pending;
+    Logger logger;
+};
+
+#endif //GPUTIMER_H
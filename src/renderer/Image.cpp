@@ -0,0 +1,147 @@
+//
+// Created by raph on 02/02/25.
+//
+
+#include "Image.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "VulkanContext.h"
+
+Image::Image(VulkanContext& context,
+             VkExtent2D extent,
+             VkFormat format,
+             VkImageUsageFlags usage,
+             uint32_t mipLevels,
+             MemoryTag tag)
+    : Image(context, extent, format, usage, mipLevels, tag, true) {
+}
+
+Image::Image(VulkanContext& context,
+             VkExtent2D extent,
+             VkFormat format,
+             VkImageUsageFlags usage,
+             uint32_t mipLevels,
+             MemoryTag tag,
+             bool allocate)
+    : context(context)
+    , extent(extent)
+    , format(format)
+    , mipLevels(mipLevels)
+    , tag(tag) {
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = {extent.width, extent.height, 1};
+    imageInfo.mipLevels = mipLevels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(context.getDevice(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create image");
+    }
+    if (!allocate) {
+        return;
+    }
+
+    VkMemoryRequirements memRequirements = getMemoryRequirements();
+
+    MemoryTracker& tracker = context.getMemoryTracker();
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = tracker.findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkResult result = vkAllocateMemory(context.getDevice(), &allocInfo, nullptr, &memory);
+    if (result != VK_SUCCESS) {
+        vkDestroyImage(context.getDevice(), image, nullptr);
+        tracker.update(tracker.getSnapshot().frame);
+        throw std::runtime_error("Failed to allocate " + std::to_string(memRequirements.size >> 20) + " MiB of image memory for " +
+                                 memoryTagName(tag) + (result == VK_ERROR_OUT_OF_DEVICE_MEMORY ? " (out of device memory)\n" : "\n") +
+                                 tracker.describe());
+    }
+    memoryType = allocInfo.memoryTypeIndex;
+    allocationSize = memRequirements.size;
+    tracker.recordAllocation(memoryType, allocationSize, tag);
+
+    vkBindImageMemory(context.getDevice(), image, memory, 0);
+    createViews();
+}
+
+std::unique_ptr<Image> Image::createUnbound(VulkanContext& context,
+                                            VkExtent2D extent,
+                                            VkFormat format,
+                                            VkImageUsageFlags usage,
+                                            uint32_t mipLevels) {
+    return std::unique_ptr<Image>(new Image(context, extent, format, usage, mipLevels, MemoryTag::Targets, false));
+}
+
+VkMemoryRequirements Image::getMemoryRequirements() const {
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(context.getDevice(), image, &memRequirements);
+    return memRequirements;
+}
+
+void Image::bindMemory(VkDeviceMemory sharedMemory, VkDeviceSize offset) {
+    if (memory != VK_NULL_HANDLE || view != VK_NULL_HANDLE) {
+        throw std::runtime_error("Image already has memory");
+    }
+    if (vkBindImageMemory(context.getDevice(), image, sharedMemory, offset) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to bind image memory");
+    }
+    createViews();
+}
+
+void Image::createViews() {
+    view = createView(0, mipLevels);
+    for (uint32_t level = 0; level < mipLevels; level++) {
+        mipViews.push_back(createView(level, 1));
+    }
+}
+
+Image::~Image() {
+    for (VkImageView mipView : mipViews) {
+        vkDestroyImageView(context.getDevice(), mipView, nullptr);
+    }
+    if (view != VK_NULL_HANDLE) {
+        vkDestroyImageView(context.getDevice(), view, nullptr);
+    }
+    if (image != VK_NULL_HANDLE) {
+        vkDestroyImage(context.getDevice(), image, nullptr);
+    }
+    if (memory != VK_NULL_HANDLE) {
+        vkFreeMemory(context.getDevice(), memory, nullptr);
+        context.getMemoryTracker().recordFree(memoryType, allocationSize, tag);
+    }
+}
+
+VkExtent2D Image::getMipExtent(uint32_t level) const {
+    return {std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u)};
+}
+
+VkImageView Image::createView(uint32_t baseLevel, uint32_t levelCount) const {
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = baseLevel;
+    viewInfo.subresourceRange.levelCount = levelCount;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    VkImageView imageView;
+    if (vkCreateImageView(context.getDevice(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create image view");
+    }
+    return imageView;
+}
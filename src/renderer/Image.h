@@ -0,0 +1,83 @@
+//
+// Created by raph on 02/02/25.
+//
+
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "MemoryTracker.h"
+
+class VulkanContext;
+
+/**
+ * Device local 2D color image with a view of all its mip levels and one view per level, for render targets and
+ * compute passes. Allocations are tracked like the ones of Buffer.
+ * Unbound images have no memory of their own until bindMemory(), which lets RenderGraph alias them.
+ */
+class Image {
+public:
+    Image(VulkanContext& context,
+          VkExtent2D extent,
+          VkFormat format,
+          VkImageUsageFlags usage,
+          uint32_t mipLevels = 1,
+          MemoryTag tag = MemoryTag::Targets);
+
+    ~Image();
+
+    Image(const Image&) = delete;
+    Image& operator=(const Image&) = delete;
+
+    /**
+     * Image without memory nor views, usable once bindMemory() was called. The memory stays owned by the caller
+     */
+    static std::unique_ptr<Image> createUnbound(VulkanContext& context,
+                                                VkExtent2D extent,
+                                                VkFormat format,
+                                                VkImageUsageFlags usage,
+                                                uint32_t mipLevels = 1);
+
+    VkMemoryRequirements getMemoryRequirements() const;
+
+    /**
+     * Bind an unbound image to memory shared with other images, and create its views
+     */
+    void bindMemory(VkDeviceMemory sharedMemory, VkDeviceSize offset);
+
+    VkImage getImage() const { return image; }
+    VkImageView getView() const { return view; }
+    VkImageView getMipView(uint32_t level) const { return mipViews[level]; }
+    VkFormat getFormat() const { return format; }
+    VkExtent2D getExtent() const { return extent; }
+    uint32_t getMipLevels() const { return mipLevels; }
+
+    /**
+     * Size of a mip level, never below one texel
+     */
+    VkExtent2D getMipExtent(uint32_t level) const;
+
+private:
+    Image(VulkanContext& context, VkExtent2D extent, VkFormat format, VkImageUsageFlags usage, uint32_t mipLevels,
+          MemoryTag tag, bool allocate);
+
+    void createViews();
+    VkImageView createView(uint32_t baseLevel, uint32_t levelCount) const;
+
+    VulkanContext& context;
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;     // only when owned
+    VkImageView view = VK_NULL_HANDLE;
+    std::vector<VkImageView> mipViews;
+    VkExtent2D extent;
+    VkFormat format;
+    uint32_t mipLevels;
+    MemoryTag tag;
+    uint32_t memoryType = 0;
+    VkDeviceSize allocationSize = 0;
+};
+
+#endif //IMAGE_H
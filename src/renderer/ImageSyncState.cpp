@@ -0,0 +1,65 @@
+//
+// Created by raph on 08/02/25.
+//
+
+#include "ImageSyncState.h"
+
+ImageSyncState::ImageSyncState(VkImageLayout layout, VkPipelineStageFlags writeStages, VkAccessFlags writeAccess)
+    : layout(layout)
+    , writeStages(writeStages)
+    , writeAccess(writeAccess) {}
+
+bool ImageSyncState::use(const Access& access, Barrier& barrier) {
+    const bool layoutChange = layout != access.layout;
+    const bool visible = (access.stages & ~visibleStages) == 0 && (access.access & ~visibleAccess) == 0;
+
+    if (access.write || layoutChange) {
+        // Write after read and write after write, layout transitions count as writes
+        barrier = {layout, access.layout, writeAccess, access.access, writeStages | readStages, access.stages};
+        layout = access.layout;
+        writeStages = access.stages;
+        readStages = 0;
+        if (access.write) {
+            // Not even visible to the stages that wrote it, the next dispatch or draw reading it waits
+            writeAccess = access.access & WRITE_ACCESS;
+            visibleStages = 0;
+            visibleAccess = 0;
+        } else {
+            writeAccess = 0;
+            readStages = access.stages;
+            visibleStages = access.stages;
+            visibleAccess = access.access;
+        }
+        return true;
+    }
+
+    if (writeStages != 0 && !visible) {
+        // Read after write, from stages that have not waited for it yet
+        barrier = {layout, layout, writeAccess, access.access, writeStages, access.stages};
+        readStages |= access.stages;
+        visibleStages |= access.stages;
+        visibleAccess |= access.access;
+        return true;
+    }
+
+    readStages |= access.stages;
+    return false;
+}
+
+bool ImageSyncState::restore(const ImageSyncState& before, const Access& access, Barrier& barrier) {
+    const bool layoutChange = layout != before.layout;
+    if (layoutChange) {
+        // Within the stages of the use, which the barriers of the later uses wait on
+        barrier = {layout, before.layout, access.access & WRITE_ACCESS, 0, access.stages, access.stages};
+    }
+
+    // What both cases need: the layout from before, waiting on the writes and reads of either
+    const bool written = access.write || layoutChange;
+    layout = before.layout;
+    writeStages = before.writeStages | (written ? access.stages : 0);
+    writeAccess = before.writeAccess | (access.access & WRITE_ACCESS);
+    readStages |= before.readStages;
+    visibleStages = written ? 0 : visibleStages & before.visibleStages;
+    visibleAccess = written ? 0 : visibleAccess & before.visibleAccess;
+    return layoutChange;
+}
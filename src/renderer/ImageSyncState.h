@@ -0,0 +1,74 @@
+//
+// Created by raph on 08/02/25.
+//
+
+#ifndef IMAGESYNCSTATE_H
+#define IMAGESYNCSTATE_H
+
+#include <vulkan/vulkan.h>
+
+/**
+ * What the passes of a frame did to one image so far, while the render graph places its barriers: the layout, the
+ * last write, the stages that read it since and those that already waited for the write.
+ *
+ * Uses are given in pass order. A write or a layout transition waits on every earlier use. A read waits on the last
+ * write, unless an earlier read from the same stages and access already did: a write is never visible to the reads
+ * that come after it, even from the stages that wrote it, until one of them waited for it.
+ */
+class ImageSyncState {
+public:
+    static constexpr VkAccessFlags WRITE_ACCESS = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                                  VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    struct Access {
+        VkPipelineStageFlags stages;
+        VkAccessFlags access;
+        VkImageLayout layout;
+        bool write;
+    };
+
+    struct Barrier {
+        VkImageLayout oldLayout;
+        VkImageLayout newLayout;
+        VkAccessFlags srcAccess;
+        VkAccessFlags dstAccess;
+        VkPipelineStageFlags srcStages;
+        VkPipelineStageFlags dstStages;
+    };
+
+    ImageSyncState() = default;
+
+    /**
+     * @param writeStages what the first use waits on, the last uses of the image before the frame
+     * @param writeAccess what those uses wrote with
+     */
+    ImageSyncState(VkImageLayout layout, VkPipelineStageFlags writeStages, VkAccessFlags writeAccess);
+
+    /**
+     * Add the next use of the image
+     * @param barrier what the use waits on, when it returns true
+     * @return the use must wait for earlier ones
+     */
+    bool use(const Access& access, Barrier& barrier);
+
+    /**
+     * After a use that may be skipped, back to the layout before it, so the later uses find the image the same
+     * whether it ran or not. They wait for its writes either way
+     * @param before the state before the use
+     * @param barrier to the layout before the use, after it, when it returns true
+     * @return the use changed the layout
+     */
+    bool restore(const ImageSyncState& before, const Access& access, Barrier& barrier);
+
+    VkImageLayout getLayout() const { return layout; }
+
+private:
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags writeStages = 0;
+    VkAccessFlags writeAccess = 0;
+    VkPipelineStageFlags readStages = 0;
+    VkPipelineStageFlags visibleStages = 0;     // already waited for the last write
+    VkAccessFlags visibleAccess = 0;
+};
+
+#endif //IMAGESYNCSTATE_H
@@ -0,0 +1,141 @@
+//
+// Created by raph on 29/01/25.
+//
+
+#include "MemoryTracker.h"
+
+#include <stdexcept>
+
+#include "../core/Format.h"
+
+const char* memoryTagName(MemoryTag tag) {
+    switch (tag) {
+        case MemoryTag::Stars:    return "stars";
+        case MemoryTag::Playback: return "playback";
+        case MemoryTag::Staging:  return "staging";
+        case MemoryTag::Uniforms: return "uniforms";
+        case MemoryTag::Palette:  return "palette";
+        case MemoryTag::Sorting:  return "sorting";
+        case MemoryTag::Targets:  return "targets";
+        case MemoryTag::Other:    return "other";
+        default:                  return "unknown";
+    }
+}
+
+MemoryTracker::MemoryTracker(VkPhysicalDevice physicalDevice, bool budgetExtension)
+    : physicalDevice(physicalDevice)
+    , budgetExtension(budgetExtension)
+    , logger("MemoryTracker") {
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    update(0);
+}
+
+void MemoryTracker::recordAllocation(uint32_t memoryType, VkDeviceSize size, MemoryTag tag) {
+    const auto tagIndex = static_cast<size_t>(tag);
+    typeBytes[memoryType].fetch_add(size, std::memory_order_relaxed);
+    tagBytes[tagIndex].fetch_add(size, std::memory_order_relaxed);
+    tagAllocations[tagIndex].fetch_add(1, std::memory_order_relaxed);
+
+    const VkDeviceSize total = trackedBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    VkDeviceSize peak = peakTracked.load(std::memory_order_relaxed);
+    while (peak < total && !peakTracked.compare_exchange_weak(peak, total, std::memory_order_relaxed)) {
+    }
+}
+
+void MemoryTracker::recordFree(uint32_t memoryType, VkDeviceSize size, MemoryTag tag) {
+    const auto tagIndex = static_cast<size_t>(tag);
+    typeBytes[memoryType].fetch_sub(size, std::memory_order_relaxed);
+    tagBytes[tagIndex].fetch_sub(size, std::memory_order_relaxed);
+    tagAllocations[tagIndex].fetch_sub(1, std::memory_order_relaxed);
+    trackedBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+uint32_t MemoryTracker::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) &&
+            (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("Failed to find suitable memory type");
+}
+
+const MemorySnapshot& MemoryTracker::update(uint64_t frame) {
+    snapshot.frame = frame;
+    snapshot.driverBudget = budgetExtension;
+    snapshot.peakTracked = peakTracked.load(std::memory_order_relaxed);
+    for (size_t tag = 0; tag < MemorySnapshot::TAG_COUNT; tag++) {
+        snapshot.tagBytes[tag] = tagBytes[tag].load(std::memory_order_relaxed);
+        snapshot.tagAllocations[tag] = tagAllocations[tag].load(std::memory_order_relaxed);
+    }
+
+    snapshot.heaps.assign(memoryProperties.memoryHeapCount, {});
+    for (uint32_t heap = 0; heap < memoryProperties.memoryHeapCount; heap++) {
+        snapshot.heaps[heap].size = memoryProperties.memoryHeaps[heap].size;
+        snapshot.heaps[heap].deviceLocal = memoryProperties.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+    }
+    for (uint32_t type = 0; type < memoryProperties.memoryTypeCount; type++) {
+        snapshot.typeBytes[type] = typeBytes[type].load(std::memory_order_relaxed);
+        snapshot.heaps[memoryProperties.memoryTypes[type].heapIndex].tracked += snapshot.typeBytes[type];
+    }
+
+    if (budgetExtension) {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+        budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        VkPhysicalDeviceMemoryProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties.pNext = &budget;
+        vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &properties);
+
+        for (uint32_t heap = 0; heap < memoryProperties.memoryHeapCount; heap++) {
+            snapshot.heaps[heap].budget = budget.heapBudget[heap];
+            snapshot.heaps[heap].usage = budget.heapUsage[heap];
+        }
+    } else {
+        for (auto& heap : snapshot.heaps) {
+            heap.budget = heap.size;
+            heap.usage = heap.tracked;
+        }
+    }
+
+    for (size_t heap = 0; heap < snapshot.heaps.size(); heap++) {
+        const MemoryHeapUsage& usage = snapshot.heaps[heap];
+        if (usage.budget == 0) {
+            continue;
+        }
+        const double fraction = static_cast<double>(usage.usage) / static_cast<double>(usage.budget);
+        if (!warned[heap] && fraction > WARNING_FRACTION) {
+            warned[heap] = true;
+            logger.warning("Memory heap " + std::to_string(heap) + " is at " + std::to_string(static_cast<int>(100.0 * fraction)) +
+                           "% of its budget\n" + describe());
+        } else if (warned[heap] && fraction < REARM_FRACTION) {
+            warned[heap] = false;
+        }
+    }
+    return snapshot;
+}
+
+std::string MemoryTracker::describe() const {
+    std::string text = snapshot.driverBudget ? "Device memory (driver budget):" : "Device memory (no budget extension, heap sizes):";
+    for (size_t heap = 0; heap < snapshot.heaps.size(); heap++) {
+        const MemoryHeapUsage& usage = snapshot.heaps[heap];
+        text += "\n  heap " + std::to_string(heap) + (usage.deviceLocal ? " (device local): " : " (host): ") +
+                mebibytes(usage.usage) + " used of " + mebibytes(usage.budget) + ", " + mebibytes(usage.tracked) +
+                " from our buffers";
+    }
+    for (uint32_t type = 0; type < memoryProperties.memoryTypeCount; type++) {
+        if (snapshot.typeBytes[type] > 0) {
+            text += "\n  type " + std::to_string(type) + " (heap " + std::to_string(memoryProperties.memoryTypes[type].heapIndex) +
+                    "): " + mebibytes(snapshot.typeBytes[type]);
+        }
+    }
+    for (size_t tag = 0; tag < MemorySnapshot::TAG_COUNT; tag++) {
+        if (snapshot.tagAllocations[tag] > 0) {
+            text += "\n  " + std::string(memoryTagName(static_cast<MemoryTag>(tag))) + ": " + mebibytes(snapshot.tagBytes[tag]) +
+                    " in " + std::to_string(snapshot.tagAllocations[tag]) + " allocations";
+        }
+    }
+    text += "\n  peak of our buffers: " + mebibytes(snapshot.peakTracked);
+    return text;
+}
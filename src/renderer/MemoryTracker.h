@@ -0,0 +1,112 @@
+//
+// Created by raph on 29/01/25.
+//
+
+#ifndef MEMORYTRACKER_H
+#define MEMORYTRACKER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "../core/Logger.h"
+
+/**
+ * What a device allocation is used for, given by its owner
+ */
+enum class MemoryTag : uint8_t {
+    Stars,          // star vertices and positions
+    Playback,       // snapshot keyframes and appearance
+    Staging,        // host visible upload buffers
+    Uniforms,
+    Palette,
+    Sorting,        // depth sort keys and indices
+    Targets,        // offscreen render targets and their mip chains
+    Other,
+    Count,
+};
+
+const char* memoryTagName(MemoryTag tag);
+
+/**
+ * Usage of one memory heap
+ */
+struct MemoryHeapUsage {
+    VkDeviceSize size = 0;
+    VkDeviceSize budget = 0;        // what the driver lets the process use, the heap size without VK_EXT_memory_budget
+    VkDeviceSize usage = 0;         // process usage reported by the driver, the tracked bytes without the extension
+    VkDeviceSize tracked = 0;       // bytes allocated through Buffer, Image and RenderGraph
+    bool deviceLocal = false;
+};
+
+struct MemorySnapshot {
+    static constexpr size_t TAG_COUNT = static_cast<size_t>(MemoryTag::Count);
+
+    uint64_t frame = 0;
+    bool driverBudget = false;      // budget and usage come from VK_EXT_memory_budget
+    std::vector<MemoryHeapUsage> heaps;
+    std::array<VkDeviceSize, VK_MAX_MEMORY_TYPES> typeBytes{};
+    std::array<VkDeviceSize, TAG_COUNT> tagBytes{};
+    std::array<uint32_t, TAG_COUNT> tagAllocations{};
+    VkDeviceSize peakTracked = 0;
+};
+
+/**
+ * Counts device memory by heap, memory type and tag. Allocations are recorded with atomics from any thread;
+ * update() runs once per frame to query the driver budget and take a snapshot, and warns when a heap gets close
+ * to its budget. describe() gives the breakdown to log when an allocation fails or the device is lost.
+ */
+class MemoryTracker {
+public:
+    static constexpr double WARNING_FRACTION = 0.9;     // of the budget
+    static constexpr double REARM_FRACTION = 0.8;       // warn again once usage went back below this
+
+    /**
+     * @param budgetExtension VK_EXT_memory_budget is enabled on the device
+     */
+    MemoryTracker(VkPhysicalDevice physicalDevice, bool budgetExtension);
+
+    MemoryTracker(const MemoryTracker&) = delete;
+    MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+    void recordAllocation(uint32_t memoryType, VkDeviceSize size, MemoryTag tag);
+    void recordFree(uint32_t memoryType, VkDeviceSize size, MemoryTag tag);
+
+    /**
+     * Query the budget and take the snapshot of this frame
+     */
+    const MemorySnapshot& update(uint64_t frame);
+    const MemorySnapshot& getSnapshot() const { return snapshot; }
+
+    /**
+     * Per heap and per tag breakdown of the latest snapshot, one line each
+     */
+    std::string describe() const;
+
+    const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const { return memoryProperties; }
+
+    /**
+     * First memory type allowed by the filter that has all the properties, throws when there is none
+     */
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+private:
+    VkPhysicalDevice physicalDevice;
+    bool budgetExtension;
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+
+    std::array<std::atomic<VkDeviceSize>, VK_MAX_MEMORY_TYPES> typeBytes{};
+    std::array<std::atomic<VkDeviceSize>, MemorySnapshot::TAG_COUNT> tagBytes{};
+    std::array<std::atomic<uint32_t>, MemorySnapshot::TAG_COUNT> tagAllocations{};
+    std::atomic<VkDeviceSize> trackedBytes{0};
+    std::atomic<VkDeviceSize> peakTracked{0};
+
+    MemorySnapshot snapshot;
+    std::array<bool, VK_MAX_MEMORY_HEAPS> warned{};
+    Logger logger;
+};
+
+#endif //MEMORYTRACKER_H
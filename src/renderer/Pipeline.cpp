@@ -17,8 +17,8 @@ Pipeline::Pipeline(VulkanContext& context,
 }
 
 Pipeline::~Pipeline() {
+    // The layout belongs to whoever passed it in the config (the PipelineManager)
     vkDestroyPipeline(context.getDevice(), graphicsPipeline, nullptr);
-    vkDestroyPipelineLayout(context.getDevice(), pipelineLayout, nullptr);
 }
 
 void Pipeline::bind(VkCommandBuffer commandBuffer) {
@@ -31,8 +31,8 @@ void Pipeline::createGraphicsPipeline(
 
     assert(configInfo.pipelineLayout != VK_NULL_HANDLE &&
            "Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
-    assert(configInfo.renderPass != VK_NULL_HANDLE &&
-           "Cannot create graphics pipeline: no renderPass provided in configInfo");
+    assert((configInfo.renderPass != VK_NULL_HANDLE || !configInfo.colorAttachmentFormats.empty()) &&
+           "Cannot create graphics pipeline: no renderPass or attachment formats provided in configInfo");
 
     // Create shader modules
     // Shader vertShader(context, vertFilepath, Shader::Type::Vertex);
@@ -55,6 +55,16 @@ void Pipeline::createGraphicsPipeline(
     // shaderStages[1].pNext = nullptr;
     // shaderStages[1].pSpecializationInfo = nullptr;
 
+    pipelineLayout = configInfo.pipelineLayout;
+    vertexInput = configInfo.vertexInput;
+
+    // The config may be a copy, so its internal pointers can refer to another instance. Point them back to this one
+    VkPipelineColorBlendStateCreateInfo colorBlendInfo = configInfo.colorBlendInfo;
+    colorBlendInfo.pAttachments = &configInfo.colorBlendAttachment;
+    VkPipelineDynamicStateCreateInfo dynamicStateInfo = configInfo.dynamicStateInfo;
+    dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStates.size());
+    dynamicStateInfo.pDynamicStates = configInfo.dynamicStates.data();
+
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(configInfo.bindingDescriptions.size());
@@ -71,14 +81,26 @@ void Pipeline::createGraphicsPipeline(
     pipelineInfo.pViewportState = &configInfo.viewportInfo;
     pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
     pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
-    pipelineInfo.pColorBlendState = &configInfo.colorBlendInfo;
+    pipelineInfo.pColorBlendState = &colorBlendInfo;
     pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
-    pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
+    pipelineInfo.pDynamicState = &dynamicStateInfo;
 
     pipelineInfo.layout = configInfo.pipelineLayout;
     pipelineInfo.renderPass = configInfo.renderPass;
     pipelineInfo.subpass = configInfo.subpass;
 
+    // Without a render pass, the attachments are only known by their formats
+    VkPipelineRenderingCreateInfoKHR renderingInfo{};
+    if (configInfo.renderPass == VK_NULL_HANDLE) {
+        renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+        renderingInfo.colorAttachmentCount = static_cast<uint32_t>(configInfo.colorAttachmentFormats.size());
+        renderingInfo.pColorAttachmentFormats = configInfo.colorAttachmentFormats.data();
+        renderingInfo.depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+        renderingInfo.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+        pipelineInfo.pNext = &renderingInfo;
+        pipelineInfo.subpass = 0;
+    }
+
     pipelineInfo.basePipelineIndex = -1;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
@@ -14,6 +14,15 @@
 class VulkanContext;
 class Shader;
 
+/**
+ * Where the vertex shader gets its vertices: fixed function attributes from the binding and attribute descriptions,
+ * or pulled from storage buffers (see VertexStreams) with gl_VertexIndex, with no vertex input state at all
+ */
+enum class VertexInput {
+    Attributes,
+    Pulling
+};
+
 struct PipelineConfigInfo {
     VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo{};
     VkPipelineRasterizationStateCreateInfo rasterizationInfo{};
@@ -29,10 +38,15 @@ struct PipelineConfigInfo {
     VkPipelineLayout pipelineLayout = nullptr;
     VkRenderPass renderPass = nullptr;
     uint32_t subpass = 0;
+    std::vector<VkFormat> colorAttachmentFormats{};     // without a render pass, drawn with dynamic rendering into these
 
+    VertexInput vertexInput = VertexInput::Attributes;
     std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
     std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts{};
+    std::vector<VkPushConstantRange> pushConstantRanges{};
+
     void enableDynamicStates(std::initializer_list<VkDynamicState> states) {
         dynamicStates = states;
         dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
@@ -56,6 +70,7 @@ public:
     static PipelineConfigInfo defaultPipelineConfigInfo();
 
     VkPipelineLayout getLayout() const { return pipelineLayout; }
+    bool pullsVertices() const { return vertexInput == VertexInput::Pulling; }
 
 private:
     void createGraphicsPipeline(
@@ -66,6 +81,7 @@ private:
     VulkanContext& context;
     VkPipeline graphicsPipeline{};
     VkPipelineLayout pipelineLayout{};
+    VertexInput vertexInput = VertexInput::Attributes;
     Logger logger;
 };
 
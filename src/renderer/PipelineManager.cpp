@@ -48,7 +48,13 @@ void PipelineManager::createPipeline(
     // Update config with the created layout
     auto finalConfig = configInfo;
     finalConfig.pipelineLayout = pipelineLayouts[name];
-    finalConfig.renderPass = context.getSwapChain().getRenderPass();
+    if (finalConfig.renderPass == VK_NULL_HANDLE && finalConfig.colorAttachmentFormats.empty()) {
+        throw std::runtime_error("Pipeline '" + name + "' has neither a render pass nor attachment formats");
+    }
+    if (finalConfig.vertexInput == VertexInput::Pulling &&
+        (!finalConfig.bindingDescriptions.empty() || !finalConfig.attributeDescriptions.empty())) {
+        throw std::runtime_error("Pipeline '" + name + "' pulls its vertices but has vertex attributes");
+    }
 
     // Create shader stage create infos
     VkPipelineShaderStageCreateInfo shaderStages[2]{};
@@ -136,12 +142,12 @@ void PipelineManager::createPipelineLayout(const std::string& name, const Pipeli
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 
     // Add descriptor set layouts if they exist
-    // pipelineLayoutInfo.setLayoutCount = configInfo.descriptorSetLayouts.size();
-    // pipelineLayoutInfo.pSetLayouts = configInfo.descriptorSetLayouts.data();
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(configInfo.descriptorSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = configInfo.descriptorSetLayouts.data();
 
     // Add push constant ranges if they exist
-    // pipelineLayoutInfo.pushConstantRangeCount = configInfo.pushConstantRanges.size();
-    // pipelineLayoutInfo.pPushConstantRanges = configInfo.pushConstantRanges.data();
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(configInfo.pushConstantRanges.size());
+    pipelineLayoutInfo.pPushConstantRanges = configInfo.pushConstantRanges.data();
 
     if (vkCreatePipelineLayout(context.getDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayouts[name]) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create pipeline layout for '" + name + "'");
@@ -177,6 +183,7 @@ PipelineConfigInfo PipelineManager::getUIConfig() {
     return config;
 }
 
+// Blending without depth writes is only right for draws sorted back to front (see StarDepthSort)
 PipelineConfigInfo PipelineManager::getTransparentConfig() {
     auto config = getDefaultConfig();
 
@@ -193,9 +200,27 @@ PipelineConfigInfo PipelineManager::getTransparentConfig() {
     return config;
 }
 
+// Additive: the result does not depend on the draw order, so particles need no sorting
 PipelineConfigInfo PipelineManager::getParticleConfig() {
     auto config = getTransparentConfig();
 
+    config.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    config.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    config.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    config.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    config.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    return config;
+}
+
+PipelineConfigInfo PipelineManager::getFullscreenConfig() {
+    auto config = getDefaultConfig();
+
+    // a single triangle without vertex buffers, covering every pixel once
+    config.rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
+    config.depthStencilInfo.depthTestEnable = VK_FALSE;
+    config.depthStencilInfo.depthWriteEnable = VK_FALSE;
+
     return config;
 }
 
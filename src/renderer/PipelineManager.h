@@ -24,7 +24,9 @@ public:
     explicit PipelineManager(VulkanContext& context);
     ~PipelineManager();
 
-    // Create a pipeline with a unique name
+    // Create a pipeline with a unique name, for the render pass of the config or, with dynamic rendering, its attachment formats.
+    // RenderGraph::configurePipeline() fills either for one of its passes. Vertices come from the attributes of the config,
+    // or are pulled by the vertex shader when its vertexInput is VertexInput::Pulling
     void createPipeline(
         const std::string& name,
         const std::string& vertShaderPath,
@@ -47,6 +49,7 @@ public:
     static PipelineConfigInfo getUIConfig();
     static PipelineConfigInfo getTransparentConfig();
     static PipelineConfigInfo getParticleConfig();
+    static PipelineConfigInfo getFullscreenConfig();
 
     void recreatePipelines();
 
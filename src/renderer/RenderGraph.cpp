@@ -0,0 +1,577 @@
+//
+// Created by raph on 03/02/25.
+//
+
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "ImageSyncState.h"
+#include "MemoryTracker.h"
+#include "VulkanContext.h"
+#include "../core/Format.h"
+
+RenderGraph::Pass::Pass(std::string name, bool graphics, RecordFunction record)
+    : name(std::move(name))
+    , graphics(graphics)
+    , record(std::move(record)) {}
+
+RenderGraph::Pass& RenderGraph::Pass::use(const Use& use) {
+    for (const auto& existing : uses) {
+        if (existing.image == use.image) {
+            throw std::runtime_error("Pass '" + name + "' uses the same image twice");
+        }
+    }
+    uses.push_back(use);
+    return *this;
+}
+
+RenderGraph::Pass& RenderGraph::Pass::colorAttachment(Resource image, bool clear) {
+    if (!graphics) {
+        throw std::runtime_error("Compute pass '" + name + "' cannot have color attachments");
+    }
+    // Blending reads the attachment
+    return use({image, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true, clear});
+}
+
+RenderGraph::Pass& RenderGraph::Pass::sampled(Resource image, VkPipelineStageFlags stages) {
+    return use({image, stages, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_IMAGE_USAGE_SAMPLED_BIT, false, false});
+}
+
+RenderGraph::Pass& RenderGraph::Pass::storage(Resource image, VkPipelineStageFlags stages, bool write) {
+    // Passes also sample the levels they wrote, as the bloom does
+    return use({image, stages, VK_ACCESS_SHADER_READ_BIT | (write ? VK_ACCESS_SHADER_WRITE_BIT : 0),
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, write, false});
+}
+
+RenderGraph::Pass& RenderGraph::Pass::enableIf(std::function<bool()> predicate) {
+    enabled = std::move(predicate);
+    return *this;
+}
+
+RenderGraph::RenderGraph(VulkanContext& context, bool dynamicRendering)
+    : context(context)
+    , dynamicRendering(dynamicRendering && context.hasDynamicRendering())
+    , logger("RenderGraph") {
+    logger.info(this->dynamicRendering ? "Drawing with dynamic rendering" : "Drawing with render passes");
+}
+
+RenderGraph::~RenderGraph() {
+    releaseTransients();
+    for (const auto& [key, renderPass] : renderPasses) {
+        vkDestroyRenderPass(context.getDevice(), renderPass, nullptr);
+    }
+}
+
+RenderGraph::Resource RenderGraph::createImage(const std::string& name, const ImageInfo& info) {
+    ImageResource resource;
+    resource.name = name;
+    resource.format = info.format;
+    resource.imported = false;
+    resource.info = info;
+    images.push_back(std::move(resource));
+    return static_cast<Resource>(images.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::importImage(const std::string& name, const ImportInfo& info) {
+    ImageResource resource;
+    resource.name = name;
+    resource.format = info.format;
+    resource.imported = true;
+    resource.import = info;
+    images.push_back(std::move(resource));
+    return static_cast<Resource>(images.size() - 1);
+}
+
+void RenderGraph::setImage(Resource resource, VkImage image, VkImageView view, VkExtent2D imageExtent) {
+    ImageResource& target = images.at(resource);
+    if (!target.imported) {
+        throw std::runtime_error("Image '" + target.name + "' belongs to the render graph");
+    }
+    target.image = image;
+    target.view = view;
+    target.extent = imageExtent;
+}
+
+RenderGraph::Pass& RenderGraph::addGraphicsPass(const std::string& name, RecordFunction record) {
+    passes.push_back(std::unique_ptr<Pass>(new Pass(name, true, std::move(record))));
+    return *passes.back();
+}
+
+RenderGraph::Pass& RenderGraph::addComputePass(const std::string& name, RecordFunction record) {
+    passes.push_back(std::unique_ptr<Pass>(new Pass(name, false, std::move(record))));
+    return *passes.back();
+}
+
+void RenderGraph::compile(VkExtent2D graphExtent) {
+    releaseTransients();
+    extent = graphExtent;
+
+    cull();
+    allocateTransients();
+    planBarriers();
+    createRenderPasses();
+    compiled = true;
+}
+
+void RenderGraph::cull() {
+    // Walk back from the imported images: a pass is needed when something needed comes out of it
+    std::vector<bool> needed(images.size());
+    for (size_t i = 0; i < images.size(); i++) {
+        needed[i] = images[i].imported;
+    }
+    for (auto pass = passes.rbegin(); pass != passes.rend(); ++pass) {
+        Pass& current = **pass;
+        current.culled = std::none_of(current.uses.begin(), current.uses.end(), [&](const Pass::Use& use) {
+            return use.write && needed[use.image];
+        });
+        if (!current.culled) {
+            for (const auto& use : current.uses) {
+                needed[use.image] = true;
+            }
+        } else {
+            LOG_DEBUG(logger, "Culled pass '{}', nothing reads what it writes", current.name);
+        }
+    }
+}
+
+void RenderGraph::allocateTransients() {
+    for (auto& image : images) {
+        image.usage = 0;
+        image.firstPass = -1;
+        image.lastPass = -1;
+    }
+    for (size_t p = 0; p < passes.size(); p++) {
+        if (passes[p]->culled) {
+            continue;
+        }
+        for (const auto& use : passes[p]->uses) {
+            ImageResource& image = images[use.image];
+            image.usage |= use.usage;
+            if (image.firstPass < 0) {
+                image.firstPass = static_cast<int>(p);
+            }
+            image.lastPass = static_cast<int>(p);
+        }
+    }
+
+    // Largest images first, each into the first block whose images are all done before it starts or start after
+    // it is done
+    std::vector<Resource> order;
+    std::vector<VkMemoryRequirements> requirements(images.size());
+    for (Resource i = 0; i < images.size(); i++) {
+        ImageResource& image = images[i];
+        if (image.imported || image.firstPass < 0) {
+            continue;
+        }
+        const VkExtent2D imageExtent{
+            std::max(static_cast<uint32_t>(static_cast<float>(extent.width) * image.info.scale), 1u),
+            std::max(static_cast<uint32_t>(static_cast<float>(extent.height) * image.info.scale), 1u)
+        };
+        image.transient = Image::createUnbound(context, imageExtent, image.format, image.usage, image.info.mipLevels);
+        image.image = image.transient->getImage();
+        image.extent = imageExtent;
+        requirements[i] = image.transient->getMemoryRequirements();
+        order.push_back(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](Resource a, Resource b) {
+        return requirements[a].size > requirements[b].size;
+    });
+
+    VkDeviceSize unaliasedSize = 0;
+    for (Resource i : order) {
+        ImageResource& image = images[i];
+        unaliasedSize += requirements[i].size;
+
+        auto overlaps = [&](Resource other) {
+            return image.firstPass <= images[other].lastPass && images[other].firstPass <= image.lastPass;
+        };
+        size_t block = 0;
+        for (; block < blocks.size(); block++) {
+            if ((blocks[block].memoryTypeBits & requirements[i].memoryTypeBits) != 0 &&
+                std::none_of(blocks[block].images.begin(), blocks[block].images.end(), overlaps)) {
+                break;
+            }
+        }
+        if (block == blocks.size()) {
+            blocks.emplace_back();
+        }
+        blocks[block].images.push_back(i);
+        blocks[block].size = std::max(blocks[block].size, requirements[i].size);
+        blocks[block].memoryTypeBits &= requirements[i].memoryTypeBits;
+        image.block = static_cast<uint32_t>(block);
+    }
+
+    MemoryTracker& tracker = context.getMemoryTracker();
+    VkDeviceSize aliasedSize = 0;
+    for (auto& block : blocks) {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = block.size;
+        allocInfo.memoryTypeIndex = tracker.findMemoryType(block.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        VkResult result = vkAllocateMemory(context.getDevice(), &allocInfo, nullptr, &block.memory);
+        if (result != VK_SUCCESS) {
+            tracker.update(tracker.getSnapshot().frame);
+            throw std::runtime_error("Failed to allocate " + mebibytes(block.size) + " for transient images" +
+                                     (result == VK_ERROR_OUT_OF_DEVICE_MEMORY ? " (out of device memory)\n" : "\n") +
+                                     tracker.describe());
+        }
+        block.memoryType = allocInfo.memoryTypeIndex;
+        tracker.recordAllocation(block.memoryType, block.size, MemoryTag::Targets);
+        aliasedSize += block.size;
+
+        for (Resource i : block.images) {
+            images[i].transient->bindMemory(block.memory, 0);
+            images[i].view = images[i].transient->getView();
+        }
+    }
+
+    LOG_DEBUG(logger, "{} transient images in {} allocations: {} instead of {}", order.size(), blocks.size(),
+              mebibytes(aliasedSize), mebibytes(unaliasedSize));
+}
+
+void RenderGraph::planBarriers() {
+    // What the uses of each block wait on in the next frame, and when its images change owner
+    for (size_t p = 0; p < passes.size(); p++) {
+        if (passes[p]->culled) {
+            continue;
+        }
+        for (const auto& use : passes[p]->uses) {
+            const ImageResource& image = images[use.image];
+            if (!image.imported) {
+                blocks[image.block].stages |= use.stages;
+                blocks[image.block].writeAccess |= use.access & ImageSyncState::WRITE_ACCESS;
+            }
+        }
+    }
+
+    std::vector<ImageSyncState> states(images.size());
+    for (size_t i = 0; i < images.size(); i++) {
+        const ImageResource& image = images[i];
+        if (image.imported) {
+            states[i] = ImageSyncState(image.import.initialLayout, image.import.initialStages, 0);
+        } else if (image.firstPass >= 0) {
+            // Content is discarded, but the earlier users of the memory must be done with it
+            const MemoryBlock& block = blocks[image.block];
+            states[i] = ImageSyncState(VK_IMAGE_LAYOUT_UNDEFINED, block.stages, block.writeAccess);
+        }
+    }
+
+    for (auto& pass : passes) {
+        pass->barriers.clear();
+        pass->srcStages = 0;
+        pass->dstStages = 0;
+        pass->restoreBarriers.clear();
+        pass->restoreStages = 0;
+        if (pass->culled) {
+            continue;
+        }
+
+        for (const auto& use : pass->uses) {
+            if (pass->enabled && use.write && !images[use.image].imported) {
+                // Skipped, it would leave whatever the aliased images wrote
+                throw std::runtime_error("Pass '" + pass->name + "' may be skipped but writes the transient image '" +
+                                         images[use.image].name + "'");
+            }
+
+            ImageSyncState& state = states[use.image];
+            const ImageSyncState before = state;
+            const ImageSyncState::Access access{use.stages, use.access, use.layout, use.write};
+            ImageSyncState::Barrier barrier;
+            if (state.use(access, barrier)) {
+                pass->barriers.push_back({use.image, barrier.oldLayout, barrier.newLayout, barrier.srcAccess, barrier.dstAccess});
+                pass->srcStages |= barrier.srcStages;
+                pass->dstStages |= barrier.dstStages;
+            }
+            if (pass->enabled && state.restore(before, access, barrier)) {
+                pass->restoreBarriers.push_back({use.image, barrier.oldLayout, barrier.newLayout, barrier.srcAccess,
+                                                 barrier.dstAccess});
+                pass->restoreStages |= barrier.srcStages;
+            }
+        }
+    }
+
+    // A transition to the final layout, from no stage of the graph
+    finalBarriers.clear();
+    finalSrcStages = 0;
+    for (Resource i = 0; i < images.size(); i++) {
+        const ImageResource& image = images[i];
+        ImageSyncState::Barrier barrier;
+        if (image.imported && image.import.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED &&
+            states[i].use({0, 0, image.import.finalLayout, false}, barrier)) {
+            finalBarriers.push_back({i, barrier.oldLayout, barrier.newLayout, barrier.srcAccess, barrier.dstAccess});
+            finalSrcStages |= barrier.srcStages;
+        }
+    }
+}
+
+void RenderGraph::createRenderPasses() {
+    for (auto& pass : passes) {
+        const bool needed = !dynamicRendering && pass->graphics && !pass->culled;
+        pass->renderPass = needed ? findRenderPass(*pass) : VK_NULL_HANDLE;
+    }
+}
+
+VkRenderPass RenderGraph::findRenderPass(const Pass& pass) {
+    std::vector<std::pair<VkFormat, VkAttachmentLoadOp>> key;
+    for (const auto& use : pass.uses) {
+        if (use.usage == VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) {
+            key.emplace_back(images[use.image].format, use.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD);
+        }
+    }
+    if (key.empty()) {
+        throw std::runtime_error("Graphics pass '" + pass.name + "' has no color attachment");
+    }
+    if (auto found = renderPasses.find(key); found != renderPasses.end()) {
+        return found->second;
+    }
+
+    // Layouts are changed by the barriers of the graph, the attachments stay in the attachment layout
+    std::vector<VkAttachmentDescription> attachments;
+    std::vector<VkAttachmentReference> references;
+    for (const auto& [format, loadOp] : key) {
+        VkAttachmentDescription attachment{};
+        attachment.format = format;
+        attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        attachment.loadOp = loadOp;
+        attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        references.push_back({static_cast<uint32_t>(attachments.size()), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+        attachments.push_back(attachment);
+    }
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = static_cast<uint32_t>(references.size());
+    subpass.pColorAttachments = references.data();
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    VkRenderPass renderPass;
+    if (vkCreateRenderPass(context.getDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create render pass for '" + pass.name + "'");
+    }
+    renderPasses[key] = renderPass;
+    return renderPass;
+}
+
+VkFramebuffer RenderGraph::findFramebuffer(Pass& pass) {
+    std::vector<VkImageView> views;
+    VkExtent2D framebufferExtent{};
+    for (const auto& use : pass.uses) {
+        if (use.usage == VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) {
+            const ImageResource& image = images[use.image];
+            if (image.view == VK_NULL_HANDLE) {
+                throw std::runtime_error("Image '" + image.name + "' was not given to the render graph");
+            }
+            views.push_back(image.view);
+            framebufferExtent = image.extent;
+        }
+    }
+    if (auto found = pass.framebuffers.find(views); found != pass.framebuffers.end()) {
+        return found->second;
+    }
+
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = pass.renderPass;
+    framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+    framebufferInfo.pAttachments = views.data();
+    framebufferInfo.width = framebufferExtent.width;
+    framebufferInfo.height = framebufferExtent.height;
+    framebufferInfo.layers = 1;
+
+    VkFramebuffer framebuffer;
+    if (vkCreateFramebuffer(context.getDevice(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create framebuffer for '" + pass.name + "'");
+    }
+    pass.framebuffers[views] = framebuffer;
+    return framebuffer;
+}
+
+void RenderGraph::execute(VkCommandBuffer commandBuffer) {
+    if (!compiled) {
+        throw std::runtime_error("The render graph must be compiled before it is executed");
+    }
+
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    auto recordBarriers = [&](const std::vector<Pass::Barrier>& barriers, VkPipelineStageFlags srcStages,
+                              VkPipelineStageFlags dstStages) {
+        if (barriers.empty()) {
+            return;
+        }
+        imageBarriers.clear();
+        for (const auto& barrier : barriers) {
+            const ImageResource& image = images[barrier.image];
+            VkImageMemoryBarrier imageBarrier{};
+            imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            imageBarrier.srcAccessMask = barrier.srcAccess;
+            imageBarrier.dstAccessMask = barrier.dstAccess;
+            imageBarrier.oldLayout = barrier.oldLayout;
+            imageBarrier.newLayout = barrier.newLayout;
+            imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.image = image.image;
+            imageBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, 1};
+            imageBarriers.push_back(imageBarrier);
+        }
+        vkCmdPipelineBarrier(commandBuffer,
+                             srcStages != 0 ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             dstStages != 0 ? dstStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+    };
+
+    for (auto& pass : passes) {
+        if (pass->culled || (pass->enabled && !pass->enabled())) {
+            continue;
+        }
+        recordBarriers(pass->barriers, pass->srcStages, pass->dstStages);
+
+        if (pass->graphics) {
+            beginRendering(commandBuffer, *pass);
+            pass->record(commandBuffer);
+            endRendering(commandBuffer);
+        } else {
+            pass->record(commandBuffer);
+        }
+
+        recordBarriers(pass->restoreBarriers, pass->restoreStages, pass->restoreStages);
+    }
+
+    recordBarriers(finalBarriers, finalSrcStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+}
+
+void RenderGraph::beginRendering(VkCommandBuffer commandBuffer, Pass& pass) {
+    if (dynamicRendering) {
+        std::vector<VkRenderingAttachmentInfoKHR> attachments;
+        VkExtent2D renderExtent{};
+        for (const auto& use : pass.uses) {
+            if (use.usage == VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) {
+                const ImageResource& image = images[use.image];
+                if (image.view == VK_NULL_HANDLE) {
+                    throw std::runtime_error("Image '" + image.name + "' was not given to the render graph");
+                }
+                VkRenderingAttachmentInfoKHR attachment{};
+                attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+                attachment.imageView = image.view;
+                attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                attachment.loadOp = use.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+                attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+                attachment.clearValue = VkClearValue{{{0.0f, 0.0f, 0.0f, 0.0f}}};
+                attachments.push_back(attachment);
+                renderExtent = image.extent;
+            }
+        }
+
+        VkRenderingInfoKHR renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+        renderingInfo.renderArea.offset = {0, 0};
+        renderingInfo.renderArea.extent = renderExtent;
+        renderingInfo.layerCount = 1;
+        renderingInfo.colorAttachmentCount = static_cast<uint32_t>(attachments.size());
+        renderingInfo.pColorAttachments = attachments.data();
+        context.beginRendering(commandBuffer, renderingInfo);
+        return;
+    }
+
+    VkFramebuffer framebuffer = findFramebuffer(pass);
+    std::vector<VkClearValue> clearValues;
+    VkExtent2D renderExtent{};
+    for (const auto& use : pass.uses) {
+        if (use.usage == VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) {
+            clearValues.push_back(VkClearValue{{{0.0f, 0.0f, 0.0f, 0.0f}}});
+            renderExtent = images[use.image].extent;
+        }
+    }
+
+    VkRenderPassBeginInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = pass.renderPass;
+    renderPassInfo.framebuffer = framebuffer;
+    renderPassInfo.renderArea.offset = {0, 0};
+    renderPassInfo.renderArea.extent = renderExtent;
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassInfo.pClearValues = clearValues.data();
+
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void RenderGraph::endRendering(VkCommandBuffer commandBuffer) const {
+    if (dynamicRendering) {
+        context.endRendering(commandBuffer);
+    } else {
+        vkCmdEndRenderPass(commandBuffer);
+    }
+}
+
+const Image& RenderGraph::getImage(Resource resource) const {
+    const ImageResource& image = images.at(resource);
+    if (!image.transient) {
+        throw std::runtime_error("Image '" + image.name + "' is not a transient of the compiled render graph");
+    }
+    return *image.transient;
+}
+
+const RenderGraph::Pass& RenderGraph::findGraphicsPass(const std::string& name) const {
+    for (const auto& pass : passes) {
+        if (pass->name == name && pass->graphics) {
+            return *pass;
+        }
+    }
+    throw std::runtime_error("No graphics pass '" + name + "' in the render graph");
+}
+
+void RenderGraph::configurePipeline(const std::string& name, PipelineConfigInfo& config) {
+    const Pass& pass = findGraphicsPass(name);
+    config.renderPass = VK_NULL_HANDLE;
+    config.colorAttachmentFormats.clear();
+
+    if (dynamicRendering) {
+        for (const auto& use : pass.uses) {
+            if (use.usage == VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) {
+                config.colorAttachmentFormats.push_back(images[use.image].format);
+            }
+        }
+        return;
+    }
+
+    // Culled passes have no render pass, but a pipeline may still be created for them
+    config.renderPass = pass.renderPass != VK_NULL_HANDLE ? pass.renderPass : findRenderPass(pass);
+}
+
+void RenderGraph::releaseTransients() {
+    for (auto& pass : passes) {
+        for (const auto& [views, framebuffer] : pass->framebuffers) {
+            vkDestroyFramebuffer(context.getDevice(), framebuffer, nullptr);
+        }
+        pass->framebuffers.clear();
+    }
+    for (auto& image : images) {
+        if (!image.imported) {
+            image.transient.reset();
+            image.image = VK_NULL_HANDLE;
+            image.view = VK_NULL_HANDLE;
+        }
+    }
+    for (const auto& block : blocks) {
+        if (block.memory != VK_NULL_HANDLE) {
+            vkFreeMemory(context.getDevice(), block.memory, nullptr);
+            context.getMemoryTracker().recordFree(block.memoryType, block.size, MemoryTag::Targets);
+        }
+    }
+    blocks.clear();
+    compiled = false;
+}
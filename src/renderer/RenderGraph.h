@@ -0,0 +1,228 @@
+//
+// Created by raph on 03/02/25.
+//
+
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "Image.h"
+#include "Pipeline.h"
+#include "../core/Logger.h"
+
+class VulkanContext;
+
+/**
+ * The passes of a frame and the images they read and write, declared once and recorded every frame.
+ *
+ * compile() drops the passes whose results are never used, places the barriers and layout transitions between the
+ * passes that remain, and allocates the transient images: images whose lifetimes (first to last pass using them) do
+ * not overlap share the same memory.
+ * Graphics passes are drawn with dynamic rendering when the device has it, and need neither render passes nor
+ * framebuffers. Otherwise a render pass is created for every graphics pass, and framebuffers when it is executed.
+ * Passes only record their own commands; barriers inside a pass (between the mips of an image, for example) are
+ * still theirs to record.
+ *
+ * Transient images are sized relative to the extent of the graph, imported images (the swap chain image) are
+ * given with setImage() before every execute(). A pass is kept when it writes an imported image, or an image read
+ * by a kept pass.
+ */
+class RenderGraph {
+public:
+    using Resource = uint32_t;
+    using RecordFunction = std::function<void(VkCommandBuffer)>;
+
+    struct ImageInfo {
+        VkFormat format;
+        float scale = 1.0f;             // of the graph extent, never below one texel
+        uint32_t mipLevels = 1;
+    };
+
+    /**
+     * How an imported image is found before the first pass, and left after the last one
+     */
+    struct ImportInfo {
+        VkFormat format;
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags initialStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;     // of the last use before the graph
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;                      // undefined keeps the last one
+    };
+
+    class Pass {
+    public:
+        /**
+         * Render into the image, cleared to 0 first or loaded. Graphics passes only
+         */
+        Pass& colorAttachment(Resource image, bool clear = true);
+
+        /**
+         * Sample the image, in the shader read only layout
+         */
+        Pass& sampled(Resource image, VkPipelineStageFlags stages);
+
+        /**
+         * Load and store the image, in the general layout
+         */
+        Pass& storage(Resource image, VkPipelineStageFlags stages, bool write = true);
+
+        /**
+         * Only record the pass, and its barriers, in the executes where enabled() returns true. The images it
+         * changed the layout of are transitioned back after it, so the later passes find them the same either way.
+         * Its writes must be kept across frames: imported images only
+         */
+        Pass& enableIf(std::function<bool()> enabled);
+
+        const std::string& getName() const { return name; }
+
+    private:
+        friend class RenderGraph;
+
+        struct Use {
+            Resource image;
+            VkPipelineStageFlags stages;
+            VkAccessFlags access;
+            VkImageLayout layout;
+            VkImageUsageFlags usage;
+            bool write;
+            bool clear;
+        };
+
+        struct Barrier {
+            Resource image;
+            VkImageLayout oldLayout;
+            VkImageLayout newLayout;
+            VkAccessFlags srcAccess;
+            VkAccessFlags dstAccess;
+        };
+
+        Pass(std::string name, bool graphics, RecordFunction record);
+        Pass& use(const Use& use);
+
+        std::string name;
+        bool graphics;
+        RecordFunction record;
+        std::vector<Use> uses;
+        std::function<bool()> enabled;
+
+        // Filled by compile()
+        bool culled = false;
+        std::vector<Barrier> barriers;
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+        std::vector<Barrier> restoreBarriers;       // after a pass that may be skipped
+        VkPipelineStageFlags restoreStages = 0;     // of its uses, both source and destination
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        std::map<std::vector<VkImageView>, VkFramebuffer> framebuffers;    // by attachment views
+    };
+
+    /**
+     * @param dynamicRendering draw with dynamic rendering when the device has it, render passes otherwise
+     */
+    explicit RenderGraph(VulkanContext& context, bool dynamicRendering = true);
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    Resource createImage(const std::string& name, const ImageInfo& info);
+    Resource importImage(const std::string& name, const ImportInfo& info);
+
+    /**
+     * Image of an imported resource for the next execute()
+     */
+    void setImage(Resource resource, VkImage image, VkImageView view, VkExtent2D extent);
+
+    /**
+     * Passes run in the order they were added
+     */
+    Pass& addGraphicsPass(const std::string& name, RecordFunction record);
+    Pass& addComputePass(const std::string& name, RecordFunction record);
+
+    /**
+     * Plan the frame for this extent, and (re)create the transient images. The device must be idle when the graph
+     * was already compiled, render passes are kept so the pipelines created with them stay valid
+     */
+    void compile(VkExtent2D extent);
+
+    /**
+     * Record every kept pass with its barriers, outside of any render pass
+     */
+    void execute(VkCommandBuffer commandBuffer);
+
+    /**
+     * Transient image of a compiled graph
+     */
+    const Image& getImage(Resource resource) const;
+
+    /**
+     * Set what a pipeline drawn in a graphics pass is created for: the formats of its attachments with dynamic
+     * rendering, which can be done before compile(), or its render pass, kept across compiles
+     */
+    void configurePipeline(const std::string& pass, PipelineConfigInfo& config);
+
+    VkExtent2D getExtent() const { return extent; }
+    bool usesDynamicRendering() const { return dynamicRendering; }
+
+private:
+    struct ImageResource {
+        std::string name;
+        VkFormat format;
+        bool imported;
+        ImageInfo info;
+        ImportInfo import;
+
+        // Filled by compile(), and by setImage() for imported ones
+        std::unique_ptr<Image> transient;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkExtent2D extent{};
+        VkImageUsageFlags usage = 0;
+        int firstPass = -1;
+        int lastPass = -1;
+        uint32_t block = 0;
+    };
+
+    // Memory shared by transient images with disjoint lifetimes
+    struct MemoryBlock {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        uint32_t memoryTypeBits = ~0u;
+        uint32_t memoryType = 0;
+        std::vector<Resource> images;
+        VkPipelineStageFlags stages = 0;        // of every use of its images, what the next frame waits on
+        VkAccessFlags writeAccess = 0;
+    };
+
+    void cull();
+    void allocateTransients();
+    void planBarriers();
+    void createRenderPasses();
+    VkRenderPass findRenderPass(const Pass& pass);
+    VkFramebuffer findFramebuffer(Pass& pass);
+    void beginRendering(VkCommandBuffer commandBuffer, Pass& pass);
+    void endRendering(VkCommandBuffer commandBuffer) const;
+    const Pass& findGraphicsPass(const std::string& name) const;
+    void releaseTransients();
+
+    VulkanContext& context;
+    bool dynamicRendering;
+    VkExtent2D extent{};
+    std::vector<ImageResource> images;
+    std::vector<std::unique_ptr<Pass>> passes;
+    std::vector<MemoryBlock> blocks;
+    std::vector<Pass::Barrier> finalBarriers;   // imported images to their final layout
+    VkPipelineStageFlags finalSrcStages = 0;
+    std::map<std::vector<std::pair<VkFormat, VkAttachmentLoadOp>>, VkRenderPass> renderPasses;
+    bool compiled = false;
+    Logger logger;
+};
+
+#endif //RENDERGRAPH_H
@@ -0,0 +1,264 @@
+//
+// Created by raph on 19/01/25.
+//
+
+#include "SnapshotPlayback.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Pipeline.h"
+#include "StarVertex.h"
+#include "VertexStreams.h"
+#include "VulkanContext.h"
+
+SnapshotPlayback::SnapshotPlayback(VulkanContext& context, const PlaybackConfig& config, uint32_t framesInFlight,
+                                   VertexStreams* streams)
+    : context(context)
+    , config(config)
+    , framesInFlight(framesInFlight)
+    , streams(streams)
+    , series(config.directory)
+    , streamSize(sizeof(StarVertex::Position) * series.getStarCount())
+    , logger("SnapshotPlayback") {
+
+    for (auto& keyframe : keyframes) {
+        keyframe.buffer = std::make_unique<Buffer>(
+            context,
+            streamSize,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            MemoryTag::Playback
+        );
+    }
+
+    for (auto& staging : stagings) {
+        staging.buffer = std::make_unique<Buffer>(
+            context,
+            streamSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            MemoryTag::Staging
+        );
+        staging.buffer->map();
+    }
+
+    // Stars keep their appearance for the whole series, and it fits in the staging buffer of a keyframe
+    SnapshotFile first(series.getPath(0));
+    if (!first.hasSection(Snapshot::Section::Appearance)) {
+        throw std::runtime_error("Snapshot " + series.getPath(0) + " has no appearance section to play");
+    }
+    const VkDeviceSize appearanceSize = sizeof(StarPacking::Appearance) * series.getStarCount();
+    // Rounded to whole words, the pulling shader reads two stars at a time
+    appearanceBuffer = std::make_unique<Buffer>(
+        context,
+        (appearanceSize + 3) & ~VkDeviceSize(3),
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        MemoryTag::Playback
+    );
+    first.copySection(Snapshot::Section::Appearance, sizeof(StarPacking::Appearance), stagings[0].buffer->getMapped());
+    stagings[0].buffer->copyTo(*appearanceBuffer, appearanceSize);
+
+    // The first interval is loaded before the first frame, the rest is streamed
+    for (size_t frame = 0; frame < 2; frame++) {
+        SnapshotFile snapshot(series.getPath(frame));
+        snapshot.copySection(Snapshot::Section::Positions, sizeof(StarVertex::Position),
+                             stagings[0].buffer->getMapped());
+        stagings[0].buffer->copyTo(*keyframes[frame].buffer, streamSize);
+        keyframes[frame].frame = frame;
+    }
+
+    if (streams) {
+        for (size_t i = 0; i < keyframes.size(); i++) {
+            streams->setBuffer(StarVertex::PULLED_KEYFRAMES_BINDING + static_cast<uint32_t>(i), *keyframes[i].buffer);
+        }
+        streams->setBuffer(StarVertex::PULLED_APPEARANCE_BINDING, *appearanceBuffer);
+    }
+
+    time = series.getStartTime();
+    logger.info("Playing " + std::to_string(series.getFrameCount()) + " snapshots with " +
+                std::to_string((streamSize * (KEYFRAME_COUNT + STAGING_COUNT)) >> 20) + " MiB of keyframe buffers");
+}
+
+SnapshotPlayback::~SnapshotPlayback() = default;
+
+void SnapshotPlayback::advance(double realSeconds) {
+    double next = time + realSeconds * config.timeScale;
+    if (next >= series.getEndTime()) {
+        next = config.loop ? series.getStartTime() : series.getEndTime();
+    }
+
+    wantedInterval = series.findInterval(next);
+    if (findKeyframe(wantedInterval) != NO_FRAME && findKeyframe(wantedInterval + 1) != NO_FRAME) {
+        time = next;
+        displayedInterval = wantedInterval;
+    } else {
+        // Hold the last loaded keyframe until the disk catches up
+        time = series.getTime(displayedInterval + 1);
+    }
+}
+
+void SnapshotPlayback::recordUploads(VkCommandBuffer commandBuffer, uint64_t frameNumber) {
+    for (auto& staging : stagings) {
+        if (staging.state == StagingState::InFlight && frameNumber >= staging.releaseFrame) {
+            staging.state = StagingState::Free;
+        }
+        if (staging.state == StagingState::Loading && streamer.isComplete(staging.ticket)) {
+            staging.state = StagingState::Ready;
+        }
+        if (staging.state == StagingState::Ready && !isWanted(staging.frame)) {
+            staging.state = StagingState::Free;
+        }
+    }
+
+    // Loaded keyframes replace one the current and next frames do not need
+    for (auto& staging : stagings) {
+        if (staging.state != StagingState::Ready) {
+            continue;
+        }
+
+        auto target = std::find_if(keyframes.begin(), keyframes.end(), [this](const Keyframe& keyframe) {
+            return keyframe.frame == NO_FRAME || (!isProtected(keyframe.frame) && !isWanted(keyframe.frame));
+        });
+        if (target == keyframes.end()) {
+            continue;
+        }
+
+        recordCopy(commandBuffer, staging, *target);
+        target->frame = staging.frame;
+        staging.state = StagingState::InFlight;
+        staging.releaseFrame = frameNumber + framesInFlight;
+    }
+
+    // Start reading the wanted keyframes that are neither on the GPU nor on their way, most urgent first
+    const size_t frameCount = series.getFrameCount();
+    for (size_t offset = 0; offset < 3; offset++) {
+        size_t frame = wantedInterval + offset;
+        if (frame >= frameCount) {
+            if (!config.loop) {
+                break;
+            }
+            frame -= frameCount;
+        }
+        if (findKeyframe(frame) != NO_FRAME || isPending(frame)) {
+            continue;
+        }
+
+        auto free = std::find_if(stagings.begin(), stagings.end(), [](const Staging& staging) {
+            return staging.state == StagingState::Free;
+        });
+        if (free == stagings.end()) {
+            break;
+        }
+
+        free->frame = frame;
+        free->ticket = streamer.request(series.getPath(frame), Snapshot::Section::Positions,
+                                        sizeof(StarVertex::Position), free->buffer->getMapped(), streamSize);
+        free->state = StagingState::Loading;
+    }
+}
+
+void SnapshotPlayback::draw(VkCommandBuffer commandBuffer, Pipeline& pipeline) const {
+    size_t current = findKeyframe(displayedInterval);
+    size_t next = findKeyframe(displayedInterval + 1);
+    if (next == NO_FRAME) {
+        return;
+    }
+
+    StarPlaybackPushConstants constants{};
+    if (isHolding() || current == NO_FRAME) {
+        // The current keyframe may already be overwritten, only the next one is drawn
+        current = next;
+        constants.blend = 0.0f;
+    } else {
+        double start = series.getTime(displayedInterval);
+        double end = series.getTime(displayedInterval + 1);
+        constants.blend = end > start ? static_cast<float>(std::clamp((time - start) / (end - start), 0.0, 1.0)) : 1.0f;
+    }
+
+    constants.currentKeyframe = static_cast<uint32_t>(current);
+    constants.nextKeyframe = static_cast<uint32_t>(next);
+    vkCmdPushConstants(commandBuffer, pipeline.getLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+
+    if (pipeline.pullsVertices()) {
+        if (!streams) {
+            throw std::runtime_error("Playback was created without vertex streams to pull from");
+        }
+        streams->bind(commandBuffer, pipeline.getLayout());
+    } else {
+        keyframes[current].buffer->bindAsVertex(commandBuffer, StarVertex::KEYFRAME_BINDING);
+        appearanceBuffer->bindAsVertex(commandBuffer, StarVertex::APPEARANCE_BINDING);
+        keyframes[next].buffer->bindAsVertex(commandBuffer, StarVertex::NEXT_KEYFRAME_BINDING);
+    }
+    vkCmdDraw(commandBuffer, static_cast<uint32_t>(series.getStarCount()), 1, 0, 0);
+}
+
+size_t SnapshotPlayback::findKeyframe(size_t frame) const {
+    for (size_t i = 0; i < keyframes.size(); i++) {
+        if (keyframes[i].frame == frame) {
+            return i;
+        }
+    }
+    return NO_FRAME;
+}
+
+bool SnapshotPlayback::isHolding() const {
+    return wantedInterval != displayedInterval;
+}
+
+bool SnapshotPlayback::isWanted(size_t frame) const {
+    const size_t frameCount = series.getFrameCount();
+    for (size_t offset = 0; offset < 3; offset++) {
+        size_t wanted = wantedInterval + offset;
+        if (wanted >= frameCount) {
+            if (!config.loop) {
+                break;
+            }
+            wanted -= frameCount;
+        }
+        if (wanted == frame) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SnapshotPlayback::isProtected(size_t frame) const {
+    return frame == displayedInterval + 1 || (!isHolding() && frame == displayedInterval);
+}
+
+bool SnapshotPlayback::isPending(size_t frame) const {
+    return std::any_of(stagings.begin(), stagings.end(), [frame](const Staging& staging) {
+        return staging.frame == frame &&
+               (staging.state == StagingState::Loading || staging.state == StagingState::Ready);
+    });
+}
+
+void SnapshotPlayback::recordCopy(VkCommandBuffer commandBuffer, const Staging& staging, Keyframe& keyframe) const {
+    // Frames submitted before this one may still draw the keyframe being replaced, as attributes or pulled
+    const VkPipelineStageFlags readStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+    const VkAccessFlags readAccess = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = readAccess;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = keyframe.buffer->getBuffer();
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, readStages, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = 0;
+    copyRegion.dstOffset = 0;
+    copyRegion.size = streamSize;
+    vkCmdCopyBuffer(commandBuffer, staging.buffer->getBuffer(), keyframe.buffer->getBuffer(), 1, &copyRegion);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = readAccess;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, readStages,
+                         0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
@@ -0,0 +1,123 @@
+//
+// Created by raph on 19/01/25.
+//
+
+#ifndef SNAPSHOTPLAYBACK_H
+#define SNAPSHOTPLAYBACK_H
+
+#include <array>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include "Buffer.h"
+#include "../core/Logger.h"
+#include "../galaxy/SnapshotSeries.h"
+#include "../galaxy/SnapshotStreamer.h"
+
+class VulkanContext;
+class Pipeline;
+class VertexStreams;
+
+struct PlaybackConfig {
+    std::string directory;          // snapshots to play, playback is disabled when empty
+    float timeScale = 20.0f;        // simulated Myr per real second
+    bool loop = true;
+};
+
+/**
+ * Plays a recorded series of snapshots. Three keyframes of positions live on the GPU: the two being blended in
+ * the vertex shader and the next one, which is read from disk by a background thread into one of two staging
+ * buffers, then copied at the start of a frame. Playback holds on the last loaded keyframe rather than skipping
+ * when the disk falls behind. The appearance of the stars is read once from the first snapshot.
+ * Pipelines that pull their vertices read the keyframes in place through VertexStreams, with
+ * StarVertex::PULLED_PLAYBACK_STREAMS buffers.
+ */
+class SnapshotPlayback {
+public:
+    /**
+     * @param streams when given, the keyframe and appearance buffers are set into it, for pipelines that pull their
+     * vertices
+     */
+    SnapshotPlayback(VulkanContext& context, const PlaybackConfig& config, uint32_t framesInFlight,
+                     VertexStreams* streams = nullptr);
+    ~SnapshotPlayback();
+
+    SnapshotPlayback(const SnapshotPlayback&) = delete;
+    SnapshotPlayback& operator=(const SnapshotPlayback&) = delete;
+
+    /**
+     * Move the playback clock, without going past the keyframes that are already on the GPU
+     */
+    void advance(double realSeconds);
+
+    /**
+     * Collect finished reads, record their copies to the keyframe buffers and queue the next reads.
+     * Must be recorded outside of a render pass
+     * @param frameNumber number of frames rendered so far, used to know when a staging buffer is free again
+     */
+    void recordUploads(VkCommandBuffer commandBuffer, uint64_t frameNumber);
+
+    /**
+     * Draw the stars between the two current keyframes, the star palette and frame uniforms must already be bound
+     */
+    void draw(VkCommandBuffer commandBuffer, Pipeline& pipeline) const;
+
+    const SnapshotSeries& getSeries() const { return series; }
+    double getTime() const { return time; }
+
+private:
+    static constexpr size_t NO_FRAME = std::numeric_limits<size_t>::max();
+    static constexpr size_t KEYFRAME_COUNT = 3;
+    static constexpr size_t STAGING_COUNT = 2;
+
+    enum class StagingState {
+        Free,
+        Loading,        // the streamer is writing to it
+        Ready,          // loaded, waiting for a keyframe buffer
+        InFlight,       // copy recorded, the GPU may still be reading it
+    };
+
+    struct Keyframe {
+        std::unique_ptr<Buffer> buffer;
+        size_t frame = NO_FRAME;
+    };
+
+    struct Staging {
+        std::unique_ptr<Buffer> buffer;
+        StagingState state = StagingState::Free;
+        size_t frame = NO_FRAME;
+        uint64_t ticket = 0;
+        uint64_t releaseFrame = 0;
+    };
+
+    size_t findKeyframe(size_t frame) const;
+    bool isHolding() const;
+    bool isWanted(size_t frame) const;
+    bool isProtected(size_t frame) const;
+    bool isPending(size_t frame) const;
+    void recordCopy(VkCommandBuffer commandBuffer, const Staging& staging, Keyframe& keyframe) const;
+
+    VulkanContext& context;
+    PlaybackConfig config;
+    uint32_t framesInFlight;
+    VertexStreams* streams;
+    SnapshotSeries series;
+    VkDeviceSize streamSize;
+
+    std::unique_ptr<Buffer> appearanceBuffer;
+    std::array<Keyframe, KEYFRAME_COUNT> keyframes;
+    std::array<Staging, STAGING_COUNT> stagings;
+
+    // After the stagings it reads into: destroyed first, it joins its worker before they are unmapped and freed
+    SnapshotStreamer streamer;
+
+    double time = 0.0;
+    size_t displayedInterval = 0;   // keyframes displayedInterval and displayedInterval + 1 are drawn
+    size_t wantedInterval = 0;      // interval the clock wants to reach, differs while waiting for the disk
+    Logger logger;
+};
+
+#endif //SNAPSHOTPLAYBACK_H
@@ -0,0 +1,68 @@
+//
+// Created by raph on 01/02/25.
+//
+
+#include "StarDepthSort.h"
+
+#include <cstring>
+
+#include "VulkanContext.h"
+
+StarDepthSort::StarDepthSort(VulkanContext& context, const StarScene& scene, uint32_t framesInFlight,
+                             const DepthSortConfig& config)
+    : context(context)
+    , config(config)
+    , framesInFlight(framesInFlight)
+    , sorter(scene)
+    , sliceSize(sizeof(uint32_t) * scene.getPointCount())
+    , sliceVersions(framesInFlight, 0)
+    , logger("StarDepthSort") {
+
+    indexBuffer = std::make_unique<Buffer>(
+        context,
+        sliceSize * framesInFlight,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        MemoryTag::Sorting
+    );
+    indexBuffer->map();
+
+    if (config.gpuMinimumCount > 0 && scene.getPointCount() >= config.gpuMinimumCount) {
+        gpuSort = std::make_unique<GpuRadixSort>(context, scene.getPointCount(), framesInFlight);
+    }
+}
+
+StarDepthSort::~StarDepthSort() = default;
+
+void StarDepthSort::update(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector<StarDrawRange>& ranges,
+                           const glm::vec3& eye) {
+    if (sorter.needsSort(ranges, eye)) {
+        uint32_t count = 0;
+        for (const auto& range : ranges) {
+            count += range.pointCount;
+        }
+
+        sortedOnGpu = gpuSort && count >= config.gpuMinimumCount;
+        if (sortedOnGpu) {
+            const uint32_t rankBits = sorter.writeKeys(ranges, eye, gpuSort->getKeys(frameIndex), gpuSort->getValues(frameIndex));
+            gpuSort->record(commandBuffer, frameIndex, count, 32 + rankBits);
+            return;
+        }
+        sorter.sort(ranges, eye);
+    }
+
+    // The order may come from a frame that wrote another slice
+    if (!sortedOnGpu && sliceVersions[frameIndex] != sorter.getVersion()) {
+        std::memcpy(static_cast<char*>(indexBuffer->getMapped()) + sliceSize * frameIndex, sorter.getIndices().data(),
+                    sizeof(uint32_t) * sorter.getIndexCount());
+        sliceVersions[frameIndex] = sorter.getVersion();
+    }
+}
+
+void StarDepthSort::bindIndices(VkCommandBuffer commandBuffer, uint32_t frameIndex) const {
+    if (sortedOnGpu) {
+        vkCmdBindIndexBuffer(commandBuffer, gpuSort->getSortedValues(), 0, VK_INDEX_TYPE_UINT32);
+    } else {
+        indexBuffer->bindAsIndex(commandBuffer, sliceSize * frameIndex, VK_INDEX_TYPE_UINT32);
+    }
+}
@@ -0,0 +1,63 @@
+//
+// Created by raph on 01/02/25.
+//
+
+#ifndef STARDEPTHSORT_H
+#define STARDEPTHSORT_H
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include "Buffer.h"
+#include "GpuRadixSort.h"
+#include "../core/Logger.h"
+#include "../scene/DepthSorter.h"
+
+class VulkanContext;
+
+/**
+ * Back to front index buffer of the selected stars, for the blended star pipelines (see DepthSorter).
+ *
+ * Small selections are sorted on the CPU and copied into a host visible slice per frame in flight, large ones are
+ * keyed on the CPU and sorted by GpuRadixSort. When neither the eye, the selection nor the positions changed, the
+ * last order is drawn again without sorting.
+ */
+class StarDepthSort {
+public:
+    StarDepthSort(VulkanContext& context, const StarScene& scene, uint32_t framesInFlight, const DepthSortConfig& config);
+    ~StarDepthSort();
+
+    StarDepthSort(const StarDepthSort&) = delete;
+    StarDepthSort& operator=(const StarDepthSort&) = delete;
+
+    /**
+     * Bring the indices of the frame up to date with the selection. Must be recorded outside of a render pass,
+     * after the fence of the frame was waited on
+     */
+    void update(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector<StarDrawRange>& ranges,
+                const glm::vec3& eye);
+
+    void bindIndices(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+
+    /**
+     * Chunks back to front, in the bound indices
+     */
+    const std::vector<StarIndexRange>& getRanges() const { return sorter.getRanges(); }
+
+private:
+    VulkanContext& context;
+    DepthSortConfig config;
+    uint32_t framesInFlight;
+    DepthSorter sorter;
+
+    std::unique_ptr<Buffer> indexBuffer;        // host visible, one slice per frame in flight
+    VkDeviceSize sliceSize;
+    std::vector<uint64_t> sliceVersions;        // order held by each slice
+    std::unique_ptr<GpuRadixSort> gpuSort;      // only when the scene can select enough points
+    bool sortedOnGpu = false;
+    Logger logger;
+};
+
+#endif //STARDEPTHSORT_H
@@ -0,0 +1,211 @@
+//
+// Created by raph on 12/01/25.
+//
+
+#include "StarField.h"
+
+#include <stdexcept>
+
+#include "Pipeline.h"
+#include "VertexStreams.h"
+#include "VulkanContext.h"
+#include "../core/ThreadPool.h"
+#include "../scene/DepthSorter.h"
+#include "../scene/FrustumCuller.h"
+#include "../scene/StarScene.h"
+
+StarField::StarField(VulkanContext& context, StarScene& scene, uint32_t framesInFlight, bool dynamicPositions,
+                     VertexStreams* streams)
+    : context(context)
+    , scene(scene)
+    , starCount(scene.getStarCount())
+    , framesInFlight(framesInFlight)
+    , dynamicPositions(dynamicPositions)
+    , streams(streams)
+    , previousPoints(dynamicPositions ? scene.getPointCount() : 0)
+    , streamSize(sizeof(StarVertex::Packed) * (size_t(scene.getPointCount()) + previousPoints))
+    , chunkFrames(scene.getChunkCount())
+    , logger("StarField") {
+
+    if (starCount == 0) {
+        throw std::runtime_error("Cannot create a star field without stars");
+    }
+
+    starBuffer = std::make_unique<Buffer>(
+        context,
+        streamSize,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        MemoryTag::Stars
+    );
+    if (streams) {
+        streams->setBuffer(StarVertex::PACKED_BINDING, *starBuffer);
+    }
+
+    if (dynamicPositions) {
+        positionStaging = std::make_unique<Buffer>(
+            context,
+            streamSize * framesInFlight,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            MemoryTag::Staging
+        );
+        positionStaging->map();
+    }
+
+    LOG_DEBUG(logger, "Created star field of {} stars and {} aggregates in {} chunks ({} MiB)",
+              starCount, scene.getPointCount() - starCount, chunkFrames.size(), streamSize >> 20);
+}
+
+StarField::~StarField() = default;
+
+StarUploadStreams StarField::beginUpload() {
+    positionScratch.resize(starCount);
+    appearance.resize(starCount);
+    return {positionScratch.data(), appearance.data()};
+}
+
+void StarField::endUpload() {
+    if (positionScratch.empty()) {
+        return;
+    }
+
+    const auto* positions = reinterpret_cast<const float*>(positionScratch.data());
+    scene.build(positions, appearance.data());
+    scene.update(positions);
+
+    Buffer uploadBuffer(
+        context,
+        streamSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        MemoryTag::Staging
+    );
+    packStars(static_cast<StarVertex::Packed*>(uploadBuffer.map()), nullptr);
+    uploadBuffer.unmap();
+    uploadBuffer.copyTo(*starBuffer, streamSize);
+
+    positionScratch = {};
+}
+
+void StarField::updatePositions(VkCommandBuffer commandBuffer, uint32_t frameIndex, const float* previous,
+                                const float* current) {
+    if (!positionStaging) {
+        throw std::runtime_error("Star field was created with static positions");
+    }
+
+    // The aggregates of the previous state are kept for packing, its bounds so that culling holds for the stars at
+    // any blend between the two states
+    scene.update(previous);
+    const float* points = scene.getPointPositions();
+    previousPointPositions.assign(points, points + 3 * size_t(scene.getPointCount()));
+    const ChunkBounds previousBounds = scene.getChunkBounds();
+
+    scene.update(current);
+    scene.widenBounds(previousBounds);
+
+    const VkDeviceSize sliceOffset = streamSize * frameIndex;
+    packStars(reinterpret_cast<StarVertex::Packed*>(static_cast<char*>(positionStaging->getMapped()) + sliceOffset),
+              previousPointPositions.data());
+
+    // Frames submitted before this one may still read the stream, as attributes, pulled by the vertex shader or
+    // splatted by StarSplat
+    const VkPipelineStageFlags readStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    const VkAccessFlags readAccess = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = readAccess;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = starBuffer->getBuffer();
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, readStages, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = sliceOffset;
+    copyRegion.dstOffset = 0;
+    copyRegion.size = streamSize;
+    vkCmdCopyBuffer(commandBuffer, positionStaging->getBuffer(), starBuffer->getBuffer(), 1, &copyRegion);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = readAccess;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, readStages,
+                         0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void StarField::draw(VkCommandBuffer commandBuffer, Pipeline& pipeline, const std::vector<StarDrawRange>& ranges,
+                     uint32_t verticesPerStar) const {
+    bindStream(commandBuffer, pipeline);
+
+    // Sprite vertices find their star from gl_VertexIndex, the records are not repeated
+    for (const auto& range : ranges) {
+        pushChunkFrame(commandBuffer, pipeline, range.chunk, range.merge);
+        vkCmdDraw(commandBuffer, range.pointCount * verticesPerStar, 1, range.firstPoint * verticesPerStar, 0);
+    }
+}
+
+void StarField::draw(VkCommandBuffer commandBuffer, Pipeline& pipeline, const std::vector<StarIndexRange>& ranges) const {
+    bindStream(commandBuffer, pipeline);
+
+    // Indices are points of the whole stream, no vertex offset. Pulled, gl_VertexIndex is the index itself
+    for (const auto& range : ranges) {
+        pushChunkFrame(commandBuffer, pipeline, range.chunk, range.merge);
+        vkCmdDrawIndexed(commandBuffer, range.indexCount, 1, range.firstIndex, 0, 0);
+    }
+}
+
+void StarField::bindStream(VkCommandBuffer commandBuffer, const Pipeline& pipeline) const {
+    if (!pipeline.pullsVertices()) {
+        starBuffer->bindAsVertex(commandBuffer, StarVertex::PACKED_BINDING);
+        starBuffer->bindAsVertex(commandBuffer, StarVertex::PREVIOUS_PACKED_BINDING,
+                                 sizeof(StarVertex::Packed) * previousPoints);
+        return;
+    }
+    if (!streams) {
+        throw std::runtime_error("Star field was created without vertex streams to pull from");
+    }
+    streams->bind(commandBuffer, pipeline.getLayout());
+}
+
+void StarField::pushChunkFrame(VkCommandBuffer commandBuffer, Pipeline& pipeline, uint32_t chunk,
+                               const StarMerge& merge) const {
+    const auto& frame = chunkFrames[chunk];
+    StarPushConstants constants{};
+    constants.chunkCenter = glm::vec4(frame.center[0], frame.center[1], frame.center[2], 0.0f);
+    constants.chunkHalfExtent = glm::vec4(frame.halfExtent[0], frame.halfExtent[1], frame.halfExtent[2], 0.0f);
+    constants.merge = glm::uvec4(merge.lastPoint, merge.starsPerPoint, merge.lastPointStars, 0);
+    constants.blend = blend;
+    constants.previousPoints = previousPoints;
+    vkCmdPushConstants(commandBuffer, pipeline.getLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+}
+
+void StarField::packStars(StarVertex::Packed* destination, const float* previousPositions) {
+    const float* positions = scene.getPointPositions();
+    const float* previous = previousPositions ? previousPositions : positions;
+    const StarPacking::Appearance* pointAppearance = scene.getPointAppearance();
+
+    // Aggregates lie inside the bounds of their stars, the frame of the stars covers the whole chunk. Both states
+    // share it, the shaders blend the records before decoding them
+    ThreadPool::global().parallelFor(0, chunkFrames.size(), 1, [&](size_t firstChunk, size_t lastChunk) {
+        for (size_t chunk = firstChunk; chunk < lastChunk; chunk++) {
+            size_t first = scene.getChunkFirstPoint(chunk);
+            size_t stars = scene.getChunkStarCount(chunk);
+            size_t points = scene.getChunkPointCount(chunk);
+            chunkFrames[chunk] = StarPacking::computeFrame(positions + 3 * first, stars);
+            if (previousPositions) {
+                chunkFrames[chunk] = StarPacking::mergeFrames(chunkFrames[chunk],
+                                                              StarPacking::computeFrame(previous + 3 * first, stars));
+            }
+            StarPacking::packChunk(chunkFrames[chunk], positions + 3 * first, pointAppearance + first, points,
+                                   destination + first);
+            if (previousPoints > 0) {
+                StarPacking::packChunk(chunkFrames[chunk], previous + 3 * first, pointAppearance + first, points,
+                                       destination + previousPoints + first);
+            }
+        }
+    });
+}
@@ -0,0 +1,141 @@
+//
+// Created by raph on 12/01/25.
+//
+
+#ifndef STARFIELD_H
+#define STARFIELD_H
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include "Buffer.h"
+#include "StarVertex.h"
+#include "../core/Logger.h"
+
+class VulkanContext;
+class Pipeline;
+class StarScene;
+class VertexStreams;
+struct StarDrawRange;
+struct StarMerge;
+struct StarIndexRange;
+
+/**
+ * Float positions and appearance of every star, filled by the caller before they are packed for the GPU
+ */
+struct StarUploadStreams {
+    StarVertex::Position* positions;
+    StarPacking::Appearance* appearance;
+};
+
+/**
+ * GPU side of the stars: one device local stream with every point of the scene (stars and their aggregates), packed
+ * chunk by chunk so each chunk carries its own quantization frame. When positions are dynamic, the stream is followed
+ * by the records of the previous simulation state, packed in the same frames: the shaders blend the two with the
+ * blend of the push constants, so positions are only packed again when a new state arrives. Each frame in flight
+ * owns a persistently mapped staging slice, so a frame can pack a new state while the previous one is still being
+ * rendered.
+ * The stream is read either as a vertex buffer or, by pipelines that pull their vertices, through VertexStreams.
+ */
+class StarField {
+public:
+    /**
+     * @param streams when given, the star stream is also set as its binding StarVertex::PACKED_BINDING, for
+     * pipelines that pull their vertices
+     */
+    StarField(VulkanContext& context, StarScene& scene, uint32_t framesInFlight, bool dynamicPositions,
+              VertexStreams* streams = nullptr);
+    ~StarField();
+
+    StarField(const StarField&) = delete;
+    StarField& operator=(const StarField&) = delete;
+
+    /**
+     * Allocate the upload streams. Write each star at its index, then call endUpload()
+     */
+    StarUploadStreams beginUpload();
+
+    /**
+     * Build the scene from the streams, pack it, copy it to the device local buffer and release the staging memory
+     */
+    void endUpload();
+
+    /**
+     * Update the scene to a new simulation state, pack both of its sets of positions into the staging slice of the
+     * frame and record the copy to the star stream. Only needed when the state changes, moving between the two is
+     * setBlend(). Must be recorded outside of a render pass
+     * @param previous interleaved xyz in star order
+     * @param current interleaved xyz in star order
+     */
+    void updatePositions(VkCommandBuffer commandBuffer, uint32_t frameIndex, const float* previous, const float* current);
+
+    /**
+     * Where the stars are drawn between the two sets of positions of the last updatePositions(), pushed with the
+     * chunk frames
+     * @param blend 0 draws previous, 1 draws current
+     */
+    void setBlend(float blend) { this->blend = blend; }
+
+    /**
+     * Draw the ranges selected by the scene, the star palette and frame uniforms must already be bound
+     * @param verticesPerStar StarVertex::SPRITE_VERTICES for pipelines expanding each star into a quad
+     */
+    void draw(VkCommandBuffer commandBuffer, Pipeline& pipeline, const std::vector<StarDrawRange>& ranges,
+              uint32_t verticesPerStar = 1) const;
+
+    /**
+     * Draw sorted ranges, their index buffer must already be bound (see StarDepthSort)
+     */
+    void draw(VkCommandBuffer commandBuffer, Pipeline& pipeline, const std::vector<StarIndexRange>& ranges) const;
+
+    const std::vector<StarPacking::Appearance>& getAppearance() const { return appearance; }
+    const Buffer& getStarBuffer() const { return *starBuffer; }
+    const StarPacking::ChunkFrame& getChunkFrame(uint32_t chunk) const { return chunkFrames[chunk]; }
+    uint32_t getStarCount() const { return starCount; }
+    float getBlend() const { return blend; }
+
+    /**
+     * Records between a point and its previous state in the star stream, 0 when positions are static
+     */
+    uint32_t getPreviousPoints() const { return previousPoints; }
+
+private:
+    /**
+     * Compute the frame of every chunk of the scene and pack its points into destination, followed by their previous
+     * positions when they are dynamic
+     * @param previousPositions of every point, in the order of the scene. Null packs the scene positions twice
+     */
+    void packStars(StarVertex::Packed* destination, const float* previousPositions);
+
+    void pushChunkFrame(VkCommandBuffer commandBuffer, Pipeline& pipeline, uint32_t chunk, const StarMerge& merge) const;
+
+    /**
+     * Bind the star stream the way the pipeline reads it
+     */
+    void bindStream(VkCommandBuffer commandBuffer, const Pipeline& pipeline) const;
+
+    VulkanContext& context;
+    StarScene& scene;
+    uint32_t starCount;
+    uint32_t framesInFlight;
+    bool dynamicPositions;
+    VertexStreams* streams;
+    uint32_t previousPoints;
+    VkDeviceSize streamSize;                    // current records, then as many previous ones when dynamic
+    float blend = 1.0f;
+
+    std::unique_ptr<Buffer> starBuffer;
+    std::unique_ptr<Buffer> positionStaging;
+
+    // Stars in their original order, until endUpload()
+    std::vector<StarVertex::Position> positionScratch;
+    // Points of the previous simulation state, in the order of the scene
+    std::vector<float> previousPointPositions;
+    std::vector<StarPacking::Appearance> appearance;
+    std::vector<StarPacking::ChunkFrame> chunkFrames;
+    Logger logger;
+};
+
+#endif //STARFIELD_H
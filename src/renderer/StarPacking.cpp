@@ -0,0 +1,143 @@
+//
+// Created by raph on 20/01/25.
+//
+
+#include "StarPacking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define STAR_PACKING_SSE2 1
+#endif
+
+namespace StarPacking {
+    namespace {
+        constexpr float SNORM_SCALE = 32767.0f;
+        constexpr float MIN_HALF_EXTENT = 1e-6f;
+
+        int16_t quantize(float value, float center, float inverseHalfExtent) {
+            float normalized = std::clamp((value - center) * inverseHalfExtent, -1.0f, 1.0f);
+            return static_cast<int16_t>(std::lround(normalized * SNORM_SCALE));
+        }
+
+#ifdef STAR_PACKING_SSE2
+        uint16_t appearanceWord(const Appearance& appearance) {
+            uint16_t word;
+            std::memcpy(&word, &appearance, sizeof(word));
+            return word;
+        }
+#endif
+    }
+
+    uint8_t encodeMagnitude(float luminosity) {
+        float magnitude = SUN_MAGNITUDE - 2.5f * std::log10(std::max(luminosity, 1e-12f));
+        float t = (magnitude - MIN_MAGNITUDE) / (MAX_MAGNITUDE - MIN_MAGNITUDE);
+        return static_cast<uint8_t>(std::lround(std::clamp(t, 0.0f, 1.0f) * 255.0f));
+    }
+
+    float decodeLuminosity(uint8_t magnitude) {
+        float absoluteMagnitude = MIN_MAGNITUDE + (MAX_MAGNITUDE - MIN_MAGNITUDE) * static_cast<float>(magnitude) / 255.0f;
+        return std::pow(10.0f, 0.4f * (SUN_MAGNITUDE - absoluteMagnitude));
+    }
+
+    float brightness(float luminosity) {
+        return std::max(std::pow(luminosity, BRIGHTNESS_EXPONENT), MIN_BRIGHTNESS);
+    }
+
+    float brightnessLuminosity(float brightness) {
+        return std::pow(brightness, 1.0f / BRIGHTNESS_EXPONENT);
+    }
+
+    ChunkFrame computeFrame(const float* positions, size_t count) {
+        std::array<float, 3> low{}, high{};
+        if (count > 0) {
+#ifdef STAR_PACKING_SSE2
+            // Each star is loaded as one vector, its fourth lane (the next x) is ignored
+            __m128 minimum = _mm_set1_ps(std::numeric_limits<float>::max());
+            __m128 maximum = _mm_set1_ps(std::numeric_limits<float>::lowest());
+            for (size_t i = 0; i + 1 < count; i++) {
+                __m128 v = _mm_loadu_ps(positions + 3 * i);
+                minimum = _mm_min_ps(minimum, v);
+                maximum = _mm_max_ps(maximum, v);
+            }
+            const float* last = positions + 3 * (count - 1);
+            __m128 v = _mm_setr_ps(last[0], last[1], last[2], 0.0f);
+            minimum = _mm_min_ps(minimum, v);
+            maximum = _mm_max_ps(maximum, v);
+
+            alignas(16) float lowLanes[4], highLanes[4];
+            _mm_store_ps(lowLanes, minimum);
+            _mm_store_ps(highLanes, maximum);
+            low = {lowLanes[0], lowLanes[1], lowLanes[2]};
+            high = {highLanes[0], highLanes[1], highLanes[2]};
+#else
+            low = {positions[0], positions[1], positions[2]};
+            high = low;
+            for (size_t i = 1; i < count; i++) {
+                for (int axis = 0; axis < 3; axis++) {
+                    low[axis] = std::min(low[axis], positions[3 * i + axis]);
+                    high[axis] = std::max(high[axis], positions[3 * i + axis]);
+                }
+            }
+#endif
+        }
+
+        ChunkFrame frame{};
+        for (int axis = 0; axis < 3; axis++) {
+            frame.center[axis] = 0.5f * (low[axis] + high[axis]);
+            frame.halfExtent[axis] = std::max(0.5f * (high[axis] - low[axis]), MIN_HALF_EXTENT);
+        }
+        return frame;
+    }
+
+    ChunkFrame mergeFrames(const ChunkFrame& a, const ChunkFrame& b) {
+        ChunkFrame frame{};
+        for (int axis = 0; axis < 3; axis++) {
+            float low = std::min(a.center[axis] - a.halfExtent[axis], b.center[axis] - b.halfExtent[axis]);
+            float high = std::max(a.center[axis] + a.halfExtent[axis], b.center[axis] + b.halfExtent[axis]);
+            frame.center[axis] = 0.5f * (low + high);
+            frame.halfExtent[axis] = 0.5f * (high - low);
+        }
+        return frame;
+    }
+
+    void packChunk(const ChunkFrame& frame, const float* positions, const Appearance* appearance, size_t count,
+                   PackedStar* destination) {
+        const std::array<float, 3> inverse = {
+            1.0f / frame.halfExtent[0], 1.0f / frame.halfExtent[1], 1.0f / frame.halfExtent[2],
+        };
+
+        size_t i = 0;
+#ifdef STAR_PACKING_SSE2
+        // Two stars per iteration: quantize both to int32, saturate to int16 and slot the appearance in the
+        // fourth lane of each. Stops one star early so the second load never reads past the array
+        const __m128 center = _mm_setr_ps(frame.center[0], frame.center[1], frame.center[2], 0.0f);
+        const __m128 scale = _mm_setr_ps(inverse[0] * SNORM_SCALE, inverse[1] * SNORM_SCALE,
+                                         inverse[2] * SNORM_SCALE, 0.0f);
+        const __m128 lowest = _mm_set1_ps(-SNORM_SCALE);
+        const __m128 highest = _mm_set1_ps(SNORM_SCALE);
+
+        for (; i + 2 < count; i += 2) {
+            __m128 first = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(positions + 3 * i), center), scale);
+            __m128 second = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(positions + 3 * i + 3), center), scale);
+            first = _mm_min_ps(_mm_max_ps(first, lowest), highest);
+            second = _mm_min_ps(_mm_max_ps(second, lowest), highest);
+
+            __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(first), _mm_cvtps_epi32(second));
+            packed = _mm_insert_epi16(packed, appearanceWord(appearance[i]), 3);
+            packed = _mm_insert_epi16(packed, appearanceWord(appearance[i + 1]), 7);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), packed);
+        }
+#endif
+        for (; i < count; i++) {
+            for (int axis = 0; axis < 3; axis++) {
+                destination[i].position[axis] = quantize(positions[3 * i + axis], frame.center[axis], inverse[axis]);
+            }
+            destination[i].appearance = appearance[i];
+        }
+    }
+}
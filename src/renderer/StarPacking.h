@@ -0,0 +1,90 @@
+//
+// Created by raph on 20/01/25.
+//
+
+#ifndef STARPACKING_H
+#define STARPACKING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Compact GPU format of the stars, 8 bytes instead of 24 for float positions and colors.
+ *
+ * Stars are split in chunks of CHUNK_SIZE consecutive stars. Positions are 16 bit snorm relative to the bounding
+ * box of their chunk, whose center and half extent are given to the vertex shader per draw. Colors are an index
+ * into the blackbody palette, and brightness an 8 bit absolute magnitude.
+ */
+namespace StarPacking {
+    constexpr uint32_t CHUNK_SIZE = 16384;
+
+    // Absolute bolometric magnitude range of the 8 bit encoding, about 0.14 magnitude per step
+    constexpr float MIN_MAGNITUDE = -15.0f;
+    constexpr float MAX_MAGNITUDE = 20.0f;
+    constexpr float SUN_MAGNITUDE = 4.74f;
+
+    // Compression of the luminosity into the drawn brightness, must match star_appearance.glsl
+    constexpr float BRIGHTNESS_EXPONENT = 0.125f;
+    constexpr float MIN_BRIGHTNESS = 0.25f;
+
+    struct Appearance {
+        uint8_t temperatureIndex;       // into Blackbody::Palette
+        uint8_t magnitude;
+    };
+    static_assert(sizeof(Appearance) == 2);
+
+    struct PackedStar {
+        std::array<int16_t, 3> position;
+        Appearance appearance;
+    };
+    static_assert(sizeof(PackedStar) == 8);
+
+    struct ChunkFrame {
+        std::array<float, 3> center;
+        std::array<float, 3> halfExtent;
+    };
+
+    inline size_t chunkCount(size_t starCount) {
+        return (starCount + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    }
+
+    /**
+     * @param luminosity in Lsun
+     */
+    uint8_t encodeMagnitude(float luminosity);
+
+    /**
+     * Inverse of encodeMagnitude(), in Lsun
+     */
+    float decodeLuminosity(uint8_t magnitude);
+
+    /**
+     * Light of a star as the shaders draw it, its luminosity heavily compressed (see star_appearance.glsl)
+     * @param luminosity in Lsun
+     */
+    float brightness(float luminosity);
+
+    /**
+     * Inverse of brightness(), in Lsun
+     */
+    float brightnessLuminosity(float brightness);
+
+    /**
+     * Bounding box of count interleaved xyz positions
+     */
+    ChunkFrame computeFrame(const float* positions, size_t count);
+
+    /**
+     * Smallest frame holding both frames, to pack two sets of positions of the same chunk that are blended together
+     */
+    ChunkFrame mergeFrames(const ChunkFrame& a, const ChunkFrame& b);
+
+    /**
+     * Quantize count interleaved xyz positions relative to frame and interleave them with their appearance
+     */
+    void packChunk(const ChunkFrame& frame, const float* positions, const Appearance* appearance, size_t count,
+                   PackedStar* destination);
+}
+
+#endif //STARPACKING_H
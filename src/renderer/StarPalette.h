@@ -0,0 +1,42 @@
+//
+// Created by raph on 20/01/25.
+//
+
+#ifndef STARPALETTE_H
+#define STARPALETTE_H
+
+#include <memory>
+#include <vulkan/vulkan.h>
+
+#include "Buffer.h"
+#include "../core/Logger.h"
+
+class VulkanContext;
+
+/**
+ * Blackbody palette as a uniform buffer, so stars only carry an 8 bit temperature index.
+ * Bound as set 0 of the star pipelines.
+ */
+class StarPalette {
+public:
+    explicit StarPalette(VulkanContext& context);
+    ~StarPalette();
+
+    StarPalette(const StarPalette&) = delete;
+    StarPalette& operator=(const StarPalette&) = delete;
+
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+
+    void bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout,
+              VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS) const;
+
+private:
+    VulkanContext& context;
+    std::unique_ptr<Buffer> colorBuffer;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    Logger logger;
+};
+
+#endif //STARPALETTE_H
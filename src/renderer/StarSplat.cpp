@@ -0,0 +1,249 @@
+//
+// Created by raph on 05/02/25.
+//
+
+#include "StarSplat.h"
+
+#include <array>
+#include <stdexcept>
+
+#include "FrameUniforms.h"
+#include "Pipeline.h"
+#include "StarField.h"
+#include "StarPalette.h"
+#include "VulkanContext.h"
+
+namespace {
+    // Must match star_splat.comp
+    constexpr uint32_t GROUP_SIZE = 64;
+    constexpr uint32_t STARS_BINDING = 0;
+    constexpr uint32_t ACCUMULATION_BINDING = 1;
+}
+
+StarSplat::StarSplat(VulkanContext& context, const StarField& starField, const StarScene& scene,
+                     const StarPalette& palette, const FrameUniforms& frameUniforms, const StarSplatConfig& config)
+    : context(context)
+    , starField(starField)
+    , scene(scene)
+    , palette(palette)
+    , frameUniforms(frameUniforms)
+    , config(config)
+    , logger("StarSplat") {
+    createDescriptors();
+    createPipeline();
+}
+
+StarSplat::~StarSplat() {
+    VkDevice device = context.getDevice();
+    if (pipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device, pipeline, nullptr);
+    }
+    if (pipelineLayout != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    }
+    if (descriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    }
+    if (descriptorSetLayout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+    }
+}
+
+void StarSplat::createDescriptors() {
+    // The packed stars are read in place, the accumulation is also read by the composite
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    bindings[STARS_BINDING].binding = STARS_BINDING;
+    bindings[STARS_BINDING].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[STARS_BINDING].descriptorCount = 1;
+    bindings[STARS_BINDING].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[ACCUMULATION_BINDING].binding = ACCUMULATION_BINDING;
+    bindings[ACCUMULATION_BINDING].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[ACCUMULATION_BINDING].descriptorCount = 1;
+    bindings[ACCUMULATION_BINDING].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(context.getDevice(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create star splat descriptor set layout");
+    }
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = static_cast<uint32_t>(bindings.size());
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(context.getDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create star splat descriptor pool");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(context.getDevice(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate star splat descriptor set");
+    }
+
+    VkDescriptorBufferInfo bufferInfo{starField.getStarBuffer().getBuffer(), 0, VK_WHOLE_SIZE};
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = STARS_BINDING;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(context.getDevice(), 1, &write, 0, nullptr);
+}
+
+void StarSplat::createPipeline() {
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(SplatConstants);
+
+    std::array<VkDescriptorSetLayout, 3> setLayouts = {palette.getDescriptorSetLayout(),
+                                                       frameUniforms.getDescriptorSetLayout(), descriptorSetLayout};
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    layoutInfo.pSetLayouts = setLayouts.data();
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(context.getDevice(), &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create star splat pipeline layout");
+    }
+
+    splatShader = std::make_unique<Shader>(context, "shaders/star_splat.comp.spv", Shader::Type::Compute);
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = splatShader->getShaderModule();
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = pipelineLayout;
+
+    if (vkCreateComputePipelines(context.getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create star splat pipeline");
+    }
+}
+
+void StarSplat::resize(VkExtent2D newExtent) {
+    if (accumulation && newExtent.width == extent.width && newExtent.height == extent.height) {
+        return;
+    }
+    extent = newExtent;
+
+    accumulation.reset();
+    accumulation = std::make_unique<Buffer>(
+        context,
+        3 * sizeof(uint32_t) * extent.width * extent.height,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        MemoryTag::Targets
+    );
+
+    VkDescriptorBufferInfo bufferInfo{accumulation->getBuffer(), 0, VK_WHOLE_SIZE};
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = ACCUMULATION_BINDING;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(context.getDevice(), 1, &write, 0, nullptr);
+
+    LOG_DEBUG(logger, "Star splat accumulation of {}x{} ({} MiB)", extent.width, extent.height,
+              accumulation->getSize() >> 20);
+}
+
+bool StarSplat::isFar(uint32_t chunk, const glm::vec3& eye, float sunPixels) const {
+    // Nearest point of the bounds, the eye may be inside
+    return sunPixels < config.maxPixels * scene.getChunkBounds().distance(chunk, eye);
+}
+
+void StarSplat::record(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector<StarDrawRange>& ranges,
+                       const glm::vec3& eye, float sunPixels, const StarSpritePushConstants& sprite) {
+    nearRanges.clear();
+    farRanges.clear();
+    for (const auto& range : ranges) {
+        (isFar(range.chunk, eye, sunPixels) ? farRanges : nearRanges).push_back(range);
+    }
+    if (farRanges.empty() || !accumulation) {
+        nearRanges = ranges;
+        farRanges.clear();
+        return;
+    }
+
+    // The composite of the previous frame may still read the accumulation
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = accumulation->getBuffer();
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 1, &barrier, 0, nullptr);
+    vkCmdFillBuffer(commandBuffer, accumulation->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    palette.bind(commandBuffer, pipelineLayout, VK_PIPELINE_BIND_POINT_COMPUTE);
+    frameUniforms.bind(commandBuffer, pipelineLayout, frameIndex, VK_PIPELINE_BIND_POINT_COMPUTE);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, SET, 1, &descriptorSet, 0, nullptr);
+
+    // One dispatch per chunk, like the draws: each carries its own quantization frame
+    for (const auto& range : farRanges) {
+        const auto& frame = starField.getChunkFrame(range.chunk);
+        SplatConstants constants{};
+        constants.chunkCenter = glm::vec4(frame.center[0], frame.center[1], frame.center[2], 0.0f);
+        constants.chunkHalfExtent = glm::vec4(frame.halfExtent[0], frame.halfExtent[1], frame.halfExtent[2], 0.0f);
+        constants.merge = glm::uvec4(range.merge.lastPoint, range.merge.starsPerPoint, range.merge.lastPointStars, 0);
+        constants.sprite = glm::vec4(sprite.radius, sprite.minPixels, sprite.maxPixels, 0.0f);
+        constants.firstPoint = range.firstPoint;
+        constants.pointCount = range.pointCount;
+        constants.width = extent.width;
+        constants.height = extent.height;
+        constants.blend = starField.getBlend();
+        constants.previousPoints = starField.getPreviousPoints();
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(commandBuffer, (range.pointCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+    }
+
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void StarSplat::composite(VkCommandBuffer commandBuffer, Pipeline& compositePipeline) const {
+    if (farRanges.empty()) {
+        return;
+    }
+
+    StarSplatResolveConstants constants{extent.width};
+    compositePipeline.bind(commandBuffer);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, compositePipeline.getLayout(), SET, 1,
+                            &descriptorSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, compositePipeline.getLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants),
+                       &constants);
+    vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+}
@@ -0,0 +1,131 @@
+//
+// Created by raph on 05/02/25.
+//
+
+#ifndef STARSPLAT_H
+#define STARSPLAT_H
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include "Buffer.h"
+#include "Shader.h"
+#include "StarVertex.h"
+#include "../core/Logger.h"
+#include "../scene/StarScene.h"
+
+class VulkanContext;
+class FrameUniforms;
+class Pipeline;
+class StarField;
+class StarPalette;
+
+struct StarSplatConfig {
+    bool enabled = false;
+    float maxPixels = 1.0f;         // chunks where a sun like star would be smaller than this radius are splatted
+};
+
+/**
+ * Push constants of the pipeline compositing the splatted stars (see star_splat_resolve.frag)
+ */
+struct StarSplatResolveConstants {
+    uint32_t width;
+};
+
+/**
+ * Software rasterization of the far field: the stars of chunks too far to cover more than a pixel are projected
+ * by a compute shader and added with integer atomics into an accumulation buffer, in fixed point with 3 words per
+ * pixel. The stars pass then adds the buffer to the HDR target with a full screen triangle, next to the near field
+ * the hardware rasterizes. Stars are added, so splatting them in any order gives the same image. With star sprites,
+ * a star adds all the light its sprite would have spread, faded the same way, so the splatted chunks are as bright
+ * as the rasterized ones next to them.
+ *
+ * Chunks are picked each frame from the distance of their bounds. The splat is recorded outside of the render
+ * graph, with its own barriers, like the star uploads and the depth sort.
+ */
+class StarSplat {
+public:
+    static constexpr uint32_t SET = 2;
+
+    /**
+     * @param palette and frameUniforms are bound as sets 0 and 1 of the splat, like the star pipelines
+     */
+    StarSplat(VulkanContext& context, const StarField& starField, const StarScene& scene, const StarPalette& palette,
+              const FrameUniforms& frameUniforms, const StarSplatConfig& config = StarSplatConfig());
+    ~StarSplat();
+
+    StarSplat(const StarSplat&) = delete;
+    StarSplat& operator=(const StarSplat&) = delete;
+
+    /**
+     * Set of the accumulation buffer, for the composite pipeline layout after the palette and frame uniforms
+     */
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+
+    /**
+     * Size the accumulation buffer to the HDR target, the device must be idle
+     */
+    void resize(VkExtent2D extent);
+
+    /**
+     * Split the selection between the near and far fields, and splat the far one. Must be recorded outside of a
+     * render pass, after the frame uniforms of the frame were written
+     * @param sunPixels radius in pixels of a sun like star at distance 1
+     * @param sprite pushed to the star pipelines, all 0 when stars are single pixels
+     */
+    void record(VkCommandBuffer commandBuffer, uint32_t frameIndex, const std::vector<StarDrawRange>& ranges,
+                const glm::vec3& eye, float sunPixels, const StarSpritePushConstants& sprite);
+
+    /**
+     * Chunks left to the rasterizer by the last record()
+     */
+    const std::vector<StarDrawRange>& getNearRanges() const { return nearRanges; }
+
+    /**
+     * Add the splatted stars to the bound color attachment, with the pipeline from
+     * PipelineManager::getFullscreenConfig() blended like the stars. Nothing is drawn when nothing was splatted
+     */
+    void composite(VkCommandBuffer commandBuffer, Pipeline& pipeline) const;
+
+private:
+    struct SplatConstants {
+        glm::vec4 chunkCenter;
+        glm::vec4 chunkHalfExtent;
+        glm::uvec4 merge;
+        glm::vec4 sprite;
+        uint32_t firstPoint;
+        uint32_t pointCount;
+        uint32_t width;
+        uint32_t height;
+        float blend;
+        uint32_t previousPoints;
+    };
+
+    void createDescriptors();
+    void createPipeline();
+    bool isFar(uint32_t chunk, const glm::vec3& eye, float sunPixels) const;
+
+    VulkanContext& context;
+    const StarField& starField;
+    const StarScene& scene;
+    const StarPalette& palette;
+    const FrameUniforms& frameUniforms;
+    StarSplatConfig config;
+    VkExtent2D extent{};
+
+    std::unique_ptr<Buffer> accumulation;       // r, g, b per pixel
+    std::vector<StarDrawRange> nearRanges;
+    std::vector<StarDrawRange> farRanges;
+
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    std::unique_ptr<Shader> splatShader;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    Logger logger;
+};
+
+#endif //STARSPLAT_H
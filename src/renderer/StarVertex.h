@@ -0,0 +1,162 @@
+//
+// Created by raph on 12/01/25.
+//
+
+#ifndef STARVERTEX_H
+#define STARVERTEX_H
+
+#include <array>
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include "StarPacking.h"
+
+/**
+ * Stars are drawn as points from 8 byte packed records (see StarPacking): a chunk relative 16 bit snorm position,
+ * a palette index and a magnitude. The vertex shader decodes them with the chunk frame given in push constants.
+ * Simulated stars have a second record per point, their previous state, that the shader blends towards the current
+ * one with the blend of the push constants (see StarField).
+ *
+ * Snapshot playback keeps float keyframe positions next to a separate stream of appearance records.
+ *
+ * With vertex pulling the same buffers are storage buffers of VertexStreams, read by stars_pulled.vert and
+ * stars_playback_pulled.vert: no vertex input state, and no copy to another layout.
+ *
+ * Star sprites are pulled too: stars_sprite.vert expands each record into SPRITE_VERTICES corners found from
+ * gl_VertexIndex, stars_point_sprite.vert sizes a single point. Neither duplicates a record.
+ */
+struct StarVertex {
+    using Position = glm::vec3;
+    using Packed = StarPacking::PackedStar;
+
+    static constexpr uint32_t PACKED_BINDING = 0;
+    static constexpr uint32_t PREVIOUS_PACKED_BINDING = 1;
+
+    // Playback
+    static constexpr uint32_t KEYFRAME_BINDING = 0;
+    static constexpr uint32_t APPEARANCE_BINDING = 1;
+    static constexpr uint32_t NEXT_KEYFRAME_BINDING = 2;
+
+    // Pulled playback streams: every keyframe buffer, selected by index in the push constants, then the appearance
+    static constexpr uint32_t PULLED_KEYFRAMES_BINDING = 0;
+    static constexpr uint32_t PULLED_APPEARANCE_BINDING = 3;
+    static constexpr uint32_t PULLED_PLAYBACK_STREAMS = 4;
+
+    // Two triangles per star sprite, without an index buffer
+    static constexpr uint32_t SPRITE_VERTICES = 6;
+
+    static std::array<VkVertexInputBindingDescription, 2> getBindingDescriptions() {
+        std::array<VkVertexInputBindingDescription, 2> bindingDescriptions{};
+        bindingDescriptions[0].binding = PACKED_BINDING;
+        bindingDescriptions[0].stride = sizeof(Packed);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        // The same buffer, bound at the records of the previous state
+        bindingDescriptions[1].binding = PREVIOUS_PACKED_BINDING;
+        bindingDescriptions[1].stride = sizeof(Packed);
+        bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        return bindingDescriptions;
+    }
+
+    static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
+        std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+        // The fourth component overlaps the appearance and is ignored, RGB16 formats are optional for vertex input
+        attributeDescriptions[0].binding = PACKED_BINDING;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_SNORM;
+        attributeDescriptions[0].offset = offsetof(Packed, position);
+
+        attributeDescriptions[1].binding = PACKED_BINDING;
+        attributeDescriptions[1].location = 1;
+        attributeDescriptions[1].format = VK_FORMAT_R8G8_UINT;
+        attributeDescriptions[1].offset = offsetof(Packed, appearance);
+
+        attributeDescriptions[2].binding = PREVIOUS_PACKED_BINDING;
+        attributeDescriptions[2].location = 2;
+        attributeDescriptions[2].format = VK_FORMAT_R16G16B16A16_SNORM;
+        attributeDescriptions[2].offset = offsetof(Packed, position);
+
+        return attributeDescriptions;
+    }
+
+    static std::array<VkVertexInputBindingDescription, 3> getPlaybackBindingDescriptions() {
+        std::array<VkVertexInputBindingDescription, 3> bindingDescriptions{};
+        bindingDescriptions[0].binding = KEYFRAME_BINDING;
+        bindingDescriptions[0].stride = sizeof(Position);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        bindingDescriptions[1].binding = APPEARANCE_BINDING;
+        bindingDescriptions[1].stride = sizeof(StarPacking::Appearance);
+        bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        bindingDescriptions[2].binding = NEXT_KEYFRAME_BINDING;
+        bindingDescriptions[2].stride = sizeof(Position);
+        bindingDescriptions[2].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        return bindingDescriptions;
+    }
+
+    static std::array<VkVertexInputAttributeDescription, 3> getPlaybackAttributeDescriptions() {
+        std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
+        attributeDescriptions[0].binding = KEYFRAME_BINDING;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attributeDescriptions[0].offset = 0;
+
+        attributeDescriptions[1].binding = APPEARANCE_BINDING;
+        attributeDescriptions[1].location = 1;
+        attributeDescriptions[1].format = VK_FORMAT_R8G8_UINT;
+        attributeDescriptions[1].offset = 0;
+
+        attributeDescriptions[2].binding = NEXT_KEYFRAME_BINDING;
+        attributeDescriptions[2].location = 2;
+        attributeDescriptions[2].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attributeDescriptions[2].offset = 0;
+
+        return attributeDescriptions;
+    }
+};
+
+/**
+ * Push constants of the star pipeline, set for each chunk. The view comes from the frame uniforms
+ */
+struct StarPushConstants {
+    glm::vec4 chunkCenter;          // xyz, kpc
+    glm::vec4 chunkHalfExtent;      // xyz, kpc
+    glm::uvec4 merge;               // StarMerge: last point, stars per point, stars of the last point
+    float blend;                    // 0 at the previous simulation state, 1 at the current one
+    uint32_t previousPoints;        // records between a point and its previous state, 0 when positions are static
+    float padding[2];
+};
+
+enum class StarSprites {
+    Pixels,         // one pixel per star, whatever its brightness
+    Quads,          // a screen aligned quad expanded in the vertex shader
+    Points          // a sized point, cheaper where the rasterizer handles large points well
+};
+
+struct StarSpriteConfig {
+    StarSprites mode = StarSprites::Pixels;
+    float radius = 0.01f;           // kpc, world radius of a sun like star, scaled by the fourth root of the luminosity
+    float minPixels = 1.0f;         // smaller sprites keep this radius and fade instead
+    float maxPixels = 16.0f;        // clamped to the device point size range for Points
+};
+
+/**
+ * Pushed after StarPushConstants by the sprite pipelines, once per draw (see star_sprite.glsl)
+ */
+struct StarSpritePushConstants {
+    float radius;
+    float minPixels;
+    float maxPixels;
+    float padding;
+};
+
+struct StarPlaybackPushConstants {
+    float blend;                    // 0 at the current keyframe, 1 at the next one
+    uint32_t currentKeyframe;       // buffers of the two keyframes, only read when the vertices are pulled
+    uint32_t nextKeyframe;
+};
+
+#endif //STARVERTEX_H
@@ -10,9 +10,12 @@
 #include <memory>
 #include "../core/Logger.h"
 
-class RenderPass;
 class VulkanContext;
 
+/**
+ * Swap chain images and their views. They are drawn into by the render graph, which owns the render passes and
+ * framebuffers (none at all with dynamic rendering), so recreating the swap chain leaves the pipelines alone
+ */
 class SwapChain {
 public:
     SwapChain(VulkanContext& context);
@@ -21,14 +24,9 @@ public:
     void recreate();
     VkExtent2D getExtent() const { return extent; }
     VkFormat getImageFormat() const { return imageFormat; }
-    VkRenderPass getRenderPass() const { return renderPass; }
+    VkPresentModeKHR getPresentMode() const { return presentMode; }
+    const std::vector<VkImage>& getImages() const { return images; }
     const std::vector<VkImageView>& getImageViews() const { return imageViews; }
-    const std::vector<VkFramebuffer>& getFramebuffers() const { return framebuffers; }
-
-    // Add these render pass methods
-    void beginRenderPass(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer) const;
-
-    static void endRenderPass(VkCommandBuffer commandBuffer);
 
     VkSwapchainKHR swapChain{};
 
@@ -36,8 +34,6 @@ private:
     void create();
     void cleanup();
     void createImageViews();
-    void createRenderPass();
-    void createFramebuffers();
 
     static VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
     VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
@@ -46,9 +42,8 @@ private:
     VulkanContext& context;
     std::vector<VkImage> images;
     std::vector<VkImageView> imageViews;
-    std::vector<VkFramebuffer> framebuffers;
-    VkRenderPass renderPass{};
     VkFormat imageFormat;
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
     VkExtent2D extent{};
     Logger logger;
 };
@@ -0,0 +1,138 @@
+//
+// Created by raph on 02/02/25.
+//
+
+#include "Tonemap.h"
+
+#include <array>
+#include <stdexcept>
+
+#include "Image.h"
+#include "Pipeline.h"
+#include "VulkanContext.h"
+
+namespace {
+    bool supports(VkPhysicalDevice physicalDevice, VkFormat format, VkFormatFeatureFlags features) {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+        return (properties.optimalTilingFeatures & features) == features;
+    }
+}
+
+Tonemap::Tonemap(VulkanContext& context)
+    : context(context)
+    , logger("Tonemap") {
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 0.0f;
+
+    if (vkCreateSampler(context.getDevice(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create tonemap sampler");
+    }
+
+    // HDR color, bloom
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(context.getDevice(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create tonemap descriptor set layout");
+    }
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = static_cast<uint32_t>(bindings.size());
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(context.getDevice(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create tonemap descriptor pool");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(context.getDevice(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate tonemap descriptor set");
+    }
+}
+
+Tonemap::~Tonemap() {
+    if (descriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(context.getDevice(), descriptorPool, nullptr);
+    }
+    if (descriptorSetLayout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(context.getDevice(), descriptorSetLayout, nullptr);
+    }
+    if (sampler != VK_NULL_HANDLE) {
+        vkDestroySampler(context.getDevice(), sampler, nullptr);
+    }
+}
+
+VkFormat Tonemap::chooseFormat(VulkanContext& context, const HdrConfig& config) {
+    // Stars are added with blending, and the result is filtered by the bloom downsample
+    const VkFormatFeatureFlags features = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT |
+                                          VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    if (config.packedFormat) {
+        if (supports(context.getPhysicalDevice(), VK_FORMAT_B10G11R11_UFLOAT_PACK32, features)) {
+            return VK_FORMAT_B10G11R11_UFLOAT_PACK32;
+        }
+        Logger("Tonemap").warning("B10G11R11 cannot be blended into on this GPU, using RGBA16F");
+    }
+    if (!supports(context.getPhysicalDevice(), VK_FORMAT_R16G16B16A16_SFLOAT, features)) {
+        throw std::runtime_error("RGBA16F render targets are not supported");
+    }
+    return VK_FORMAT_R16G16B16A16_SFLOAT;
+}
+
+void Tonemap::update(const Image& target, const Image* bloom) {
+    hasBloom = bloom != nullptr;
+
+    // Without bloom the second binding repeats the target, and is weighted by 0
+    std::array<VkDescriptorImageInfo, 2> imageInfos{};
+    imageInfos[0] = {sampler, target.getView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    imageInfos[1] = bloom ? VkDescriptorImageInfo{sampler, bloom->getMipView(0), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL}
+                          : imageInfos[0];
+
+    std::array<VkWriteDescriptorSet, 2> writes{};
+    for (uint32_t i = 0; i < writes.size(); i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = descriptorSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[i].pImageInfo = &imageInfos[i];
+    }
+    vkUpdateDescriptorSets(context.getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void Tonemap::draw(VkCommandBuffer commandBuffer, Pipeline& pipeline, float exposure, float bloomIntensity) const {
+    TonemapPushConstants constants{exposure, hasBloom ? bloomIntensity : 0.0f};
+
+    pipeline.bind(commandBuffer);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getLayout(), 0, 1, &descriptorSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, pipeline.getLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants), &constants);
+    vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+}
@@ -0,0 +1,67 @@
+//
+// Created by raph on 02/02/25.
+//
+
+#ifndef TONEMAP_H
+#define TONEMAP_H
+
+#include <vulkan/vulkan.h>
+
+#include "../core/Logger.h"
+
+class VulkanContext;
+class Image;
+class Pipeline;
+
+struct HdrConfig {
+    bool packedFormat = false;      // B10G11R11 instead of RGBA16F when the GPU can blend into it, half the bandwidth but a 6 bit mantissa
+    float exposure = 1.0f;          // applied before tonemapping
+};
+
+/**
+ * Push constants of the tonemap pipeline (see tonemap.frag)
+ */
+struct TonemapPushConstants {
+    float exposure;
+    float bloomIntensity;
+};
+
+/**
+ * Resolve of the HDR target the stars are added into, and of its bloom, into the swap chain: a full screen
+ * triangle with the pipeline from PipelineManager::getFullscreenConfig() and this descriptor set layout.
+ */
+class Tonemap {
+public:
+    explicit Tonemap(VulkanContext& context);
+    ~Tonemap();
+
+    Tonemap(const Tonemap&) = delete;
+    Tonemap& operator=(const Tonemap&) = delete;
+
+    /**
+     * Format of the HDR target: it is blended into and filtered
+     */
+    static VkFormat chooseFormat(VulkanContext& context, const HdrConfig& config);
+
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+
+    /**
+     * Point the descriptor set at the images of the compiled render graph, both sampled in the shader read only
+     * layout. The device must be idle
+     * @param bloom level 0 is used, null to tonemap the target alone
+     */
+    void update(const Image& target, const Image* bloom);
+
+    void draw(VkCommandBuffer commandBuffer, Pipeline& pipeline, float exposure, float bloomIntensity) const;
+
+private:
+    VulkanContext& context;
+    bool hasBloom = false;
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    Logger logger;
+};
+
+#endif //TONEMAP_H
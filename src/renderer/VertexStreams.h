@@ -0,0 +1,50 @@
+//
+// Created by raph on 04/02/25.
+//
+
+#ifndef VERTEXSTREAMS_H
+#define VERTEXSTREAMS_H
+
+#include <vulkan/vulkan.h>
+
+#include "../core/Logger.h"
+
+class VulkanContext;
+class Buffer;
+
+/**
+ * Storage buffers read by vertex shaders that pull their own vertices with gl_VertexIndex, instead of going
+ * through vertex attributes. Bound as set 2 of the star pipelines, after the palette and the frame uniforms.
+ * Buffers are written once by their owner (StarField, SnapshotPlayback), which must not replace them while a frame
+ * may still read them.
+ */
+class VertexStreams {
+public:
+    static constexpr uint32_t SET = 2;
+
+    VertexStreams(VulkanContext& context, uint32_t bufferCount);
+    ~VertexStreams();
+
+    VertexStreams(const VertexStreams&) = delete;
+    VertexStreams& operator=(const VertexStreams&) = delete;
+
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+    uint32_t getBufferCount() const { return bufferCount; }
+
+    /**
+     * Point a binding at a whole buffer, created with VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+     */
+    void setBuffer(uint32_t binding, const Buffer& buffer);
+
+    void bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) const;
+
+private:
+    VulkanContext& context;
+    uint32_t bufferCount;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    Logger logger;
+};
+
+#endif //VERTEXSTREAMS_H
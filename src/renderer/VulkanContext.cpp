@@ -8,6 +8,7 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <sstream>
 
 #include "CommandManager.h"
 #include "SwapChain.h"
@@ -39,6 +40,7 @@ VulkanContext::~VulkanContext() {
 
     commandManager.reset();
     swapChain.reset();
+    memoryTracker.reset();
 
     if (device != VK_NULL_HANDLE) {
         vkDestroyDevice(device, nullptr);
@@ -75,12 +77,13 @@ void VulkanContext::initialize() {
     createLogicalDevice();
 
     // Create Managers
+    memoryTracker = std::make_unique<MemoryTracker>(physicalDevice, isExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME));
     commandManager = std::make_unique<CommandManager>(*this);
     swapChain = std::make_unique<SwapChain>(*this);
 }
 
 void VulkanContext::createInstance() {
-    logger.trace("Creating Vulkan instance");
+    LOG_TRACE(logger, "Creating Vulkan instance");
     if (enableValidationLayers && !checkValidationLayerSupport()) {
         throw std::runtime_error("No required validation layers available. Please install the Vulkan SDK or disable NDEBUG");
     }
@@ -91,7 +94,7 @@ void VulkanContext::createInstance() {
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = VK_API_VERSION_1_1;     // vkGetPhysicalDeviceMemoryProperties2 for the memory budget
 
     auto extensions = getRequiredExtensions();
     VkInstanceCreateInfo createInfo{};
@@ -123,7 +126,7 @@ void VulkanContext::setupDebugMessenger() {
         return;
     }
 
-    logger.trace("Setting up debug messenger");
+    LOG_TRACE(logger, "Setting up debug messenger");
 
     VkDebugUtilsMessengerCreateInfoEXT createInfo{};
     populateDebugMessengerCreateInfo(createInfo);
@@ -134,14 +137,14 @@ void VulkanContext::setupDebugMessenger() {
 }
 
 void VulkanContext::createSurface() {
-    logger.trace("Getting surface from glfw window");
+    LOG_TRACE(logger, "Getting surface from glfw window");
     if (window.createSurface(instance, &surface) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create window surface");
     }
 }
 
 void VulkanContext::pickPhysicalDevice() {
-    logger.trace("Picking physical device");
+    LOG_TRACE(logger, "Picking physical device");
     uint32_t deviceCount = 0;
     vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
 
@@ -149,7 +152,7 @@ void VulkanContext::pickPhysicalDevice() {
         throw std::runtime_error("No physical devices found compatible with Vulkan");
     }
 
-    logger.trace("Found " + std::to_string(deviceCount) + " physical devices: ");
+    LOG_TRACE(logger, "Found {} physical devices: ", deviceCount);
 
     std::vector<VkPhysicalDevice> devices(deviceCount);
     vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
@@ -162,7 +165,7 @@ void VulkanContext::pickPhysicalDevice() {
         candidates.insert(std::make_pair(score, device));
         VkPhysicalDeviceProperties deviceProperties;
         vkGetPhysicalDeviceProperties(device, &deviceProperties);
-        logger.trace(" - " + std::string(deviceProperties.deviceName) + " (" + std::to_string(score) + ")");
+        LOG_TRACE(logger, " - {} ({})", deviceProperties.deviceName, score);
     }
 
     // get the best candidate
@@ -178,7 +181,7 @@ void VulkanContext::pickPhysicalDevice() {
 }
 
 void VulkanContext::createLogicalDevice() {
-    logger.trace("Creating logical device");
+    LOG_TRACE(logger, "Creating logical device");
 
     QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
@@ -195,7 +198,17 @@ void VulkanContext::createLogicalDevice() {
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    // Sized points for the star sprites, at most 1 pixel without the feature
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
     VkPhysicalDeviceFeatures deviceFeatures{};
+    deviceFeatures.largePoints = supportedFeatures.largePoints;
+    if (supportedFeatures.largePoints) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        maxPointSize = properties.limits.pointSizeRange[1];
+    }
+
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
@@ -204,8 +217,28 @@ void VulkanContext::createLogicalDevice() {
 
     createInfo.pEnabledFeatures = &deviceFeatures;
 
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    std::vector<const char*> extensions = deviceExtensions;
+    for (const char* extension : optionalDeviceExtensions) {
+        if (hasDeviceExtension(physicalDevice, extension)) {
+            enabledOptionalExtensions.push_back(extension);
+            extensions.push_back(extension);
+        } else {
+            logger.info(std::string("Optional device extension ") + extension + " is not available");
+        }
+    }
+
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+    dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    const bool dynamicRendering = supportsDynamicRendering(physicalDevice);
+    if (dynamicRendering) {
+        extensions.insert(extensions.end(), dynamicRenderingExtensions.begin(), dynamicRenderingExtensions.end());
+        dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+        createInfo.pNext = &dynamicRenderingFeatures;
+    } else {
+        logger.info("Dynamic rendering is not available, drawing with render passes");
+    }
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+    createInfo.ppEnabledExtensionNames = extensions.data();
 
     if (enableValidationLayers) {
         createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -220,6 +253,16 @@ void VulkanContext::createLogicalDevice() {
 
     vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
     vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+
+    if (dynamicRendering) {
+        cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdBeginRenderingKHR"));
+        cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdEndRenderingKHR"));
+        if (cmdBeginRendering == nullptr || cmdEndRendering == nullptr) {
+            logger.warning("Dynamic rendering commands are missing, drawing with render passes");
+            cmdBeginRendering = nullptr;
+            cmdEndRendering = nullptr;
+        }
+    }
 }
 
 ////////////////////////////////////////
@@ -232,6 +275,17 @@ void VulkanContext::waitIdle() const {
     }
 }
 
+void VulkanContext::beginRendering(VkCommandBuffer commandBuffer, const VkRenderingInfoKHR& renderingInfo) const {
+    if (cmdBeginRendering == nullptr) {
+        throw std::runtime_error("Dynamic rendering is not enabled");
+    }
+    cmdBeginRendering(commandBuffer, &renderingInfo);
+}
+
+void VulkanContext::endRendering(VkCommandBuffer commandBuffer) const {
+    cmdEndRendering(commandBuffer);
+}
+
 int VulkanContext::rateDeviceSuitability(VkPhysicalDevice device) {
     VkPhysicalDeviceProperties deviceProperties;
     VkPhysicalDeviceFeatures deviceFeatures;
@@ -464,6 +518,46 @@ QueueFamilyIndices VulkanContext::findQueueFamilies(VkPhysicalDevice device) con
     return indices;
 }
 
+bool VulkanContext::hasDeviceExtension(VkPhysicalDevice device, const char* extension) {
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+    for (const auto& available : availableExtensions) {
+        if (std::strcmp(available.extensionName, extension) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VulkanContext::isExtensionEnabled(const char* extension) const {
+    for (const char* enabled : enabledOptionalExtensions) {
+        if (std::strcmp(enabled, extension) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VulkanContext::supportsDynamicRendering(VkPhysicalDevice device) const {
+    for (const char* extension : dynamicRenderingExtensions) {
+        if (!hasDeviceExtension(device, extension)) {
+            return false;
+        }
+    }
+
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+    dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &dynamicRenderingFeatures;
+    vkGetPhysicalDeviceFeatures2(device, &features);
+    return dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+}
+
 bool VulkanContext::checkDeviceExtensionSupport(VkPhysicalDevice device) const {
     uint32_t extensionCount;
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "CommandManager.h"
+#include "MemoryTracker.h"
 #include "SwapChain.h"
 #include "../core/Logger.h"
 
@@ -55,8 +56,22 @@ public:
     VkSurfaceKHR getSurface() const { return surface; }
     SwapChain& getSwapChain() const { return *swapChain; }
     CommandManager& getCommandManager() const { return *commandManager; }
+    MemoryTracker& getMemoryTracker() const { return *memoryTracker; }
     Window& getWindow() const { return window; }
 
+    /**
+     * VK_KHR_dynamic_rendering is enabled: pipelines can be created for attachment formats instead of a render pass,
+     * and drawn between beginRendering() and endRendering() without framebuffers
+     */
+    bool hasDynamicRendering() const { return cmdBeginRendering != nullptr; }
+    void beginRendering(VkCommandBuffer commandBuffer, const VkRenderingInfoKHR& renderingInfo) const;
+    void endRendering(VkCommandBuffer commandBuffer) const;
+
+    /**
+     * Largest gl_PointSize the rasterizer honours, 1 when the device lacks the largePoints feature
+     */
+    float getMaxPointSize() const { return maxPointSize; }
+
     /**
      * Get the queue family indices for a given physical device. This also can be used to check if the device
      * supports the required queues, and if the graphics and present queues are different or not
@@ -86,6 +101,18 @@ private:
      */
     bool checkDeviceExtensionSupport(VkPhysicalDevice device) const;
 
+    /**
+     * Check if one extension is supported by the device
+     */
+    static bool hasDeviceExtension(VkPhysicalDevice device, const char* extension);
+
+    bool isExtensionEnabled(const char* extension) const;
+
+    /**
+     * Check if the device has VK_KHR_dynamic_rendering, the extensions it needs before Vulkan 1.2, and the feature
+     */
+    bool supportsDynamicRendering(VkPhysicalDevice device) const;
+
     /**
      * Check if all layer names in validationLayers are supported by the Vulkan instance
      * @return true if all layers are supported, false otherwise
@@ -145,6 +172,7 @@ private:
 
     std::unique_ptr<SwapChain> swapChain;
     std::unique_ptr<CommandManager> commandManager;
+    std::unique_ptr<MemoryTracker> memoryTracker;
 
 
     // Configuration
@@ -157,6 +185,22 @@ private:
         VK_KHR_SWAPCHAIN_EXTENSION_NAME
     };
 
+    // Enabled when the device has them
+    const std::vector<const char*> optionalDeviceExtensions = {
+        VK_EXT_MEMORY_BUDGET_EXTENSION_NAME
+    };
+    std::vector<const char*> enabledOptionalExtensions;
+
+    // Enabled together when supportsDynamicRendering(), the instance targets Vulkan 1.1
+    const std::vector<const char*> dynamicRenderingExtensions = {
+        VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME,
+        VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+        VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME
+    };
+    PFN_vkCmdBeginRenderingKHR cmdBeginRendering = nullptr;
+    PFN_vkCmdEndRenderingKHR cmdEndRendering = nullptr;
+    float maxPointSize = 1.0f;
+
     #ifdef NDEBUG
         static constexpr bool enableValidationLayers = false;
     #else
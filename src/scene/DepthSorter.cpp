@@ -0,0 +1,86 @@
+//
+// Created by raph on 01/02/25.
+//
+
+#include "DepthSorter.h"
+
+#include <bit>
+
+#include "../core/ThreadPool.h"
+
+DepthSorter::DepthSorter(const StarScene& scene)
+    : scene(scene) {
+}
+
+bool DepthSorter::needsSort(const std::vector<StarDrawRange>& ranges, const glm::vec3& eye) const {
+    return version == 0 || eye != sortedEye || scene.getPositionsVersion() != sortedPositionsVersion || ranges != sortedRanges;
+}
+
+uint32_t DepthSorter::writeKeys(const std::vector<StarDrawRange>& ranges, const glm::vec3& eye, uint64_t* keys,
+                                uint32_t* values) {
+    // Chunks back to front: increasing flipped distance of their center
+    const auto rangeCount = static_cast<uint32_t>(ranges.size());
+    chunkKeys.resize(rangeCount);
+    chunkOrder.resize(rangeCount);
+    chunkRanks.resize(rangeCount);
+    rangeOffsets.resize(rangeCount);
+    for (uint32_t i = 0; i < rangeCount; i++) {
+        const glm::vec3 offset = scene.getChunkCenter(ranges[i].chunk) - eye;
+        chunkKeys[i] = ~RadixSorter::sortableKey(glm::dot(offset, offset));
+        chunkOrder[i] = i;
+    }
+    sorter.sort(chunkKeys.data(), chunkOrder.data(), rangeCount);
+
+    indexRanges.resize(rangeCount);
+    uint32_t sortedOffset = 0;
+    for (uint32_t rank = 0; rank < rangeCount; rank++) {
+        const StarDrawRange& range = ranges[chunkOrder[rank]];
+        chunkRanks[chunkOrder[rank]] = rank;
+        indexRanges[rank] = {range.chunk, sortedOffset, range.pointCount, range.merge};
+        sortedOffset += range.pointCount;
+    }
+
+    uint32_t keyOffset = 0;
+    for (uint32_t i = 0; i < rangeCount; i++) {
+        rangeOffsets[i] = keyOffset;
+        keyOffset += ranges[i].pointCount;
+    }
+    indexCount = keyOffset;
+
+    const float* positions = scene.getPointPositions();
+    ThreadPool::global().parallelFor(0, rangeCount, 1, [&](size_t firstRange, size_t lastRange) {
+        for (size_t r = firstRange; r < lastRange; r++) {
+            const StarDrawRange& range = ranges[r];
+            const uint64_t rank = uint64_t(chunkRanks[r]) << 32;
+            uint64_t* rangeKeys = keys + rangeOffsets[r];
+            uint32_t* rangeValues = values + rangeOffsets[r];
+            for (uint32_t i = 0; i < range.pointCount; i++) {
+                const uint32_t point = range.firstPoint + i;
+                const float* position = positions + 3 * size_t(point);
+                const glm::vec3 offset(position[0] - eye.x, position[1] - eye.y, position[2] - eye.z);
+                rangeKeys[i] = rank | ~RadixSorter::sortableKey(glm::dot(offset, offset));
+                rangeValues[i] = point;
+            }
+        }
+    });
+
+    sortedRanges = ranges;
+    sortedEye = eye;
+    sortedPositionsVersion = scene.getPositionsVersion();
+    version++;
+    return rangeCount > 1 ? std::bit_width(rangeCount - 1) : 0;
+}
+
+void DepthSorter::sort(const std::vector<StarDrawRange>& ranges, const glm::vec3& eye) {
+    uint32_t count = 0;
+    for (const auto& range : ranges) {
+        count += range.pointCount;
+    }
+    if (keys.size() < count) {
+        keys.resize(count);
+        indices.resize(count);
+    }
+
+    const uint32_t rankBits = writeKeys(ranges, eye, keys.data(), indices.data());
+    sorter.sort(keys.data(), indices.data(), indexCount, 32 + rankBits);
+}
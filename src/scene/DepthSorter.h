@@ -0,0 +1,95 @@
+//
+// Created by raph on 01/02/25.
+//
+
+#ifndef DEPTHSORTER_H
+#define DEPTHSORTER_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "StarScene.h"
+#include "../core/RadixSort.h"
+
+struct DepthSortConfig {
+    bool enabled = false;                   // the star pipelines blend additively, which does not depend on the order
+    uint32_t gpuMinimumCount = 1'000'000;   // selections of at least this many points are sorted by the GPU, 0 never
+};
+
+/**
+ * Indexed draw command for one chunk, in the indices written by the sort
+ */
+struct StarIndexRange {
+    uint32_t chunk;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    StarMerge merge;
+};
+
+/**
+ * Back to front order of the selected points, for blending that is only right when far points are drawn first.
+ *
+ * Points keep being drawn chunk by chunk, as each chunk has its own quantization frame: chunks are ordered by the
+ * distance of their center to the eye, points by their own distance inside their chunk. Both go in one 64 bit key,
+ * the chunk rank in the high half and the flipped distance in the low half, sorted as one radix sort whose rank
+ * passes are mostly skipped. The order is exact inside a chunk and between chunks that do not overlap.
+ *
+ * Distances do not depend on the view direction, so turning the camera in place keeps the order; nothing is sorted
+ * again until the eye, the selection or the positions change.
+ */
+class DepthSorter {
+public:
+    explicit DepthSorter(const StarScene& scene);
+
+    /**
+     * Whether the last order is stale for this selection and eye
+     */
+    bool needsSort(const std::vector<StarDrawRange>& ranges, const glm::vec3& eye) const;
+
+    /**
+     * Rank the chunks and write the key of every selected point, with the point as value, chunk after chunk.
+     * The index ranges are those of the sorted order
+     * @return the number of bits of the high half of the keys in use
+     */
+    uint32_t writeKeys(const std::vector<StarDrawRange>& ranges, const glm::vec3& eye, uint64_t* keys, uint32_t* values);
+
+    /**
+     * writeKeys() into the sorter and radix sort them on the CPU
+     */
+    void sort(const std::vector<StarDrawRange>& ranges, const glm::vec3& eye);
+
+    /**
+     * Points back to front, only valid after sort()
+     */
+    const std::vector<uint32_t>& getIndices() const { return indices; }
+    const std::vector<StarIndexRange>& getRanges() const { return indexRanges; }
+    uint32_t getIndexCount() const { return indexCount; }
+
+    /**
+     * Incremented every time the order changes
+     */
+    uint64_t getVersion() const { return version; }
+
+private:
+    const StarScene& scene;
+    RadixSorter sorter;
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> indices;
+    std::vector<StarIndexRange> indexRanges;
+    uint32_t indexCount = 0;
+
+    // Chunk ranking, by decreasing distance of the centers
+    std::vector<uint32_t> chunkKeys;
+    std::vector<uint32_t> chunkOrder;
+    std::vector<uint32_t> chunkRanks;       // range -> rank
+    std::vector<uint32_t> rangeOffsets;     // range -> first key
+
+    // What the last order was computed for
+    std::vector<StarDrawRange> sortedRanges;
+    glm::vec3 sortedEye{0.0f};
+    uint64_t sortedPositionsVersion = 0;
+    uint64_t version = 0;
+};
+
+#endif //DEPTHSORTER_H
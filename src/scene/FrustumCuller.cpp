@@ -0,0 +1,164 @@
+//
+// Created by raph on 23/01/25.
+//
+
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "../core/ThreadPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FRUSTUM_CULLER_SSE2 1
+#endif
+
+namespace {
+    glm::vec4 row(const glm::mat4& m, int index) {
+        return {m[0][index], m[1][index], m[2][index], m[3][index]};
+    }
+
+    // Planes scaled to a unit normal, so that their distances can be compared with lengths
+    glm::vec4 normalizePlane(const glm::vec4& plane) {
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        return length > 0.0f ? plane * (1.0f / length) : plane;
+    }
+
+    /**
+     * Coordinate arrays of the corner of each box that lies furthest along the plane normal: when even that
+     * corner is behind the plane, the whole box is
+     */
+    struct PlaneTest {
+        const float* x;
+        const float* y;
+        const float* z;
+        glm::vec4 plane;
+    };
+
+    std::array<PlaneTest, 6> makeTests(const Frustum& frustum, const ChunkBounds& bounds) {
+        std::array<PlaneTest, 6> tests{};
+        for (size_t p = 0; p < tests.size(); p++) {
+            const glm::vec4& plane = frustum.planes[p];
+            tests[p].x = plane.x >= 0.0f ? bounds.maxX.data() : bounds.minX.data();
+            tests[p].y = plane.y >= 0.0f ? bounds.maxY.data() : bounds.minY.data();
+            tests[p].z = plane.z >= 0.0f ? bounds.maxZ.data() : bounds.minZ.data();
+            tests[p].plane = plane;
+        }
+        return tests;
+    }
+}
+
+Frustum Frustum::fromViewProjection(const glm::mat4& viewProjection) {
+    const glm::vec4 x = row(viewProjection, 0);
+    const glm::vec4 y = row(viewProjection, 1);
+    const glm::vec4 z = row(viewProjection, 2);
+    const glm::vec4 w = row(viewProjection, 3);
+
+    Frustum frustum{};
+    frustum.planes = {
+        normalizePlane(w + x),      // left
+        normalizePlane(w - x),      // right
+        normalizePlane(w + y),      // bottom
+        normalizePlane(w - y),      // top
+        normalizePlane(z),          // near, depth starts at 0
+        normalizePlane(w - z),      // far
+    };
+    return frustum;
+}
+
+void ChunkBounds::resize(size_t count) {
+    for (auto* coordinate : {&minX, &minY, &minZ, &maxX, &maxY, &maxZ}) {
+        coordinate->resize(count);
+    }
+}
+
+void ChunkBounds::set(size_t chunk, const std::array<float, 3>& low, const std::array<float, 3>& high) {
+    minX[chunk] = low[0];
+    minY[chunk] = low[1];
+    minZ[chunk] = low[2];
+    maxX[chunk] = high[0];
+    maxY[chunk] = high[1];
+    maxZ[chunk] = high[2];
+}
+
+void ChunkBounds::include(const ChunkBounds& other) {
+    for (size_t chunk = 0; chunk < size(); chunk++) {
+        minX[chunk] = std::min(minX[chunk], other.minX[chunk]);
+        minY[chunk] = std::min(minY[chunk], other.minY[chunk]);
+        minZ[chunk] = std::min(minZ[chunk], other.minZ[chunk]);
+        maxX[chunk] = std::max(maxX[chunk], other.maxX[chunk]);
+        maxY[chunk] = std::max(maxY[chunk], other.maxY[chunk]);
+        maxZ[chunk] = std::max(maxZ[chunk], other.maxZ[chunk]);
+    }
+}
+
+float ChunkBounds::distance(size_t chunk, const glm::vec3& point) const {
+    const glm::vec3 gap(std::max({minX[chunk] - point.x, point.x - maxX[chunk], 0.0f}),
+                        std::max({minY[chunk] - point.y, point.y - maxY[chunk], 0.0f}),
+                        std::max({minZ[chunk] - point.z, point.z - maxZ[chunk], 0.0f}));
+    return glm::length(gap);
+}
+
+void FrustumCuller::cull(const Frustum& frustum, const ChunkBounds& bounds, std::vector<uint32_t>& visible) {
+    // About four ranges per thread, so one slow thread does not hold the others back
+    const size_t count = bounds.size();
+    const size_t grain = std::max(MIN_GRAIN, count / (4 * ThreadPool::global().getConcurrency()));
+    const size_t rangeCount = (count + grain - 1) / grain;
+    if (rangeVisible.size() < rangeCount) {
+        rangeVisible.resize(rangeCount);
+    }
+
+    // Ranges are aligned on the grain, so each one knows its output slot
+    ThreadPool::global().parallelFor(0, count, grain, [&](size_t begin, size_t end) {
+        auto& output = rangeVisible[begin / grain];
+        output.clear();
+        cullRange(frustum, bounds, begin, end, output);
+    });
+
+    visible.clear();
+    for (size_t range = 0; range < rangeCount; range++) {
+        visible.insert(visible.end(), rangeVisible[range].begin(), rangeVisible[range].end());
+    }
+}
+
+void FrustumCuller::cullRange(const Frustum& frustum, const ChunkBounds& bounds, size_t begin, size_t end,
+                              std::vector<uint32_t>& visible) {
+    const auto tests = makeTests(frustum, bounds);
+
+    size_t i = begin;
+#ifdef FRUSTUM_CULLER_SSE2
+    // Four boxes per iteration, a box is outside as soon as one plane rejects it. A NaN distance compares false,
+    // so the box is kept
+    for (; i + 4 <= end; i += 4) {
+        __m128 outside = _mm_setzero_ps();
+        for (const auto& test : tests) {
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(test.plane.x), _mm_loadu_ps(test.x + i)),
+                           _mm_mul_ps(_mm_set1_ps(test.plane.y), _mm_loadu_ps(test.y + i))),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(test.plane.z), _mm_loadu_ps(test.z + i)),
+                           _mm_set1_ps(test.plane.w)));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+        }
+
+        int inside = ~_mm_movemask_ps(outside) & 0xF;
+        while (inside != 0) {
+            int lane = std::countr_zero(static_cast<unsigned>(inside));
+            visible.push_back(static_cast<uint32_t>(i + lane));
+            inside &= inside - 1;
+        }
+    }
+#endif
+
+    for (; i < end; i++) {
+        bool inside = true;
+        for (const auto& test : tests) {
+            float distance = test.plane.x * test.x[i] + test.plane.y * test.y[i] + test.plane.z * test.z[i] + test.plane.w;
+            inside = inside && !(distance < 0.0f);
+        }
+        if (inside) {
+            visible.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
@@ -0,0 +1,76 @@
+//
+// Created by raph on 23/01/25.
+//
+
+#ifndef FRUSTUMCULLER_H
+#define FRUSTUMCULLER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * Planes of a view frustum, a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for every plane
+ */
+struct Frustum {
+    std::array<glm::vec4, 6> planes;
+
+    /**
+     * Extract the planes from a world to clip matrix with Vulkan depth in [0, 1]
+     */
+    static Frustum fromViewProjection(const glm::mat4& viewProjection);
+};
+
+/**
+ * Axis aligned boxes stored as structure of arrays, so that four of them load as one vector per coordinate
+ */
+struct ChunkBounds {
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    void resize(size_t count);
+    size_t size() const { return minX.size(); }
+
+    void set(size_t chunk, const std::array<float, 3>& low, const std::array<float, 3>& high);
+
+    /**
+     * Grow every box to also hold the box of the same chunk in other, which must have as many
+     */
+    void include(const ChunkBounds& other);
+
+    /**
+     * Distance from point to the nearest point of a box, 0 inside it
+     */
+    float distance(size_t chunk, const glm::vec3& point) const;
+};
+
+/**
+ * Tests chunk bounds against a frustum, four boxes per SSE instruction, split over the global thread pool.
+ * Each range of chunks collects its visible chunks separately, then the lists are joined in chunk order.
+ */
+class FrustumCuller {
+public:
+    /**
+     * Fewest chunks per thread pool range, below this scheduling a range costs more than testing its boxes
+     */
+    static constexpr size_t MIN_GRAIN = 256;
+
+    /**
+     * Replace visible with the indices of the boxes that intersect the frustum, in increasing order.
+     * Boxes straddling a plane are kept: the test is conservative, so are boxes with NaN bounds
+     */
+    void cull(const Frustum& frustum, const ChunkBounds& bounds, std::vector<uint32_t>& visible);
+
+    /**
+     * Same test on the calling thread only: append the visible boxes of [begin, end) to visible
+     */
+    static void cullRange(const Frustum& frustum, const ChunkBounds& bounds, size_t begin, size_t end,
+                          std::vector<uint32_t>& visible);
+
+private:
+    std::vector<std::vector<uint32_t>> rangeVisible;
+};
+
+#endif //FRUSTUMCULLER_H
@@ -0,0 +1,277 @@
+//
+// Created by raph on 22/01/25.
+//
+
+#include "StarScene.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "../core/ThreadPool.h"
+
+namespace {
+    constexpr uint32_t MERGE_FACTOR = 8;
+    constexpr uint32_t MORTON_BITS = 10;
+
+    // Spread the low 10 bits of v so that there are two zero bits between each
+    uint32_t spreadBits(uint32_t v) {
+        v = (v | (v << 16)) & 0x030000FF;
+        v = (v | (v << 8)) & 0x0300F00F;
+        v = (v | (v << 4)) & 0x030C30C3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+
+    float distance(const float* a, const float* b) {
+        float dx = a[0] - b[0];
+        float dy = a[1] - b[1];
+        float dz = a[2] - b[2];
+        return std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+StarScene::StarScene(uint32_t starCount, const StarLodConfig& config)
+    : config(config)
+    , starCount(starCount)
+    , levelCount(std::clamp<uint32_t>(config.levelCount, 1, MAX_LEVELS))
+    , logger("StarScene") {
+
+    chunks.resize(StarPacking::chunkCount(starCount));
+    bounds.resize(chunks.size());
+    for (size_t c = 0; c < chunks.size(); c++) {
+        Chunk& chunk = chunks[c];
+        chunk.firstPoint = pointCount;
+
+        uint32_t count = std::min<uint32_t>(StarPacking::CHUNK_SIZE, starCount - c * StarPacking::CHUNK_SIZE);
+        for (uint32_t level = 0; level < levelCount; level++) {
+            chunk.levelOffset[level] = chunk.pointCount;
+            chunk.levelCount[level] = count;
+            chunk.pointCount += count;
+            count = (count + MERGE_FACTOR - 1) / MERGE_FACTOR;
+        }
+        pointCount += chunk.pointCount;
+    }
+
+    order.resize(starCount);
+    pointPositions.resize(size_t(pointCount) * 3);
+    pointBrightness.resize(pointCount);
+    pointAppearance.resize(pointCount);
+    visibleChunks.reserve(chunks.size());
+    otherVisibleChunks.reserve(chunks.size());
+    ranges.reserve(chunks.size());
+}
+
+void StarScene::build(const float* positions, const StarPacking::Appearance* appearance) {
+    auto start = std::chrono::steady_clock::now();
+    sortStars(positions);
+
+    ThreadPool::global().parallelFor(0, chunks.size(), 1, [&](size_t firstChunk, size_t lastChunk) {
+        for (size_t c = firstChunk; c < lastChunk; c++) {
+            const Chunk& chunk = chunks[c];
+            const uint32_t* stars = order.data() + c * StarPacking::CHUNK_SIZE;
+
+            for (uint32_t i = 0; i < chunk.levelCount[0]; i++) {
+                uint32_t point = chunk.firstPoint + i;
+                pointAppearance[point] = appearance[stars[i]];
+                pointBrightness[point] = StarPacking::brightness(StarPacking::decodeLuminosity(appearance[stars[i]].magnitude));
+            }
+
+            // The drawn brightness adds up, not the luminosity it is compressed from. The color index is averaged
+            // with brightness weights (it is linear in log T)
+            uint32_t starsPerPoint = 1;
+            for (uint32_t level = 1; level < levelCount; level++) {
+                uint32_t children = chunk.firstPoint + chunk.levelOffset[level - 1];
+                uint32_t childCount = chunk.levelCount[level - 1];
+                starsPerPoint *= MERGE_FACTOR;
+
+                for (uint32_t i = 0; i < chunk.levelCount[level]; i++) {
+                    uint32_t first = children + i * MERGE_FACTOR;
+                    uint32_t last = children + std::min(childCount, (i + 1) * MERGE_FACTOR);
+
+                    float brightness = 0.0f;
+                    float weightedIndex = 0.0f;
+                    for (uint32_t child = first; child < last; child++) {
+                        brightness += pointBrightness[child];
+                        weightedIndex += pointBrightness[child] * pointAppearance[child].temperatureIndex;
+                    }
+
+                    // Stored as the mean over the merged stars, the shaders multiply it back by their count
+                    uint32_t point = chunk.firstPoint + chunk.levelOffset[level] + i;
+                    uint32_t merged = std::min(starsPerPoint, chunk.levelCount[0] - i * starsPerPoint);
+                    pointBrightness[point] = brightness;
+                    pointAppearance[point].temperatureIndex = static_cast<uint8_t>(
+                        std::lround(brightness > 0.0f ? weightedIndex / brightness : pointAppearance[first].temperatureIndex));
+                    pointAppearance[point].magnitude = StarPacking::encodeMagnitude(
+                        StarPacking::brightnessLuminosity(brightness / static_cast<float>(merged)));
+                }
+            }
+        }
+    });
+
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    logger.info("Built " + std::to_string(levelCount) + " levels over " + std::to_string(chunks.size()) +
+                " chunks (" + std::to_string(pointCount) + " points) in " + std::to_string(elapsed) + " ms");
+}
+
+void StarScene::sortStars(const float* positions) {
+    std::array<float, 3> low{}, high{};
+    for (int axis = 0; axis < 3; axis++) {
+        low[axis] = std::numeric_limits<float>::max();
+        high[axis] = std::numeric_limits<float>::lowest();
+    }
+    for (uint32_t i = 0; i < starCount; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            low[axis] = std::min(low[axis], positions[3 * i + axis]);
+            high[axis] = std::max(high[axis], positions[3 * i + axis]);
+        }
+    }
+
+    // Stable sort by Morton code, stars of the same cell stay in index order
+    const float cells = static_cast<float>(1u << MORTON_BITS);
+    std::vector<uint32_t> codes(starCount);
+    ThreadPool::global().parallelFor(0, starCount, 65536, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            uint32_t code = 0;
+            for (int axis = 0; axis < 3; axis++) {
+                float extent = std::max(high[axis] - low[axis], 1e-6f);
+                float t = (positions[3 * i + axis] - low[axis]) / extent;
+                auto cell = static_cast<uint32_t>(std::clamp(t * cells, 0.0f, cells - 1.0f));
+                code |= spreadBits(cell) << axis;
+            }
+            codes[i] = code;
+            order[i] = static_cast<uint32_t>(i);
+        }
+    });
+
+    sorter.sort(codes.data(), order.data(), starCount, 3 * MORTON_BITS);
+}
+
+void StarScene::update(const float* positions) {
+    positionsVersion++;
+    ThreadPool::global().parallelFor(0, chunks.size(), 1, [&](size_t firstChunk, size_t lastChunk) {
+        thread_local std::vector<float> spreads;
+
+        for (size_t c = firstChunk; c < lastChunk; c++) {
+            Chunk& chunk = chunks[c];
+            const uint32_t* stars = order.data() + c * StarPacking::CHUNK_SIZE;
+            float* points = pointPositions.data() + size_t(chunk.firstPoint) * 3;
+            spreads.assign(chunk.pointCount, 0.0f);
+
+            std::array<float, 3> low = {positions[3 * stars[0]], positions[3 * stars[0] + 1], positions[3 * stars[0] + 2]};
+            std::array<float, 3> high = low;
+            for (uint32_t i = 0; i < chunk.levelCount[0]; i++) {
+                for (int axis = 0; axis < 3; axis++) {
+                    float value = positions[3 * size_t(stars[i]) + axis];
+                    points[3 * i + axis] = value;
+                    low[axis] = std::min(low[axis], value);
+                    high[axis] = std::max(high[axis], value);
+                }
+            }
+            for (int axis = 0; axis < 3; axis++) {
+                chunk.center[axis] = 0.5f * (low[axis] + high[axis]);
+            }
+            bounds.set(c, low, high);
+            chunk.spread[0] = 0.0f;
+
+            for (uint32_t level = 1; level < levelCount; level++) {
+                uint32_t children = chunk.levelOffset[level - 1];
+                uint32_t childCount = chunk.levelCount[level - 1];
+                float levelSpread = 0.0f;
+
+                for (uint32_t i = 0; i < chunk.levelCount[level]; i++) {
+                    uint32_t first = children + i * MERGE_FACTOR;
+                    uint32_t last = children + std::min(childCount, (i + 1) * MERGE_FACTOR);
+                    uint32_t point = chunk.levelOffset[level] + i;
+                    const float* brightness = pointBrightness.data() + chunk.firstPoint;
+
+                    std::array<float, 3> center{};
+                    float weight = 0.0f;
+                    for (uint32_t child = first; child < last; child++) {
+                        for (int axis = 0; axis < 3; axis++) {
+                            center[axis] += brightness[child] * points[3 * child + axis];
+                        }
+                        weight += brightness[child];
+                    }
+                    for (int axis = 0; axis < 3; axis++) {
+                        points[3 * point + axis] = weight > 0.0f ? center[axis] / weight : points[3 * first + axis];
+                    }
+
+                    // Bound of the distance from any merged star to the point
+                    float spread = 0.0f;
+                    for (uint32_t child = first; child < last; child++) {
+                        spread = std::max(spread, spreads[child] + distance(points + 3 * child, points + 3 * point));
+                    }
+                    spreads[point] = spread;
+                    levelSpread += spread;
+                }
+
+                // Typical rather than worst case: a single stray star should not keep the whole chunk at full detail
+                chunk.spread[level] = levelSpread / static_cast<float>(chunk.levelCount[level]);
+            }
+        }
+    });
+}
+
+void StarScene::widenBounds(const ChunkBounds& other) {
+    bounds.include(other);
+}
+
+const std::vector<StarDrawRange>& StarScene::select(const glm::mat4& viewProjection, const glm::vec3& eye,
+                                                    float viewportHeight) {
+    selectedPointCount = selectInto(viewProjection, eye, viewportHeight, visibleChunks, ranges);
+    return ranges;
+}
+
+void StarScene::select(const glm::mat4& viewProjection, const glm::vec3& eye, float viewportHeight,
+                       std::vector<StarDrawRange>& selection) {
+    selectInto(viewProjection, eye, viewportHeight, otherVisibleChunks, selection);
+}
+
+uint64_t StarScene::selectInto(const glm::mat4& viewProjection, const glm::vec3& eye, float viewportHeight,
+                               std::vector<uint32_t>& visible, std::vector<StarDrawRange>& selection) {
+    // Pixels per world unit at a distance of 1, from the rows of the matrix that produce clip x and y
+    glm::vec3 rowX(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0]);
+    glm::vec3 rowY(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1]);
+    const float pixelScale = 0.5f * viewportHeight * std::max(glm::length(rowX), glm::length(rowY));
+
+    culler.cull(Frustum::fromViewProjection(viewProjection), bounds, visible);
+
+    float threshold = config.pixelThreshold;
+    uint64_t pointTotal = 0;
+    for (int attempt = 0; attempt < 16; attempt++) {
+        selection.clear();
+        pointTotal = 0;
+
+        for (uint32_t c : visible) {
+            const Chunk& chunk = chunks[c];
+
+            // From the nearest star the chunk can hold, so the part close to the camera decides. With the eye inside
+            // the bounds, some stars are arbitrarily close: full detail
+            uint32_t level = 0;
+            float distance = bounds.distance(c, eye);
+            if (distance > 0.0f) {
+                float pixelsPerUnit = pixelScale / distance;
+                level = levelCount - 1;
+                while (level > 0 && chunk.spread[level] * pixelsPerUnit > threshold) {
+                    level--;
+                }
+            }
+
+            const uint32_t firstPoint = chunk.firstPoint + chunk.levelOffset[level];
+            const uint32_t starsPerPoint = 1u << (3 * level);
+            const StarMerge merge{firstPoint + chunk.levelCount[level] - 1, starsPerPoint,
+                                  chunk.levelCount[0] - (chunk.levelCount[level] - 1) * starsPerPoint};
+            selection.push_back({c, firstPoint, chunk.levelCount[level], merge});
+            pointTotal += chunk.levelCount[level];
+        }
+
+        if (pointTotal <= config.maxPrimitives) {
+            break;
+        }
+        threshold *= 2.0f;
+    }
+
+    return pointTotal;
+}
@@ -0,0 +1,175 @@
+//
+// Created by raph on 22/01/25.
+//
+
+#ifndef STARSCENE_H
+#define STARSCENE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "FrustumCuller.h"
+#include "../core/Logger.h"
+#include "../core/RadixSort.h"
+#include "../renderer/StarPacking.h"
+
+struct StarLodConfig {
+    uint32_t levelCount = 5;                // level 0 is the stars themselves, each level merges 8 points
+    float pixelThreshold = 1.0f;            // coarsest level whose points are merged over less than this
+    uint64_t maxPrimitives = 4'000'000;     // the threshold is raised until the selection fits
+};
+
+/**
+ * Stars merged into the points of a draw. Every point merges starsPerPoint stars but the last one of a level, which
+ * can merge fewer. The shaders multiply the light of a point by its count (see star_appearance.glsl)
+ */
+struct StarMerge {
+    uint32_t lastPoint;
+    uint32_t starsPerPoint;
+    uint32_t lastPointStars;
+
+    bool operator==(const StarMerge&) const = default;
+};
+
+/**
+ * Draw command for one chunk at its selected level, in points of the scene
+ */
+struct StarDrawRange {
+    uint32_t chunk;
+    uint32_t firstPoint;
+    uint32_t pointCount;
+    StarMerge merge;
+
+    bool operator==(const StarDrawRange&) const = default;
+};
+
+/**
+ * Spatial organization of the stars between the particle data and the renderer.
+ *
+ * Stars are sorted along a Morton curve and cut in chunks of StarPacking::CHUNK_SIZE consecutive stars, so each
+ * chunk is a compact region. Every chunk stores a hierarchy of levels: level k merges groups of 8 consecutive points
+ * of level k - 1 (nearby along the curve) into one aggregated point at their light weighted center, with their light
+ * weighted color. The shaders compress the luminosity of a star into the brightness they draw, so an aggregate stores
+ * the mean brightness of its stars and is drawn times their count (StarMerge): its light is the sum of what its stars
+ * would have drawn. Each frame, a chunk is drawn at the coarsest level whose merged points stay below a pixel, so
+ * far regions cost a handful of points. Chunks outside the view frustum are culled against their bounds first and
+ * not drawn at all.
+ *
+ * Points are stored chunk by chunk, all levels of a chunk next to each other, so a chunk packs with one frame.
+ * The hierarchy is built once; when stars move, only the positions of the points are recomputed.
+ */
+class StarScene {
+public:
+    static constexpr uint32_t MAX_LEVELS = 6;
+
+    StarScene(uint32_t starCount, const StarLodConfig& config = StarLodConfig());
+
+    /**
+     * Sort the stars and compute the appearance of every level
+     * @param positions interleaved xyz, in star order
+     * @param appearance in star order
+     */
+    void build(const float* positions, const StarPacking::Appearance* appearance);
+
+    /**
+     * Recompute the positions of every point, the chunk bounds and the level spreads
+     * @param positions interleaved xyz, in star order
+     */
+    void update(const float* positions);
+
+    /**
+     * Grow the chunk bounds to also hold bounds taken from other positions, so culling stays conservative for stars
+     * drawn anywhere between the two sets of positions
+     */
+    void widenBounds(const ChunkBounds& other);
+
+    /**
+     * Cull the chunks against the view and choose the level of every visible chunk, from its distance to the eye
+     * @param viewProjection world to clip space
+     * @param eye camera position, in world space
+     * @param viewportHeight in pixels
+     */
+    const std::vector<StarDrawRange>& select(const glm::mat4& viewProjection, const glm::vec3& eye, float viewportHeight);
+
+    /**
+     * Same, into selection: the selection of the scene and its counts stay those of the last select() above, for
+     * the views drawn next to the frame one
+     */
+    void select(const glm::mat4& viewProjection, const glm::vec3& eye, float viewportHeight,
+                std::vector<StarDrawRange>& selection);
+
+    uint32_t getStarCount() const { return starCount; }
+    uint32_t getPointCount() const { return pointCount; }
+    size_t getChunkCount() const { return chunks.size(); }
+    uint32_t getLevelCount() const { return levelCount; }
+
+    /**
+     * Points of a chunk: [first, first + count), the first starCount of them being level 0
+     */
+    uint32_t getChunkFirstPoint(size_t chunk) const { return chunks[chunk].firstPoint; }
+    uint32_t getChunkPointCount(size_t chunk) const { return chunks[chunk].pointCount; }
+    uint32_t getChunkStarCount(size_t chunk) const { return chunks[chunk].levelCount[0]; }
+
+    const float* getPointPositions() const { return pointPositions.data(); }
+    const StarPacking::Appearance* getPointAppearance() const { return pointAppearance.data(); }
+
+    const ChunkBounds& getChunkBounds() const { return bounds; }
+    glm::vec3 getChunkCenter(size_t chunk) const {
+        return {chunks[chunk].center[0], chunks[chunk].center[1], chunks[chunk].center[2]};
+    }
+
+    /**
+     * Incremented by every update(), to know whether anything derived from the positions is stale
+     */
+    uint64_t getPositionsVersion() const { return positionsVersion; }
+
+    /**
+     * Primitives drawn by the last selection
+     */
+    uint64_t getSelectedPointCount() const { return selectedPointCount; }
+    size_t getVisibleChunkCount() const { return visibleChunks.size(); }
+
+private:
+    struct Chunk {
+        uint32_t firstPoint = 0;
+        uint32_t pointCount = 0;
+        std::array<uint32_t, MAX_LEVELS> levelOffset{};     // relative to firstPoint
+        std::array<uint32_t, MAX_LEVELS> levelCount{};
+        std::array<float, MAX_LEVELS> spread{};             // mean distance from merged stars to their point
+        std::array<float, 3> center{};
+    };
+
+    void sortStars(const float* positions);
+
+    /**
+     * @return primitives of the selection
+     */
+    uint64_t selectInto(const glm::mat4& viewProjection, const glm::vec3& eye, float viewportHeight,
+                        std::vector<uint32_t>& visible, std::vector<StarDrawRange>& selection);
+
+    StarLodConfig config;
+    uint32_t starCount;
+    uint32_t levelCount;
+    uint32_t pointCount = 0;
+    uint64_t positionsVersion = 0;
+
+    std::vector<Chunk> chunks;
+    ChunkBounds bounds;                                     // of the stars of each chunk, the aggregates lie inside
+    std::vector<uint32_t> order;                            // level 0 point -> star
+    RadixSorter sorter;
+    std::vector<float> pointPositions;                      // xyz
+    std::vector<float> pointBrightness;                     // summed over the merged stars
+    std::vector<StarPacking::Appearance> pointAppearance;
+
+    FrustumCuller culler;
+    std::vector<uint32_t> visibleChunks;
+    std::vector<uint32_t> otherVisibleChunks;              // of the selections into a given vector
+    std::vector<StarDrawRange> ranges;
+    uint64_t selectedPointCount = 0;
+    Logger logger;
+};
+
+#endif //STARSCENE_H
@@ -0,0 +1,26 @@
+// Shared by the passes of the bloom, see Bloom.h
+
+const uint BLOOM_GROUP_SIZE = 8;                // local_size_x and local_size_y of every pass
+
+layout(set = 0, binding = 0) uniform sampler2D source;
+layout(set = 0, binding = 1, rgba16f) uniform image2D destination;
+
+layout(push_constant) uniform BloomPass {
+    float threshold;
+    float knee;
+    uint prefilter;     // 1 when the source is the HDR target
+    uint padding;
+} bloomPass;
+
+// Center of a destination texel in the normalized coordinates of the source
+vec2 destinationUv(ivec2 texel) {
+    return (vec2(texel) + 0.5) / vec2(imageSize(destination));
+}
+
+// Keep what is brighter than the threshold, with a quadratic knee below it so stars do not pop in
+vec3 thresholded(vec3 color) {
+    float brightness = max(color.r, max(color.g, color.b));
+    float soft = clamp(brightness - bloomPass.threshold + bloomPass.knee, 0.0, 2.0 * bloomPass.knee);
+    soft = soft * soft / (4.0 * bloomPass.knee + 1e-4);
+    return color * max(soft, brightness - bloomPass.threshold) / max(brightness, 1e-4);
+}
@@ -0,0 +1,9 @@
+// Per frame view data, see FrameUniforms.h
+
+layout(set = 1, binding = 0) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 position;
+    vec4 viewport;      // width, height, pixels per unit at distance 1
+} camera;
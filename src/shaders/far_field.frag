@@ -0,0 +1,24 @@
+#version 450
+
+// Stars far from the eye, drawn when the cache was last refreshed (see FarFieldCache.h)
+layout(set = 2, binding = 0) uniform sampler2D cache;
+
+layout(push_constant) uniform FarFieldConstants {
+    mat4 reprojection;      // clip space of the frame to the one of the cache
+} constants;
+
+layout(location = 0) in vec2 fragUv;
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // The far plane of the pixel, exact for a turning camera; the parallax of a moving one is bounded by the cache
+    vec4 cached = constants.reprojection * vec4(fragUv * 2.0 - 1.0, 1.0, 1.0);
+    vec2 uv = cached.xy / cached.w * 0.5 + 0.5;
+    if (cached.w <= 0.0 || any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0)))) {
+        outColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    // Blended additively with the near stars
+    outColor = vec4(textureLod(cache, uv, 0.0).rgb, 1.0);
+}
@@ -0,0 +1,16 @@
+// Emission texture of the galaxy, see GalaxyVolume.h
+
+// 3 words per voxel, r g b in fixed point
+layout(std430, set = 2, binding = 1) buffer Accumulation {
+    uint accumulation[];
+};
+
+// Fractional steps of the fixed point colors: a voxel holds 16M suns before it wraps
+const float VOLUME_SPLAT_SCALE = 256.0;
+
+// Light of a voxel in the texture, scaled down to stay in the range of half floats
+const float VOLUME_TEXTURE_SCALE = 1.0 / 64.0;
+
+uint voxelIndex(uvec3 voxel, uvec3 resolution) {
+    return (voxel.z * resolution.y + voxel.y) * resolution.x + voxel.x;
+}
@@ -0,0 +1,49 @@
+#version 450
+
+layout(set = 2, binding = 5) uniform sampler2D march;
+
+layout(push_constant) uniform CompositeConstants {
+    mat4 inverseViewProjection;
+    vec4 eye;               // w is the height of the disk plane
+    vec4 viewport;          // width, height
+} constants;
+
+layout(location = 0) out vec4 outColor;
+
+// Depth where the ray of the pixel crosses the disk plane, or 0 when it does not
+float planeDepth(vec2 uv) {
+    vec4 far = constants.inverseViewProjection * vec4(uv * 2.0 - 1.0, 1.0, 1.0);
+    vec3 direction = normalize(far.xyz / far.w - constants.eye.xyz);
+    if (abs(direction.z) < 1e-4) {
+        return 0.0;
+    }
+    return max((constants.eye.w - constants.eye.z) / direction.z, 0.0);
+}
+
+void main() {
+    // Bilinear taps of the low resolution march, weighted down when their depth is far from the one of the disk
+    // at this pixel, so the edges of the disk stay sharp over the bulge. Pixels that miss the plane are bilinear
+    vec2 uv = gl_FragCoord.xy / constants.viewport.xy;
+    float guide = planeDepth(uv);
+
+    ivec2 size = textureSize(march, 0);
+    vec2 position = uv * vec2(size) - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = position - vec2(base);
+
+    vec3 color = vec3(0.0);
+    float totalWeight = 0.0;
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            vec4 tap = texelFetch(march, clamp(base + ivec2(x, y), ivec2(0), size - 1), 0);
+            float bilinear = (x == 1 ? f.x : 1.0 - f.x) * (y == 1 ? f.y : 1.0 - f.y);
+            float depthWeight = guide > 0.0 ? 1.0 / (1e-3 + abs(tap.a - guide) / guide) : 1.0;
+            float weight = bilinear * depthWeight;
+            color += tap.rgb * weight;
+            totalWeight += weight;
+        }
+    }
+
+    // Blended additively over the clear color like the stars
+    outColor = vec4(totalWeight > 0.0 ? color / totalWeight : vec3(0.0), 1.0);
+}
@@ -0,0 +1,25 @@
+// Packed stars read in place from the pulled star stream, see StarPacking.h
+
+// x and y snorm, then z snorm and the two appearance bytes
+layout(std430, set = 2, binding = 0) readonly buffer PackedStars {
+    uvec2 stars[];
+};
+
+vec3 starSnorm(uvec2 star) {
+    return vec3(unpackSnorm2x16(star.x), unpackSnorm2x16(star.y).x);
+}
+
+vec3 starPosition(uvec2 star, vec3 chunkCenter, vec3 chunkHalfExtent) {
+    return chunkCenter + starSnorm(star) * chunkHalfExtent;
+}
+
+// Between the previous simulation state of the point, previousPoints records further, and its current one
+vec3 blendedStarPosition(uint point, vec3 chunkCenter, vec3 chunkHalfExtent, float blend, uint previousPoints) {
+    vec3 snorm = mix(starSnorm(stars[point + previousPoints]), starSnorm(stars[point]), blend);
+    return chunkCenter + snorm * chunkHalfExtent;
+}
+
+// Palette index, magnitude
+uvec2 starAppearance(uvec2 star) {
+    return uvec2((star.y >> 16) & 0xFFu, star.y >> 24);
+}
@@ -0,0 +1,27 @@
+// Shared by the passes of the GPU radix sort, see GpuRadixSort.h
+
+const uint RADIX_BITS = 11;
+const uint RADIX_BUCKETS = 1u << RADIX_BITS;
+const uint RADIX_THREADS = 256;                 // local_size_x of every pass
+const uint RADIX_ITEMS = 16;                    // pairs per thread and block
+const uint RADIX_BLOCK = RADIX_THREADS * RADIX_ITEMS;
+
+// 64 bit keys as (low, high) words
+layout(set = 0, binding = 0) readonly buffer SourceKeys { uvec2 sourceKeys[]; };
+layout(set = 0, binding = 1) readonly buffer SourceValues { uint sourceValues[]; };
+layout(set = 0, binding = 2) writeonly buffer DestinationKeys { uvec2 destinationKeys[]; };
+layout(set = 0, binding = 3) writeonly buffer DestinationValues { uint destinationValues[]; };
+
+// Digit counts, then output offsets, digit major: [digit * blockCount + block]
+layout(set = 0, binding = 4) buffer Histograms { uint histograms[]; };
+
+layout(push_constant) uniform RadixPass {
+    uint count;
+    uint word;          // 0 sorts on the low word of the keys, 1 on the high one
+    uint shift;         // of the digit in the word
+    uint blockCount;
+} radixPass;
+
+uint digitOf(uvec2 key) {
+    return ((radixPass.word == 0 ? key.x : key.y) >> radixPass.shift) & (RADIX_BUCKETS - 1);
+}
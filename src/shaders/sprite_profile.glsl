@@ -0,0 +1,12 @@
+// Radial falloff of the star sprites
+
+// Gaussian reaching 0 at the edge, so the corners of the sprite stay black
+// @param offset from the center of the sprite, 1 at the edge
+float spriteFalloff(vec2 offset) {
+    const float EDGE = exp(-4.0);
+    float falloff = exp(-4.0 * dot(offset, offset));
+    return max(falloff - EDGE, 0.0) / (1.0 - EDGE);
+}
+
+// Integral of spriteFalloff over the unit disk: a sprite of radius r pixels adds its color times this and r^2
+const float SPRITE_FLUX = 0.7268;
@@ -0,0 +1,30 @@
+// Decoding of the packed star appearance, see StarPacking.h
+
+layout(set = 0, binding = 0) uniform StarPalette {
+    vec4 colors[256];
+} palette;
+
+const float MIN_MAGNITUDE = -15.0;
+const float MAX_MAGNITUDE = 20.0;
+const float SUN_MAGNITUDE = 4.74;
+
+// In suns
+float starLuminosity(uvec2 appearance) {
+    float magnitude = mix(MIN_MAGNITUDE, MAX_MAGNITUDE, float(appearance.y) / 255.0);
+    return pow(10.0, 0.4 * (SUN_MAGNITUDE - magnitude));
+}
+
+vec3 starColor(uvec2 appearance) {
+    float luminosity = starLuminosity(appearance);
+
+    // Stars cover a single pixel: compress the luminosity range heavily so dwarfs stay visible. Giants go over 1
+    // in the HDR target, the tonemap brings them back and the bloom makes them glow. Same as StarPacking::brightness
+    float brightness = max(pow(luminosity, 0.125), 0.25);
+    return palette.colors[appearance.x].rgb * brightness;
+}
+
+// Stars merged into a point of the hierarchy (see StarMerge in StarScene.h), whose appearance is their mean
+// @param merge last point of the draw, stars per point, stars of the last point
+float mergedStars(uint point, uvec4 merge) {
+    return float(point == merge.x ? merge.z : merge.y);
+}
@@ -0,0 +1,9 @@
+// Accumulation of the splatted stars, see StarSplat.h
+
+// 3 words per pixel, r g b in fixed point
+layout(std430, set = 2, binding = 1) buffer Accumulation {
+    uint accumulation[];
+};
+
+// Fractional steps of the fixed point colors: a pixel holds 4M suns before it wraps
+const float SPLAT_SCALE = 1024.0;
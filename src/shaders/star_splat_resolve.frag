@@ -0,0 +1,17 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "star_splat.glsl"
+
+layout(push_constant) uniform ResolveConstants {
+    uint width;
+} constants;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Blended additively over the rasterized stars
+    uint base = 3u * (uint(gl_FragCoord.y) * constants.width + uint(gl_FragCoord.x));
+    vec3 color = vec3(accumulation[base], accumulation[base + 1u], accumulation[base + 2u]) / SPLAT_SCALE;
+    outColor = vec4(color, 1.0);
+}
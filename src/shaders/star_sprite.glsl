@@ -0,0 +1,17 @@
+// Screen size of the star sprites, see StarSpriteConfig. Needs camera.glsl and star_appearance.glsl
+
+// Dimmest a sprite gets when it is smaller than the minimum radius
+const float MIN_SPRITE_FADE = 0.1;
+
+// Radius in pixels of a star seen from the camera, from its luminosity and view depth
+// @param sprite world radius of a sun like star, then the min and max radius in pixels
+// @param fade to scale the color with, below 1 when the sprite would be smaller than the minimum
+float spriteRadius(vec3 position, uvec2 appearance, vec3 sprite, out float fade) {
+    float depth = max(-(camera.view * vec4(position, 1.0)).z, 1e-4);
+    float pixels = sprite.x * pow(starLuminosity(appearance), 0.25) * camera.viewport.z / depth;
+    float radius = clamp(pixels, sprite.y, sprite.z);
+
+    // The light of a star too small to cover the minimum radius is spread over it
+    fade = clamp(pixels * pixels / (radius * radius), MIN_SPRITE_FADE, 1.0);
+    return radius;
+}
@@ -0,0 +1,26 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "camera.glsl"
+#include "star_appearance.glsl"
+
+layout(location = 0) in vec4 inPosition;        // snorm, relative to the chunk frame
+layout(location = 1) in uvec2 inAppearance;     // palette index, magnitude
+layout(location = 2) in vec4 inPreviousPosition;    // snorm, the previous simulation state in the same frame
+
+layout(push_constant) uniform StarConstants {
+    vec4 chunkCenter;
+    vec4 chunkHalfExtent;
+    uvec4 merge;
+    float blend;        // 0 at the previous simulation state, 1 at the current one
+} constants;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    vec3 snorm = mix(inPreviousPosition.xyz, inPosition.xyz, constants.blend);
+    vec3 position = constants.chunkCenter.xyz + snorm * constants.chunkHalfExtent.xyz;
+    gl_Position = camera.viewProjection * vec4(position, 1.0);
+    gl_PointSize = 1.0;
+    fragColor = starColor(inAppearance) * mergedStars(uint(gl_VertexIndex), constants.merge);
+}
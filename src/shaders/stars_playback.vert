@@ -0,0 +1,22 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "camera.glsl"
+#include "star_appearance.glsl"
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in uvec2 inAppearance;
+layout(location = 2) in vec3 inNextPosition;
+
+layout(push_constant) uniform StarPlaybackConstants {
+    float blend;
+} constants;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    vec3 position = mix(inPosition, inNextPosition, constants.blend);
+    gl_Position = camera.viewProjection * vec4(position, 1.0);
+    gl_PointSize = 1.0;
+    fragColor = starColor(inAppearance);
+}
@@ -0,0 +1,45 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "camera.glsl"
+#include "star_appearance.glsl"
+
+// The three keyframe buffers of SnapshotPlayback, tightly packed xyz floats as they come from the snapshots
+layout(std430, set = 2, binding = 0) readonly buffer Keyframe0 { float positions[]; } keyframe0;
+layout(std430, set = 2, binding = 1) readonly buffer Keyframe1 { float positions[]; } keyframe1;
+layout(std430, set = 2, binding = 2) readonly buffer Keyframe2 { float positions[]; } keyframe2;
+
+// Two bytes per star, two stars per word
+layout(std430, set = 2, binding = 3) readonly buffer Appearance {
+    uint appearance[];
+};
+
+layout(push_constant) uniform StarPlaybackConstants {
+    float blend;
+    uint currentKeyframe;
+    uint nextKeyframe;
+} constants;
+
+layout(location = 0) out vec3 fragColor;
+
+vec3 keyframePosition(uint keyframe, uint star) {
+    uint i = 3u * star;
+    if (keyframe == 0u) {
+        return vec3(keyframe0.positions[i], keyframe0.positions[i + 1u], keyframe0.positions[i + 2u]);
+    }
+    if (keyframe == 1u) {
+        return vec3(keyframe1.positions[i], keyframe1.positions[i + 1u], keyframe1.positions[i + 2u]);
+    }
+    return vec3(keyframe2.positions[i], keyframe2.positions[i + 1u], keyframe2.positions[i + 2u]);
+}
+
+void main() {
+    uint star = uint(gl_VertexIndex);
+    vec3 position = mix(keyframePosition(constants.currentKeyframe, star),
+                        keyframePosition(constants.nextKeyframe, star), constants.blend);
+    uint bytes = appearance[star >> 1] >> ((star & 1u) * 16u);
+
+    gl_Position = camera.viewProjection * vec4(position, 1.0);
+    gl_PointSize = 1.0;
+    fragColor = starColor(uvec2(bytes & 0xFFu, (bytes >> 8) & 0xFFu));
+}
@@ -0,0 +1,12 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "sprite_profile.glsl"
+
+layout(location = 0) in vec3 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = vec4(fragColor * spriteFalloff(gl_PointCoord * 2.0 - 1.0), 1.0);
+}
@@ -0,0 +1,31 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "camera.glsl"
+#include "star_appearance.glsl"
+#include "packed_star.glsl"
+#include "star_sprite.glsl"
+
+layout(push_constant) uniform StarConstants {
+    vec4 chunkCenter;
+    vec4 chunkHalfExtent;
+    uvec4 merge;            // last point, stars per point, stars of the last point
+    float blend;            // 0 at the previous simulation state, 1 at the current one
+    uint previousPoints;    // records between a point and its previous state
+    vec4 sprite;            // radius, min and max pixels
+} constants;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    uvec2 star = stars[gl_VertexIndex];
+    vec3 position = blendedStarPosition(uint(gl_VertexIndex), constants.chunkCenter.xyz, constants.chunkHalfExtent.xyz,
+                                        constants.blend, constants.previousPoints);
+    uvec2 appearance = starAppearance(star);
+    float fade;
+    float radius = spriteRadius(position, appearance, constants.sprite.xyz, fade);
+
+    gl_Position = camera.viewProjection * vec4(position, 1.0);
+    gl_PointSize = 2.0 * radius;
+    fragColor = starColor(appearance) * (fade * mergedStars(uint(gl_VertexIndex), constants.merge));
+}
@@ -0,0 +1,26 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "camera.glsl"
+#include "star_appearance.glsl"
+#include "packed_star.glsl"
+
+layout(push_constant) uniform StarConstants {
+    vec4 chunkCenter;
+    vec4 chunkHalfExtent;
+    uvec4 merge;
+    float blend;            // 0 at the previous simulation state, 1 at the current one
+    uint previousPoints;    // records between a point and its previous state
+} constants;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    // gl_VertexIndex already includes the first point of the draw, or is the sorted index
+    uvec2 star = stars[gl_VertexIndex];
+    vec3 position = blendedStarPosition(uint(gl_VertexIndex), constants.chunkCenter.xyz, constants.chunkHalfExtent.xyz,
+                                        constants.blend, constants.previousPoints);
+    gl_Position = camera.viewProjection * vec4(position, 1.0);
+    gl_PointSize = 1.0;
+    fragColor = starColor(starAppearance(star)) * mergedStars(uint(gl_VertexIndex), constants.merge);
+}
@@ -0,0 +1,13 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "sprite_profile.glsl"
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragOffset;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = vec4(fragColor * spriteFalloff(fragOffset), 1.0);
+}
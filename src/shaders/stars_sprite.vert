@@ -0,0 +1,45 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "camera.glsl"
+#include "star_appearance.glsl"
+#include "packed_star.glsl"
+#include "star_sprite.glsl"
+
+layout(push_constant) uniform StarConstants {
+    vec4 chunkCenter;
+    vec4 chunkHalfExtent;
+    uvec4 merge;            // last point, stars per point, stars of the last point
+    float blend;            // 0 at the previous simulation state, 1 at the current one
+    uint previousPoints;    // records between a point and its previous state
+    vec4 sprite;            // radius, min and max pixels
+} constants;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragOffset;
+
+// Two triangles covering the sprite
+const vec2 CORNERS[6] = vec2[](
+    vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+    vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0)
+);
+
+void main() {
+    // Every star is read by its 6 vertices, the first vertex of the draw is 6 times its first star
+    uint point = uint(gl_VertexIndex) / 6u;
+    uvec2 star = stars[point];
+    vec2 corner = CORNERS[gl_VertexIndex % 6];
+
+    vec3 position = blendedStarPosition(point, constants.chunkCenter.xyz, constants.chunkHalfExtent.xyz,
+                                        constants.blend, constants.previousPoints);
+    uvec2 appearance = starAppearance(star);
+    float fade;
+    float radius = spriteRadius(position, appearance, constants.sprite.xyz, fade);
+
+    // Pixels to clip space, scaled by w to stay the same size after the perspective divide
+    vec4 center = camera.viewProjection * vec4(position, 1.0);
+    center.xy += corner * radius * 2.0 / camera.viewport.xy * center.w;
+    gl_Position = center;
+    fragColor = starColor(appearance) * (fade * mergedStars(point, constants.merge));
+    fragOffset = corner;
+}
@@ -0,0 +1,24 @@
+#version 450
+
+// HDR target and bloom to the swap chain, see Tonemap.h
+layout(set = 0, binding = 0) uniform sampler2D hdrColor;
+layout(set = 0, binding = 1) uniform sampler2D bloom;
+
+layout(push_constant) uniform TonemapConstants {
+    float exposure;
+    float bloomIntensity;
+} constants;
+
+layout(location = 0) in vec2 fragUv;
+
+layout(location = 0) out vec4 outColor;
+
+// Narkowicz's fit of the ACES filmic curve, the swap chain is sRGB so the result stays linear
+vec3 aces(vec3 color) {
+    return clamp(color * (2.51 * color + 0.03) / (color * (2.43 * color + 0.59) + 0.14), 0.0, 1.0);
+}
+
+void main() {
+    vec3 color = texture(hdrColor, fragUv).rgb + constants.bloomIntensity * texture(bloom, fragUv).rgb;
+    outColor = vec4(aces(constants.exposure * color), 1.0);
+}
@@ -0,0 +1,187 @@
+//
+// Created by raph on 08/01/25.
+//
+
+#include "BlockTimestepIntegrator.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+#include "../core/ThreadPool.h"
+
+BlockTimestepIntegrator::BlockTimestepIntegrator(GravitySolver& solver, const BlockTimestepConfig& config)
+    : solver(solver)
+    , config(config)
+    , logger("Integrator") {
+
+    if (config.maxLevel > 30) {
+        throw std::runtime_error("Block timestep levels are limited to 30");
+    }
+
+    substepsPerStep = uint64_t{1} << config.maxLevel;
+    finestTimestep = static_cast<double>(config.maxTimestep) / static_cast<double>(substepsPerStep);
+    levelOffsets.assign(config.maxLevel + 2, 0);
+}
+
+void BlockTimestepIntegrator::initialize(ParticleSet& particles, double startTime) {
+    time = startTime;
+    substepIndex = 0;
+    forceEvaluations = 0;
+
+    const size_t count = particles.size();
+    if (count == 0) {
+        std::fill(levelOffsets.begin(), levelOffsets.end(), 0);
+        return;
+    }
+
+    solver.computeAccelerations(particles, 0, count);
+    forceEvaluations += count;
+
+    for (size_t i = 0; i < count; i++) {
+        particles.timestepLevel[i] = chooseLevel(particles.ax[i], particles.ay[i], particles.az[i]);
+    }
+    sortByLevel(particles, count, 0);
+
+    // Opening half kick, every particle starts its first step now
+    const double maxTimestep = config.maxTimestep;
+    ThreadPool::global().parallelFor(0, count, 8192, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            float halfStep = static_cast<float>(0.5 * maxTimestep / static_cast<double>(1u << particles.timestepLevel[i]));
+            particles.vx[i] += particles.ax[i] * halfStep;
+            particles.vy[i] += particles.ay[i] * halfStep;
+            particles.vz[i] += particles.az[i] * halfStep;
+        }
+    });
+
+    std::string distribution;
+    for (uint32_t level = 0; level <= config.maxLevel; level++) {
+        size_t onLevel = levelOffsets[level] - levelOffsets[level + 1];
+        if (onLevel > 0) {
+            distribution += " L" + std::to_string(level) + "=" + std::to_string(onLevel);
+        }
+    }
+    LOG_DEBUG(logger, "Initial timestep levels:{}", distribution);
+}
+
+void BlockTimestepIntegrator::substep(ParticleSet& particles) {
+    const size_t count = particles.size();
+    if (count == 0) {
+        return;
+    }
+
+    // Drift everyone with their half kicked velocity
+    const float dt = static_cast<float>(finestTimestep);
+    ThreadPool::global().parallelFor(0, count, 16384, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            particles.x[i] += particles.vx[i] * dt;
+            particles.y[i] += particles.vy[i] * dt;
+            particles.z[i] += particles.vz[i] * dt;
+        }
+    });
+
+    substepIndex++;
+    time += finestTimestep;
+
+    const uint32_t lowestLevel = lowestActiveLevel(substepIndex);
+    const size_t activeCount = levelOffsets[lowestLevel];
+    if (substepIndex == substepsPerStep) {
+        substepIndex = 0;
+    }
+    if (activeCount == 0) {
+        return;
+    }
+
+    solver.computeAccelerations(particles, 0, activeCount);
+    forceEvaluations += activeCount;
+
+    // Closing kick of the step that just ended, then opening kick of the next one. A particle may only move
+    // to a level whose steps start now, which is any level >= lowestLevel
+    const double maxTimestep = config.maxTimestep;
+    ThreadPool::global().parallelFor(0, activeCount, 8192, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            float closingHalfStep = static_cast<float>(0.5 * maxTimestep / static_cast<double>(1u << particles.timestepLevel[i]));
+            uint8_t level = std::max<uint8_t>(chooseLevel(particles.ax[i], particles.ay[i], particles.az[i]),
+                                              static_cast<uint8_t>(lowestLevel));
+            float openingHalfStep = static_cast<float>(0.5 * maxTimestep / static_cast<double>(1u << level));
+            particles.timestepLevel[i] = level;
+
+            float kick = closingHalfStep + openingHalfStep;
+            particles.vx[i] += particles.ax[i] * kick;
+            particles.vy[i] += particles.ay[i] * kick;
+            particles.vz[i] += particles.az[i] * kick;
+        }
+    });
+
+    sortByLevel(particles, activeCount, lowestLevel);
+}
+
+void BlockTimestepIntegrator::getSynchronizedVelocity(const ParticleSet& particles, size_t i,
+                                                      float& vx, float& vy, float& vz) const {
+    // Opening half kick of the particle's step, minus the part of the step it already drifted through
+    const uint64_t stepSubsteps = substepsPerStep >> particles.timestepLevel[i];
+    const double elapsed = static_cast<double>(substepIndex % stepSubsteps) * finestTimestep;
+    const auto ahead = static_cast<float>(0.5 * static_cast<double>(stepSubsteps) * finestTimestep - elapsed);
+    vx = particles.vx[i] - particles.ax[i] * ahead;
+    vy = particles.vy[i] - particles.ay[i] * ahead;
+    vz = particles.vz[i] - particles.az[i] * ahead;
+}
+
+uint8_t BlockTimestepIntegrator::chooseLevel(float ax, float ay, float az) const {
+    float acceleration = std::sqrt(ax * ax + ay * ay + az * az);
+    if (acceleration <= 0.0f) {
+        return 0;
+    }
+
+    float wanted = std::sqrt(2.0f * config.accuracy * config.softening / acceleration);
+    float ratio = config.maxTimestep / wanted;
+    if (ratio <= 1.0f) {
+        return 0;
+    }
+    if (!std::isfinite(ratio)) {
+        // A NaN or infinite acceleration: the finest level, the cast below would be undefined
+        return static_cast<uint8_t>(config.maxLevel);
+    }
+
+    auto level = static_cast<uint32_t>(std::ceil(std::log2(ratio)));
+    return static_cast<uint8_t>(std::min(level, config.maxLevel));
+}
+
+uint32_t BlockTimestepIntegrator::lowestActiveLevel(uint64_t index) const {
+    // Level k steps end on multiples of 2^(maxLevel - k)
+    if (index % substepsPerStep == 0) {
+        return 0;
+    }
+    return config.maxLevel - static_cast<uint32_t>(std::countr_zero(index));
+}
+
+void BlockTimestepIntegrator::sortByLevel(ParticleSet& particles, size_t count, uint32_t lowestLevel) {
+    // Counting sort, levels are only 0..maxLevel. The prefix only ever holds levels >= lowestLevel
+    std::vector<size_t> histogram(config.maxLevel + 1, 0);
+    bool sorted = true;
+    for (size_t i = 0; i < count; i++) {
+        histogram[particles.timestepLevel[i]]++;
+        sorted = sorted && (i == 0 || particles.timestepLevel[i] <= particles.timestepLevel[i - 1]);
+    }
+
+    // Prefix offsets, highest level first
+    size_t running = 0;
+    std::vector<size_t> cursor(config.maxLevel + 1, 0);
+    for (int64_t level = config.maxLevel; level >= static_cast<int64_t>(lowestLevel); level--) {
+        cursor[level] = running;
+        running += histogram[level];
+        levelOffsets[level] = running;
+    }
+    levelOffsets[config.maxLevel + 1] = 0;
+
+    if (sorted) {
+        return;
+    }
+
+    order.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        order[cursor[particles.timestepLevel[i]]++] = static_cast<uint32_t>(i);
+    }
+    particles.permute(order);
+}
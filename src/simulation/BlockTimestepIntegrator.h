@@ -0,0 +1,89 @@
+//
+// Created by raph on 08/01/25.
+//
+
+#ifndef BLOCKTIMESTEPINTEGRATOR_H
+#define BLOCKTIMESTEPINTEGRATOR_H
+
+#include <cstdint>
+#include <vector>
+
+#include "GravitySolver.h"
+#include "../core/Logger.h"
+
+struct BlockTimestepConfig {
+    float maxTimestep = 1.0f;       // Myr, timestep of level 0
+    uint32_t maxLevel = 8;          // the finest step is maxTimestep / 2^maxLevel
+    float accuracy = 0.02f;         // eta in dt = sqrt(2 eta eps / |a|)
+    float softening = 0.05f;        // kpc, length scale of the timestep criterion
+};
+
+/**
+ * Kick-drift-kick leapfrog with individual power of two timesteps. A particle on level k is kicked every
+ * maxTimestep / 2^k, so the dense bulge can run on fine steps while the outer disk is only updated a few times.
+ *
+ * Particles are kept sorted by decreasing level, so at any substep the active particles (every level whose step
+ * ends now) are the contiguous prefix [0, activeCount) and the solver only computes their accelerations.
+ * Positions of every particle are drifted each substep, which is cheap compared to a force evaluation.
+ */
+class BlockTimestepIntegrator {
+public:
+    BlockTimestepIntegrator(GravitySolver& solver, const BlockTimestepConfig& config);
+
+    /**
+     * Compute every acceleration, assign the initial levels and apply the first half kick.
+     * Must be called again whenever the particle set is replaced
+     * @param startTime simulation time of the particle state, in Myr
+     */
+    void initialize(ParticleSet& particles, double startTime = 0.0);
+
+    /**
+     * Advance every particle by the finest timestep, kicking the ones whose own step ends
+     */
+    void substep(ParticleSet& particles);
+
+    /**
+     * Velocity of a particle at the current time. The stored velocities are half a kick ahead, and initialize()
+     * kicks them again, so a saved state must hold these instead to resume the run. Exact at the end of a level 0
+     * step, first order for a particle in the middle of its own step
+     */
+    void getSynchronizedVelocity(const ParticleSet& particles, size_t i, float& vx, float& vy, float& vz) const;
+
+    double getTime() const { return time; }
+    double getFinestTimestep() const { return finestTimestep; }
+    const BlockTimestepConfig& getConfig() const { return config; }
+
+    /**
+     * Number of single particle force evaluations since initialize(), to compare with a global timestep
+     */
+    uint64_t getForceEvaluations() const { return forceEvaluations; }
+
+    /**
+     * Number of particles with a level >= level
+     */
+    size_t getCountAtOrAbove(uint32_t level) const { return levelOffsets[level]; }
+
+private:
+    uint8_t chooseLevel(float ax, float ay, float az) const;
+    uint32_t lowestActiveLevel(uint64_t substepIndex) const;
+
+    /**
+     * Sort the first count particles by decreasing level and refresh the offsets of the levels they hold
+     */
+    void sortByLevel(ParticleSet& particles, size_t count, uint32_t lowestLevel);
+
+    GravitySolver& solver;
+    BlockTimestepConfig config;
+    Logger logger;
+
+    double time = 0.0;
+    double finestTimestep;
+    uint64_t substepIndex = 0;      // position inside the current level 0 step, in finest timesteps
+    uint64_t substepsPerStep;       // 2^maxLevel
+    uint64_t forceEvaluations = 0;
+
+    std::vector<size_t> levelOffsets;   // levelOffsets[k] = number of particles with a level >= k
+    std::vector<uint32_t> order;
+};
+
+#endif //BLOCKTIMESTEPINTEGRATOR_H
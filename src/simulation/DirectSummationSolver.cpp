@@ -0,0 +1,49 @@
+//
+// Created by raph on 04/01/25.
+//
+
+#include "DirectSummationSolver.h"
+
+#include <cmath>
+
+#include "Units.h"
+#include "../core/ThreadPool.h"
+
+DirectSummationSolver::DirectSummationSolver(float softening, double gravitationalConstant)
+    : softening(softening)
+    , gravitationalConstant(gravitationalConstant > 0.0 ? gravitationalConstant : Units::G) {
+}
+
+void DirectSummationSolver::computeAccelerations(ParticleSet& particles, size_t begin, size_t end) {
+    const size_t count = particles.size();
+    const float* x = particles.x.data();
+    const float* y = particles.y.data();
+    const float* z = particles.z.data();
+    const float* mass = particles.mass.data();
+    const float eps2 = softening * softening;
+    const double g = gravitationalConstant;
+
+    ThreadPool::global().parallelFor(begin, end, 64, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            const float xi = x[i], yi = y[i], zi = z[i];
+            float sumX = 0.0f, sumY = 0.0f, sumZ = 0.0f;
+
+            // Branch free inner loop so it vectorizes, the self term contributes zero
+            for (size_t j = 0; j < count; j++) {
+                float dx = x[j] - xi;
+                float dy = y[j] - yi;
+                float dz = z[j] - zi;
+                float r2 = dx * dx + dy * dy + dz * dz + eps2;
+                float invR = r2 > 0.0f ? 1.0f / std::sqrt(r2) : 0.0f;
+                float weight = mass[j] * invR * invR * invR;
+                sumX += dx * weight;
+                sumY += dy * weight;
+                sumZ += dz * weight;
+            }
+
+            particles.ax[i] = static_cast<float>(g * sumX);
+            particles.ay[i] = static_cast<float>(g * sumY);
+            particles.az[i] = static_cast<float>(g * sumZ);
+        }
+    });
+}
@@ -0,0 +1,28 @@
+//
+// Created by raph on 04/01/25.
+//
+
+#ifndef DIRECTSUMMATIONSOLVER_H
+#define DIRECTSUMMATIONSOLVER_H
+
+#include "GravitySolver.h"
+
+/**
+ * O(N^2) Plummer-softened pairwise summation. Too slow for a galaxy, but exact, so it is the reference
+ * the mesh solver is validated against on small particle counts.
+ */
+class DirectSummationSolver : public GravitySolver {
+public:
+    explicit DirectSummationSolver(float softening = 0.0f, double gravitationalConstant = 0.0);
+
+    using GravitySolver::computeAccelerations;
+    void computeAccelerations(ParticleSet& particles, size_t begin, size_t end) override;
+
+    const char* getName() const override { return "Direct summation"; }
+
+private:
+    float softening;
+    double gravitationalConstant;
+};
+
+#endif //DIRECTSUMMATIONSOLVER_H
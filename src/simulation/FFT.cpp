@@ -0,0 +1,133 @@
+//
+// Created by raph on 05/01/25.
+//
+
+#include "FFT.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+
+#include "../core/ThreadPool.h"
+
+FFT3D::FFT3D(uint32_t size) : n(size) {
+    if (!isPowerOfTwo(size) || size < 2) {
+        throw std::runtime_error("FFT size must be a power of two, got " + std::to_string(size));
+    }
+
+    uint32_t bits = 0;
+    while ((1u << bits) < n) {
+        bits++;
+    }
+
+    bitReverse.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t reversed = 0;
+        for (uint32_t b = 0; b < bits; b++) {
+            reversed |= ((i >> b) & 1u) << (bits - 1 - b);
+        }
+        bitReverse[i] = reversed;
+    }
+
+    twiddles.resize(n / 2);
+    for (uint32_t k = 0; k < n / 2; k++) {
+        double angle = -2.0 * std::numbers::pi * k / n;
+        twiddles[k] = Complex(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+    }
+}
+
+void FFT3D::forward(Complex* data) const {
+    transform(data, false);
+}
+
+void FFT3D::inverse(Complex* data) const {
+    transform(data, true);
+}
+
+void FFT3D::transform(Complex* data, bool inverse) const {
+    const size_t plane = static_cast<size_t>(n) * n;
+
+    transformContiguousAxis(data, inverse);
+    transformStridedAxis(data, n, plane, inverse);       // y axis, one z plane after the other
+    transformStridedAxis(data, plane, n, inverse);       // z axis, one y row after the other
+}
+
+void FFT3D::transformContiguousAxis(Complex* data, bool inverse) const {
+    const size_t lineCount = static_cast<size_t>(n) * n;
+    const size_t grain = std::max<size_t>(1, 16384 / n);
+
+    ThreadPool::global().parallelFor(0, lineCount, grain, [&](size_t first, size_t last) {
+        for (size_t line = first; line < last; line++) {
+            transformLine(data + line * n, inverse);
+        }
+    });
+}
+
+void FFT3D::transformStridedAxis(Complex* data, size_t stride, size_t outerStride, bool inverse) const {
+    // Work items are (outer line, block of columns) pairs. Columns are always the contiguous x axis
+    const uint32_t blockWidth = std::min(BLOCK_COLUMNS, n);
+    const size_t blocksPerLine = n / blockWidth;
+    const size_t itemCount = static_cast<size_t>(n) * blocksPerLine;
+
+    ThreadPool::global().parallelFor(0, itemCount, 1, [&](size_t first, size_t last) {
+        thread_local std::vector<Complex> scratch;
+        scratch.resize(static_cast<size_t>(blockWidth) * n);
+
+        for (size_t item = first; item < last; item++) {
+            size_t outer = item / blocksPerLine;
+            size_t column = (item % blocksPerLine) * blockWidth;
+            Complex* base = data + outer * outerStride + column;
+
+            for (uint32_t i = 0; i < n; i++) {
+                const Complex* row = base + i * stride;
+                for (uint32_t b = 0; b < blockWidth; b++) {
+                    scratch[b * n + i] = row[b];
+                }
+            }
+
+            for (uint32_t b = 0; b < blockWidth; b++) {
+                transformLine(scratch.data() + b * n, inverse);
+            }
+
+            for (uint32_t i = 0; i < n; i++) {
+                Complex* row = base + i * stride;
+                for (uint32_t b = 0; b < blockWidth; b++) {
+                    row[b] = scratch[b * n + i];
+                }
+            }
+        }
+    });
+}
+
+void FFT3D::transformLine(Complex* line, bool inverse) const {
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t j = bitReverse[i];
+        if (i < j) {
+            std::swap(line[i], line[j]);
+        }
+    }
+
+    for (uint32_t length = 2; length <= n; length <<= 1) {
+        const uint32_t half = length >> 1;
+        const uint32_t step = n / length;
+
+        for (uint32_t start = 0; start < n; start += length) {
+            for (uint32_t k = 0; k < half; k++) {
+                Complex w = twiddles[k * step];
+                if (inverse) {
+                    w = std::conj(w);
+                }
+
+                // Written out by hand, std::complex multiplication handles inf/nan and does not vectorize
+                Complex odd = line[start + k + half];
+                Complex product(w.real() * odd.real() - w.imag() * odd.imag(),
+                                w.real() * odd.imag() + w.imag() * odd.real());
+                Complex even = line[start + k];
+                line[start + k] = even + product;
+                line[start + k + half] = even - product;
+            }
+        }
+    }
+}
@@ -0,0 +1,53 @@
+//
+// Created by raph on 05/01/25.
+//
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+/**
+ * In-place radix-2 complex FFT over a cubic grid, stored x-major: index = (z * n + y) * n + x.
+ * Lines along x are contiguous and transformed directly. Lines along y and z are strided, so they are
+ * gathered by blocks of a few columns into a contiguous scratch buffer first, which keeps every memory
+ * access on full cache lines. Lines are spread over the global thread pool.
+ */
+class FFT3D {
+public:
+    using Complex = std::complex<float>;
+
+    /**
+     * @param size grid size along each axis, must be a power of two
+     */
+    explicit FFT3D(uint32_t size);
+
+    void forward(Complex* data) const;
+
+    /**
+     * Inverse transform. The result is not normalized: divide by getSize()^3 to get the original data back
+     */
+    void inverse(Complex* data) const;
+
+    uint32_t getSize() const { return n; }
+    size_t getCellCount() const { return static_cast<size_t>(n) * n * n; }
+
+    static bool isPowerOfTwo(uint32_t value) { return value != 0 && (value & (value - 1)) == 0; }
+
+private:
+    void transform(Complex* data, bool inverse) const;
+    void transformContiguousAxis(Complex* data, bool inverse) const;
+    void transformStridedAxis(Complex* data, size_t stride, size_t outerStride, bool inverse) const;
+    void transformLine(Complex* line, bool inverse) const;
+
+    uint32_t n;
+    std::vector<uint32_t> bitReverse;
+    std::vector<Complex> twiddles;
+
+    // Number of columns gathered together when transforming a strided axis, 8 complex floats = one cache line
+    static constexpr uint32_t BLOCK_COLUMNS = 8;
+};
+
+#endif //FFT_H
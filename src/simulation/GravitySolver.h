@@ -0,0 +1,33 @@
+//
+// Created by raph on 04/01/25.
+//
+
+#ifndef GRAVITYSOLVER_H
+#define GRAVITYSOLVER_H
+
+#include <cstddef>
+
+#include "ParticleSet.h"
+
+/**
+ * Common interface of the gravity engines. Solvers always take the mass of every particle into account,
+ * but only write the accelerations of the [begin, end) range, so integrators can ask for the active particles only.
+ */
+class GravitySolver {
+public:
+    virtual ~GravitySolver() = default;
+
+    /**
+     * Compute the gravitational acceleration of particles [begin, end) into ax, ay and az
+     * @param particles the whole particle set, sources of the field
+     * @param begin first particle to update
+     * @param end one past the last particle to update
+     */
+    virtual void computeAccelerations(ParticleSet& particles, size_t begin, size_t end) = 0;
+
+    void computeAccelerations(ParticleSet& particles) { computeAccelerations(particles, 0, particles.size()); }
+
+    virtual const char* getName() const = 0;
+};
+
+#endif //GRAVITYSOLVER_H
@@ -0,0 +1,81 @@
+//
+// Created by raph on 06/01/25.
+//
+
+#include "GravityValidation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <random>
+
+#include "DirectSummationSolver.h"
+
+namespace GravityValidation {
+    ParticleSet makePlummerSphere(size_t count, float scaleRadius, float totalMass, uint64_t seed) {
+        ParticleSet particles;
+        particles.resize(count);
+
+        std::mt19937_64 rng(seed);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        for (size_t i = 0; i < count; i++) {
+            // Inverse of the Plummer cumulative mass, truncated so no particle lands absurdly far away
+            double u = std::min(uniform(rng), 0.9);
+            double r = scaleRadius / std::sqrt(std::pow(u, -2.0 / 3.0) - 1.0);
+
+            double cosTheta = 2.0 * uniform(rng) - 1.0;
+            double sinTheta = std::sqrt(1.0 - cosTheta * cosTheta);
+            double phi = 2.0 * std::numbers::pi * uniform(rng);
+
+            particles.x[i] = static_cast<float>(r * sinTheta * std::cos(phi));
+            particles.y[i] = static_cast<float>(r * sinTheta * std::sin(phi));
+            particles.z[i] = static_cast<float>(r * cosTheta);
+            particles.mass[i] = totalMass / static_cast<float>(count);
+        }
+
+        return particles;
+    }
+
+    AccelerationError compare(const ParticleSet& reference, const ParticleSet& candidate) {
+        AccelerationError error;
+        const size_t count = std::min(reference.size(), candidate.size());
+        double sumSquares = 0.0;
+        double sum = 0.0;
+
+        for (size_t i = 0; i < count; i++) {
+            double dx = static_cast<double>(candidate.ax[i]) - reference.ax[i];
+            double dy = static_cast<double>(candidate.ay[i]) - reference.ay[i];
+            double dz = static_cast<double>(candidate.az[i]) - reference.az[i];
+            double norm = std::sqrt(static_cast<double>(reference.ax[i]) * reference.ax[i] +
+                                    static_cast<double>(reference.ay[i]) * reference.ay[i] +
+                                    static_cast<double>(reference.az[i]) * reference.az[i]);
+            if (norm <= 0.0) {
+                continue;
+            }
+
+            double relative = std::sqrt(dx * dx + dy * dy + dz * dz) / norm;
+            sumSquares += relative * relative;
+            sum += relative;
+            error.maxRelative = std::max(error.maxRelative, relative);
+            error.count++;
+        }
+
+        if (error.count > 0) {
+            error.rmsRelative = std::sqrt(sumSquares / static_cast<double>(error.count));
+            error.meanRelative = sum / static_cast<double>(error.count);
+        }
+        return error;
+    }
+
+    AccelerationError validate(GravitySolver& solver, const ParticleSet& particles, float softening) {
+        ParticleSet reference = particles;
+        DirectSummationSolver direct(softening);
+        direct.computeAccelerations(reference);
+
+        ParticleSet candidate = particles;
+        solver.computeAccelerations(candidate);
+
+        return compare(reference, candidate);
+    }
+}
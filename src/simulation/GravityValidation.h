@@ -0,0 +1,40 @@
+//
+// Created by raph on 06/01/25.
+//
+
+#ifndef GRAVITYVALIDATION_H
+#define GRAVITYVALIDATION_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "GravitySolver.h"
+
+/**
+ * Helpers used to check an approximate gravity solver against direct summation on small particle counts
+ */
+namespace GravityValidation {
+    struct AccelerationError {
+        double rmsRelative = 0.0;
+        double meanRelative = 0.0;
+        double maxRelative = 0.0;
+        size_t count = 0;
+    };
+
+    /**
+     * Plummer sphere centered on the origin, positions only (velocities are left at zero)
+     */
+    ParticleSet makePlummerSphere(size_t count, float scaleRadius, float totalMass, uint64_t seed);
+
+    /**
+     * Per particle relative error |a - a_ref| / |a_ref| of candidate against reference
+     */
+    AccelerationError compare(const ParticleSet& reference, const ParticleSet& candidate);
+
+    /**
+     * Run solver and a direct summation with the given softening on the same particles and compare them
+     */
+    AccelerationError validate(GravitySolver& solver, const ParticleSet& particles, float softening);
+}
+
+#endif //GRAVITYVALIDATION_H
@@ -0,0 +1,413 @@
+//
+// Created by raph on 05/01/25.
+//
+
+#include "PMSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+
+#include "../core/ThreadPool.h"
+
+namespace {
+    // Cells kept free between the particles and the mesh border, so the force stencils never read outside the mesh
+    constexpr int64_t BORDER_CELLS = 2;
+
+    // Cloud-in-cell footprint of a particle: the two cells it overlaps along each axis and their weights
+    struct CicStencil {
+        int64_t first[3];
+        int64_t second[3];
+        float firstWeight[3];
+        float secondWeight[3];
+    };
+
+    int64_t wrap(int64_t index, int64_t size) {
+        index %= size;
+        return index < 0 ? index + size : index;
+    }
+
+    // Cell centers sit at (i + 0.5) * cellSize. Returns false when the stencil leaves a non periodic mesh
+    bool computeStencil(const float position[3], const float boxMin[3], float invCell, int64_t n, bool periodic,
+                        CicStencil& s) {
+        for (int axis = 0; axis < 3; axis++) {
+            float g = (position[axis] - boxMin[axis]) * invCell - 0.5f;
+            float cell = std::floor(g);
+            s.first[axis] = static_cast<int64_t>(cell);
+            s.second[axis] = s.first[axis] + 1;
+            s.secondWeight[axis] = g - cell;
+            s.firstWeight[axis] = 1.0f - s.secondWeight[axis];
+
+            if (periodic) {
+                s.first[axis] = wrap(s.first[axis], n);
+                s.second[axis] = wrap(s.second[axis], n);
+            } else if (s.first[axis] < 0 || s.second[axis] >= n) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+PMSolver::PMSolver(const PMSolverConfig& config)
+    : config(config)
+    , logger("PMSolver")
+    , meshSize(config.gridSize)
+    , fft(config.boundary == PMSolverConfig::Boundary::Isolated ? config.gridSize * 2 : config.gridSize) {
+
+    if (!FFT3D::isPowerOfTwo(meshSize) || meshSize < 8) {
+        throw std::runtime_error("PM grid size must be a power of two >= 8, got " + std::to_string(meshSize));
+    }
+    if (config.boundary == PMSolverConfig::Boundary::Periodic && config.boxSize <= 0.0f) {
+        throw std::runtime_error("Periodic PM solver needs an explicit box size");
+    }
+
+    const size_t meshCells = static_cast<size_t>(meshSize) * meshSize * meshSize;
+    depositGrids.resize(ThreadPool::global().getConcurrency());
+    for (auto& grid : depositGrids) {
+        grid.resize(meshCells);
+    }
+    density.resize(meshCells);
+    potential.resize(meshCells);
+    forceX.resize(meshCells);
+    forceY.resize(meshCells);
+    forceZ.resize(meshCells);
+    workGrid.resize(fft.getCellCount());
+    greens.resize(fft.getCellCount());
+
+    logger.info(std::string("Created ") + (config.boundary == PMSolverConfig::Boundary::Periodic ? "periodic" : "isolated") +
+                " PM solver with a " + std::to_string(meshSize) + "^3 mesh (FFT " + std::to_string(fft.getSize()) + "^3)");
+}
+
+void PMSolver::computeAccelerations(ParticleSet& particles, size_t begin, size_t end) {
+    if (particles.empty() || begin >= end) {
+        return;
+    }
+
+    if (updateBox(particles) || !greensValid) {
+        buildGreensFunction();
+    }
+
+    depositMass(particles);
+    solvePotential();
+    computeMeshForces();
+    interpolateForces(particles, begin, end);
+}
+
+////////////////////////////////////////
+/// Mesh setup
+////////////////////////////////////////
+
+bool PMSolver::updateBox(const ParticleSet& particles) {
+    const bool fixedBox = config.boundary == PMSolverConfig::Boundary::Periodic || config.boxSize > 0.0f;
+    if (fixedBox) {
+        if (cellSize > 0.0f) {
+            return false;
+        }
+        boxSize = config.boxSize;
+        for (int axis = 0; axis < 3; axis++) {
+            boxMin[axis] = config.boxCenter[axis] - 0.5f * boxSize;
+        }
+        cellSize = boxSize / static_cast<float>(meshSize);
+        return true;
+    }
+
+    // Bounding box of the particles, reduced per partition
+    const size_t count = particles.size();
+    const size_t partitions = depositGrids.size();
+    std::vector<std::array<float, 6>> bounds(partitions);
+    const float* coordinates[3] = {particles.x.data(), particles.y.data(), particles.z.data()};
+
+    ThreadPool::global().parallelFor(0, partitions, 1, [&](size_t firstPartition, size_t lastPartition) {
+        for (size_t p = firstPartition; p < lastPartition; p++) {
+            auto& b = bounds[p];
+            for (int axis = 0; axis < 3; axis++) {
+                b[axis] = std::numeric_limits<float>::max();
+                b[axis + 3] = std::numeric_limits<float>::lowest();
+            }
+            size_t first = count * p / partitions;
+            size_t last = count * (p + 1) / partitions;
+            for (int axis = 0; axis < 3; axis++) {
+                for (size_t i = first; i < last; i++) {
+                    b[axis] = std::min(b[axis], coordinates[axis][i]);
+                    b[axis + 3] = std::max(b[axis + 3], coordinates[axis][i]);
+                }
+            }
+        }
+    });
+
+    std::array<float, 6> total = bounds[0];
+    for (const auto& b : bounds) {
+        for (int axis = 0; axis < 3; axis++) {
+            total[axis] = std::min(total[axis], b[axis]);
+            total[axis + 3] = std::max(total[axis + 3], b[axis + 3]);
+        }
+    }
+
+    float extent = 1e-3f;
+    for (int axis = 0; axis < 3; axis++) {
+        extent = std::max(extent, total[axis + 3] - total[axis]);
+    }
+    const float usableFraction = static_cast<float>(meshSize - 2 * BORDER_CELLS) / static_cast<float>(meshSize);
+    const float requiredSize = extent / usableFraction;
+
+    // Keep the current box while it still contains everything and is not much too large,
+    // so the Green's function is not rebuilt at every step
+    if (cellSize > 0.0f && boxSize <= 2.0f * requiredSize) {
+        const float border = BORDER_CELLS * cellSize;
+        bool inside = true;
+        for (int axis = 0; axis < 3; axis++) {
+            inside = inside && total[axis] >= boxMin[axis] + border && total[axis + 3] <= boxMin[axis] + boxSize - border;
+        }
+        if (inside) {
+            return false;
+        }
+    }
+
+    boxSize = requiredSize * 1.25f;
+    cellSize = boxSize / static_cast<float>(meshSize);
+    for (int axis = 0; axis < 3; axis++) {
+        boxMin[axis] = 0.5f * (total[axis] + total[axis + 3]) - 0.5f * boxSize;
+    }
+    LOG_DEBUG(logger, "Mesh box resized to {} kpc (cell {} kpc)", boxSize, cellSize);
+    return true;
+}
+
+void PMSolver::buildGreensFunction() {
+    const int64_t m = fft.getSize();
+    const size_t plane = static_cast<size_t>(m) * m;
+    const double normalization = 1.0 / static_cast<double>(fft.getCellCount());
+
+    if (config.boundary == PMSolverConfig::Boundary::Isolated) {
+        // Real space kernel -1/r in cell units, with distances wrapped so the padded mesh holds both signs.
+        // Convolved with the mass per cell, it gives the potential once scaled by G / cellSize
+        const double eps2 = static_cast<double>(config.softening / cellSize) * (config.softening / cellSize);
+
+        ThreadPool::global().parallelFor(0, static_cast<size_t>(m), 1, [&](size_t firstK, size_t lastK) {
+            for (int64_t k = static_cast<int64_t>(firstK); k < static_cast<int64_t>(lastK); k++) {
+                for (int64_t j = 0; j < m; j++) {
+                    for (int64_t i = 0; i < m; i++) {
+                        double di = static_cast<double>(std::min(i, m - i));
+                        double dj = static_cast<double>(std::min(j, m - j));
+                        double dk = static_cast<double>(std::min(k, m - k));
+                        double r2 = di * di + dj * dj + dk * dk + eps2;
+                        double g = r2 > 0.0 ? -1.0 / std::sqrt(r2) : -1.0;
+                        workGrid[k * plane + j * m + i] = FFT3D::Complex(static_cast<float>(g), 0.0f);
+                    }
+                }
+            }
+        });
+
+        fft.forward(workGrid.data());
+
+        const double scale = config.gravitationalConstant / cellSize * normalization;
+        ThreadPool::global().parallelFor(0, greens.size(), 1 << 16, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; c++) {
+                greens[c] = static_cast<float>(workGrid[c].real() * scale);
+            }
+        });
+    } else {
+        // Periodic: phi_k = -4 pi G rho_k / k^2, with the k^2 of the discrete Laplacian so it matches the force stencil
+        const double h = cellSize;
+        const double scale = -4.0 * std::numbers::pi * config.gravitationalConstant / (h * h * h) * normalization;
+
+        ThreadPool::global().parallelFor(0, static_cast<size_t>(m), 1, [&](size_t firstK, size_t lastK) {
+            for (int64_t k = static_cast<int64_t>(firstK); k < static_cast<int64_t>(lastK); k++) {
+                for (int64_t j = 0; j < m; j++) {
+                    for (int64_t i = 0; i < m; i++) {
+                        double si = std::sin(std::numbers::pi * static_cast<double>(i) / m);
+                        double sj = std::sin(std::numbers::pi * static_cast<double>(j) / m);
+                        double sk = std::sin(std::numbers::pi * static_cast<double>(k) / m);
+                        double k2 = 4.0 * (si * si + sj * sj + sk * sk) / (h * h);
+                        greens[k * plane + j * m + i] = k2 > 0.0 ? static_cast<float>(scale / k2) : 0.0f;
+                    }
+                }
+            }
+        });
+    }
+
+    greensValid = true;
+}
+
+////////////////////////////////////////
+/// Solver stages
+////////////////////////////////////////
+
+size_t PMSolver::meshIndex(int64_t i, int64_t j, int64_t k) const {
+    return (static_cast<size_t>(k) * meshSize + static_cast<size_t>(j)) * meshSize + static_cast<size_t>(i);
+}
+
+void PMSolver::depositMass(const ParticleSet& particles) {
+    const size_t count = particles.size();
+    const size_t partitions = depositGrids.size();
+    const int64_t n = meshSize;
+    const bool periodic = config.boundary == PMSolverConfig::Boundary::Periodic;
+    const float invCell = 1.0f / cellSize;
+    std::vector<size_t> outside(partitions, 0);
+
+    // Every partition scatters into its own grid, so no atomics are needed
+    ThreadPool::global().parallelFor(0, partitions, 1, [&](size_t firstPartition, size_t lastPartition) {
+        for (size_t p = firstPartition; p < lastPartition; p++) {
+            auto& grid = depositGrids[p];
+            std::fill(grid.begin(), grid.end(), 0.0f);
+
+            size_t first = count * p / partitions;
+            size_t last = count * (p + 1) / partitions;
+            for (size_t i = first; i < last; i++) {
+                const float position[3] = {particles.x[i], particles.y[i], particles.z[i]};
+                CicStencil s{};
+                if (!computeStencil(position, boxMin.data(), invCell, n, periodic, s)) {
+                    outside[p]++;
+                    continue;
+                }
+
+                const float m = particles.mass[i];
+                for (int dk = 0; dk < 2; dk++) {
+                    int64_t k = dk ? s.second[2] : s.first[2];
+                    float wk = m * (dk ? s.secondWeight[2] : s.firstWeight[2]);
+                    for (int dj = 0; dj < 2; dj++) {
+                        int64_t j = dj ? s.second[1] : s.first[1];
+                        float wjk = wk * (dj ? s.secondWeight[1] : s.firstWeight[1]);
+                        grid[meshIndex(s.first[0], j, k)] += wjk * s.firstWeight[0];
+                        grid[meshIndex(s.second[0], j, k)] += wjk * s.secondWeight[0];
+                    }
+                }
+            }
+        }
+    });
+
+    ThreadPool::global().parallelFor(0, density.size(), 1 << 15, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++) {
+            float sum = 0.0f;
+            for (const auto& grid : depositGrids) {
+                sum += grid[c];
+            }
+            density[c] = sum;
+        }
+    });
+
+    outsideCount = 0;
+    for (size_t o : outside) {
+        outsideCount += o;
+    }
+    if (outsideCount > 0) {
+        logger.warning(std::to_string(outsideCount) + " particles are outside the PM mesh and feel no force");
+    }
+}
+
+void PMSolver::solvePotential() {
+    const size_t n = meshSize;
+    const size_t m = fft.getSize();
+
+    // Copy the mass into the first octant, the rest of an isolated mesh is the zero padding
+    ThreadPool::global().parallelFor(0, m, 1, [&](size_t firstK, size_t lastK) {
+        for (size_t k = firstK; k < lastK; k++) {
+            for (size_t j = 0; j < m; j++) {
+                FFT3D::Complex* row = workGrid.data() + (k * m + j) * m;
+                if (k < n && j < n) {
+                    const float* source = density.data() + (k * n + j) * n;
+                    for (size_t i = 0; i < n; i++) {
+                        row[i] = FFT3D::Complex(source[i], 0.0f);
+                    }
+                    std::fill(row + n, row + m, FFT3D::Complex(0.0f, 0.0f));
+                } else {
+                    std::fill(row, row + m, FFT3D::Complex(0.0f, 0.0f));
+                }
+            }
+        }
+    });
+
+    fft.forward(workGrid.data());
+
+    ThreadPool::global().parallelFor(0, workGrid.size(), 1 << 16, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++) {
+            workGrid[c] *= greens[c];
+        }
+    });
+
+    fft.inverse(workGrid.data());
+
+    ThreadPool::global().parallelFor(0, n, 1, [&](size_t firstK, size_t lastK) {
+        for (size_t k = firstK; k < lastK; k++) {
+            for (size_t j = 0; j < n; j++) {
+                const FFT3D::Complex* source = workGrid.data() + (k * m + j) * m;
+                float* row = potential.data() + (k * n + j) * n;
+                for (size_t i = 0; i < n; i++) {
+                    row[i] = source[i].real();
+                }
+            }
+        }
+    });
+}
+
+void PMSolver::computeMeshForces() {
+    const int64_t n = meshSize;
+    const bool periodic = config.boundary == PMSolverConfig::Boundary::Periodic;
+    const float invTwelveH = 1.0f / (12.0f * cellSize);
+
+    auto fix = [&](int64_t index) {
+        return periodic ? wrap(index, n) : std::clamp<int64_t>(index, 0, n - 1);
+    };
+
+    // Fourth order central differences: f = -(8 (phi[+1] - phi[-1]) - (phi[+2] - phi[-2])) / 12h
+    ThreadPool::global().parallelFor(0, static_cast<size_t>(n), 1, [&](size_t firstK, size_t lastK) {
+        for (int64_t k = static_cast<int64_t>(firstK); k < static_cast<int64_t>(lastK); k++) {
+            for (int64_t j = 0; j < n; j++) {
+                for (int64_t i = 0; i < n; i++) {
+                    auto derivative = [&](int64_t di, int64_t dj, int64_t dk) {
+                        float p1 = potential[meshIndex(fix(i + di), fix(j + dj), fix(k + dk))];
+                        float m1 = potential[meshIndex(fix(i - di), fix(j - dj), fix(k - dk))];
+                        float p2 = potential[meshIndex(fix(i + 2 * di), fix(j + 2 * dj), fix(k + 2 * dk))];
+                        float m2 = potential[meshIndex(fix(i - 2 * di), fix(j - 2 * dj), fix(k - 2 * dk))];
+                        return -(8.0f * (p1 - m1) - (p2 - m2)) * invTwelveH;
+                    };
+
+                    size_t c = meshIndex(i, j, k);
+                    forceX[c] = derivative(1, 0, 0);
+                    forceY[c] = derivative(0, 1, 0);
+                    forceZ[c] = derivative(0, 0, 1);
+                }
+            }
+        }
+    });
+}
+
+void PMSolver::interpolateForces(ParticleSet& particles, size_t begin, size_t end) const {
+    const int64_t n = meshSize;
+    const bool periodic = config.boundary == PMSolverConfig::Boundary::Periodic;
+    const float invCell = 1.0f / cellSize;
+
+    ThreadPool::global().parallelFor(begin, end, 4096, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            const float position[3] = {particles.x[i], particles.y[i], particles.z[i]};
+            CicStencil s{};
+            bool inside = computeStencil(position, boxMin.data(), invCell, n, periodic, s);
+
+            float a[3] = {0.0f, 0.0f, 0.0f};
+            if (inside) {
+                for (int dk = 0; dk < 2; dk++) {
+                    int64_t k = dk ? s.second[2] : s.first[2];
+                    float wk = dk ? s.secondWeight[2] : s.firstWeight[2];
+                    for (int dj = 0; dj < 2; dj++) {
+                        int64_t j = dj ? s.second[1] : s.first[1];
+                        float wjk = wk * (dj ? s.secondWeight[1] : s.firstWeight[1]);
+                        for (int di = 0; di < 2; di++) {
+                            size_t c = meshIndex(di ? s.second[0] : s.first[0], j, k);
+                            float w = wjk * (di ? s.secondWeight[0] : s.firstWeight[0]);
+                            a[0] += w * forceX[c];
+                            a[1] += w * forceY[c];
+                            a[2] += w * forceZ[c];
+                        }
+                    }
+                }
+            }
+
+            particles.ax[i] = a[0];
+            particles.ay[i] = a[1];
+            particles.az[i] = a[2];
+        }
+    });
+}
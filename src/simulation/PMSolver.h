@@ -0,0 +1,85 @@
+//
+// Created by raph on 05/01/25.
+//
+
+#ifndef PMSOLVER_H
+#define PMSOLVER_H
+
+#include <array>
+#include <vector>
+
+#include "FFT.h"
+#include "GravitySolver.h"
+#include "Units.h"
+#include "../core/Logger.h"
+
+struct PMSolverConfig {
+    enum class Boundary {
+        Periodic,   // the box is tiled infinitely, boxSize must be set
+        Isolated,   // vacuum outside the box, solved on a zero padded mesh twice as large
+    };
+
+    uint32_t gridSize = 64;                 // mesh cells along each axis, power of two
+    Boundary boundary = Boundary::Isolated;
+    float boxSize = 0.0f;                   // kpc. 0 fits the box around the particles (isolated only)
+    std::array<float, 3> boxCenter{0.0f, 0.0f, 0.0f};
+    float softening = 0.0f;                 // kpc, Plummer softening added to the mesh kernel (isolated only)
+    double gravitationalConstant = Units::G;
+};
+
+/**
+ * Particle-mesh gravity: masses are deposited on a 3D grid with cloud-in-cell weights, the Poisson equation
+ * is solved with FFTs, and the mesh forces are interpolated back to the particles with the same weights.
+ * Cost is O(N + M log M) for N particles and M cells, so it is the engine used for large scale disk dynamics.
+ */
+class PMSolver : public GravitySolver {
+public:
+    explicit PMSolver(const PMSolverConfig& config = PMSolverConfig());
+
+    PMSolver(const PMSolver&) = delete;
+    PMSolver& operator=(const PMSolver&) = delete;
+
+    using GravitySolver::computeAccelerations;
+    void computeAccelerations(ParticleSet& particles, size_t begin, size_t end) override;
+
+    const char* getName() const override { return "Particle mesh"; }
+
+    const PMSolverConfig& getConfig() const { return config; }
+    float getCellSize() const { return cellSize; }
+
+    /**
+     * Number of particles that fell outside the mesh during the last solve. They receive no force
+     */
+    size_t getOutsideCount() const { return outsideCount; }
+
+private:
+    bool updateBox(const ParticleSet& particles);
+    void buildGreensFunction();
+    void depositMass(const ParticleSet& particles);
+    void solvePotential();
+    void computeMeshForces();
+    void interpolateForces(ParticleSet& particles, size_t begin, size_t end) const;
+
+    size_t meshIndex(int64_t i, int64_t j, int64_t k) const;
+
+    PMSolverConfig config;
+    Logger logger;
+
+    uint32_t meshSize;      // N, cells covering the box
+    FFT3D fft;              // N for periodic boundaries, 2N for isolated ones
+
+    std::array<float, 3> boxMin{};
+    float boxSize = 0.0f;
+    float cellSize = 0.0f;
+    bool greensValid = false;
+    size_t outsideCount = 0;
+
+    std::vector<std::vector<float>> depositGrids;   // one private grid per thread, reduced into density
+    std::vector<float> density;                     // mass per cell
+    std::vector<FFT3D::Complex> workGrid;
+    std::vector<float> greens;                      // kernel in k space, real since it is even in r
+    std::vector<float> potential;
+    std::vector<float> forceX, forceY, forceZ;
+};
+
+#endif //PMSOLVER_H
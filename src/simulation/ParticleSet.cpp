@@ -0,0 +1,52 @@
+//
+// Created by raph on 04/01/25.
+//
+
+#include "ParticleSet.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+    template<typename T>
+    void applyPermutation(std::vector<T>& values, const std::vector<uint32_t>& order, std::vector<T>& scratch) {
+        scratch.resize(order.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            scratch[i] = values[order[i]];
+        }
+        std::copy(scratch.begin(), scratch.end(), values.begin());
+    }
+}
+
+void ParticleSet::resize(size_t count) {
+    for (auto* array : {&x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az, &mass}) {
+        array->resize(count, 0.0f);
+    }
+
+    timestepLevel.resize(count, 0);
+
+    size_t previous = id.size();
+    id.resize(count);
+    std::iota(id.begin() + static_cast<ptrdiff_t>(previous), id.end(), static_cast<uint32_t>(previous));
+}
+
+void ParticleSet::clear() {
+    resize(0);
+}
+
+void ParticleSet::permute(const std::vector<uint32_t>& order) {
+    std::vector<float> floatScratch;
+    for (auto* array : {&x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az, &mass}) {
+        applyPermutation(*array, order, floatScratch);
+    }
+
+    std::vector<uint32_t> idScratch;
+    applyPermutation(id, order, idScratch);
+
+    std::vector<uint8_t> levelScratch;
+    applyPermutation(timestepLevel, order, levelScratch);
+}
+
+double ParticleSet::totalMass() const {
+    return std::accumulate(mass.begin(), mass.end(), 0.0);
+}
@@ -0,0 +1,41 @@
+//
+// Created by raph on 04/01/25.
+//
+
+#ifndef PARTICLESET_H
+#define PARTICLESET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Particle state stored as structure of arrays, so the force and integration loops stream
+ * through contiguous floats. Every particle keeps the id it was created with, which is also
+ * its slot in the render buffers when the simulation reorders particles internally.
+ */
+struct ParticleSet {
+    std::vector<float> x, y, z;
+    std::vector<float> vx, vy, vz;
+    std::vector<float> ax, ay, az;
+    std::vector<float> mass;
+    std::vector<uint32_t> id;
+    std::vector<uint8_t> timestepLevel;     // block timestep level, dt = maxTimestep / 2^level
+
+    size_t size() const { return mass.size(); }
+    bool empty() const { return mass.empty(); }
+
+    void resize(size_t count);
+    void clear();
+
+    /**
+     * Reorder every array so that the particle at order[i] ends up at index i.
+     * When order is shorter than the set, only that prefix is reordered and the rest is left untouched
+     * @param order permutation of [0, order.size())
+     */
+    void permute(const std::vector<uint32_t>& order);
+
+    double totalMass() const;
+};
+
+#endif //PARTICLESET_H
@@ -0,0 +1,60 @@
+//
+// Created by raph on 08/01/25.
+//
+
+#include "Simulation.h"
+
+#include <algorithm>
+#include <string>
+
+Simulation::Simulation(const SimulationConfig& config)
+    : config(config)
+    , logger("Simulation")
+    , solver(std::make_unique<PMSolver>(config.gravity))
+    , integrator(std::make_unique<BlockTimestepIntegrator>(*solver, config.timestep)) {
+}
+
+void Simulation::setParticles(ParticleSet&& newParticles, double startTime) {
+    particles = std::move(newParticles);
+    pendingTime = 0.0;
+
+    logger.info("Simulating " + std::to_string(particles.size()) + " particles with the " +
+                solver->getName() + " solver");
+    integrator->initialize(particles, startTime);
+    stateVersion++;
+}
+
+uint32_t Simulation::advance(double realSeconds) {
+    if (particles.empty() || realSeconds <= 0.0) {
+        return 0;
+    }
+
+    const double substepTime = integrator->getFinestTimestep();
+    pendingTime += realSeconds * config.timeScale;
+
+    uint32_t substeps = 0;
+    while (pendingTime >= substepTime && substeps < config.maxSubstepsPerUpdate) {
+        integrator->substep(particles);
+        pendingTime -= substepTime;
+        substeps++;
+    }
+
+    // Too slow to keep up: drop the backlog rather than spiral into longer and longer updates
+    if (pendingTime >= substepTime) {
+        LOG_DEBUG(logger, "Simulation is behind real time, skipping {} Myr", pendingTime);
+        pendingTime = 0.0;
+    }
+
+    if (substeps > 0) {
+        stateVersion++;
+    }
+    return substeps;
+}
+
+double Simulation::getRealTimeToNextSubstep() const {
+    // Without particles there is nothing to step, check back later
+    if (particles.empty() || config.timeScale <= 0.0f) {
+        return 0.1;
+    }
+    return std::max(0.0, (integrator->getFinestTimestep() - pendingTime) / config.timeScale);
+}
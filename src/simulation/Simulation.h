@@ -0,0 +1,77 @@
+//
+// Created by raph on 08/01/25.
+//
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <memory>
+
+#include "BlockTimestepIntegrator.h"
+#include "ParticleSet.h"
+#include "PMSolver.h"
+#include "../core/Logger.h"
+
+struct SimulationConfig {
+    bool enabled = true;
+    float timeScale = 5.0f;                 // simulated Myr per real second
+    bool interpolate = true;                // the renderer blends between the last two published states
+    uint32_t maxSubstepsPerUpdate = 64;     // above this the simulation falls behind instead of stalling the frame
+    BlockTimestepConfig timestep;
+    PMSolverConfig gravity;
+};
+
+/**
+ * Owns the particle state, the gravity solver and the integrator, and keeps the simulation clock.
+ * The clock is advanced from real elapsed time, so the number of substeps taken per call depends on the
+ * simulated time that passed, not on how many frames were rendered.
+ */
+class Simulation {
+public:
+    explicit Simulation(const SimulationConfig& config = SimulationConfig());
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    /**
+     * Replace the simulated particles and restart the clock
+     * @param startTime simulation time of the new state, in Myr (non zero when resuming a snapshot)
+     */
+    void setParticles(ParticleSet&& newParticles, double startTime = 0.0);
+
+    /**
+     * Run as many finest substeps as fit in realSeconds * timeScale simulated Myr
+     * @param realSeconds elapsed wall clock time
+     * @return the number of substeps taken
+     */
+    uint32_t advance(double realSeconds);
+
+    /**
+     * Real seconds until the clock owes the next finest substep
+     */
+    double getRealTimeToNextSubstep() const;
+
+    bool hasParticles() const { return !particles.empty(); }
+    const ParticleSet& getParticles() const { return particles; }
+    double getTime() const { return integrator->getTime(); }
+    const BlockTimestepIntegrator& getIntegrator() const { return *integrator; }
+    const SimulationConfig& getConfig() const { return config; }
+
+    /**
+     * Incremented each time the particle positions change, so consumers know when to upload them again
+     */
+    uint64_t getStateVersion() const { return stateVersion; }
+
+private:
+    SimulationConfig config;
+    Logger logger;
+
+    ParticleSet particles;
+    std::unique_ptr<GravitySolver> solver;
+    std::unique_ptr<BlockTimestepIntegrator> integrator;
+
+    double pendingTime = 0.0;   // simulated time owed to the clock, always below one finest substep
+    uint64_t stateVersion = 0;
+};
+
+#endif //SIMULATION_H
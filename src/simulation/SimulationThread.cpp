@@ -0,0 +1,135 @@
+//
+// Created by raph on 25/01/25.
+//
+
+#include "SimulationThread.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+#include "../core/ThreadPool.h"
+
+float SimulationState::blendAt(double now) const {
+    if (interval <= 0.0) {
+        return 1.0f;
+    }
+    return static_cast<float>(std::clamp((now - publishedAt) / interval, 0.0, 1.0));
+}
+
+SimulationThread::SimulationThread(Simulation& simulation)
+    : simulation(simulation)
+    , logger("SimulationThread") {
+
+    // The renderer starts from the current state, with nothing to blend from
+    publish();
+    states.acquire();
+
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+SimulationThread::~SimulationThread() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void SimulationThread::post(Task task) {
+    {
+        std::lock_guard lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    wakeCondition.notify_all();
+}
+
+double SimulationThread::clock() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SimulationThread::run() {
+    logger.info("Simulation thread started");
+    double last = clock();
+
+    while (true) {
+        {
+            // Sleep until the clock owes the next substep, or something needs the thread
+            std::unique_lock lock(mutex);
+            auto wait = std::chrono::duration<double>(simulation.getRealTimeToNextSubstep());
+            wakeCondition.wait_for(lock, wait, [this] { return stopping || !tasks.empty(); });
+            if (stopping) {
+                break;
+            }
+        }
+        runTasks();
+
+        double now = clock();
+        uint32_t substeps = simulation.advance(now - last);
+        last = now;
+
+        if (substeps > 0) {
+            publish();
+        }
+    }
+
+    runTasks();
+    logger.info("Simulation thread stopped");
+}
+
+void SimulationThread::publish() {
+    SimulationState& state = states.getWriteBuffer();
+    const ParticleSet& particles = simulation.getParticles();
+    const size_t count = particles.size();
+    const bool first = lastPositions.size() != 3 * count;
+
+    // The last positions move to the state without a copy, the buffer they leave takes the new ones along with it
+    state.previousPositions.swap(lastPositions);
+    state.positions.resize(3 * count);
+    lastPositions.resize(3 * count);
+
+    // The integrator reorders particles, the renderer wants them at their id
+    ThreadPool::global().parallelFor(0, count, 65536, [&](size_t firstParticle, size_t lastParticle) {
+        for (size_t i = firstParticle; i < lastParticle; i++) {
+            const size_t offset = 3 * size_t(particles.id[i]);
+            float* position = state.positions.data() + offset;
+            float* kept = lastPositions.data() + offset;
+            position[0] = kept[0] = particles.x[i];
+            position[1] = kept[1] = particles.y[i];
+            position[2] = kept[2] = particles.z[i];
+        }
+    });
+    if (first) {
+        state.previousPositions = state.positions;
+    }
+
+    const double now = clock();
+    state.previousTime = first ? simulation.getTime() : lastTime;
+    state.time = simulation.getTime();
+    state.interval = first ? 0.0 : now - lastPublishedAt;
+    state.publishedAt = now;
+    state.version = simulation.getStateVersion();
+
+    lastTime = state.time;
+    lastPublishedAt = now;
+    states.publish();
+}
+
+void SimulationThread::runTasks() {
+    std::vector<Task> pending;
+    {
+        std::lock_guard lock(mutex);
+        pending.swap(tasks);
+    }
+
+    for (auto& task : pending) {
+        try {
+            task(simulation);
+        } catch (const std::exception& e) {
+            logger.error(e.what());
+        }
+    }
+}
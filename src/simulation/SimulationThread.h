@@ -0,0 +1,93 @@
+//
+// Created by raph on 25/01/25.
+//
+
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Simulation.h"
+#include "TripleBuffer.h"
+#include "../core/Logger.h"
+
+/**
+ * Positions published by the simulation thread, in star order (particle ids), interleaved xyz.
+ * The state of the previous publication comes along so the renderer can blend between the two.
+ */
+struct SimulationState {
+    std::vector<float> positions;
+    std::vector<float> previousPositions;
+    double time = 0.0;                  // simulated Myr
+    double previousTime = 0.0;
+    double publishedAt = 0.0;           // steady clock seconds
+    double interval = 0.0;              // wall clock seconds between the two publications
+    uint64_t version = 0;
+
+    /**
+     * Blend factor from previousPositions to positions for a wall clock time, reaching 1 one interval after
+     * publication. The renderer is thus one state behind, which is what makes the motion continuous
+     */
+    float blendAt(double now) const;
+};
+
+/**
+ * Runs a simulation on its own thread, at fixed substeps paced by the simulation clock, so a slow step only slows
+ * the simulation down and never the frame rate. Each batch of substeps is published through a triple buffer.
+ *
+ * Other threads must not touch the simulation while the thread runs: they read published states, and anything
+ * that needs the full particle state (saving a snapshot) is posted to run between two steps.
+ */
+class SimulationThread {
+public:
+    using Task = std::function<void(const Simulation& simulation)>;
+
+    explicit SimulationThread(Simulation& simulation);
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    /**
+     * Take the latest published state, call from the render thread only
+     * @return true when the state changed since the last call
+     */
+    bool acquireState() { return states.acquire(); }
+    const SimulationState& getState() const { return states.getReadBuffer(); }
+
+    /**
+     * Run task on the simulation thread between two steps. Tasks still pending on shutdown are run before it
+     */
+    void post(Task task);
+
+    /**
+     * Wall clock of the publication times, in seconds
+     */
+    static double clock();
+
+private:
+    void run();
+    void publish();
+    void runTasks();
+
+    Simulation& simulation;
+    TripleBuffer<SimulationState> states;
+    std::vector<float> lastPositions;   // writer side copy of the last published positions, the next previousPositions
+    double lastTime = 0.0;
+    double lastPublishedAt = 0.0;
+
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::vector<Task> tasks;
+    bool stopping = false;
+
+    Logger logger;
+    std::thread thread;
+};
+
+#endif //SIMULATIONTHREAD_H
@@ -0,0 +1,70 @@
+//
+// Created by raph on 25/01/25.
+//
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Lock-free single producer, single consumer hand-off of the latest value.
+ *
+ * The writer fills its own buffer and publishes it by swapping it with the middle one; the reader takes the middle
+ * one by swapping it with its own. Neither side ever waits for the other: the writer overwrites states the reader
+ * skipped, and the reader keeps its buffer for as long as it wants. A flag in the middle index tells whether it
+ * holds something the reader has not seen.
+ */
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /**
+     * Buffer owned by the writer until the next publish()
+     */
+    T& getWriteBuffer() { return buffers[writeIndex]; }
+
+    /**
+     * Hand the write buffer to the reader, and take back a buffer it is done with
+     */
+    void publish() {
+        uint8_t previous = middle.exchange(writeIndex | FRESH_BIT, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    /**
+     * Take the latest published buffer, if there is one the reader has not seen
+     * @return true when the read buffer changed
+     */
+    bool acquire() {
+        if ((middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0) {
+            return false;
+        }
+        uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * Buffer owned by the reader until the next acquire() that returns true
+     */
+    const T& getReadBuffer() const { return buffers[readIndex]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH_BIT = 0x4;
+
+    // The indices sit on separate cache lines, so the two sides do not bounce them between cores
+    std::array<T, 3> buffers{};
+    alignas(64) std::atomic<uint8_t> middle{1};
+    alignas(64) uint8_t writeIndex = 0;
+    alignas(64) uint8_t readIndex = 2;
+};
+
+#endif //TRIPLEBUFFER_H
@@ -0,0 +1,19 @@
+//
+// Created by raph on 04/01/25.
+//
+
+#ifndef UNITS_H
+#define UNITS_H
+
+/**
+ * Simulation units: lengths in kpc, times in Myr and masses in solar masses.
+ * Velocities are therefore in kpc/Myr (1 kpc/Myr ~ 978 km/s).
+ */
+namespace Units {
+    // Gravitational constant in kpc^3 / (Msun Myr^2)
+    constexpr double G = 4.498502151469554e-12;
+
+    constexpr double KM_PER_S_IN_KPC_PER_MYR = 1.0227121650537077e-3;
+}
+
+#endif //UNITS_H
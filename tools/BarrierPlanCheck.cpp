@@ -0,0 +1,142 @@
+//
+// Created by raph on 08/02/25.
+//
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/core/Logger.h"
+#include "../src/renderer/ImageSyncState.h"
+
+namespace {
+    using Access = ImageSyncState::Access;
+    using Barrier = ImageSyncState::Barrier;
+
+    constexpr VkPipelineStageFlags COMPUTE = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    constexpr VkPipelineStageFlags FRAGMENT = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    constexpr VkPipelineStageFlags ATTACHMENT = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+    constexpr VkAccessFlags SHADER_WRITE = VK_ACCESS_SHADER_WRITE_BIT;
+    constexpr VkAccessFlags COLOR_WRITE_ACCESS = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    constexpr VkImageLayout UNDEFINED = VK_IMAGE_LAYOUT_UNDEFINED;
+    constexpr VkImageLayout GENERAL = VK_IMAGE_LAYOUT_GENERAL;
+    constexpr VkImageLayout ATTACHMENT_LAYOUT = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    constexpr VkImageLayout READ_ONLY = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    // Uses as RenderGraph::Pass declares them
+    constexpr Access STORAGE_WRITE = {COMPUTE, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                                      VK_IMAGE_LAYOUT_GENERAL, true};
+    constexpr Access STORAGE_READ = {COMPUTE, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false};
+    constexpr Access COLOR_WRITE = {ATTACHMENT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true};
+    constexpr Access SAMPLED = {FRAGMENT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false};
+
+    /**
+     * A pass using the image, and the barrier expected before it. srcStages 0 expects no barrier
+     */
+    struct Step {
+        Access access;
+        VkImageLayout oldLayout;
+        VkAccessFlags srcAccess;
+        VkPipelineStageFlags srcStages;
+    };
+
+    struct Case {
+        const char* name;
+        std::vector<Step> steps;
+    };
+
+    bool check(const Case& test, Logger& logger) {
+        // A transient image, whose memory was last written by a color attachment in the previous frame
+        ImageSyncState state(VK_IMAGE_LAYOUT_UNDEFINED, ATTACHMENT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+        bool success = true;
+        for (size_t i = 0; i < test.steps.size(); i++) {
+            const Step& step = test.steps[i];
+            Barrier barrier{};
+            const bool waits = state.use(step.access, barrier);
+            const bool expected = step.srcStages != 0;
+            bool agree = waits == expected;
+            if (agree && waits) {
+                agree = barrier.oldLayout == step.oldLayout && barrier.newLayout == step.access.layout &&
+                        barrier.srcAccess == step.srcAccess && barrier.dstAccess == step.access.access &&
+                        barrier.srcStages == step.srcStages && barrier.dstStages == step.access.stages;
+            }
+            if (!agree) {
+                logger.error(std::string(test.name) + ": pass " + std::to_string(i) + (waits ? " waits" : " does not wait") +
+                             " (src access " + std::to_string(barrier.srcAccess) + ", src stages " +
+                             std::to_string(barrier.srcStages) + ")");
+            }
+            success = success && agree;
+        }
+        logger.info(std::string(test.name) + (success ? " [ok]" : " [FAILED]"));
+        return success;
+    }
+
+    /**
+     * An imported image drawn by a pass that may be skipped, then sampled. Either way the sampling must find it in
+     * the layout it was imported with, and wait for the draws when they ran
+     */
+    bool checkSkippable(Logger& logger) {
+        const ImageSyncState imported(READ_ONLY, FRAGMENT, 0);
+        ImageSyncState state = imported;
+        Barrier before{}, restore{}, read{};
+        state.use(COLOR_WRITE, before);
+
+        bool success = state.restore(imported, COLOR_WRITE, restore) && restore.oldLayout == ATTACHMENT_LAYOUT &&
+                       restore.newLayout == READ_ONLY && restore.srcAccess == COLOR_WRITE_ACCESS &&
+                       restore.srcStages == ATTACHMENT && restore.dstStages == ATTACHMENT;
+        success = success && state.use(SAMPLED, read) && read.oldLayout == READ_ONLY && read.newLayout == READ_ONLY &&
+                  read.srcAccess == COLOR_WRITE_ACCESS && (read.srcStages & ATTACHMENT) != 0;
+        logger.info(std::string("skippable color attachment, sampled") + (success ? " [ok]" : " [FAILED]"));
+        return success;
+    }
+}
+
+/**
+ * Checks the barriers the render graph places between the passes using an image, for the sequences of uses its
+ * passes declare. A dispatch reading what the previous one wrote must wait for it, even from the same stage, and a
+ * pass that may be skipped must leave its images in the layout it found them in.
+ * Returns a non zero exit code when a barrier is missing or different.
+ */
+int main() {
+    Logger logger("BarrierPlanCheck");
+
+    try {
+        const Case cases[] = {
+            {"storage write, storage reads", {
+                {STORAGE_WRITE, UNDEFINED, COLOR_WRITE_ACCESS, ATTACHMENT},
+                {STORAGE_READ, GENERAL, SHADER_WRITE, COMPUTE},
+                {STORAGE_READ, GENERAL, 0, 0},
+            }},
+            {"storage writes", {
+                {STORAGE_WRITE, UNDEFINED, COLOR_WRITE_ACCESS, ATTACHMENT},
+                {STORAGE_WRITE, GENERAL, SHADER_WRITE, COMPUTE},
+                {STORAGE_READ, GENERAL, SHADER_WRITE, COMPUTE},
+            }},
+            {"storage write, sampled", {
+                {STORAGE_WRITE, UNDEFINED, COLOR_WRITE_ACCESS, ATTACHMENT},
+                {SAMPLED, GENERAL, SHADER_WRITE, COMPUTE},
+                {SAMPLED, READ_ONLY, 0, 0},
+            }},
+            {"color attachment, sampled, color attachment", {
+                {COLOR_WRITE, UNDEFINED, COLOR_WRITE_ACCESS, ATTACHMENT},
+                {SAMPLED, ATTACHMENT_LAYOUT, COLOR_WRITE_ACCESS, ATTACHMENT},
+                {COLOR_WRITE, READ_ONLY, 0, FRAGMENT},
+            }},
+        };
+
+        bool success = true;
+        for (const auto& test : cases) {
+            success = check(test, logger) && success;
+        }
+        success = checkSkippable(logger) && success;
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,104 @@
+//
+// Created by raph on 23/01/25.
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../src/core/Logger.h"
+#include "../src/core/ThreadPool.h"
+#include "../src/galaxy/CounterRng.h"
+#include "../src/scene/FrustumCuller.h"
+
+namespace {
+    // Boxes of a few hundred parsecs spread over a 15 kpc thin disk, like the chunks of a large galaxy
+    ChunkBounds makeChunks(size_t count) {
+        ChunkBounds bounds;
+        bounds.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            CounterRng rng(7, i);
+            float x = 30.0f * rng.nextFloat() - 15.0f;
+            float y = 30.0f * rng.nextFloat() - 15.0f;
+            float z = 0.6f * rng.nextFloat() - 0.3f;
+            float halfSize = 0.05f + 0.2f * rng.nextFloat();
+            bounds.set(i, {x - halfSize, y - halfSize, z - 0.5f * halfSize}, {x + halfSize, y + halfSize, z + 0.5f * halfSize});
+        }
+        return bounds;
+    }
+
+    template<typename Function>
+    double millisecondsPerRun(int runs, Function&& function) {
+        auto start = std::chrono::steady_clock::now();
+        for (int run = 0; run < runs; run++) {
+            function();
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+    }
+}
+
+/**
+ * Measures frustum culling throughput over synthetic chunk bounds.
+ * Usage: CullBenchmark [chunk count] [runs]
+ * Returns a non zero exit code when the parallel and single threaded passes disagree.
+ */
+int main(int argc, char** argv) {
+    Logger logger("CullBenchmark");
+
+    try {
+        size_t chunkCount = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+        int runs = argc > 2 ? std::stoi(argv[2]) : 50;
+
+        ChunkBounds bounds = makeChunks(chunkCount);
+        std::vector<uint32_t> visible;
+        std::vector<uint32_t> reference;
+        visible.reserve(chunkCount);
+        reference.reserve(chunkCount);
+
+        struct View {
+            const char* name;
+            glm::vec3 eye;
+            glm::vec3 target;
+        };
+
+        // From the whole disk down to a single arm segment
+        const View views[] = {
+            {"overview", {0.0f, -25.0f, 25.0f}, {0.0f, 0.0f, 0.0f}},
+            {"arm", {6.0f, -2.0f, 1.5f}, {8.0f, 2.0f, 0.0f}},
+        };
+
+        FrustumCuller culler;
+        bool success = true;
+        for (const auto& view : views) {
+            glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.01f, 100.0f);
+            Frustum frustum = Frustum::fromViewProjection(projection * glm::lookAtRH(view.eye, view.target, glm::vec3(0.0f, 0.0f, 1.0f)));
+
+            double serial = millisecondsPerRun(runs, [&] {
+                reference.clear();
+                FrustumCuller::cullRange(frustum, bounds, 0, chunkCount, reference);
+            });
+            double parallel = millisecondsPerRun(runs, [&] {
+                culler.cull(frustum, bounds, visible);
+            });
+
+            bool agree = visible == reference;
+            success = success && agree;
+
+            logger.info(std::string(view.name) + ": " + std::to_string(chunkCount) + " chunks, " +
+                        std::to_string(visible.size()) + " visible" +
+                        " | 1 thread " + std::to_string(serial) + " ms (" +
+                        std::to_string(chunkCount / serial / 1e3) + " M culls/s)" +
+                        " | " + std::to_string(ThreadPool::global().getConcurrency()) + " threads " +
+                        std::to_string(parallel) + " ms (" + std::to_string(chunkCount / parallel / 1e3) + " M culls/s)" +
+                        (agree ? "" : " [MISMATCH]"));
+        }
+
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,114 @@
+//
+// Created by raph on 08/02/25.
+//
+
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../src/core/Logger.h"
+#include "../src/galaxy/CounterRng.h"
+#include "../src/scene/FrustumCuller.h"
+
+namespace {
+    // Boxes of a few hundred parsecs spread over a 15 kpc thin disk, like the chunks of a large galaxy
+    ChunkBounds makeChunks(size_t count) {
+        ChunkBounds bounds;
+        bounds.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            CounterRng rng(11, i);
+            float x = 30.0f * rng.nextFloat() - 15.0f;
+            float y = 30.0f * rng.nextFloat() - 15.0f;
+            float z = 0.6f * rng.nextFloat() - 0.3f;
+            float halfSize = 0.05f + 0.2f * rng.nextFloat();
+            bounds.set(i, {x - halfSize, y - halfSize, z - 0.5f * halfSize}, {x + halfSize, y + halfSize, z + 0.5f * halfSize});
+        }
+        return bounds;
+    }
+
+    /**
+     * A box is outside when one plane has all of its corners behind it. NaN distances are never behind
+     */
+    std::vector<uint32_t> referenceCull(const Frustum& frustum, const ChunkBounds& bounds) {
+        std::vector<uint32_t> visible;
+        for (size_t i = 0; i < bounds.size(); i++) {
+            bool outside = false;
+            for (const glm::vec4& plane : frustum.planes) {
+                bool allBehind = true;
+                for (int corner = 0; corner < 8; corner++) {
+                    float x = corner & 1 ? bounds.maxX[i] : bounds.minX[i];
+                    float y = corner & 2 ? bounds.maxY[i] : bounds.minY[i];
+                    float z = corner & 4 ? bounds.maxZ[i] : bounds.minZ[i];
+                    allBehind = allBehind && plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f;
+                }
+                outside = outside || allBehind;
+            }
+            if (!outside) {
+                visible.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        return visible;
+    }
+}
+
+/**
+ * Checks the frustum culler against a test of every box corner, on the thread pool and on one thread. Some boxes have
+ * NaN bounds, both in the groups of four of the SSE path and in the scalar tail: every path must keep them.
+ * Usage: FrustumCullCheck [chunk count]
+ * Returns a non zero exit code when a path disagrees with the reference.
+ */
+int main(int argc, char** argv) {
+    Logger logger("FrustumCullCheck");
+
+    try {
+        // Enough chunks for several thread pool ranges, and not a multiple of 4 so there is a scalar tail
+        const size_t chunkCount = argc > 1 ? std::stoul(argv[1]) : 64 * FrustumCuller::MIN_GRAIN + 3;
+        ChunkBounds bounds = makeChunks(chunkCount);
+
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        for (size_t chunk : {size_t{0}, chunkCount / 2 + 1, chunkCount - 1}) {
+            bounds.set(chunk, {nan, nan, nan}, {nan, nan, nan});
+        }
+
+        struct View {
+            const char* name;
+            glm::vec3 eye;
+            glm::vec3 target;
+        };
+
+        // A view that keeps about a third of the disk, and one from behind it that keeps none of it
+        const View views[] = {
+            {"arm", {6.0f, -2.0f, 1.5f}, {8.0f, 2.0f, 0.0f}},
+            {"away", {0.0f, -25.0f, 5.0f}, {0.0f, -50.0f, 5.0f}},
+        };
+
+        FrustumCuller culler;
+        bool success = true;
+        for (const auto& view : views) {
+            glm::mat4 projection = glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.01f, 100.0f);
+            Frustum frustum = Frustum::fromViewProjection(projection * glm::lookAtRH(view.eye, view.target, glm::vec3(0.0f, 0.0f, 1.0f)));
+
+            const std::vector<uint32_t> expected = referenceCull(frustum, bounds);
+            std::vector<uint32_t> parallel;
+            culler.cull(frustum, bounds, parallel);
+            std::vector<uint32_t> serial;
+            FrustumCuller::cullRange(frustum, bounds, 0, chunkCount, serial);
+
+            bool agree = parallel == expected && serial == expected;
+            success = success && agree;
+            logger.info(std::string(view.name) + ": " + std::to_string(chunkCount) + " chunks, " +
+                        std::to_string(expected.size()) + " visible, parallel " + std::to_string(parallel.size()) +
+                        ", single thread " + std::to_string(serial.size()) + (agree ? " [ok]" : " [FAILED]"));
+        }
+
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
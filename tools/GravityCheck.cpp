@@ -0,0 +1,76 @@
+//
+// Created by raph on 06/01/25.
+//
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "../src/core/Logger.h"
+#include "../src/simulation/GravityValidation.h"
+#include "../src/simulation/PMSolver.h"
+
+/**
+ * Validates the particle-mesh solver against direct summation on a small Plummer sphere.
+ * Usage: GravityCheck [particle count] [grid size]
+ * Returns a non zero exit code when the RMS relative error goes above the tolerance of a boundary mode.
+ */
+int main(int argc, char** argv) {
+    Logger logger("GravityCheck");
+
+    try {
+        size_t particleCount = argc > 1 ? std::stoul(argv[1]) : 4096;
+        uint32_t gridSize = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 64;
+
+        const float scaleRadius = 1.0f;
+        const float totalMass = 1e10f;
+        ParticleSet particles = GravityValidation::makePlummerSphere(particleCount, scaleRadius, totalMass, 42);
+
+        struct Case {
+            const char* name;
+            PMSolverConfig config;
+            double tolerance;
+        };
+
+        PMSolverConfig isolated;
+        isolated.gridSize = gridSize;
+        isolated.boundary = PMSolverConfig::Boundary::Isolated;
+
+        // Periodic images are not part of the direct sum, so this mode is only expected to agree loosely
+        PMSolverConfig periodic;
+        periodic.gridSize = gridSize;
+        periodic.boundary = PMSolverConfig::Boundary::Periodic;
+        periodic.boxSize = 8.0f * scaleRadius;
+
+        const Case cases[] = {
+            {"isolated", isolated, 0.08},
+            {"periodic", periodic, 0.25},
+        };
+
+        bool success = true;
+        for (const auto& testCase : cases) {
+            PMSolver solver(testCase.config);
+            // Compare with a direct summation softened over about one mesh cell, the PM resolution limit
+            ParticleSet probe = particles;
+            solver.computeAccelerations(probe);
+            float softening = solver.getCellSize();
+
+            auto error = GravityValidation::validate(solver, particles, softening);
+            bool passed = error.rmsRelative <= testCase.tolerance;
+            success = success && passed;
+
+            logger.info(std::string(testCase.name) + ": N=" + std::to_string(particleCount) +
+                        " mesh=" + std::to_string(gridSize) + "^3" +
+                        " rms=" + std::to_string(error.rmsRelative) +
+                        " mean=" + std::to_string(error.meanRelative) +
+                        " max=" + std::to_string(error.maxRelative) +
+                        (passed ? " [ok]" : " [FAILED]"));
+        }
+
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,139 @@
+//
+// Created by raph on 26/01/25.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/core/JobSystem.h"
+#include "../src/core/Logger.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double millisecondsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    double percentile(std::vector<double> samples, double fraction) {
+        std::sort(samples.begin(), samples.end());
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()))];
+    }
+}
+
+/**
+ * Measures the job system: parallelFor and spawn throughput, dependency chains, and the delay between submitting
+ * a job and a worker starting it.
+ * Usage: JobBenchmark [job count] [worker count]
+ * Returns a non zero exit code when a parallel result is wrong.
+ */
+int main(int argc, char** argv) {
+    Logger logger("JobBenchmark");
+
+    try {
+        size_t jobCount = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+        size_t workerCount = argc > 2 ? std::stoul(argv[2]) : JobSystem::defaultWorkerCount();
+        JobSystem jobs(workerCount);
+        bool success = true;
+
+        // parallelFor with one index per range: pure scheduling overhead
+        {
+            std::atomic<uint64_t> sum{0};
+            auto start = Clock::now();
+            jobs.parallelFor(0, jobCount, 1, [&](size_t first, size_t last) {
+                uint64_t local = 0;
+                for (size_t i = first; i < last; i++) {
+                    local += i;
+                }
+                sum.fetch_add(local, std::memory_order_relaxed);
+            });
+            double elapsed = millisecondsSince(start);
+            bool correct = sum.load() == uint64_t(jobCount) * (jobCount - 1) / 2;
+            success = success && correct;
+            logger.info("parallelFor grain 1: " + std::to_string(jobCount) + " ranges in " + std::to_string(elapsed) +
+                        " ms (" + std::to_string(jobCount / elapsed / 1e3) + " M jobs/s)" + (correct ? "" : " [WRONG]"));
+        }
+
+        // Independent jobs spawned from one thread under a common parent
+        {
+            std::atomic<size_t> ran{0};
+            auto start = Clock::now();
+            JobSystem::Job* root = jobs.create([] {});
+            for (size_t i = 0; i < jobCount; i++) {
+                jobs.submit(jobs.create([&ran] { ran.fetch_add(1, std::memory_order_relaxed); }, root));
+            }
+            jobs.submit(root);
+            jobs.wait(root);
+            double elapsed = millisecondsSince(start);
+            bool correct = ran.load() == jobCount;
+            success = success && correct;
+            logger.info("spawn: " + std::to_string(jobCount) + " jobs in " + std::to_string(elapsed) + " ms (" +
+                        std::to_string(jobCount / elapsed / 1e3) + " M jobs/s)" + (correct ? "" : " [WRONG]"));
+        }
+
+        // A chain where each job only runs once the previous one has finished
+        {
+            const size_t chainLength = std::min<size_t>(jobCount, 100'000);
+            size_t next = 0;
+            bool ordered = true;
+            auto start = Clock::now();
+            JobSystem::Job* previous = nullptr;
+            JobSystem::Job* first = nullptr;
+            for (size_t i = 0; i < chainLength; i++) {
+                JobSystem::Job* job = jobs.create([&next, &ordered, i] { ordered = ordered && next++ == i; });
+                if (previous) {
+                    jobs.addDependency(job, previous);
+                    jobs.submit(job);
+                } else {
+                    first = job;
+                }
+                previous = job;
+                // Keep the chain within the job pool of this thread
+                if ((i + 1) % (JobSystem::POOL_SIZE / 2) == 0 || i + 1 == chainLength) {
+                    if (first) {
+                        jobs.submit(first);
+                        first = nullptr;
+                    }
+                    jobs.wait(previous);
+                }
+            }
+            double elapsed = millisecondsSince(start);
+            bool correct = ordered && next == chainLength;
+            success = success && correct;
+            logger.info("dependency chain: " + std::to_string(chainLength) + " jobs in " + std::to_string(elapsed) +
+                        " ms (" + std::to_string(elapsed * 1e6 / chainLength) + " ns per link)" + (correct ? "" : " [WRONG]"));
+        }
+
+        // Submit to start, when a worker has to pick the job up (the caller does not help)
+        if (workerCount > 0) {
+            std::vector<double> latencies;
+            for (int i = 0; i < 1000; i++) {
+                std::atomic<int64_t> startedAt{0};
+                auto submitted = Clock::now();
+                JobSystem::Job* job = jobs.create([&startedAt] {
+                    startedAt.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+                });
+                jobs.submit(job);
+                while (!jobs.isFinished(job)) {
+                }
+                latencies.push_back(std::chrono::duration<double, std::micro>(
+                    Clock::duration(startedAt.load() - submitted.time_since_epoch().count())).count());
+            }
+            logger.info("worker pickup latency: median " + std::to_string(percentile(latencies, 0.5)) + " us, p99 " +
+                        std::to_string(percentile(latencies, 0.99)) + " us");
+        } else {
+            logger.info("worker pickup latency: no workers, jobs only run on waiting threads");
+        }
+
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,123 @@
+//
+// Created by raph on 27/01/25.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/core/Logger.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Timings {
+        std::vector<double> samples;    // nanoseconds per call
+        double total = 0.0;             // nanoseconds for all the calls
+    };
+
+    enum class Mode {
+        STRING,         // message built on the calling thread
+        FORMAT,         // LOG_* macro, arguments formatted by the writer
+        FILTERED,       // LOG_* macro below the logger level
+    };
+
+    // Log count messages of the usual size, timing every call
+    Timings logMessages(const std::string& component, size_t count, Mode mode) {
+        Logger logger(component);
+        if (mode == Mode::FILTERED) {
+            logger.setLogLevel(Logger::Level::INFO);
+        }
+
+        Timings timings;
+        timings.samples.reserve(count);
+        auto start = Clock::now();
+        for (size_t i = 0; i < count; i++) {
+            auto before = Clock::now();
+            switch (mode) {
+                case Mode::STRING:
+                    logger.info("Uploaded chunk positions for frame " + std::to_string(i) + ", blend factor " +
+                                std::to_string(0.5f) + " (" + component + ")");
+                    break;
+                case Mode::FORMAT:
+                    LOG_INFO(logger, "Uploaded chunk positions for frame {}, blend factor {} ({})", i, 0.5f, component);
+                    break;
+                case Mode::FILTERED:
+                    LOG_DEBUG(logger, "Uploaded chunk positions for frame {}, blend factor {} ({})", i, 0.5f, component);
+                    break;
+            }
+            timings.samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - before).count());
+        }
+        timings.total = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        return timings;
+    }
+
+    double percentile(std::vector<double>& samples, double fraction) {
+        size_t index = std::min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+}
+
+/**
+ * Measures what a log call costs the calling thread: building the message, using the LOG_* macros, a filtered out
+ * call, and the macros from several threads at once. The measured records go to stdout like any other, or to a
+ * binary log when a path is given.
+ * Usage: LogBenchmark [messages per thread] [threads] [binary log] | tail -n 4
+ */
+int main(int argc, char** argv) {
+    Logger logger("LogBenchmark");
+
+    try {
+        size_t count = argc > 1 ? std::stoul(argv[1]) : 100'000;
+        size_t threadCount = argc > 2 ? std::stoul(argv[2]) : 2;
+        if (argc > 3) {
+            Logger::openBinaryLog(argv[3]);
+        }
+
+        Timings string = logMessages("Render", count, Mode::STRING);
+        Timings format = logMessages("Render", count, Mode::FORMAT);
+        Timings filtered = logMessages("Render", count, Mode::FILTERED);
+
+        std::vector<Timings> results(threadCount);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < threadCount; t++) {
+            threads.emplace_back([&results, t, count] {
+                results[t] = logMessages("Thread" + std::to_string(t), count, Mode::FORMAT);
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        Timings concurrent;
+        for (auto& result : results) {
+            concurrent.samples.insert(concurrent.samples.end(), result.samples.begin(), result.samples.end());
+            concurrent.total = std::max(concurrent.total, result.total);
+        }
+
+        // Everything above must be written before the summary, which goes to the console
+        Logger::closeBinaryLog();
+
+        auto describe = [&](const std::string& name, Timings& timings, size_t calls) {
+            logger.info(name + ": " + std::to_string(timings.total / calls) + " ns per call, median " +
+                        std::to_string(percentile(timings.samples, 0.5)) + " ns, p99 " +
+                        std::to_string(percentile(timings.samples, 0.99)) + " ns");
+        };
+        describe("string", string, count);
+        describe("format", format, count);
+        describe("filtered", filtered, count);
+        describe("format, " + std::to_string(threadCount) + " threads", concurrent, count);
+        Logger::flush();
+
+        return EXIT_SUCCESS;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,130 @@
+//
+// Created by raph on 28/01/25.
+//
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/core/LogBackend.h"
+#include "../src/core/LogFormat.h"
+
+namespace {
+    class Reader {
+    public:
+        explicit Reader(const std::vector<char>& bytes) : bytes(bytes) {}
+
+        bool atEnd() const { return position >= bytes.size(); }
+
+        template<typename T>
+        T read() {
+            T value;
+            std::memcpy(&value, take(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        std::string_view readBytes(size_t size) {
+            return {take(size), size};
+        }
+
+    private:
+        const char* take(size_t size) {
+            if (bytes.size() - position < size) {
+                throw std::runtime_error("Truncated log at byte " + std::to_string(position));
+            }
+            const char* data = bytes.data() + position;
+            position += size;
+            return data;
+        }
+
+        const std::vector<char>& bytes;
+        size_t position = 0;
+    };
+}
+
+/**
+ * Turns a binary log written by Logger::openBinaryLog back into the console format.
+ * Usage: LogDecode <log file> [--colors]
+ */
+int main(int argc, char** argv) {
+    try {
+        if (argc < 2) {
+            std::cerr << "Usage: LogDecode <log file> [--colors]" << std::endl;
+            return EXIT_FAILURE;
+        }
+        const bool colors = argc > 2 && std::string(argv[2]) == "--colors";
+
+        std::ifstream file(argv[1], std::ios::binary);
+        if (!file) {
+            throw std::runtime_error(std::string("Failed to open ") + argv[1]);
+        }
+        const std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        Reader reader(bytes);
+        if (reader.readBytes(sizeof(LogBackend::BINARY_MAGIC)) !=
+            std::string_view(LogBackend::BINARY_MAGIC, sizeof(LogBackend::BINARY_MAGIC))) {
+            throw std::runtime_error(std::string(argv[1]) + " is not a binary log");
+        }
+
+        std::unordered_map<uint32_t, std::string> components;
+        std::unordered_map<uint32_t, std::string> formats;
+        size_t componentWidth = LogBackend::getComponentWidth();
+        LogFormatter formatter;
+        std::string message;
+        std::string line;
+
+        while (!reader.atEnd()) {
+            const auto type = reader.read<LogBackend::BinaryEntry>();
+            switch (type) {
+                case LogBackend::BinaryEntry::COMPONENT:
+                case LogBackend::BinaryEntry::FORMAT: {
+                    const auto id = reader.read<uint32_t>();
+                    const auto length = reader.read<uint32_t>();
+                    std::string text(reader.readBytes(length));
+                    if (type == LogBackend::BinaryEntry::COMPONENT) {
+                        componentWidth = std::max(componentWidth, text.size());
+                        components[id] = std::move(text);
+                    } else {
+                        formats[id] = std::move(text);
+                    }
+                    break;
+                }
+                case LogBackend::BinaryEntry::RECORD: {
+                    const auto timestamp = reader.read<int64_t>();
+                    const auto level = reader.read<uint8_t>();
+                    const auto component = reader.read<uint32_t>();
+                    const auto format = reader.read<uint32_t>();
+                    const auto length = reader.read<uint32_t>();
+                    const std::string_view payload = reader.readBytes(length);
+
+                    std::string_view text = payload;
+                    if (format != 0) {
+                        message.clear();
+                        LogArguments::format(message, formats.at(format),
+                                             reinterpret_cast<const unsigned char*>(payload.data()), payload.size());
+                        text = message;
+                    }
+
+                    line.clear();
+                    formatter.appendLine(line, timestamp, level, colors, true, components.at(component), componentWidth, text);
+                    std::cout << line;
+                    break;
+                }
+                default:
+                    throw std::runtime_error("Unknown log entry " + std::to_string(static_cast<int>(type)));
+            }
+        }
+        return EXIT_SUCCESS;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,221 @@
+//
+// Created by raph on 31/01/25.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vulkan/vulkan.h>
+
+#include "../src/core/Application.h"
+#include "../src/core/CameraScript.h"
+#include "../src/core/Logger.h"
+#include "../src/core/ThreadPool.h"
+#include "../src/renderer/VulkanContext.h"
+
+namespace {
+    void printUsage() {
+        std::cerr << "Usage: RenderBenchmark [--stars count] [--frames count] [--warmup count] [--script path] "
+                     "[--width pixels] [--height pixels] [--simulate] [--no-bloom] [--render-passes] [--vertex-pulling] "
+                     "[--sprites pixels|quads|points] [--splat] [--volume] [--far-field] "
+                     "[--json path|-]" << std::endl;
+    }
+
+    const char* spriteModeName(StarSprites mode) {
+        switch (mode) {
+            case StarSprites::Quads:  return "quads";
+            case StarSprites::Points: return "points";
+            default:                  return "pixels";
+        }
+    }
+
+    const char* presentModeName(VkPresentModeKHR mode) {
+        switch (mode) {
+            case VK_PRESENT_MODE_IMMEDIATE_KHR:    return "immediate";
+            case VK_PRESENT_MODE_MAILBOX_KHR:      return "mailbox";
+            case VK_PRESENT_MODE_FIFO_KHR:         return "fifo";
+            case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo_relaxed";
+            default:                               return "other";
+        }
+    }
+
+    std::string escape(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    std::string version(uint32_t value) {
+        return std::to_string(VK_API_VERSION_MAJOR(value)) + "." + std::to_string(VK_API_VERSION_MINOR(value)) + "." +
+               std::to_string(VK_API_VERSION_PATCH(value));
+    }
+}
+
+/**
+ * End to end frame times of the renderer: a fixed galaxy seen along a scripted camera path for a fixed number of
+ * frames, with no input needed. Reports CPU, GPU and present to present times as percentiles, with the device
+ * and swap chain they were measured on.
+ * Usage: RenderBenchmark [--stars count] [--frames count] [--warmup count] [--script path] [--width pixels]
+ *                        [--height pixels] [--simulate] [--no-bloom] [--render-passes] [--vertex-pulling]
+ *                        [--sprites pixels|quads|points] [--splat] [--volume] [--far-field] [--json path|-]
+ * Without a script the camera turns once around the galaxy over the run (see CameraScript for the file format).
+ * The simulation is off unless --simulate is given, so two runs draw the same frames. --no-bloom leaves the bloom
+ * passes out, to measure what they cost, --render-passes draws with render passes even when the device has
+ * dynamic rendering, and --vertex-pulling reads the stars from storage buffers instead of vertex attributes.
+ * --sprites compares the star sprite modes (see StarSpriteConfig), pixels being the default, and --splat
+ * rasterizes the far chunks with a compute shader (see StarSplat). --volume raymarches the galaxy instead of drawing
+ * its stars while the camera is outside of it (see GalaxyVolume), and --far-field keeps the distant stars in a
+ * cache drawn again only when it is stale (see FarFieldCache); give it a static script to measure an idle view.
+ * Run it from the build directory, where the shaders are. On a machine without a GPU or a display:
+ *     VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json xvfb-run -s "-screen 0 1920x1080x24" ./RenderBenchmark
+ */
+int main(int argc, char** argv) {
+    Logger logger("RenderBenchmark");
+
+    try {
+        ApplicationConfig config;
+        config.windowProps.title = "Galaxy Renderer Benchmark";
+        config.windowProps.width = 1280;
+        config.windowProps.height = 720;
+        config.windowProps.isResizable = false;
+        config.galaxy.starCount = 1'000'000;
+        config.simulation.enabled = false;
+
+        uint64_t frames = 1200;
+        uint64_t warmup = 60;
+        std::string scriptPath;
+        std::string jsonPath;
+
+        for (int i = 1; i < argc; i++) {
+            const std::string argument = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (argument == "--stars" && hasValue) {
+                config.galaxy.starCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (argument == "--frames" && hasValue) {
+                frames = std::stoull(argv[++i]);
+            } else if (argument == "--warmup" && hasValue) {
+                warmup = std::stoull(argv[++i]);
+            } else if (argument == "--script" && hasValue) {
+                scriptPath = argv[++i];
+            } else if (argument == "--width" && hasValue) {
+                config.windowProps.width = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (argument == "--height" && hasValue) {
+                config.windowProps.height = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (argument == "--simulate") {
+                config.simulation.enabled = true;
+            } else if (argument == "--no-bloom") {
+                config.bloom.enabled = false;
+            } else if (argument == "--render-passes") {
+                config.dynamicRendering = false;
+            } else if (argument == "--vertex-pulling") {
+                config.vertexPulling = true;
+            } else if (argument == "--sprites" && hasValue) {
+                const std::string mode = argv[++i];
+                if (mode == "pixels") {
+                    config.sprites.mode = StarSprites::Pixels;
+                } else if (mode == "quads") {
+                    config.sprites.mode = StarSprites::Quads;
+                } else if (mode == "points") {
+                    config.sprites.mode = StarSprites::Points;
+                } else {
+                    printUsage();
+                    return 1;
+                }
+            } else if (argument == "--splat") {
+                config.splat.enabled = true;
+            } else if (argument == "--volume") {
+                config.volume.enabled = true;
+            } else if (argument == "--far-field") {
+                config.farField.enabled = true;
+            } else if (argument == "--json" && hasValue) {
+                jsonPath = argv[++i];
+            } else {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        }
+        if (frames <= warmup) {
+            throw std::runtime_error("--frames must be larger than --warmup");
+        }
+
+        Application app(config);
+
+        // The default path lasts the measured frames, at the fixed 60 frames per second of scripted runs
+        std::unique_ptr<CameraScript> script = scriptPath.empty()
+            ? std::make_unique<CameraScript>(CameraScript::orbit(app.getGalaxyRadius(), static_cast<float>(frames) / 60.0f))
+            : std::make_unique<CameraScript>(CameraScript::load(scriptPath));
+
+        app.run(frames, script.get(), warmup);
+        if (app.getFrameNumber() < frames) {
+            throw std::runtime_error("The window was closed after " + std::to_string(app.getFrameNumber()) + " frames");
+        }
+
+        VulkanContext& context = app.getVulkanContext();
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(context.getPhysicalDevice(), &properties);
+        const VkExtent2D extent = context.getSwapChain().getExtent();
+
+        const FrameStatistics& statistics = app.getFrameStatistics();
+        const FrameTimeSummary cpu = statistics.getCpu();
+        const FrameTimeSummary gpu = statistics.getGpu();
+        const FrameTimeSummary present = statistics.getPresent();
+        char summary[256];
+        std::snprintf(summary, sizeof(summary),
+                      "ms p50/p95/p99: cpu %.3f/%.3f/%.3f, gpu %.3f/%.3f/%.3f, present %.3f/%.3f/%.3f",
+                      cpu.p50, cpu.p95, cpu.p99, gpu.p50, gpu.p95, gpu.p99, present.p50, present.p95, present.p99);
+        logger.info(std::string(properties.deviceName) + ", " + presentModeName(context.getSwapChain().getPresentMode()) +
+                    ", " + std::to_string(config.galaxy.starCount) + " stars: " + summary);
+
+        if (!jsonPath.empty()) {
+            std::string json = "{\n";
+            json += "  \"config\": {\"device\": \"" + escape(properties.deviceName) +
+                    "\", \"deviceType\": " + std::to_string(properties.deviceType) +
+                    ", \"apiVersion\": \"" + version(properties.apiVersion) +
+                    "\", \"driverVersion\": " + std::to_string(properties.driverVersion) +
+                    ", \"presentMode\": \"" + presentModeName(context.getSwapChain().getPresentMode()) +
+                    "\", \"framesInFlight\": " + std::to_string(config.maxFramesInFlight) +
+                    ", \"width\": " + std::to_string(extent.width) + ", \"height\": " + std::to_string(extent.height) +
+                    ", \"stars\": " + std::to_string(config.galaxy.starCount) +
+                    ", \"seed\": " + std::to_string(config.galaxy.seed) +
+                    ", \"simulation\": " + (config.simulation.enabled ? "true" : "false") +
+                    ", \"bloom\": " + (config.bloom.enabled ? "true" : "false") +
+                    ", \"dynamicRendering\": " + (config.dynamicRendering && context.hasDynamicRendering() ? "true" : "false") +
+                    ", \"vertexPulling\": " + (config.vertexPulling ? "true" : "false") +
+                    ", \"sprites\": \"" + spriteModeName(config.sprites.mode) + "\"" +
+                    ", \"splat\": " + (config.splat.enabled ? "true" : "false") +
+                    ", \"volume\": " + (config.volume.enabled ? "true" : "false") +
+                    ", \"farField\": " + (config.farField.enabled ? "true" : "false") +
+                    ", \"script\": \"" + escape(scriptPath.empty() ? "orbit" : scriptPath) +
+                    "\", \"frames\": " + std::to_string(frames) + ", \"warmup\": " + std::to_string(warmup) +
+                    ", \"threads\": " + std::to_string(ThreadPool::global().getConcurrency()) + "},\n";
+            json += "  \"frameTimes\": " + statistics.toJson() + "\n}\n";
+
+            if (jsonPath == "-") {
+                Logger::flush();
+                std::cout << json;
+            } else {
+                std::ofstream file(jsonPath);
+                if (!(file << json)) {
+                    throw std::runtime_error("Failed to write " + jsonPath);
+                }
+            }
+        }
+        Logger::flush();
+
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+//
+// Created by raph on 08/02/25.
+//
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/core/Logger.h"
+#include "../src/galaxy/Snapshot.h"
+#include "../src/simulation/BlockTimestepIntegrator.h"
+#include "../src/simulation/DirectSummationSolver.h"
+#include "../src/simulation/GravityValidation.h"
+
+namespace {
+    using Float3 = std::array<float, 3>;
+
+    /**
+     * Save the state like Application::writeSnapshot, in star order with synchronized velocities
+     */
+    void save(const std::string& path, const ParticleSet& particles, const BlockTimestepIntegrator& integrator) {
+        const size_t count = particles.size();
+        std::vector<Float3> positions(count), velocities(count);
+        std::vector<float> masses(count);
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t slot = particles.id[i];
+            positions[slot] = {particles.x[i], particles.y[i], particles.z[i]};
+            integrator.getSynchronizedVelocity(particles, i, velocities[slot][0], velocities[slot][1], velocities[slot][2]);
+            masses[slot] = particles.mass[i];
+        }
+
+        Snapshot::Metadata metadata;
+        metadata.particleCount = count;
+        metadata.time = integrator.getTime();
+        Snapshot::write(path, metadata, {
+            {Snapshot::Section::Positions, sizeof(Float3), positions.data()},
+            {Snapshot::Section::Velocities, sizeof(Float3), velocities.data()},
+            {Snapshot::Section::Masses, sizeof(float), masses.data()},
+        });
+    }
+
+    /**
+     * Read it back like Application::loadSnapshot
+     */
+    ParticleSet load(const std::string& path, double& time) {
+        SnapshotFile snapshot(path);
+        const size_t count = snapshot.getMetadata().particleCount;
+        time = snapshot.getMetadata().time;
+
+        auto positions = reinterpret_cast<const Float3*>(
+            snapshot.getSection(Snapshot::Section::Positions, sizeof(Float3)).data());
+        auto velocities = reinterpret_cast<const Float3*>(
+            snapshot.getSection(Snapshot::Section::Velocities, sizeof(Float3)).data());
+        auto masses = reinterpret_cast<const float*>(
+            snapshot.getSection(Snapshot::Section::Masses, sizeof(float)).data());
+
+        ParticleSet particles;
+        particles.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            particles.x[i] = positions[i][0];
+            particles.y[i] = positions[i][1];
+            particles.z[i] = positions[i][2];
+            particles.vx[i] = velocities[i][0];
+            particles.vy[i] = velocities[i][1];
+            particles.vz[i] = velocities[i][2];
+            particles.mass[i] = masses[i];
+        }
+        return particles;
+    }
+
+    std::vector<Float3> positionsById(const ParticleSet& particles) {
+        std::vector<Float3> positions(particles.size());
+        for (size_t i = 0; i < particles.size(); i++) {
+            positions[particles.id[i]] = {particles.x[i], particles.y[i], particles.z[i]};
+        }
+        return positions;
+    }
+}
+
+/**
+ * Checks that a run saved to a snapshot and resumed from it continues the uninterrupted run: a small Plummer sphere
+ * is stepped with block timesteps, saved at the end of a level 0 step, loaded into a new integrator and stepped
+ * again. Usage: SnapshotResumeCheck [particle count]
+ * Returns a non zero exit code when the resumed positions drift from the uninterrupted ones.
+ */
+int main(int argc, char** argv) {
+    Logger logger("SnapshotResumeCheck");
+
+    try {
+        const size_t particleCount = argc > 1 ? std::stoul(argv[1]) : 512;
+        const float scaleRadius = 1.0f;
+        const ParticleSet initial = GravityValidation::makePlummerSphere(particleCount, scaleRadius, 1e10f, 42);
+
+        BlockTimestepConfig config;
+        config.maxLevel = 4;
+        DirectSummationSolver solver(config.softening);
+        const uint64_t stepSubsteps = uint64_t{1} << config.maxLevel;
+        const uint64_t beforeSave = 2 * stepSubsteps;
+        const uint64_t afterSave = 2 * stepSubsteps;
+
+        // Uninterrupted
+        ParticleSet reference = initial;
+        BlockTimestepIntegrator referenceIntegrator(solver, config);
+        referenceIntegrator.initialize(reference);
+        for (uint64_t i = 0; i < beforeSave + afterSave; i++) {
+            referenceIntegrator.substep(reference);
+        }
+
+        // Saved, loaded and resumed
+        const std::string path = (std::filesystem::temp_directory_path() / "SnapshotResumeCheck.vgs").string();
+        ParticleSet saved = initial;
+        BlockTimestepIntegrator savedIntegrator(solver, config);
+        savedIntegrator.initialize(saved);
+        for (uint64_t i = 0; i < beforeSave; i++) {
+            savedIntegrator.substep(saved);
+        }
+        save(path, saved, savedIntegrator);
+
+        double time = 0.0;
+        ParticleSet resumed = load(path, time);
+        std::filesystem::remove(path);
+        BlockTimestepIntegrator resumedIntegrator(solver, config);
+        resumedIntegrator.initialize(resumed, time);
+        for (uint64_t i = 0; i < afterSave; i++) {
+            resumedIntegrator.substep(resumed);
+        }
+
+        // Only the order of the force sums differs between the runs
+        const auto expected = positionsById(reference);
+        const auto actual = positionsById(resumed);
+        double maxError = 0.0;
+        for (size_t i = 0; i < expected.size(); i++) {
+            const double dx = actual[i][0] - expected[i][0];
+            const double dy = actual[i][1] - expected[i][1];
+            const double dz = actual[i][2] - expected[i][2];
+            maxError = std::max(maxError, std::sqrt(dx * dx + dy * dy + dz * dz));
+        }
+        const double tolerance = 1e-4 * scaleRadius;
+        const bool passed = maxError <= tolerance && std::abs(resumedIntegrator.getTime() - referenceIntegrator.getTime()) < 1e-9;
+
+        logger.info("N=" + std::to_string(particleCount) + " resumed at t=" + std::to_string(time) +
+                    " Myr, max position error after " + std::to_string(afterSave) + " substeps: " +
+                    std::to_string(maxError) + " kpc" + (passed ? " [ok]" : " [FAILED]"));
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}